@@ -15,6 +15,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
@@ -83,6 +84,7 @@ class ColorConvertCalculator : public CalculatorBase {
 
   absl::Status Open(CalculatorContext* cc) override {
     cc->SetOffset(TimestampDiff(0));
+    image_pool_ = cc->Service(kImageMultiPoolService);
     return absl::OkStatus();
   }
 
@@ -96,6 +98,8 @@ class ColorConvertCalculator : public CalculatorBase {
                                 ImageFormat::Format output_format,
                                 int open_cv_convert_code,
                                 CalculatorContext* cc);
+
+  ServiceBinding<ImageMultiPool> image_pool_;
 };
 
 REGISTER_CALCULATOR(ColorConvertCalculator);
@@ -105,6 +109,7 @@ absl::Status ColorConvertCalculator::GetContract(CalculatorContract* cc) {
       << "Only one input stream is allowed.";
   RET_CHECK_EQ(cc->Outputs().NumEntries(), 1)
       << "Only one output stream is allowed.";
+  cc->UseService(kImageMultiPoolService).Optional();
 
   if (cc->Inputs().HasTag(kRgbaInTag)) {
     cc->Inputs().Tag(kRgbaInTag).Set<ImageFrame>();
@@ -147,8 +152,8 @@ absl::Status ColorConvertCalculator::ConvertAndOutput(
     CalculatorContext* cc) {
   const cv::Mat& input_mat =
       formats::MatView(&cc->Inputs().Tag(input_tag).Get<ImageFrame>());
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(output_format, input_mat.cols, input_mat.rows));
+  std::unique_ptr<ImageFrame> output_frame = CreateImageFrame(
+      image_pool_, output_format, input_mat.cols, input_mat.rows);
   cv::Mat output_mat = formats::MatView(output_frame.get());
   cv::cvtColor(input_mat, output_mat, open_cv_convert_code);
 
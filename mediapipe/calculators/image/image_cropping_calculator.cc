@@ -64,6 +64,7 @@ absl::Status ImageCroppingCalculator::GetContract(CalculatorContract* cc) {
     RET_CHECK(cc->Outputs().HasTag(kImageTag));
     cc->Inputs().Tag(kImageTag).Set<ImageFrame>();
     cc->Outputs().Tag(kImageTag).Set<ImageFrame>();
+    cc->UseService(kImageMultiPoolService).Optional();
   }
 #if !MEDIAPIPE_DISABLE_GPU
   if (cc->Inputs().HasTag(kImageGpuTag)) {
@@ -123,6 +124,8 @@ absl::Status ImageCroppingCalculator::Open(CalculatorContext* cc) {
 
   if (cc->Inputs().HasTag(kImageGpuTag)) {
     use_gpu_ = true;
+  } else {
+    image_pool_ = cc->Service(kImageMultiPoolService);
   }
 
   options_ = cc->Options<mediapipe::ImageCroppingCalculatorOptions>();
@@ -254,16 +257,17 @@ absl::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
   cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
   cv::Mat projection_matrix =
       cv::getPerspectiveTransform(src_points, dst_points);
-  cv::Mat cropped_image;
-  cv::warpPerspective(input_mat, cropped_image, projection_matrix,
-                      cv::Size(output_width, output_height),
+  const cv::Size output_size(output_width, output_height);
+  std::unique_ptr<ImageFrame> output_frame =
+      CreateImageFrame(image_pool_, input_img.Format(), output_size.width,
+                       output_size.height);
+  // The view has the size and type of the result, so OpenCV writes into the
+  // output frame instead of allocating a new image.
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+  cv::warpPerspective(input_mat, output_mat, projection_matrix, output_size,
                       /* flags = */ 0,
                       /* borderMode = */ border_mode);
-
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
-      input_img.Format(), cropped_image.cols, cropped_image.rows));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
-  cropped_image.copyTo(output_mat);
+  RET_CHECK_EQ(output_mat.data, output_frame->MutablePixelData());
   cc->Outputs().Tag(kImageTag).Add(output_frame.release(),
                                    cc->InputTimestamp());
   return absl::OkStatus();
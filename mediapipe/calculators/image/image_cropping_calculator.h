@@ -5,6 +5,7 @@
 
 #include "mediapipe/calculators/image/image_cropping_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -17,7 +18,8 @@
 //
 // Input:
 //   One of the following two tags:
-//   IMAGE - ImageFrame representing the input image.
+//   IMAGE - ImageFrame representing the input image. The output frames come
+//           from the kImageMultiPoolService pool if the graph provides one.
 //   IMAGE_GPU - GpuBuffer representing the input image.
 //   One of the following two tags (optional if WIDTH/HEIGHT is specified):
 //   RECT - A Rect proto specifying the width/height and location of the
@@ -83,6 +85,7 @@ class ImageCroppingCalculator : public CalculatorBase {
   float transformed_points_[8];
   float output_max_width_ = FLT_MAX;
   float output_max_height_ = FLT_MAX;
+  ServiceBinding<ImageMultiPool> image_pool_;
 #if !MEDIAPIPE_DISABLE_GPU
   bool gpu_initialized_ = false;
   mediapipe::GlCalculatorHelper gpu_helper_;
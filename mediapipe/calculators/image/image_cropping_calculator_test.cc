@@ -19,6 +19,8 @@
 
 #include "mediapipe/calculators/image/image_cropping_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
@@ -212,5 +214,64 @@ TEST(ImageCroppingCalculatorTest, RedundantSpecWithInputStream) {
             expectRect);
 }  // TEST
 
+// Verifies that the CPU path takes its output frames from the graph's
+// kImageMultiPoolService pool, which GetGraphMetrics() reports.
+TEST(ImageCroppingCalculatorTest, UsesGraphImagePool) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input_frames"
+        node {
+          calculator: "ImageCroppingCalculator"
+          input_stream: "IMAGE:input_frames"
+          output_stream: "IMAGE:cropped_frames"
+          options: {
+            [mediapipe.ImageCroppingCalculatorOptions.ext] {
+              width: 40
+              height: 30
+            }
+          }
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.SetServiceObject(kImageMultiPoolService,
+                                      std::make_shared<ImageMultiPool>()));
+  MP_ASSERT_OK(graph.Initialize(config));
+  int num_outputs = 0;
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "cropped_frames", [&num_outputs](const Packet& packet) {
+        const ImageFrame& frame = packet.Get<ImageFrame>();
+        EXPECT_EQ(frame.Width(), 40);
+        EXPECT_EQ(frame.Height(), 30);
+        ++num_outputs;
+        return absl::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  constexpr int kNumFrames = 3;
+  for (int i = 0; i < kNumFrames; ++i) {
+    auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, input_width,
+                                               input_height);
+    frame->SetToZero();
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input_frames", Adopt(frame.release()).At(Timestamp(i))));
+    // The observer doesn't keep the cropped frame, so it goes back to the
+    // pool before the next frame is cropped.
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+
+  GraphMetrics metrics;
+  MP_ASSERT_OK(graph.GetGraphMetrics(&metrics));
+  ASSERT_EQ(metrics.buffer_pool_size(), 1);
+  const GraphMetrics::BufferPoolMetrics& pool = metrics.buffer_pool(0);
+  EXPECT_EQ(pool.name(), "image_frames");
+  EXPECT_EQ(pool.miss_count(), 1);
+  EXPECT_EQ(pool.hit_count(), kNumFrames - 1);
+  EXPECT_GT(pool.allocated_bytes(), 0);
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(num_outputs, kNumFrames);
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -13,9 +13,11 @@
 // limitations under the License.
 
 #include "mediapipe/calculators/image/image_transformation_calculator.pb.h"
+#include "mediapipe/calculators/image/image_transformation_cpu.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -155,6 +157,9 @@ mediapipe::ScaleMode_Mode ParseScaleMode(
 //   rotation_mode - (optional) Rotation in multiples of 90 degrees.
 //   flip_vertically, flip_horizontally - (optional) flip about x or y axis.
 //   scale_mode - (optional) Stretch, Fit, or Fill and Crop
+//   cpu_implementation - (optional) By default, ImageFrames with one byte per
+//     channel are transformed in a single pass into pooled output frames.
+//     The pool is that of kImageMultiPoolService if the graph provides one.
 //
 // Note: To enable horizontal or vertical flipping, specify them in the
 // calculator options. Flipping is applied after rotation.
@@ -175,11 +180,20 @@ class ImageTransformationCalculator : public CalculatorBase {
 
  private:
   absl::Status RenderCpu(CalculatorContext* cc);
+  void RenderCpuOpenCv(const ImageFrame& input,
+                       const ImageTransformationSpec& spec,
+                       ImageFrame* output);
   absl::Status RenderGpu(CalculatorContext* cc);
   absl::Status GlSetup();
 
   void ComputeOutputDimensions(int input_width, int input_height,
                                int* output_width, int* output_height);
+  // Describes the CPU rendering of an input_width x input_height image, and
+  // returns the output dimensions.
+  ImageTransformationSpec GetCpuTransformationSpec(int input_width,
+                                                   int input_height,
+                                                   int* output_width,
+                                                   int* output_height);
   void ComputeOutputLetterboxPadding(int input_width, int input_height,
                                      int output_width, int output_height,
                                      std::array<float, 4>* padding);
@@ -192,6 +206,10 @@ class ImageTransformationCalculator : public CalculatorBase {
   bool flip_horizontally_ = false;
   bool flip_vertically_ = false;
 
+  // Pool of the CPU output frames. The fused CPU implementation uses a pool
+  // of its own if the graph does not provide one.
+  ServiceBinding<ImageMultiPool> image_pool_;
+
   bool use_gpu_ = false;
 #if !MEDIAPIPE_DISABLE_GPU
   GlCalculatorHelper gpu_helper_;
@@ -215,6 +233,7 @@ absl::Status ImageTransformationCalculator::GetContract(
     RET_CHECK(cc->Outputs().HasTag(kImageFrameTag));
     cc->Inputs().Tag(kImageFrameTag).Set<ImageFrame>();
     cc->Outputs().Tag(kImageFrameTag).Set<ImageFrame>();
+    cc->UseService(kImageMultiPoolService).Optional();
   }
 #if !MEDIAPIPE_DISABLE_GPU
   if (cc->Inputs().HasTag(kGpuBufferTag)) {
@@ -274,6 +293,14 @@ absl::Status ImageTransformationCalculator::Open(CalculatorContext* cc) {
 
   if (cc->Inputs().HasTag(kGpuBufferTag)) {
     use_gpu_ = true;
+  } else {
+    image_pool_ = cc->Service(kImageMultiPoolService);
+    if (!image_pool_.IsAvailable() &&
+        options_.cpu_implementation() !=
+            ImageTransformationCalculatorOptions::CPU_IMPLEMENTATION_OPENCV) {
+      image_pool_ = ServiceBinding<ImageMultiPool>(
+          std::make_shared<ImageMultiPool>());
+    }
   }
 
   if (cc->InputSidePackets().HasTag("OUTPUT_DIMENSIONS")) {
@@ -391,58 +418,57 @@ absl::Status ImageTransformationCalculator::Close(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
-absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
-  cv::Mat input_mat;
-  mediapipe::ImageFormat::Format format;
-
-  const auto& input = cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
-  input_mat = formats::MatView(&input);
-  format = input.Format();
-
-  const int input_width = input_mat.cols;
-  const int input_height = input_mat.rows;
-  int output_width;
-  int output_height;
-  ComputeOutputDimensions(input_width, input_height, &output_width,
-                          &output_height);
-
+ImageTransformationSpec ImageTransformationCalculator::GetCpuTransformationSpec(
+    int input_width, int input_height, int* output_width, int* output_height) {
+  ComputeOutputDimensions(input_width, input_height, output_width,
+                          output_height);
+  ImageTransformationSpec spec;
+  spec.scaled_width = input_width;
+  spec.scaled_height = input_height;
   if (output_width_ > 0 && output_height_ > 0) {
-    cv::Mat scaled_mat;
     if (scale_mode_ == mediapipe::ScaleMode_Mode_STRETCH) {
-      int scale_flag =
-          input_mat.cols > output_width_ && input_mat.rows > output_height_
-              ? cv::INTER_AREA
-              : cv::INTER_LINEAR;
-      cv::resize(input_mat, scaled_mat, cv::Size(output_width_, output_height_),
-                 0, 0, scale_flag);
+      spec.scaled_width = output_width_;
+      spec.scaled_height = output_height_;
+      spec.area_interpolation =
+          input_width > output_width_ && input_height > output_height_;
     } else {
       const float scale =
           std::min(static_cast<float>(output_width_) / input_width,
                    static_cast<float>(output_height_) / input_height);
-      const int target_width = std::round(input_width * scale);
-      const int target_height = std::round(input_height * scale);
-      int scale_flag = scale < 1.0f ? cv::INTER_AREA : cv::INTER_LINEAR;
+      spec.scaled_width = std::round(input_width * scale);
+      spec.scaled_height = std::round(input_height * scale);
+      spec.area_interpolation = scale < 1.0f;
       if (scale_mode_ == mediapipe::ScaleMode_Mode_FIT) {
-        cv::Mat intermediate_mat;
-        cv::resize(input_mat, intermediate_mat,
-                   cv::Size(target_width, target_height), 0, 0, scale_flag);
-        const int top = (output_height_ - target_height) / 2;
-        const int bottom = output_height_ - target_height - top;
-        const int left = (output_width_ - target_width) / 2;
-        const int right = output_width_ - target_width - left;
-        cv::copyMakeBorder(intermediate_mat, scaled_mat, top, bottom, left,
-                           right,
-                           options_.constant_padding() ? cv::BORDER_CONSTANT
-                                                       : cv::BORDER_REPLICATE);
+        spec.pad_top = (output_height_ - spec.scaled_height) / 2;
+        spec.pad_bottom = output_height_ - spec.scaled_height - spec.pad_top;
+        spec.pad_left = (output_width_ - spec.scaled_width) / 2;
+        spec.pad_right = output_width_ - spec.scaled_width - spec.pad_left;
+        spec.constant_padding = options_.constant_padding();
       } else {
-        cv::resize(input_mat, scaled_mat, cv::Size(target_width, target_height),
-                   0, 0, scale_flag);
-        output_width = target_width;
-        output_height = target_height;
+        *output_width = spec.scaled_width;
+        *output_height = spec.scaled_height;
       }
     }
-    input_mat = scaled_mat;
   }
+  spec.rotation_degrees = RotationModeToDegrees(rotation_);
+  // An image that already has the output dimensions is rotated about its
+  // center, even if the rotation is by 90 or 270 degrees.
+  spec.rotate_about_center =
+      spec.pad_left + spec.scaled_width + spec.pad_right == *output_width &&
+      spec.pad_top + spec.scaled_height + spec.pad_bottom == *output_height;
+  spec.flip_horizontally = flip_horizontally_;
+  spec.flip_vertically = flip_vertically_;
+  return spec;
+}
+
+absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
+  const auto& input = cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
+  const int input_width = input.Width();
+  const int input_height = input.Height();
+  int output_width;
+  int output_height;
+  const ImageTransformationSpec spec = GetCpuTransformationSpec(
+      input_width, input_height, &output_width, &output_height);
 
   if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
     auto padding = absl::make_unique<std::array<float, 4>>();
@@ -453,49 +479,99 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
         .Add(padding.release(), cc->InputTimestamp());
   }
 
+  if (options_.cpu_implementation() !=
+          ImageTransformationCalculatorOptions::CPU_IMPLEMENTATION_OPENCV &&
+      IsInPlaceTransformation(spec, input_width, input_height)) {
+    // If this calculator holds the only reference to the input frame, the
+    // frame is flipped in place and becomes the output, without allocating
+    // or writing another frame. Consume() leaves a shared input untouched.
+    auto frame = cc->Inputs().Tag(kImageFrameTag).Consume<ImageFrame>();
+    if (frame.ok()) {
+      MP_RETURN_IF_ERROR(TransformImageFrameInPlace(spec, frame->get()));
+      cc->Outputs()
+          .Tag(kImageFrameTag)
+          .Add(frame->release(), cc->InputTimestamp());
+      return absl::OkStatus();
+    }
+  }
+
+  std::unique_ptr<ImageFrame> output_frame = CreateImageFrame(
+      image_pool_, input.Format(), output_width, output_height);
+  if (options_.cpu_implementation() !=
+          ImageTransformationCalculatorOptions::CPU_IMPLEMENTATION_OPENCV &&
+      IsFusedTransformationSupported(input)) {
+    MP_RETURN_IF_ERROR(TransformImageFrame(input, spec, output_frame.get()));
+  } else {
+    RenderCpuOpenCv(input, spec, output_frame.get());
+  }
+  cc->Outputs()
+      .Tag(kImageFrameTag)
+      .Add(output_frame.release(), cc->InputTimestamp());
+
+  return absl::OkStatus();
+}
+
+void ImageTransformationCalculator::RenderCpuOpenCv(
+    const ImageFrame& input, const ImageTransformationSpec& spec,
+    ImageFrame* output) {
+  cv::Mat input_mat = formats::MatView(&input);
+
+  if (output_width_ > 0 && output_height_ > 0) {
+    cv::Mat scaled_mat;
+    const int scale_flag =
+        spec.area_interpolation ? cv::INTER_AREA : cv::INTER_LINEAR;
+    if (spec.pad_left + spec.pad_top + spec.pad_right + spec.pad_bottom > 0) {
+      cv::Mat intermediate_mat;
+      cv::resize(input_mat, intermediate_mat,
+                 cv::Size(spec.scaled_width, spec.scaled_height), 0, 0,
+                 scale_flag);
+      cv::copyMakeBorder(intermediate_mat, scaled_mat, spec.pad_top,
+                         spec.pad_bottom, spec.pad_left, spec.pad_right,
+                         spec.constant_padding ? cv::BORDER_CONSTANT
+                                               : cv::BORDER_REPLICATE);
+    } else {
+      cv::resize(input_mat, scaled_mat,
+                 cv::Size(spec.scaled_width, spec.scaled_height), 0, 0,
+                 scale_flag);
+    }
+    input_mat = scaled_mat;
+  }
+
   cv::Mat rotated_mat;
-  cv::Size rotated_size(output_width, output_height);
-  if (input_mat.size() == rotated_size) {
-    const int angle = RotationModeToDegrees(rotation_);
+  if (spec.rotate_about_center) {
     cv::Point2f src_center(input_mat.cols / 2.0, input_mat.rows / 2.0);
-    cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
-    cv::warpAffine(input_mat, rotated_mat, rotation_mat, rotated_size);
+    cv::Mat rotation_mat =
+        cv::getRotationMatrix2D(src_center, spec.rotation_degrees, 1.0);
+    cv::warpAffine(input_mat, rotated_mat, rotation_mat, input_mat.size());
   } else {
-    switch (rotation_) {
-      case mediapipe::RotationMode_Mode_UNKNOWN:
-      case mediapipe::RotationMode_Mode_ROTATION_0:
+    switch (spec.rotation_degrees) {
+      case 0:
         rotated_mat = input_mat;
         break;
-      case mediapipe::RotationMode_Mode_ROTATION_90:
+      case 90:
         cv::rotate(input_mat, rotated_mat, cv::ROTATE_90_COUNTERCLOCKWISE);
         break;
-      case mediapipe::RotationMode_Mode_ROTATION_180:
+      case 180:
         cv::rotate(input_mat, rotated_mat, cv::ROTATE_180);
         break;
-      case mediapipe::RotationMode_Mode_ROTATION_270:
+      case 270:
         cv::rotate(input_mat, rotated_mat, cv::ROTATE_90_CLOCKWISE);
         break;
     }
   }
 
   cv::Mat flipped_mat;
-  if (flip_horizontally_ || flip_vertically_) {
-    const int flip_code =
-        flip_horizontally_ && flip_vertically_ ? -1 : flip_horizontally_;
+  if (spec.flip_horizontally || spec.flip_vertically) {
+    const int flip_code = spec.flip_horizontally && spec.flip_vertically
+                              ? -1
+                              : spec.flip_horizontally;
     cv::flip(rotated_mat, flipped_mat, flip_code);
   } else {
     flipped_mat = rotated_mat;
   }
 
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(format, output_width, output_height));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
+  cv::Mat output_mat = formats::MatView(output);
   flipped_mat.copyTo(output_mat);
-  cc->Outputs()
-      .Tag(kImageFrameTag)
-      .Add(output_frame.release(), cc->InputTimestamp());
-
-  return absl::OkStatus();
 }
 
 absl::Status ImageTransformationCalculator::RenderGpu(CalculatorContext* cc) {
@@ -0,0 +1,128 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures ImageTransformationCalculator on a 1080p SRGB image with the
+// OpenCV and the fused CPU implementations: scaling to 256x256 in each scale
+// mode, with a horizontal flip as for a front camera, and rotating the full
+// image by 90 degrees.
+//
+// bazel run -c opt \
+//   //mediapipe/calculators/image:image_transformation_calculator_benchmark
+
+#include <memory>
+#include <random>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kImageWidth = 1920;
+constexpr int kImageHeight = 1080;
+
+// |options| are the ImageTransformationCalculatorOptions besides
+// cpu_implementation.
+void BM_ImageTransformation(benchmark::State& state,
+                            const char* cpu_implementation,
+                            const char* options) {
+  CalculatorGraph graph;
+  CHECK(graph
+            .Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(
+                absl::Substitute(R"(
+                  input_stream: "input"
+                  node {
+                    calculator: "ImageTransformationCalculator"
+                    input_stream: "IMAGE:input"
+                    output_stream: "IMAGE:output"
+                    options {
+                      [mediapipe.ImageTransformationCalculatorOptions.ext] {
+                        $0
+                        cpu_implementation: $1
+                      }
+                    }
+                  }
+                )",
+                                 options, cpu_implementation)))
+            .ok());
+  int num_outputs = 0;
+  CHECK(graph
+            .ObserveOutputStream("output",
+                                 [&num_outputs](const Packet&) {
+                                   ++num_outputs;
+                                   return absl::OkStatus();
+                                 })
+            .ok());
+  CHECK(graph.StartRun({}).ok());
+
+  auto image = absl::make_unique<ImageFrame>(ImageFormat::SRGB, kImageWidth,
+                                            kImageHeight);
+  std::mt19937 rng(42);
+  for (int y = 0; y < kImageHeight; ++y) {
+    uint8* row = image->MutablePixelData() + y * image->WidthStep();
+    for (int x = 0; x < kImageWidth * 3; ++x) {
+      row[x] = rng();
+    }
+  }
+  Packet image_packet = Adopt(image.release());
+
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    CHECK(graph
+              .AddPacketToInputStream("input",
+                                      image_packet.At(Timestamp(timestamp)))
+              .ok());
+    CHECK(graph.WaitUntilIdle().ok());
+    ++timestamp;
+  }
+  CHECK_EQ(num_outputs, timestamp);
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+}
+
+constexpr char kStretch[] =
+    "output_width: 256 output_height: 256 scale_mode: STRETCH "
+    "flip_horizontally: true";
+constexpr char kFit[] =
+    "output_width: 256 output_height: 256 scale_mode: FIT "
+    "flip_horizontally: true";
+constexpr char kFillAndCrop[] =
+    "output_width: 256 output_height: 256 scale_mode: FILL_AND_CROP "
+    "flip_horizontally: true";
+constexpr char kRotate90[] = "rotation_mode: ROTATION_90";
+
+BENCHMARK_CAPTURE(BM_ImageTransformation, OpenCvStretch,
+                  "CPU_IMPLEMENTATION_OPENCV", kStretch);
+BENCHMARK_CAPTURE(BM_ImageTransformation, FusedStretch,
+                  "CPU_IMPLEMENTATION_FUSED", kStretch);
+BENCHMARK_CAPTURE(BM_ImageTransformation, OpenCvFit,
+                  "CPU_IMPLEMENTATION_OPENCV", kFit);
+BENCHMARK_CAPTURE(BM_ImageTransformation, FusedFit, "CPU_IMPLEMENTATION_FUSED",
+                  kFit);
+BENCHMARK_CAPTURE(BM_ImageTransformation, OpenCvFillAndCrop,
+                  "CPU_IMPLEMENTATION_OPENCV", kFillAndCrop);
+BENCHMARK_CAPTURE(BM_ImageTransformation, FusedFillAndCrop,
+                  "CPU_IMPLEMENTATION_FUSED", kFillAndCrop);
+BENCHMARK_CAPTURE(BM_ImageTransformation, OpenCvRotate90,
+                  "CPU_IMPLEMENTATION_OPENCV", kRotate90);
+BENCHMARK_CAPTURE(BM_ImageTransformation, FusedRotate90,
+                  "CPU_IMPLEMENTATION_FUSED", kRotate90);
+
+}  // namespace
+}  // namespace mediapipe
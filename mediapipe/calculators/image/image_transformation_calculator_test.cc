@@ -0,0 +1,203 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+struct TransformationParams {
+  int output_width;
+  int output_height;
+  std::string scale_mode;
+  std::string rotation_mode;
+  bool flip_horizontally;
+  bool flip_vertically;
+  bool constant_padding;
+};
+
+Packet MakeInputFrame(ImageFormat::Format format, int width, int height) {
+  auto frame = absl::make_unique<ImageFrame>(format, width, height);
+  std::mt19937 rng(width * 1000 + height);
+  // A gradient with noise, so that both smooth content and edges are
+  // resampled.
+  for (int y = 0; y < height; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width * frame->NumberOfChannels(); ++x) {
+      row[x] = (x + 3 * y + rng() % 32) & 0xff;
+    }
+  }
+  return Adopt(frame.release()).At(Timestamp(0));
+}
+
+ImageFrame RunTransformation(const Packet& input,
+                             const TransformationParams& params,
+                             const std::string& cpu_implementation) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::Substitute(R"(
+        calculator: "ImageTransformationCalculator"
+        input_stream: "IMAGE:input"
+        output_stream: "IMAGE:output"
+        options {
+          [mediapipe.ImageTransformationCalculatorOptions.ext] {
+            output_width: $0
+            output_height: $1
+            scale_mode: $2
+            rotation_mode: $3
+            flip_horizontally: $4
+            flip_vertically: $5
+            constant_padding: $6
+            cpu_implementation: $7
+          }
+        }
+      )",
+                       params.output_width, params.output_height,
+                       params.scale_mode, params.rotation_mode,
+                       params.flip_horizontally, params.flip_vertically,
+                       params.constant_padding, cpu_implementation)));
+  runner.MutableInputs()->Tag("IMAGE").packets.push_back(input);
+  MP_EXPECT_OK(runner.Run());
+  ImageFrame output;
+  const auto& packets = runner.Outputs().Tag("IMAGE").packets;
+  EXPECT_EQ(packets.size(), 1);
+  if (!packets.empty()) {
+    output.CopyFrom(packets[0].Get<ImageFrame>(), 1);
+  }
+  return output;
+}
+
+// Returns the largest difference between corresponding channel values.
+int MaxDifference(const ImageFrame& a, const ImageFrame& b) {
+  int max_diff = 0;
+  for (int y = 0; y < a.Height(); ++y) {
+    const uint8* row_a = a.PixelData() + y * a.WidthStep();
+    const uint8* row_b = b.PixelData() + y * b.WidthStep();
+    for (int x = 0; x < a.Width() * a.NumberOfChannels(); ++x) {
+      max_diff = std::max(max_diff, std::abs(row_a[x] - row_b[x]));
+    }
+  }
+  return max_diff;
+}
+
+TEST(ImageTransformationCalculatorTest, FusedCpuMatchesOpenCv) {
+  const Packet inputs[] = {MakeInputFrame(ImageFormat::SRGB, 64, 48),
+                           MakeInputFrame(ImageFormat::SRGBA, 37, 53),
+                           MakeInputFrame(ImageFormat::GRAY8, 200, 120)};
+  const std::pair<int, int> output_sizes[] = {
+      {0, 0}, {32, 32}, {50, 30}, {97, 61}, {300, 150}};
+  for (const Packet& input : inputs) {
+    for (const auto& size : output_sizes) {
+      for (const char* scale_mode : {"STRETCH", "FIT", "FILL_AND_CROP"}) {
+        for (const char* rotation_mode :
+             {"ROTATION_0", "ROTATION_90", "ROTATION_180", "ROTATION_270"}) {
+          for (int flip = 0; flip < 4; ++flip) {
+            TransformationParams params;
+            params.output_width = size.first;
+            params.output_height = size.second;
+            params.scale_mode = scale_mode;
+            params.rotation_mode = rotation_mode;
+            params.flip_horizontally = (flip & 1) != 0;
+            params.flip_vertically = (flip & 2) != 0;
+            params.constant_padding = flip != 3;
+            const ImageFrame expected = RunTransformation(
+                input, params, "CPU_IMPLEMENTATION_OPENCV");
+            const ImageFrame result =
+                RunTransformation(input, params, "CPU_IMPLEMENTATION_FUSED");
+            ASSERT_EQ(result.Width(), expected.Width());
+            ASSERT_EQ(result.Height(), expected.Height());
+            ASSERT_EQ(result.Format(), expected.Format());
+            // OpenCV rounds the intermediate images.
+            EXPECT_LE(MaxDifference(result, expected), 1)
+                << input.Get<ImageFrame>().Width() << " " << size.first
+                << "x" << size.second << " " << scale_mode << " "
+                << rotation_mode << " " << flip;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Flips |input| horizontally and vertically in a graph, and returns the
+// output packet. The graph holds the only reference to the input frame unless
+// the caller keeps one.
+Packet RunFlipInGraph(Packet input) {
+  CalculatorGraph graph(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "ImageTransformationCalculator"
+      input_stream: "IMAGE:input"
+      output_stream: "IMAGE:output"
+      options {
+        [mediapipe.ImageTransformationCalculatorOptions.ext] {
+          flip_horizontally: true
+          flip_vertically: true
+        }
+      }
+    }
+  )pb"));
+  Packet output;
+  MP_EXPECT_OK(graph.ObserveOutputStream("output", [&output](const Packet& p) {
+    output = p;
+    return absl::OkStatus();
+  }));
+  MP_EXPECT_OK(graph.StartRun({}));
+  MP_EXPECT_OK(graph.AddPacketToInputStream("input", std::move(input)));
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+  return output;
+}
+
+TEST(ImageTransformationCalculatorTest, FlipsSoleInputInPlace) {
+  Packet input = MakeInputFrame(ImageFormat::SRGB, 64, 48);
+  const ImageFrame& frame = input.Get<ImageFrame>();
+  const uint8* input_data = frame.PixelData();
+  ImageFrame expected(frame.Format(), frame.Width(), frame.Height());
+  for (int y = 0; y < frame.Height(); ++y) {
+    const uint8* src =
+        input_data + (frame.Height() - 1 - y) * frame.WidthStep();
+    uint8* dst = expected.MutablePixelData() + y * expected.WidthStep();
+    for (int x = 0; x < frame.Width(); ++x) {
+      std::copy_n(src + (frame.Width() - 1 - x) * 3, 3, dst + x * 3);
+    }
+  }
+
+  // The test keeps a reference to the input, so the output is a new frame.
+  Packet output = RunFlipInGraph(input);
+  ASSERT_FALSE(output.IsEmpty());
+  EXPECT_NE(output.Get<ImageFrame>().PixelData(), input_data);
+  EXPECT_EQ(MaxDifference(output.Get<ImageFrame>(), expected), 0);
+
+  // Otherwise the input frame is flipped in place, and no frame is allocated.
+  output = RunFlipInGraph(std::move(input));
+  ASSERT_FALSE(output.IsEmpty());
+  EXPECT_EQ(output.Get<ImageFrame>().PixelData(), input_data);
+  EXPECT_EQ(MaxDifference(output.Get<ImageFrame>(), expected), 0);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,519 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/image/image_transformation_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "mediapipe/framework/port/ret_check.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MEDIAPIPE_IMAGE_TRANSFORMATION_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MEDIAPIPE_IMAGE_TRANSFORMATION_NEON 1
+#endif
+
+namespace mediapipe {
+
+namespace {
+
+// All steps of the transformation keep rows and columns aligned with the
+// input axes. Every input x coordinate is mapped from the same output
+// coordinate: the output column, or the output row if rotated by 90 or 270
+// degrees. The input pixels an output pixel depends on are the product of
+// the taps along input x and the taps along input y.
+struct Tap {
+  int index;
+  float weight;
+};
+
+// Taps along one input axis of every value of the output coordinate mapped
+// to it.
+struct AxisTaps {
+  // Taps of output coordinate i are [begin[i], begin[i + 1]).
+  std::vector<int> begin;
+  std::vector<int> index;
+  std::vector<float> weight;
+  // Whether every output coordinate has at most one tap, of weight 1.
+  bool is_copy = true;
+
+  int size() const { return begin.size() - 1; }
+};
+
+// Geometry of steps 1 and 2 along one input axis.
+struct AxisGeometry {
+  int input_size;
+  int scaled_size;
+  int pad_before;
+  int padded_size;
+};
+
+// Appends the taps of coordinate |s| of the scaled image, as computed by
+// cv::resize.
+void AppendResizeTaps(int s, const AxisGeometry& axis, bool area, float weight,
+                      std::vector<Tap>* taps) {
+  if (axis.scaled_size == axis.input_size) {
+    taps->push_back({s, weight});
+    return;
+  }
+  const double scale = static_cast<double>(axis.input_size) / axis.scaled_size;
+  if (!area) {
+    float fx = static_cast<float>((s + 0.5) * scale - 0.5);
+    int sx = static_cast<int>(std::floor(fx));
+    fx -= sx;
+    if (sx < 0) {
+      fx = 0.0f;
+      sx = 0;
+    }
+    if (sx >= axis.input_size - 1) {
+      fx = 0.0f;
+      sx = axis.input_size - 1;
+    }
+    taps->push_back({sx, weight * (1.0f - fx)});
+    if (fx > 0.0f) {
+      taps->push_back({sx + 1, weight * fx});
+    }
+    return;
+  }
+  // Area interpolation averages the input pixels covered by the scaled
+  // pixel, weighted by the covered fraction.
+  const double fsx1 = s * scale;
+  const double fsx2 = fsx1 + scale;
+  int sx2 = std::min(static_cast<int>(std::floor(fsx2)), axis.input_size - 1);
+  int sx1 = std::min(static_cast<int>(std::ceil(fsx1)), sx2);
+  const double cell_width = std::min(scale, axis.input_size - fsx1);
+  if (sx1 - fsx1 > 1e-3) {
+    taps->push_back(
+        {sx1 - 1, static_cast<float>(weight * (sx1 - fsx1) / cell_width)});
+  }
+  for (int sx = sx1; sx < sx2; ++sx) {
+    taps->push_back({sx, static_cast<float>(weight / cell_width)});
+  }
+  if (fsx2 - sx2 > 1e-3) {
+    const double covered = std::min(std::min(fsx2 - sx2, 1.0), cell_width);
+    taps->push_back({sx2, static_cast<float>(weight * covered / cell_width)});
+  }
+}
+
+// Appends the taps of coordinate |p| of the padded image.
+void AppendPaddedTaps(int p, const AxisGeometry& axis,
+                      const ImageTransformationSpec& spec, float weight,
+                      std::vector<Tap>* taps) {
+  int s = p - axis.pad_before;
+  if (s < 0 || s >= axis.scaled_size) {
+    if (spec.constant_padding) return;
+    s = std::min(std::max(s, 0), axis.scaled_size - 1);
+  }
+  AppendResizeTaps(s, axis, spec.area_interpolation, weight, taps);
+}
+
+// Computes the taps of the |size| output coordinates that are mapped to
+// coordinate sign * i + offset of the padded image along |axis|.
+AxisTaps GetAxisTaps(int size, float sign, float offset,
+                     const AxisGeometry& axis,
+                     const ImageTransformationSpec& spec) {
+  AxisTaps result;
+  result.begin.reserve(size + 1);
+  std::vector<Tap> taps;
+  for (int i = 0; i < size; ++i) {
+    result.begin.push_back(result.index.size());
+    taps.clear();
+    const float q = sign * i + offset;
+    if (spec.rotate_about_center) {
+      // Bilinear interpolation with a zero border, as cv::warpAffine. The
+      // rotation center can be between two pixels.
+      const int q0 = static_cast<int>(std::floor(q));
+      const float f = q - q0;
+      if (q0 >= 0 && q0 < axis.padded_size) {
+        AppendPaddedTaps(q0, axis, spec, 1.0f - f, &taps);
+      }
+      if (f > 0.0f && q0 + 1 >= 0 && q0 + 1 < axis.padded_size) {
+        AppendPaddedTaps(q0 + 1, axis, spec, f, &taps);
+      }
+    } else {
+      AppendPaddedTaps(static_cast<int>(q), axis, spec, 1.0f, &taps);
+    }
+    if (taps.size() > 1 || (taps.size() == 1 && taps[0].weight != 1.0f)) {
+      result.is_copy = false;
+    }
+    for (const Tap& tap : taps) {
+      result.index.push_back(tap.index);
+      result.weight.push_back(tap.weight);
+    }
+  }
+  result.begin.push_back(result.index.size());
+  return result;
+}
+
+// Returns the offsets of the taps along one axis, with one tap or none per
+// output coordinate, in units of |stride| bytes. Coordinates without taps
+// have offset -1.
+std::vector<int> GetCopyOffsets(const AxisTaps& taps, int stride) {
+  std::vector<int> offsets(taps.size());
+  for (int i = 0; i < taps.size(); ++i) {
+    offsets[i] = taps.begin[i] == taps.begin[i + 1]
+                     ? -1
+                     : taps.index[taps.begin[i]] * stride;
+  }
+  return offsets;
+}
+
+// Copies input pixels for transformations without resampling, such as pure
+// rotations and flips. Empty taps give zero pixels.
+template <int kChannels>
+void CopyPixels(const ImageFrame& input, const AxisTaps& x_taps,
+                const AxisTaps& y_taps, bool rotated, ImageFrame* output) {
+  const uint8_t* in = input.PixelData();
+  uint8_t* out = output->MutablePixelData();
+  const int out_step = output->WidthStep();
+  const std::vector<int> x_offsets = GetCopyOffsets(x_taps, kChannels);
+  const std::vector<int> y_offsets = GetCopyOffsets(y_taps, input.WidthStep());
+  auto copy_pixel = [](const uint8_t* src, uint8_t* dst) {
+    for (int c = 0; c < kChannels; ++c) {
+      dst[c] = src[c];
+    }
+  };
+  if (!rotated) {
+    for (int y = 0; y < output->Height(); ++y) {
+      uint8_t* dst = out + y * out_step;
+      if (y_offsets[y] < 0) {
+        std::fill_n(dst, output->Width() * kChannels, 0);
+        continue;
+      }
+      const uint8_t* src = in + y_offsets[y];
+      for (int x = 0; x < output->Width(); ++x, dst += kChannels) {
+        if (x_offsets[x] < 0) {
+          std::fill_n(dst, kChannels, 0);
+        } else {
+          copy_pixel(src + x_offsets[x], dst);
+        }
+      }
+    }
+    return;
+  }
+  // Output rows read input columns. Copying a band of output rows column by
+  // column reads consecutive input pixels.
+  constexpr int kBandHeight = 16;
+  // For plain rotations, the input pixels of an output column are a fixed
+  // number of bytes apart. Otherwise x_stride is 0 and x_offsets are used.
+  int x_stride = x_offsets.size() > 1 ? x_offsets[1] - x_offsets[0] : 0;
+  for (int i = 0; i < x_offsets.size(); ++i) {
+    if (x_offsets[i] < 0 || x_offsets[i] != x_offsets[0] + i * x_stride) {
+      x_stride = 0;
+      break;
+    }
+  }
+  for (int y0 = 0; y0 < output->Height(); y0 += kBandHeight) {
+    const int y1 = std::min(y0 + kBandHeight, output->Height());
+    for (int x = 0; x < output->Width(); ++x) {
+      uint8_t* dst = out + y0 * out_step + x * kChannels;
+      if (y_offsets[x] < 0) {
+        for (int y = y0; y < y1; ++y, dst += out_step) {
+          std::fill_n(dst, kChannels, 0);
+        }
+        continue;
+      }
+      const uint8_t* src = in + y_offsets[x];
+      if (x_stride != 0) {
+        src += x_offsets[y0];
+        for (int y = y0; y < y1; ++y, dst += out_step, src += x_stride) {
+          copy_pixel(src, dst);
+        }
+        continue;
+      }
+      for (int y = y0; y < y1; ++y, dst += out_step) {
+        if (x_offsets[y] < 0) {
+          std::fill_n(dst, kChannels, 0);
+        } else {
+          copy_pixel(src + x_offsets[y], dst);
+        }
+      }
+    }
+  }
+}
+
+// Sets acc[i] = weight * src[i] for i in [0, size), or adds it to acc[i] if
+// |accumulate| is set.
+void WeightRow(const uint8_t* src, int size, float weight, bool accumulate,
+               float* acc) {
+  int i = 0;
+#if defined(MEDIAPIPE_IMAGE_TRANSFORMATION_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 w = _mm_set1_ps(weight);
+  for (; i + 16 <= size; i += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    __m128 v[4] = {_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+                   _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+                   _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)),
+                   _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))};
+    for (int k = 0; k < 4; ++k) {
+      v[k] = _mm_mul_ps(w, v[k]);
+      if (accumulate) v[k] = _mm_add_ps(_mm_loadu_ps(acc + i + 4 * k), v[k]);
+      _mm_storeu_ps(acc + i + 4 * k, v[k]);
+    }
+  }
+#elif defined(MEDIAPIPE_IMAGE_TRANSFORMATION_NEON)
+  const float32x4_t w = vdupq_n_f32(weight);
+  for (; i + 16 <= size; i += 16) {
+    const uint8x16_t bytes = vld1q_u8(src + i);
+    const uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+    const uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+    float32x4_t v[4] = {vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))),
+                        vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))),
+                        vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))),
+                        vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)))};
+    for (int k = 0; k < 4; ++k) {
+      v[k] = accumulate ? vmlaq_f32(vld1q_f32(acc + i + 4 * k), w, v[k])
+                        : vmulq_f32(w, v[k]);
+      vst1q_f32(acc + i + 4 * k, v[k]);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    acc[i] = accumulate ? acc[i] + weight * src[i] : weight * src[i];
+  }
+}
+
+// Resamples along input y and then along input x. For every output coordinate
+// along y, the input rows it depends on are combined into a line of floats,
+// which is then resampled along x. The first step, which takes the bulk of
+// the work when downscaling, runs over consecutive input bytes.
+template <int kChannels>
+void ResamplePixels(const ImageFrame& input, const AxisTaps& x_taps,
+                    const AxisTaps& y_taps, bool rotated, ImageFrame* output) {
+  // Only the input columns between the first and the last x tap are read.
+  int x_min = input.Width();
+  int x_max = 0;
+  for (int index : x_taps.index) {
+    x_min = std::min(x_min, index);
+    x_max = std::max(x_max, index + 1);
+  }
+  if (x_min >= x_max) x_min = x_max = 0;
+  const int line_size = (x_max - x_min) * kChannels;
+  std::vector<float> line(line_size);
+  // Offsets of the x taps in the line.
+  std::vector<int> x_offsets(x_taps.index.size());
+  for (int i = 0; i < x_offsets.size(); ++i) {
+    x_offsets[i] = (x_taps.index[i] - x_min) * kChannels;
+  }
+
+  uint8_t* out = output->MutablePixelData();
+  const int out_step = output->WidthStep();
+  for (int k2 = 0; k2 < y_taps.size(); ++k2) {
+    float* acc = line.data();
+    const int j_begin = y_taps.begin[k2];
+    const int j_end = y_taps.begin[k2 + 1];
+    if (j_begin == j_end) {
+      std::fill_n(acc, line_size, 0.0f);
+    }
+    for (int j = j_begin; j < j_end; ++j) {
+      const uint8_t* src = input.PixelData() +
+                           y_taps.index[j] * input.WidthStep() +
+                           x_min * kChannels;
+      WeightRow(src, line_size, y_taps.weight[j], j != j_begin, acc);
+    }
+    // Without rotation, k2 is the output row and the line is resampled
+    // along it. Otherwise, k2 is the output column.
+    uint8_t* dst = rotated ? out + k2 * kChannels : out + k2 * out_step;
+    const int dst_step = rotated ? out_step : kChannels;
+    for (int k = 0; k < x_taps.size(); ++k, dst += dst_step) {
+      float sum[kChannels] = {};
+      for (int i = x_taps.begin[k]; i < x_taps.begin[k + 1]; ++i) {
+        const float* p = acc + x_offsets[i];
+        const float w = x_taps.weight[i];
+        for (int c = 0; c < kChannels; ++c) {
+          sum[c] += w * p[c];
+        }
+      }
+      for (int c = 0; c < kChannels; ++c) {
+        dst[c] = static_cast<uint8_t>(
+            std::min(std::max(sum[c] + 0.5f, 0.0f), 255.0f));
+      }
+    }
+  }
+}
+
+template <int kChannels>
+void TransformPixels(const ImageFrame& input, const AxisTaps& x_taps,
+                     const AxisTaps& y_taps, bool rotated, ImageFrame* output) {
+  if (x_taps.is_copy && y_taps.is_copy) {
+    CopyPixels<kChannels>(input, x_taps, y_taps, rotated, output);
+  } else {
+    ResamplePixels<kChannels>(input, x_taps, y_taps, rotated, output);
+  }
+}
+
+}  // namespace
+
+void GetTransformedDimensions(const ImageTransformationSpec& spec, int* width,
+                              int* height) {
+  *width = spec.pad_left + spec.scaled_width + spec.pad_right;
+  *height = spec.pad_top + spec.scaled_height + spec.pad_bottom;
+  if (!spec.rotate_about_center &&
+      (spec.rotation_degrees == 90 || spec.rotation_degrees == 270)) {
+    std::swap(*width, *height);
+  }
+}
+
+bool IsFusedTransformationSupported(const ImageFrame& image) {
+  return image.ByteDepth() == 1;
+}
+
+bool IsInPlaceTransformation(const ImageTransformationSpec& spec, int width,
+                             int height) {
+  return spec.scaled_width == width && spec.scaled_height == height &&
+         spec.pad_left == 0 && spec.pad_top == 0 && spec.pad_right == 0 &&
+         spec.pad_bottom == 0 && spec.rotation_degrees == 0;
+}
+
+absl::Status TransformImageFrameInPlace(const ImageTransformationSpec& spec,
+                                        ImageFrame* image) {
+  RET_CHECK(IsInPlaceTransformation(spec, image->Width(), image->Height()));
+  const int pixel_size = image->NumberOfChannels() * image->ByteDepth();
+  const int row_size = image->Width() * pixel_size;
+  const int step = image->WidthStep();
+  uint8_t* data = image->MutablePixelData();
+  if (spec.flip_vertically) {
+    for (int y = 0; y < image->Height() / 2; ++y) {
+      uint8_t* top = data + y * step;
+      std::swap_ranges(top, top + row_size,
+                       data + (image->Height() - 1 - y) * step);
+    }
+  }
+  if (spec.flip_horizontally) {
+    for (int y = 0; y < image->Height(); ++y) {
+      uint8_t* left = data + y * step;
+      uint8_t* right = left + row_size - pixel_size;
+      for (; left < right; left += pixel_size, right -= pixel_size) {
+        std::swap_ranges(left, left + pixel_size, right);
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status TransformImageFrame(const ImageFrame& input,
+                                 const ImageTransformationSpec& spec,
+                                 ImageFrame* output) {
+  RET_CHECK(IsFusedTransformationSupported(input));
+  RET_CHECK_EQ(output->Format(), input.Format());
+  RET_CHECK(spec.rotation_degrees % 90 == 0 && spec.rotation_degrees >= 0 &&
+            spec.rotation_degrees < 360)
+      << "Unsupported rotation: " << spec.rotation_degrees;
+  int width;
+  int height;
+  GetTransformedDimensions(spec, &width, &height);
+  RET_CHECK(output->Width() == width && output->Height() == height);
+  RET_CHECK(spec.scaled_width > 0 && spec.scaled_height > 0);
+
+  const AxisGeometry x_axis{input.Width(), spec.scaled_width, spec.pad_left,
+                            spec.pad_left + spec.scaled_width + spec.pad_right};
+  const AxisGeometry y_axis{input.Height(), spec.scaled_height, spec.pad_top,
+                            spec.pad_top + spec.scaled_height +
+                                spec.pad_bottom};
+  // Maps the output coordinates to coordinates of the padded image:
+  // padded x = x_sign * (output column or row) + x_offset, and likewise for
+  // padded y, which depends on the other output coordinate.
+  const float w = x_axis.padded_size;
+  const float h = y_axis.padded_size;
+  bool x_from_row = false;
+  float x_sign = 1.0f, x_offset = 0.0f, y_sign = 1.0f, y_offset = 0.0f;
+  if (spec.rotate_about_center) {
+    // The inverse of cv::getRotationMatrix2D about (w / 2, h / 2).
+    const float cx = w / 2.0f;
+    const float cy = h / 2.0f;
+    switch (spec.rotation_degrees) {
+      case 90:
+        x_from_row = true;
+        x_sign = -1.0f, x_offset = cx + cy;
+        y_offset = cy - cx;
+        break;
+      case 180:
+        x_sign = -1.0f, x_offset = 2.0f * cx;
+        y_sign = -1.0f, y_offset = 2.0f * cy;
+        break;
+      case 270:
+        x_from_row = true;
+        x_offset = cx - cy;
+        y_sign = -1.0f, y_offset = cx + cy;
+        break;
+    }
+  } else {
+    // cv::rotate.
+    switch (spec.rotation_degrees) {
+      case 90:
+        x_from_row = true;
+        x_sign = -1.0f, x_offset = w - 1.0f;
+        break;
+      case 180:
+        x_sign = -1.0f, x_offset = w - 1.0f;
+        y_sign = -1.0f, y_offset = h - 1.0f;
+        break;
+      case 270:
+        x_from_row = true;
+        y_sign = -1.0f, y_offset = h - 1.0f;
+        break;
+    }
+  }
+  // Flipping the output coordinate i of a dimension of size n maps it to
+  // n - 1 - i.
+  auto flip = [](int n, float* sign, float* offset) {
+    *offset += *sign * (n - 1);
+    *sign = -*sign;
+  };
+  if (spec.flip_horizontally) {
+    if (x_from_row) {
+      flip(width, &y_sign, &y_offset);
+    } else {
+      flip(width, &x_sign, &x_offset);
+    }
+  }
+  if (spec.flip_vertically) {
+    if (x_from_row) {
+      flip(height, &x_sign, &x_offset);
+    } else {
+      flip(height, &y_sign, &y_offset);
+    }
+  }
+
+  const AxisTaps x_taps = GetAxisTaps(x_from_row ? height : width, x_sign,
+                                      x_offset, x_axis, spec);
+  const AxisTaps y_taps = GetAxisTaps(x_from_row ? width : height, y_sign,
+                                      y_offset, y_axis, spec);
+  const int channels = input.NumberOfChannels();
+  switch (channels) {
+    case 1:
+      TransformPixels<1>(input, x_taps, y_taps, x_from_row, output);
+      break;
+    case 3:
+      TransformPixels<3>(input, x_taps, y_taps, x_from_row, output);
+      break;
+    case 4:
+      TransformPixels<4>(input, x_taps, y_taps, x_from_row, output);
+      break;
+    default:
+      RET_CHECK_FAIL() << "Unsupported number of channels: " << channels;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,81 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_IMAGE_IMAGE_TRANSFORMATION_CPU_H_
+#define MEDIAPIPE_CALCULATORS_IMAGE_IMAGE_TRANSFORMATION_CPU_H_
+
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// The CPU transformation of ImageTransformationCalculator, described as the
+// steps of its OpenCV implementation:
+//   1. The input is resized to scaled_width x scaled_height, with area
+//      interpolation if area_interpolation is set and bilinear interpolation
+//      otherwise (cv::resize).
+//   2. The scaled image is padded by pad_left, pad_top, pad_right and
+//      pad_bottom pixels, with zeros if constant_padding is set and by
+//      replicating the border pixels otherwise (cv::copyMakeBorder).
+//   3. The padded image is rotated counterclockwise by rotation_degrees, a
+//      multiple of 90. If rotate_about_center is set, the rotation is about
+//      the image center into an image of the same size, and pixels that come
+//      from outside the padded image are zero (cv::warpAffine). Otherwise
+//      the whole image is rotated (cv::rotate).
+//   4. The rotated image is flipped (cv::flip).
+struct ImageTransformationSpec {
+  int scaled_width = 0;
+  int scaled_height = 0;
+  bool area_interpolation = false;
+  int pad_left = 0;
+  int pad_top = 0;
+  int pad_right = 0;
+  int pad_bottom = 0;
+  bool constant_padding = true;
+  int rotation_degrees = 0;
+  bool rotate_about_center = false;
+  bool flip_horizontally = false;
+  bool flip_vertically = false;
+};
+
+// Returns the dimensions of the image that results from |spec|.
+void GetTransformedDimensions(const ImageTransformationSpec& spec, int* width,
+                              int* height);
+
+// Returns true if TransformImageFrame() supports the format of |image|, i.e.
+// if it has one byte per channel.
+bool IsFusedTransformationSupported(const ImageFrame& image);
+
+// Returns true if |spec| only flips an image of |width| x |height| pixels, or
+// leaves it unchanged, so that TransformImageFrameInPlace() can run it.
+bool IsInPlaceTransformation(const ImageTransformationSpec& spec, int width,
+                             int height);
+
+// Runs |spec|, for which IsInPlaceTransformation() is true, by swapping the
+// pixels of |image|. Supports all formats.
+absl::Status TransformImageFrameInPlace(const ImageTransformationSpec& spec,
+                                        ImageFrame* image);
+
+// Runs all the steps of |spec| in a single pass over |output|. Every output
+// pixel is computed directly from the input pixels it depends on, without
+// intermediate images. |output| must have the input format and the
+// dimensions returned by GetTransformedDimensions(). The result matches the
+// OpenCV implementation up to rounding.
+absl::Status TransformImageFrame(const ImageFrame& input,
+                                 const ImageTransformationSpec& spec,
+                                 ImageFrame* output);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_IMAGE_IMAGE_TRANSFORMATION_CPU_H_
@@ -0,0 +1,402 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/image/mask_blend_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MEDIAPIPE_MASK_BLEND_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MEDIAPIPE_MASK_BLEND_NEON 1
+#endif
+
+namespace mediapipe {
+
+namespace {
+
+// Luminance weights of RecolorCalculator, divided by 255.
+constexpr float kLumaR = 0.299f / 255.0f;
+constexpr float kLumaG = 0.587f / 255.0f;
+constexpr float kLumaB = 0.114f / 255.0f;
+
+// Returns the position and the weight of the right neighbor of the bilinear
+// sample of output coordinate |i|, as computed by cv::resize().
+void GetLinearTap(int i, double scale, int input_size, int* index,
+                  float* weight) {
+  float f = static_cast<float>((i + 0.5) * scale - 0.5);
+  int s = static_cast<int>(std::floor(f));
+  f -= s;
+  if (s < 0) {
+    s = 0;
+    f = 0;
+  }
+  if (s >= input_size - 1) {
+    s = input_size - 1;
+    f = 0;
+  }
+  *index = s;
+  *weight = f;
+}
+
+template <typename T>
+void InterpolateMaskRow(const T* src, int channels, int channel,
+                        const std::vector<int>& x0, const std::vector<int>& x1,
+                        const std::vector<float>& fx, float scale,
+                        float* dst) {
+  for (int x = 0; x < static_cast<int>(fx.size()); ++x) {
+    const float v0 = src[x0[x] * channels + channel];
+    const float v1 = src[x1[x] * channels + channel];
+    dst[x] = (v0 * (1.0f - fx[x]) + v1 * fx[x]) * scale;
+  }
+}
+
+uint8_t RoundToByte(float value) {
+  return static_cast<uint8_t>(
+      std::min(std::max(std::lrint(value), 0L), 255L));
+}
+
+#if defined(MEDIAPIPE_MASK_BLEND_SSE2)
+// Loads 16 SRGB pixels as one vector per channel.
+inline void LoadRgb(const uint8_t* ptr, __m128i* r, __m128i* g, __m128i* b) {
+  const __m128i t00 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+  const __m128i t01 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 16));
+  const __m128i t02 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 32));
+  const __m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+  const __m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+  const __m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+  const __m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+  const __m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+  const __m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+  const __m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+  const __m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+  const __m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+  *r = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+  *g = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+  *b = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+}
+
+// Stores 16 SRGB pixels from one vector per channel.
+inline void StoreRgb(uint8_t* ptr, __m128i r, __m128i g, __m128i b) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rg0 = _mm_unpacklo_epi8(r, g);
+  const __m128i rg1 = _mm_unpackhi_epi8(r, g);
+  const __m128i b0 = _mm_unpacklo_epi8(b, zero);
+  const __m128i b1 = _mm_unpackhi_epi8(b, zero);
+  const __m128i p00 = _mm_unpacklo_epi16(rg0, b0);
+  const __m128i p01 = _mm_unpackhi_epi16(rg0, b0);
+  const __m128i p02 = _mm_unpacklo_epi16(rg1, b1);
+  const __m128i p03 = _mm_unpackhi_epi16(rg1, b1);
+  const __m128i p10 = _mm_unpacklo_epi32(p00, p01);
+  const __m128i p11 = _mm_unpackhi_epi32(p00, p01);
+  const __m128i p12 = _mm_unpacklo_epi32(p02, p03);
+  const __m128i p13 = _mm_unpackhi_epi32(p02, p03);
+  const __m128i p20 = _mm_slli_si128(_mm_unpacklo_epi64(p10, p11), 1);
+  const __m128i p21 = _mm_unpackhi_epi64(p10, p11);
+  const __m128i p22 = _mm_slli_si128(_mm_unpacklo_epi64(p12, p13), 1);
+  const __m128i p23 = _mm_unpackhi_epi64(p12, p13);
+  const __m128i p30 = _mm_slli_epi64(_mm_unpacklo_epi32(p20, p21), 8);
+  const __m128i p31 = _mm_srli_epi64(_mm_unpackhi_epi32(p20, p21), 8);
+  const __m128i p32 = _mm_slli_epi64(_mm_unpacklo_epi32(p22, p23), 8);
+  const __m128i p33 = _mm_srli_epi64(_mm_unpackhi_epi32(p22, p23), 8);
+  const __m128i p40 = _mm_unpacklo_epi64(p30, p31);
+  const __m128i p41 = _mm_unpackhi_epi64(p30, p31);
+  const __m128i p42 = _mm_unpacklo_epi64(p32, p33);
+  const __m128i p43 = _mm_unpackhi_epi64(p32, p33);
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(ptr),
+      _mm_or_si128(_mm_srli_si128(p40, 2), _mm_slli_si128(p41, 10)));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(ptr + 16),
+      _mm_or_si128(_mm_srli_si128(p41, 6), _mm_slli_si128(p42, 6)));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(ptr + 32),
+      _mm_or_si128(_mm_srli_si128(p42, 10), _mm_slli_si128(p43, 2)));
+}
+
+// Converts 16 bytes to 4 vectors of floats.
+inline void BytesToFloats(__m128i bytes, __m128 v[4]) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+  const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+  v[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+  v[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+  v[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+  v[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+}
+
+// Rounds 4 vectors of floats to 16 bytes, with saturation.
+inline __m128i FloatsToBytes(const __m128 v[4]) {
+  const __m128i lo =
+      _mm_packs_epi32(_mm_cvtps_epi32(v[0]), _mm_cvtps_epi32(v[1]));
+  const __m128i hi =
+      _mm_packs_epi32(_mm_cvtps_epi32(v[2]), _mm_cvtps_epi32(v[3]));
+  return _mm_packus_epi16(lo, hi);
+}
+#elif defined(MEDIAPIPE_MASK_BLEND_NEON)
+inline void BytesToFloats(uint8x16_t bytes, float32x4_t v[4]) {
+  const uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+  const uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+  v[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo)));
+  v[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo)));
+  v[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi)));
+  v[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)));
+}
+
+// Rounds 4 vectors of floats to 16 bytes, with saturation. Halves are
+// rounded up rather than to even.
+inline uint8x16_t FloatsToBytes(const float32x4_t v[4]) {
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  uint16x4_t u[4];
+  for (int k = 0; k < 4; ++k) {
+    u[k] = vqmovn_u32(vcvtq_u32_f32(vaddq_f32(vmaxq_f32(v[k], zero), half)));
+  }
+  return vcombine_u8(vqmovn_u16(vcombine_u16(u[0], u[1])),
+                     vqmovn_u16(vcombine_u16(u[2], u[3])));
+}
+#endif
+
+}  // namespace
+
+MaskRowSampler::MaskRowSampler(const ImageFrame& mask, int channel, int width,
+                               int height, float scale)
+    : mask_(mask),
+      channel_(channel),
+      width_(width),
+      height_(height),
+      scale_(scale),
+      x0_(width),
+      x1_(width),
+      fx_(width),
+      row_(width) {
+  const double scale_x = static_cast<double>(mask.Width()) / width;
+  for (int x = 0; x < width; ++x) {
+    GetLinearTap(x, scale_x, mask.Width(), &x0_[x], &fx_[x]);
+    x1_[x] = std::min(x0_[x] + 1, mask.Width() - 1);
+  }
+  mask_rows_[0].resize(width);
+  mask_rows_[1].resize(width);
+}
+
+const float* MaskRowSampler::GetMaskRow(int row, int keep_row) {
+  for (int i = 0; i < 2; ++i) {
+    if (cached_mask_row_[i] == row) return mask_rows_[i].data();
+  }
+  const int slot = cached_mask_row_[0] == keep_row ? 1 : 0;
+  cached_mask_row_[slot] = row;
+  float* dst = mask_rows_[slot].data();
+  const uint8* src = mask_.PixelData() + row * mask_.WidthStep();
+  if (mask_.ByteDepth() == 1) {
+    InterpolateMaskRow(src, mask_.NumberOfChannels(), channel_, x0_, x1_, fx_,
+                       scale_, dst);
+  } else {
+    InterpolateMaskRow(reinterpret_cast<const float*>(src),
+                       mask_.NumberOfChannels(), channel_, x0_, x1_, fx_,
+                       scale_, dst);
+  }
+  return dst;
+}
+
+const float* MaskRowSampler::GetRow(int y) {
+  return InterpolateRow(y, row_.data());
+}
+
+void MaskRowSampler::GetRow(int y, float* row) {
+  const float* values = InterpolateRow(y, row);
+  if (values != row) std::copy(values, values + width_, row);
+}
+
+const float* MaskRowSampler::InterpolateRow(int y, float* dst) {
+  int y0;
+  float fy;
+  GetLinearTap(y, static_cast<double>(mask_.Height()) / height_,
+               mask_.Height(), &y0, &fy);
+  const float* row0 = GetMaskRow(y0, -1);
+  if (fy == 0) return row0;
+  const float* row1 = GetMaskRow(y0 + 1, y0);
+  int x = 0;
+#if defined(MEDIAPIPE_MASK_BLEND_SSE2)
+  const __m128 w0 = _mm_set1_ps(1.0f - fy);
+  const __m128 w1 = _mm_set1_ps(fy);
+  for (; x + 4 <= width_; x += 4) {
+    _mm_storeu_ps(dst + x,
+                  _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row0 + x), w0),
+                             _mm_mul_ps(_mm_loadu_ps(row1 + x), w1)));
+  }
+#elif defined(MEDIAPIPE_MASK_BLEND_NEON)
+  const float32x4_t w0 = vdupq_n_f32(1.0f - fy);
+  const float32x4_t w1 = vdupq_n_f32(fy);
+  for (; x + 4 <= width_; x += 4) {
+    vst1q_f32(dst + x, vmlaq_f32(vmulq_f32(vld1q_f32(row0 + x), w0),
+                                 vld1q_f32(row1 + x), w1));
+  }
+#endif
+  for (; x < width_; ++x) {
+    dst[x] = row0[x] * (1.0f - fy) + row1[x] * fy;
+  }
+  return dst;
+}
+
+void RecolorRow(const uint8_t* input, const float* weight, int width,
+                const RecolorSpec& spec, uint8_t* output) {
+  int x = 0;
+#if defined(MEDIAPIPE_MASK_BLEND_SSE2)
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 luma[3] = {_mm_set1_ps(kLumaR), _mm_set1_ps(kLumaG),
+                          _mm_set1_ps(kLumaB)};
+  const __m128 color[3] = {_mm_set1_ps(spec.color[0]),
+                           _mm_set1_ps(spec.color[1]),
+                           _mm_set1_ps(spec.color[2])};
+  for (; x + 16 <= width; x += 16) {
+    __m128i bytes[3];
+    LoadRgb(input + 3 * x, &bytes[0], &bytes[1], &bytes[2]);
+    __m128 v[3][4];
+    for (int c = 0; c < 3; ++c) BytesToFloats(bytes[c], v[c]);
+    for (int k = 0; k < 4; ++k) {
+      __m128 mix = _mm_loadu_ps(weight + x + 4 * k);
+      if (spec.invert_mask) mix = _mm_sub_ps(one, mix);
+      if (spec.adjust_with_luminance) {
+        const __m128 luminance =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(v[0][k], luma[0]),
+                                  _mm_mul_ps(v[1][k], luma[1])),
+                       _mm_mul_ps(v[2][k], luma[2]));
+        mix = _mm_mul_ps(mix, luminance);
+      }
+      for (int c = 0; c < 3; ++c) {
+        v[c][k] = _mm_add_ps(
+            v[c][k], _mm_mul_ps(_mm_sub_ps(color[c], v[c][k]), mix));
+      }
+    }
+    StoreRgb(output + 3 * x, FloatsToBytes(v[0]), FloatsToBytes(v[1]),
+             FloatsToBytes(v[2]));
+  }
+#elif defined(MEDIAPIPE_MASK_BLEND_NEON)
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t color[3] = {vdupq_n_f32(spec.color[0]),
+                                vdupq_n_f32(spec.color[1]),
+                                vdupq_n_f32(spec.color[2])};
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x3_t bytes = vld3q_u8(input + 3 * x);
+    float32x4_t v[3][4];
+    for (int c = 0; c < 3; ++c) BytesToFloats(bytes.val[c], v[c]);
+    for (int k = 0; k < 4; ++k) {
+      float32x4_t mix = vld1q_f32(weight + x + 4 * k);
+      if (spec.invert_mask) mix = vsubq_f32(one, mix);
+      if (spec.adjust_with_luminance) {
+        float32x4_t luminance = vmulq_n_f32(v[0][k], kLumaR);
+        luminance = vmlaq_n_f32(luminance, v[1][k], kLumaG);
+        luminance = vmlaq_n_f32(luminance, v[2][k], kLumaB);
+        mix = vmulq_f32(mix, luminance);
+      }
+      for (int c = 0; c < 3; ++c) {
+        v[c][k] = vmlaq_f32(v[c][k], vsubq_f32(color[c], v[c][k]), mix);
+      }
+    }
+    for (int c = 0; c < 3; ++c) bytes.val[c] = FloatsToBytes(v[c]);
+    vst3q_u8(output + 3 * x, bytes);
+  }
+#endif
+  for (; x < width; ++x) {
+    const uint8_t* in = input + 3 * x;
+    float mix = spec.invert_mask ? 1.0f - weight[x] : weight[x];
+    if (spec.adjust_with_luminance) {
+      mix *= in[0] * kLumaR + in[1] * kLumaG + in[2] * kLumaB;
+    }
+    uint8_t* out = output + 3 * x;
+    for (int c = 0; c < 3; ++c) {
+      out[c] = RoundToByte(in[c] + (spec.color[c] - in[c]) * mix);
+    }
+  }
+}
+
+void SetAlphaRow(const uint8_t* input, int input_channels, const float* alpha,
+                 int width, uint8_t* output) {
+  int x = 0;
+#if defined(MEDIAPIPE_MASK_BLEND_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 16 <= width; x += 16) {
+    const __m128 alpha_floats[4] = {
+        _mm_loadu_ps(alpha + x), _mm_loadu_ps(alpha + x + 4),
+        _mm_loadu_ps(alpha + x + 8), _mm_loadu_ps(alpha + x + 12)};
+    const __m128i a = FloatsToBytes(alpha_floats);
+    __m128i r, g, b;
+    if (input_channels == 3) {
+      LoadRgb(input + 3 * x, &r, &g, &b);
+    } else {
+      // Replaces the alpha byte of each pixel.
+      const __m128i alpha_lo = _mm_unpacklo_epi8(zero, a);
+      const __m128i alpha_hi = _mm_unpackhi_epi8(zero, a);
+      const __m128i alpha_bytes[4] = {_mm_unpacklo_epi16(zero, alpha_lo),
+                                      _mm_unpackhi_epi16(zero, alpha_lo),
+                                      _mm_unpacklo_epi16(zero, alpha_hi),
+                                      _mm_unpackhi_epi16(zero, alpha_hi)};
+      const __m128i color_mask = _mm_set1_epi32(0x00ffffff);
+      for (int k = 0; k < 4; ++k) {
+        const __m128i pixels = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(input + 4 * (x + 4 * k)));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output + 4 * (x + 4 * k)),
+            _mm_or_si128(_mm_and_si128(pixels, color_mask), alpha_bytes[k]));
+      }
+      continue;
+    }
+    const __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+    const __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+    const __m128i ba_lo = _mm_unpacklo_epi8(b, a);
+    const __m128i ba_hi = _mm_unpackhi_epi8(b, a);
+    uint8_t* out = output + 4 * x;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_unpacklo_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+                     _mm_unpackhi_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 32),
+                     _mm_unpacklo_epi16(rg_hi, ba_hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 48),
+                     _mm_unpackhi_epi16(rg_hi, ba_hi));
+  }
+#elif defined(MEDIAPIPE_MASK_BLEND_NEON)
+  for (; x + 16 <= width; x += 16) {
+    const float32x4_t alpha_floats[4] = {
+        vld1q_f32(alpha + x), vld1q_f32(alpha + x + 4),
+        vld1q_f32(alpha + x + 8), vld1q_f32(alpha + x + 12)};
+    uint8x16x4_t pixels;
+    if (input_channels == 3) {
+      const uint8x16x3_t rgb = vld3q_u8(input + 3 * x);
+      pixels.val[0] = rgb.val[0];
+      pixels.val[1] = rgb.val[1];
+      pixels.val[2] = rgb.val[2];
+    } else {
+      pixels = vld4q_u8(input + 4 * x);
+    }
+    pixels.val[3] = FloatsToBytes(alpha_floats);
+    vst4q_u8(output + 4 * x, pixels);
+  }
+#endif
+  for (; x < width; ++x) {
+    const uint8_t* in = input + input_channels * x;
+    uint8_t* out = output + 4 * x;
+    out[0] = in[0];
+    out[1] = in[1];
+    out[2] = in[2];
+    out[3] = RoundToByte(alpha[x]);
+  }
+}
+
+}  // namespace mediapipe
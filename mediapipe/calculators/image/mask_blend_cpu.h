@@ -0,0 +1,100 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_IMAGE_MASK_BLEND_CPU_H_
+#define MEDIAPIPE_CALCULATORS_IMAGE_MASK_BLEND_CPU_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "mediapipe/framework/formats/image_frame.h"
+
+namespace mediapipe {
+
+// The CPU kernels of RecolorCalculator and SetAlphaCalculator, which blend an
+// image with a mask that may have a lower resolution than the image. The
+// mask is upsampled one row at a time while blending, so no full resolution
+// copy of the mask is made. MaskRowSampler also upsamples the CPU masks of
+// TensorsToSegmentationCalculator.
+
+// Samples one channel of a mask at the resolution of an image, with the
+// bilinear interpolation of cv::resize() with cv::INTER_LINEAR. The mask may
+// have one byte or one float per channel. Each mask row is interpolated
+// horizontally once, and each image row is a vertical interpolation of two
+// such rows.
+class MaskRowSampler {
+ public:
+  // Samples |channel| of |mask| at width x height. The sampled values are
+  // the mask values multiplied by |scale|. |mask| must outlive the sampler.
+  MaskRowSampler(const ImageFrame& mask, int channel, int width, int height,
+                 float scale);
+
+  // Returns the width values of image row |y|. The values remain valid until
+  // the next call.
+  const float* GetRow(int y);
+
+  // Writes the width values of image row |y| to |row|.
+  void GetRow(int y, float* row);
+
+ private:
+  // Returns image row |y|, which is either written to |row| or a cached mask
+  // row.
+  const float* InterpolateRow(int y, float* row);
+
+  // Returns mask row |row| interpolated horizontally. The cached row
+  // |keep_row| is not evicted.
+  const float* GetMaskRow(int row, int keep_row);
+
+  const ImageFrame& mask_;
+  const int channel_;
+  const int width_;
+  const int height_;
+  const float scale_;
+  // Mask columns and weight of the right one for every image column.
+  std::vector<int> x0_;
+  std::vector<int> x1_;
+  std::vector<float> fx_;
+  // Two horizontally interpolated mask rows, and their indices.
+  std::vector<float> mask_rows_[2];
+  int cached_mask_row_[2] = {-1, -1};
+  std::vector<float> row_;
+};
+
+struct RecolorSpec {
+  // The RGB color blended into the image.
+  uint8_t color[3] = {0, 0, 0};
+  // Whether the weight of the color is one minus the mask value.
+  bool invert_mask = false;
+  // Whether the weight of the color is also multiplied by the luminance of
+  // the pixel.
+  bool adjust_with_luminance = false;
+};
+
+// Blends |width| SRGB pixels of |input| with spec.color, where |weight| holds
+// the mask value in [0, 1] of every pixel, and writes them to |output|. The
+// result matches the OpenCV implementation of RecolorCalculator up to
+// rounding. |output| may be |input|.
+void RecolorRow(const uint8_t* input, const float* weight, int width,
+                const RecolorSpec& spec, uint8_t* output);
+
+// Writes |width| SRGBA pixels to |output|, with the color channels of the
+// pixels of |input|, which has |input_channels| channels, 3 or 4, and the
+// alpha channel of |alpha|, which is rounded and clamped to [0, 255].
+// |output| may be |input| if it has 4 channels.
+void SetAlphaRow(const uint8_t* input, int input_channels, const float* alpha,
+                 int width, uint8_t* output);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_IMAGE_MASK_BLEND_CPU_H_
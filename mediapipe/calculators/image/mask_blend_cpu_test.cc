@@ -0,0 +1,208 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/image/mask_blend_cpu.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+void FillRandom(ImageFrame* frame, std::mt19937* rng) {
+  for (int y = 0; y < frame->Height(); ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    if (frame->ByteDepth() == 1) {
+      for (int x = 0; x < frame->Width() * frame->NumberOfChannels(); ++x) {
+        row[x] = (*rng)();
+      }
+    } else {
+      std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+      float* values = reinterpret_cast<float*>(row);
+      for (int x = 0; x < frame->Width() * frame->NumberOfChannels(); ++x) {
+        values[x] = unit(*rng);
+      }
+    }
+  }
+}
+
+float MaskValue(const ImageFrame& mask, int channel, int x, int y) {
+  const uint8* row = mask.PixelData() + y * mask.WidthStep();
+  const int index = x * mask.NumberOfChannels() + channel;
+  if (mask.ByteDepth() == 1) return row[index];
+  return reinterpret_cast<const float*>(row)[index];
+}
+
+// Source position and weight of cv::resize() with cv::INTER_LINEAR.
+void LinearTap(int i, int input_size, int output_size, int* index,
+               float* weight) {
+  const double f =
+      (i + 0.5) * input_size / static_cast<double>(output_size) - 0.5;
+  *index = static_cast<int>(std::floor(f));
+  *weight = static_cast<float>(f - *index);
+  if (*index < 0) {
+    *index = 0;
+    *weight = 0;
+  }
+  if (*index >= input_size - 1) {
+    *index = input_size - 1;
+    *weight = 0;
+  }
+}
+
+// Upsamples |channel| of |mask| to width x height, one pixel at a time.
+std::vector<float> ResizeMask(const ImageFrame& mask, int channel, int width,
+                              int height, float scale) {
+  std::vector<float> result(width * height);
+  for (int y = 0; y < height; ++y) {
+    int y0;
+    float fy;
+    LinearTap(y, mask.Height(), height, &y0, &fy);
+    const int y1 = std::min(y0 + 1, mask.Height() - 1);
+    for (int x = 0; x < width; ++x) {
+      int x0;
+      float fx;
+      LinearTap(x, mask.Width(), width, &x0, &fx);
+      const int x1 = std::min(x0 + 1, mask.Width() - 1);
+      const float top = MaskValue(mask, channel, x0, y0) * (1 - fx) +
+                        MaskValue(mask, channel, x1, y0) * fx;
+      const float bottom = MaskValue(mask, channel, x0, y1) * (1 - fx) +
+                           MaskValue(mask, channel, x1, y1) * fx;
+      result[y * width + x] = (top * (1 - fy) + bottom * fy) * scale;
+    }
+  }
+  return result;
+}
+
+class MaskRowSamplerTest
+    : public ::testing::TestWithParam<ImageFormat::Format> {};
+
+TEST_P(MaskRowSamplerTest, MatchesBilinearResize) {
+  std::mt19937 rng(1);
+  ImageFrame mask(GetParam(), 37, 23);
+  FillRandom(&mask, &rng);
+  const int channel = mask.NumberOfChannels() - 1;
+  const float scale = mask.ByteDepth() == 1 ? 1.0f / 255.0f : 1.0f;
+  for (const auto& size : std::vector<std::pair<int, int>>{
+           {37, 23}, {101, 67}, {150, 40}, {19, 11}}) {
+    const int width = size.first;
+    const int height = size.second;
+    const std::vector<float> expected =
+        ResizeMask(mask, channel, width, height, scale);
+    MaskRowSampler sampler(mask, channel, width, height, scale);
+    std::vector<float> row_copy(width);
+    for (int y = 0; y < height; ++y) {
+      const float* row = sampler.GetRow(y);
+      for (int x = 0; x < width; ++x) {
+        ASSERT_NEAR(row[x], expected[y * width + x], 1e-5)
+            << width << "x" << height << " at " << x << "," << y;
+      }
+      sampler.GetRow(y, row_copy.data());
+      ASSERT_EQ(std::vector<float>(row, row + width), row_copy);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(MaskFormats, MaskRowSamplerTest,
+                         ::testing::Values(ImageFormat::GRAY8,
+                                           ImageFormat::SRGBA,
+                                           ImageFormat::VEC32F1));
+
+// The per-pixel blend of the original OpenCV implementation.
+uint8 ExpectedRecolor(uint8 input, uint8 color, const uint8* pixel,
+                      float weight, const RecolorSpec& spec) {
+  if (spec.invert_mask) weight = 1.0f - weight;
+  float luminance = 1.0f;
+  if (spec.adjust_with_luminance) {
+    luminance = (pixel[0] * 0.299 + pixel[1] * 0.587 + pixel[2] * 0.114) / 255;
+  }
+  const float mix = weight * luminance;
+  return static_cast<uint8>(
+      std::lrint(std::min(255.0f, input * (1.0f - mix) + color * mix)));
+}
+
+TEST(RecolorRowTest, MatchesPerPixelBlend) {
+  constexpr int kWidth = 77;
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<uint8> input(kWidth * 3);
+  std::vector<float> weight(kWidth);
+  for (auto& value : input) value = rng();
+  for (auto& value : weight) value = unit(rng);
+  // Exercises saturation and the edges of the mask range.
+  weight[0] = 0.0f;
+  weight[1] = 1.0f;
+  input[6] = input[7] = input[8] = 255;
+  weight[2] = 1.0f;
+
+  for (int options = 0; options < 4; ++options) {
+    RecolorSpec spec;
+    spec.color[0] = 250;
+    spec.color[1] = 7;
+    spec.color[2] = 128;
+    spec.invert_mask = options & 1;
+    spec.adjust_with_luminance = options & 2;
+    std::vector<uint8> output(kWidth * 3);
+    RecolorRow(input.data(), weight.data(), kWidth, spec, output.data());
+    for (int x = 0; x < kWidth; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        const int expected =
+            ExpectedRecolor(input[3 * x + c], spec.color[c], &input[3 * x],
+                            weight[x], spec);
+        ASSERT_LE(std::abs(output[3 * x + c] - expected), 1)
+            << "options " << options << " at " << x << "," << c;
+      }
+    }
+
+    // In place.
+    std::vector<uint8> in_place = input;
+    RecolorRow(in_place.data(), weight.data(), kWidth, spec, in_place.data());
+    EXPECT_EQ(in_place, output);
+  }
+}
+
+TEST(SetAlphaRowTest, WritesColorAndAlpha) {
+  constexpr int kWidth = 45;
+  std::mt19937 rng(3);
+  std::vector<float> alpha(kWidth);
+  for (int x = 0; x < kWidth; ++x) alpha[x] = x * 6.1f - 10.0f;
+
+  for (int channels : {3, 4}) {
+    std::vector<uint8> input(kWidth * channels);
+    for (auto& value : input) value = rng();
+    std::vector<uint8> output(kWidth * 4);
+    SetAlphaRow(input.data(), channels, alpha.data(), kWidth, output.data());
+    for (int x = 0; x < kWidth; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        ASSERT_EQ(output[4 * x + c], input[channels * x + c]);
+      }
+      const float expected_alpha =
+          std::min(std::max(alpha[x], 0.0f), 255.0f);
+      ASSERT_NEAR(output[4 * x + 3], expected_alpha, 0.5f) << x;
+    }
+    if (channels == 4) {
+      SetAlphaRow(input.data(), channels, alpha.data(), kWidth, input.data());
+      EXPECT_EQ(input, output);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
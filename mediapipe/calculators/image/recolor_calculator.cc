@@ -12,14 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <vector>
 
+#include "mediapipe/calculators/image/mask_blend_cpu.h"
 #include "mediapipe/calculators/image/recolor_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
-#include "mediapipe/framework/formats/image_frame_opencv.h"
-#include "mediapipe/framework/port/opencv_core_inc.h"
-#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/color.pb.h"
@@ -38,21 +38,6 @@ constexpr char kMaskCpuTag[] = "MASK";
 constexpr char kGpuBufferTag[] = "IMAGE_GPU";
 constexpr char kMaskGpuTag[] = "MASK_GPU";
 
-inline cv::Vec3b Blend(const cv::Vec3b& color1, const cv::Vec3b& color2,
-                       float weight, int invert_mask,
-                       int adjust_with_luminance) {
-  weight = (1 - invert_mask) * weight + invert_mask * (1.0f - weight);
-
-  float luminance =
-      (1 - adjust_with_luminance) * 1.0f +
-      adjust_with_luminance *
-          (color1[0] * 0.299 + color1[1] * 0.587 + color1[2] * 0.114) / 255;
-
-  float mix_value = weight * luminance;
-
-  return color1 * (1.0 - mix_value) + color2 * mix_value;
-}
-
 }  // namespace
 
 namespace mediapipe {
@@ -71,7 +56,8 @@ namespace mediapipe {
 //   MASK_GPU: A GpuBuffer input mask, RGBA.
 // Output:
 //   One of the following IMAGE tags:
-//   IMAGE: An ImageFrame output image.
+//   IMAGE: An ImageFrame output image, from the kImageMultiPoolService pool
+//          if the graph provides one.
 //   IMAGE_GPU: A GpuBuffer output image.
 //
 // Options:
@@ -119,6 +105,7 @@ class RecolorCalculator : public CalculatorBase {
   bool use_gpu_ = false;
   bool invert_mask_ = false;
   bool adjust_with_luminance_ = false;
+  ServiceBinding<ImageMultiPool> image_pool_;
 #if !MEDIAPIPE_DISABLE_GPU
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
@@ -161,6 +148,7 @@ absl::Status RecolorCalculator::GetContract(CalculatorContract* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   if (cc->Outputs().HasTag(kImageFrameTag)) {
     cc->Outputs().Tag(kImageFrameTag).Set<ImageFrame>();
+    cc->UseService(kImageMultiPoolService).Optional();
   }
 
   // Confirm only one of the input streams is present.
@@ -187,6 +175,8 @@ absl::Status RecolorCalculator::Open(CalculatorContext* cc) {
 #if !MEDIAPIPE_DISABLE_GPU
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
 #endif  // !MEDIAPIPE_DISABLE_GPU
+  } else {
+    image_pool_ = cc->Service(kImageMultiPoolService);
   }
 
   MP_RETURN_IF_ERROR(LoadOptions(cc));
@@ -231,33 +221,44 @@ absl::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
         .AddPacket(cc->Inputs().Tag(kImageFrameTag).Value());
     return absl::OkStatus();
   }
-  // Get inputs and setup output.
-  const auto& input_img = cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
+  // Get inputs and setup output. The input frame is recolored in place if
+  // this calculator holds the only reference to it.
   const auto& mask_img = cc->Inputs().Tag(kMaskCpuTag).Get<ImageFrame>();
-
-  cv::Mat input_mat = formats::MatView(&input_img);
-  cv::Mat mask_mat = formats::MatView(&mask_img);
-
-  RET_CHECK(input_mat.channels() == 3);  // RGB only.
-
-  if (mask_mat.channels() > 1) {
-    std::vector<cv::Mat> channels;
-    cv::split(mask_mat, channels);
-    if (mask_channel_ == mediapipe::RecolorCalculatorOptions_MaskChannel_ALPHA)
-      mask_mat = channels[3];
-    else
-      mask_mat = channels[0];
+  Packet& input_packet = cc->Inputs().Tag(kImageFrameTag).Value();
+  const auto& input_img = input_packet.Get<ImageFrame>();
+  RET_CHECK(input_img.NumberOfChannels() == 3);  // RGB only.
+
+  const int mask_channel =
+      mask_img.NumberOfChannels() > 1 &&
+              mask_channel_ ==
+                  mediapipe::RecolorCalculatorOptions_MaskChannel_ALPHA
+          ? 3
+          : 0;
+  RET_CHECK_LT(mask_channel, mask_img.NumberOfChannels());
+  RET_CHECK(mask_img.ByteDepth() == 1 ||
+            mask_img.Format() == ImageFormat::VEC32F1);
+  const float mask_scale =
+      mask_img.Format() == ImageFormat::VEC32F1 ? 1.0f : 1.0f / 255.0f;
+  const int width = input_img.Width();
+  const int height = input_img.Height();
+  MaskRowSampler mask_sampler(mask_img, mask_channel, width, height,
+                              mask_scale);
+  RecolorSpec spec;
+  spec.color[0] = color_[0];
+  spec.color[1] = color_[1];
+  spec.color[2] = color_[2];
+  spec.invert_mask = invert_mask_;
+  spec.adjust_with_luminance = adjust_with_luminance_;
+
+  std::unique_ptr<ImageFrame> output_img;
+  auto consumed = input_packet.Consume<ImageFrame>();
+  if (consumed.ok()) {
+    output_img = std::move(consumed).value();
+  } else {
+    output_img = CreateImageFrame(image_pool_, input_img.Format(), width,
+                                  height);
   }
-  cv::Mat mask_full;
-  cv::resize(mask_mat, mask_full, input_mat.size());
-  const cv::Vec3b recolor = {color_[0], color_[1], color_[2]};
-
-  auto output_img = absl::make_unique<ImageFrame>(
-      input_img.Format(), input_mat.cols, input_mat.rows);
-  cv::Mat output_mat = mediapipe::formats::MatView(output_img.get());
-
-  const int invert_mask = invert_mask_ ? 1 : 0;
-  const int adjust_with_luminance = adjust_with_luminance_ ? 1 : 0;
+  // input_img remains valid if it was consumed, as output_img now owns it.
 
   // From GPU shader:
   /*
@@ -270,24 +271,10 @@ absl::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
 
       fragColor = mix(color1, color2, mix_value);
   */
-  if (mask_img.Format() == ImageFormat::VEC32F1) {
-    for (int i = 0; i < output_mat.rows; ++i) {
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const float weight = mask_full.at<float>(i, j);
-        output_mat.at<cv::Vec3b>(i, j) =
-            Blend(input_mat.at<cv::Vec3b>(i, j), recolor, weight, invert_mask,
-                  adjust_with_luminance);
-      }
-    }
-  } else {
-    for (int i = 0; i < output_mat.rows; ++i) {
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const float weight = mask_full.at<uchar>(i, j) * (1.0 / 255.0);
-        output_mat.at<cv::Vec3b>(i, j) =
-            Blend(input_mat.at<cv::Vec3b>(i, j), recolor, weight, invert_mask,
-                  adjust_with_luminance);
-      }
-    }
+  for (int y = 0; y < height; ++y) {
+    RecolorRow(input_img.PixelData() + y * input_img.WidthStep(),
+               mask_sampler.GetRow(y), width, spec,
+               output_img->MutablePixelData() + y * output_img->WidthStep());
   }
 
   cc->Outputs()
@@ -27,6 +27,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/image_resizer.h"
@@ -98,7 +99,8 @@ void CropImageFrame(const ImageFrame& original, int col_start, int row_start,
 // The output can be cropped and scaled ImageFrame with the SRGB format. If the
 // input is a YUVImage, the output can be a scaled YUVImage (the scaling is done
 // using libyuv). Cropping is not yet supported for a YUVImage to a scaled
-// YUVImage conversion.
+// YUVImage conversion. The cropped and downscaled ImageFrames come from the
+// kImageMultiPoolService pool if the graph provides one.
 //
 // Example config:
 // node {
@@ -184,6 +186,7 @@ class ScaleImageCalculator : public CalculatorBase {
     if (cc->Inputs().HasTag("OVERRIDE_OPTIONS")) {
       cc->Inputs().Tag("OVERRIDE_OPTIONS").Set<ScaleImageCalculatorOptions>();
     }
+    cc->UseService(kImageMultiPoolService).Optional();
     return absl::OkStatus();
   }
 
@@ -243,6 +246,8 @@ class ScaleImageCalculator : public CalculatorBase {
 
   // Efficient image resizer with gamma correction and optional sharpening.
   std::unique_ptr<ImageResizer> downscaler_;
+
+  ServiceBinding<ImageMultiPool> image_pool_;
 };
 
 REGISTER_CALCULATOR(ScaleImageCalculator);
@@ -304,6 +309,7 @@ absl::Status ScaleImageCalculator::InitializeFrameInfo(CalculatorContext* cc) {
 
 absl::Status ScaleImageCalculator::Open(CalculatorContext* cc) {
   options_ = cc->Options<ScaleImageCalculatorOptions>();
+  image_pool_ = cc->Service(kImageMultiPoolService);
 
   input_data_id_ = cc->Inputs().GetId("FRAMES", 0);
   if (!input_data_id_.IsValid()) {
@@ -614,8 +620,9 @@ absl::Status ScaleImageCalculator::Process(CalculatorContext* cc) {
   if (crop_width_ < input_width_ || crop_height_ < input_height_) {
     cc->GetCounter("Crops")->Increment();
     // TODO Do the crop as a range restrict inside OpenCV code below.
-    cropped_image.reset(new ImageFrame(image_frame->Format(), crop_width_,
-                                       crop_height_, alignment_boundary_));
+    cropped_image = CreateImageFrame(image_pool_, image_frame->Format(),
+                                     crop_width_, crop_height_,
+                                     alignment_boundary_);
     if (image_frame->ByteDepth() == 1 || image_frame->ByteDepth() == 2) {
       CropImageFrame(*image_frame, col_start_, row_start_, crop_width_,
                      crop_height_, cropped_image.get());
@@ -668,19 +675,21 @@ absl::Status ScaleImageCalculator::Process(CalculatorContext* cc) {
   }
 
   // Rescale the image frame.
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame());
+  std::unique_ptr<ImageFrame> output_frame;
   if (image_frame->Width() >= output_width_ &&
       image_frame->Height() >= output_height_) {
     // Downscale.
     cc->GetCounter("Downscales")->Increment();
     cv::Mat input_mat = ::mediapipe::formats::MatView(image_frame);
-    output_frame->Reset(image_frame->Format(), output_width_, output_height_,
-                        alignment_boundary_);
+    output_frame =
+        CreateImageFrame(image_pool_, image_frame->Format(), output_width_,
+                         output_height_, alignment_boundary_);
     cv::Mat output_mat = ::mediapipe::formats::MatView(output_frame.get());
     downscaler_->Resize(input_mat, &output_mat);
   } else {
     // Upscale. If upscaling is disallowed, output_width_ and output_height_ are
     // the same as the input/crop width and height.
+    output_frame.reset(new ImageFrame());
     image_frame_util::RescaleImageFrame(
         *image_frame, output_width_, output_height_, alignment_boundary_,
         interpolation_algorithm_, output_frame.get());
@@ -22,6 +22,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/formats/image_opencv.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
@@ -60,6 +61,8 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 //                   [Same format as MASK_CURRENT]
 //   * The resulting filtered mask will be stored in R channel,
 //     and duplicated in A if 4 channels.
+//   * CPU masks come from the kImageMultiPoolService pool if the graph
+//     provides one.
 //
 // Options:
 //   combine_with_previous_ratio - Amount of previous to blend with current.
@@ -96,6 +99,7 @@ class SegmentationSmoothingCalculator : public CalculatorBase {
   void GlRender(CalculatorContext* cc);
 
   float combine_with_previous_ratio_;
+  ServiceBinding<ImageMultiPool> image_pool_;
 
   bool gpu_initialized_ = false;
 #if !MEDIAPIPE_DISABLE_GPU
@@ -112,6 +116,7 @@ absl::Status SegmentationSmoothingCalculator::GetContract(
   cc->Inputs().Tag(kCurrentMaskTag).Set<Image>();
   cc->Inputs().Tag(kPreviousMaskTag).Set<Image>();
   cc->Outputs().Tag(kOutputMaskTag).Set<Image>();
+  cc->UseService(kImageMultiPoolService).Optional();
 
 #if !MEDIAPIPE_DISABLE_GPU
   MP_RETURN_IF_ERROR(mediapipe::GlCalculatorHelper::UpdateContract(cc));
@@ -126,6 +131,7 @@ absl::Status SegmentationSmoothingCalculator::Open(CalculatorContext* cc) {
   auto options =
       cc->Options<mediapipe::SegmentationSmoothingCalculatorOptions>();
   combine_with_previous_ratio_ = options.combine_with_previous_ratio();
+  image_pool_ = cc->Service(kImageMultiPoolService);
 
 #if !MEDIAPIPE_DISABLE_GPU
   MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
@@ -197,8 +203,9 @@ absl::Status SegmentationSmoothingCalculator::RenderCpu(CalculatorContext* cc) {
   RET_CHECK_EQ(current_mat.cols, previous_mat.cols);
 
   // Setup destination image.
-  auto output_frame = std::make_shared<ImageFrame>(
-      current_frame.image_format(), current_mat.cols, current_mat.rows);
+  std::shared_ptr<ImageFrame> output_frame =
+      CreateImageFrame(image_pool_, current_frame.image_format(),
+                       current_mat.cols, current_mat.rows);
   cv::Mat output_mat = mediapipe::formats::MatView(output_frame.get());
   output_mat.setTo(cv::Scalar(0));
 
@@ -13,15 +13,16 @@
 // limitations under the License.
 
 #include <memory>
+#include <vector>
 
+#include "mediapipe/calculators/image/mask_blend_cpu.h"
 #include "mediapipe/calculators/image/set_alpha_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
-#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/port/logging.h"
-#include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/vector.h"
 
@@ -62,7 +63,9 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 //
 //   ALPHA (optional): ImageFrame alpha mask to apply,
 //                     can be any # of channels, only first channel used,
-//                     must be same format as input
+//                     8-bit, or VEC32F1 with values in [0, 1]. A mask of
+//                     another resolution than the input is resized
+//                     bilinearly.
 //   ALPHA_GPU (optional): GpuBuffer alpha mask to apply,
 //                         can be any # of channels, only first channel used,
 //                         must be same format as input
@@ -70,7 +73,8 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 //
 // Output:
 //   One of the following two tags:
-//   IMAGE:    An ImageFrame with alpha channel set - RGBA only.
+//   IMAGE:    An ImageFrame with alpha channel set - RGBA only. It comes from
+//             the kImageMultiPoolService pool if the graph provides one.
 //   IMAGE_GPU:  A GpuBuffer with alpha channel set - RGBA only.
 //
 // Options:
@@ -80,7 +84,8 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 //
 // Notes:
 //   Either alpha_value option or ALPHA (or ALPHA_GPU) must be set.
-//   All CPU inputs must have the same image dimensions and data type.
+//   The CPU output reuses the input frame when the input is RGBA and this
+//   calculator holds the only reference to it.
 //
 class SetAlphaCalculator : public CalculatorBase {
  public:
@@ -106,6 +111,7 @@ class SetAlphaCalculator : public CalculatorBase {
 
   bool use_gpu_ = false;
   bool gpu_initialized_ = false;
+  ServiceBinding<ImageMultiPool> image_pool_;
 #if !MEDIAPIPE_DISABLE_GPU
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
@@ -158,6 +164,7 @@ absl::Status SetAlphaCalculator::GetContract(CalculatorContract* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   if (cc->Outputs().HasTag(kOutputFrameTag)) {
     cc->Outputs().Tag(kOutputFrameTag).Set<ImageFrame>();
+    cc->UseService(kImageMultiPoolService).Optional();
   }
 
   if (use_gpu) {
@@ -195,8 +202,10 @@ absl::Status SetAlphaCalculator::Open(CalculatorContext* cc) {
   if (use_gpu_) {
 #if !MEDIAPIPE_DISABLE_GPU
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
-#endif
-  }  //  !MEDIAPIPE_DISABLE_GPU
+#endif  //  !MEDIAPIPE_DISABLE_GPU
+  } else {
+    image_pool_ = cc->Service(kImageMultiPoolService);
+  }
 
   return absl::OkStatus();
 }
@@ -237,55 +246,55 @@ absl::Status SetAlphaCalculator::RenderCpu(CalculatorContext* cc) {
   }
 
   // Setup source image
-  const auto& input_frame = cc->Inputs().Tag(kInputFrameTag).Get<ImageFrame>();
-  const cv::Mat input_mat = mediapipe::formats::MatView(&input_frame);
-  if (!(input_mat.type() == CV_8UC3 || input_mat.type() == CV_8UC4)) {
-    LOG(ERROR) << "Only 3 or 4 channel 8-bit input image supported";
+  Packet& input_packet = cc->Inputs().Tag(kInputFrameTag).Value();
+  const auto& input_frame = input_packet.Get<ImageFrame>();
+  const int input_channels = input_frame.NumberOfChannels();
+  RET_CHECK(input_frame.ByteDepth() == 1 &&
+            (input_channels == 3 || input_channels == kNumChannelsRGBA))
+      << "Only 3 or 4 channel 8-bit input image supported";
+  const int width = input_frame.Width();
+  const int height = input_frame.Height();
+
+  // Setup destination image. An RGBA input is updated in place if it is not
+  // shared.
+  std::unique_ptr<ImageFrame> output_frame;
+  if (input_frame.Format() == ImageFormat::SRGBA) {
+    auto consumed = input_packet.Consume<ImageFrame>();
+    if (consumed.ok()) output_frame = std::move(consumed).value();
+  }
+  if (!output_frame) {
+    output_frame =
+        CreateImageFrame(image_pool_, ImageFormat::SRGBA, width, height);
   }
-
-  // Setup destination image
-  auto output_frame = absl::make_unique<ImageFrame>(
-      ImageFormat::SRGBA, input_mat.cols, input_mat.rows);
-  cv::Mat output_mat = mediapipe::formats::MatView(output_frame.get());
 
   const bool has_alpha_mask = cc->Inputs().HasTag(kInputAlphaTag) &&
                               !cc->Inputs().Tag(kInputAlphaTag).IsEmpty();
   const bool use_alpa_mask = alpha_value_ < 0 && has_alpha_mask;
 
-  // Setup alpha image and Update image in CPU.
+  // Setup alpha image and Update image in CPU. input_frame remains valid if
+  // it was consumed, as output_frame now owns it.
   if (use_alpa_mask) {
     const auto& alpha_mask = cc->Inputs().Tag(kInputAlphaTag).Get<ImageFrame>();
-    cv::Mat alpha_mat = mediapipe::formats::MatView(&alpha_mask);
-    RET_CHECK_EQ(input_mat.rows, alpha_mat.rows);
-    RET_CHECK_EQ(input_mat.cols, alpha_mat.cols);
-
-    for (int i = 0; i < output_mat.rows; ++i) {
-      const uchar* in_ptr = input_mat.ptr<uchar>(i);
-      uchar* alpha_ptr = alpha_mat.ptr<uchar>(i);
-      uchar* out_ptr = output_mat.ptr<uchar>(i);
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const int out_idx = j * kNumChannelsRGBA;
-        const int in_idx = j * input_mat.channels();
-        const int alpha_idx = j * alpha_mat.channels();
-        out_ptr[out_idx + 0] = in_ptr[in_idx + 0];
-        out_ptr[out_idx + 1] = in_ptr[in_idx + 1];
-        out_ptr[out_idx + 2] = in_ptr[in_idx + 2];
-        out_ptr[out_idx + 3] = alpha_ptr[alpha_idx + 0];  // channel 0 of mask
-      }
+    RET_CHECK(alpha_mask.ByteDepth() == 1 ||
+              alpha_mask.Format() == ImageFormat::VEC32F1);
+    // Channel 0 of the mask.
+    MaskRowSampler alpha_sampler(alpha_mask, 0, width, height,
+                                 alpha_mask.ByteDepth() == 1 ? 1.0f : 255.0f);
+    for (int i = 0; i < height; ++i) {
+      SetAlphaRow(input_frame.PixelData() + i * input_frame.WidthStep(),
+                  input_channels, alpha_sampler.GetRow(i), width,
+                  output_frame->MutablePixelData() +
+                      i * output_frame->WidthStep());
     }
   } else {
-    const uchar alpha_value = std::min(std::max(0.0f, alpha_value_), 255.0f);
-    for (int i = 0; i < output_mat.rows; ++i) {
-      const uchar* in_ptr = input_mat.ptr<uchar>(i);
-      uchar* out_ptr = output_mat.ptr<uchar>(i);
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const int out_idx = j * kNumChannelsRGBA;
-        const int in_idx = j * input_mat.channels();
-        out_ptr[out_idx + 0] = in_ptr[in_idx + 0];
-        out_ptr[out_idx + 1] = in_ptr[in_idx + 1];
-        out_ptr[out_idx + 2] = in_ptr[in_idx + 2];
-        out_ptr[out_idx + 3] = alpha_value;  // use value from options
-      }
+    // Use value from options.
+    const uint8 alpha_value = std::min(std::max(0.0f, alpha_value_), 255.0f);
+    const std::vector<float> alpha_row(width, alpha_value);
+    for (int i = 0; i < height; ++i) {
+      SetAlphaRow(input_frame.PixelData() + i * input_frame.WidthStep(),
+                  input_channels, alpha_row.data(), width,
+                  output_frame->MutablePixelData() +
+                      i * output_frame->WidthStep());
     }
   }
 
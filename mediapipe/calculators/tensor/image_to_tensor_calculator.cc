@@ -18,6 +18,7 @@
 
 #include "mediapipe/calculators/tensor/image_to_tensor_calculator.pb.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_cpu.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -25,6 +26,8 @@
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/tensor_pool.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -68,7 +71,8 @@ using GpuBuffer = mediapipe::GpuBuffer;
 // Inputs:
 //   IMAGE - Image[ImageFormat::SRGB / SRGBA, GpuBufferFormat::kBGRA32] or
 //           ImageFrame [ImageFormat::SRGB/SRGBA] (for backward compatibility
-//           with existing graphs that use IMAGE for ImageFrame input)
+//           with existing graphs that use IMAGE for ImageFrame input) or
+//           YUVImage [I420, NV12, NV21 with 8-bit depth]
 //   IMAGE_GPU - GpuBuffer [GpuBufferFormat::kBGRA32]
 //     Image to extract from.
 //
@@ -77,6 +81,10 @@ using GpuBuffer = mediapipe::GpuBuffer;
 //   - IMAGE input of type Image is processed on GPU if the data is already on
 //     GPU (i.e., Image::UsesGpu() returns true), or otherwise processed on CPU.
 //   - IMAGE input of type ImageFrame is always processed on CPU.
+//   - IMAGE input of type YUVImage is always processed on CPU, by the fused
+//     CPU converter regardless of the cpu_converter option. Only the pixels
+//     sampled for the tensor are converted to RGB, so there is no need to
+//     convert the whole image to an RGB ImageFrame first.
 //   - IMAGE_GPU input (of type GpuBuffer) is always processed on GPU.
 //
 //   NORM_RECT - NormalizedRect @Optional
@@ -125,8 +133,8 @@ using GpuBuffer = mediapipe::GpuBuffer;
 // }
 class ImageToTensorCalculator : public Node {
  public:
-  static constexpr Input<
-      OneOf<mediapipe::Image, mediapipe::ImageFrame>>::Optional kIn{"IMAGE"};
+  static constexpr Input<OneOf<mediapipe::Image, mediapipe::ImageFrame,
+                               mediapipe::YUVImage>>::Optional kIn{"IMAGE"};
   static constexpr Input<GpuBuffer>::Optional kInGpu{"IMAGE_GPU"};
   static constexpr Input<mediapipe::NormalizedRect>::Optional kInNormRect{
       "NORM_RECT"};
@@ -154,6 +162,7 @@ class ImageToTensorCalculator : public Node {
 
     RET_CHECK(kIn(cc).IsConnected() ^ kInGpu(cc).IsConnected())
         << "One and only one of IMAGE and IMAGE_GPU input is expected.";
+    cc->UseService(kTensorPoolService).Optional();
 
 #if MEDIAPIPE_DISABLE_GPU
     if (kInGpu(cc).IsConnected()) {
@@ -207,8 +216,17 @@ class ImageToTensorCalculator : public Node {
       }
     }
 
-    ASSIGN_OR_RETURN(auto image, GetInputImage(cc));
-    const Size size{image->width(), image->height()};
+    const bool yuv_input =
+        kIn(cc).IsConnected() && kIn(cc).Has<mediapipe::YUVImage>();
+    std::shared_ptr<const mediapipe::Image> image;
+    Size size;
+    if (yuv_input) {
+      const auto& yuv_image = kIn(cc).Get<mediapipe::YUVImage>();
+      size = {yuv_image.width(), yuv_image.height()};
+    } else {
+      ASSIGN_OR_RETURN(image, GetInputImage(cc));
+      size = {image->width(), image->height()};
+    }
     RotatedRect roi = GetRoi(size.width, size.height, norm_rect);
     ASSIGN_OR_RETURN(auto padding, PadRoi(options_.output_tensor_width(),
                                           options_.output_tensor_height(),
@@ -224,13 +242,8 @@ class ImageToTensorCalculator : public Node {
       kOutMatrix(cc).Send(std::move(matrix));
     }
 
-    // Lazy initialization of the GPU or CPU converter.
-    MP_RETURN_IF_ERROR(InitConverterIfNecessary(cc, image->UsesGpu()));
-
-    ASSIGN_OR_RETURN(Tensor tensor,
-                     (image->UsesGpu() ? gpu_converter_ : cpu_converter_)
-                         ->Convert(*image, roi, {output_width_, output_height_},
-                                   range_min_, range_max_));
+    ASSIGN_OR_RETURN(Tensor tensor, yuv_input ? ConvertYuvImage(cc, roi)
+                                              : ConvertImage(cc, *image, roi));
 
     auto result = std::make_unique<std::vector<Tensor>>();
     result->push_back(std::move(tensor));
@@ -269,6 +282,10 @@ class ImageToTensorCalculator : public Node {
             return std::make_shared<const mediapipe::Image>(
                 std::const_pointer_cast<mediapipe::ImageFrame>(
                     SharedPtrWithPacket<mediapipe::ImageFrame>(packet)));
+          },
+          [](const mediapipe::YUVImage&) {
+            // Converted without an Image, see Process().
+            return std::shared_ptr<const mediapipe::Image>();
           });
     } else {  // if (kInGpu(cc).IsConnected())
 #if !MEDIAPIPE_DISABLE_GPU
@@ -283,6 +300,26 @@ class ImageToTensorCalculator : public Node {
     }
   }
 
+  absl::StatusOr<Tensor> ConvertImage(CalculatorContext* cc,
+                                      const mediapipe::Image& image,
+                                      const RotatedRect& roi) {
+    // Lazy initialization of the GPU or CPU converter.
+    MP_RETURN_IF_ERROR(InitConverterIfNecessary(cc, image.UsesGpu()));
+    return (image.UsesGpu() ? gpu_converter_ : cpu_converter_)
+        ->Convert(image, roi, {output_width_, output_height_}, range_min_,
+                  range_max_);
+  }
+
+  absl::StatusOr<Tensor> ConvertYuvImage(CalculatorContext* cc,
+                                         const RotatedRect& roi) {
+    if (!yuv_converter_) {
+      ASSIGN_OR_RETURN(yuv_converter_, CreateCpuConverter(cc, GetBorderMode()));
+    }
+    return yuv_converter_->ConvertYuv(kIn(cc).Get<mediapipe::YUVImage>(), roi,
+                                      {output_width_, output_height_},
+                                      range_min_, range_max_);
+  }
+
   absl::Status InitConverterIfNecessary(CalculatorContext* cc, bool use_gpu) {
     // Lazy initialization of the GPU or CPU converter.
     if (use_gpu) {
@@ -305,12 +342,15 @@ class ImageToTensorCalculator : public Node {
     } else {
       if (!cpu_converter_) {
 #if !MEDIAPIPE_DISABLE_OPENCV
-        ASSIGN_OR_RETURN(cpu_converter_,
-                         CreateOpenCvConverter(cc, GetBorderMode()));
-#else
-        LOG(FATAL) << "Cannot create image to tensor opencv converter since "
-                      "MEDIAPIPE_DISABLE_OPENCV is defined.";
+        if (options_.cpu_converter() ==
+            mediapipe::ImageToTensorCalculatorOptions::CPU_CONVERTER_OPENCV) {
+          ASSIGN_OR_RETURN(cpu_converter_,
+                           CreateOpenCvConverter(cc, GetBorderMode()));
+          return absl::OkStatus();
+        }
 #endif  // !MEDIAPIPE_DISABLE_OPENCV
+        ASSIGN_OR_RETURN(cpu_converter_,
+                         CreateCpuConverter(cc, GetBorderMode()));
       }
     }
     return absl::OkStatus();
@@ -318,6 +358,7 @@ class ImageToTensorCalculator : public Node {
 
   std::unique_ptr<ImageToTensorConverter> gpu_converter_;
   std::unique_ptr<ImageToTensorConverter> cpu_converter_;
+  std::unique_ptr<ImageToTensorConverter> yuv_converter_;
   mediapipe::ImageToTensorCalculatorOptions options_;
   int output_width_ = 0;
   int output_height_ = 0;
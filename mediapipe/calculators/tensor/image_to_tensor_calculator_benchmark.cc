@@ -0,0 +1,181 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures ImageToTensorCalculator on a 1080p CPU image with the OpenCV and
+// the fused CPU converters, for square output tensors of different sizes.
+// The ROI is slightly rotated so that neither converter can take a
+// shortcut.
+//
+// The NV12 benchmarks compare converting the whole YUV image to an RGB
+// ImageFrame with libyuv before the calculator, with passing the YUVImage to
+// the calculator directly.
+//
+// bazel run -c opt \
+//   //mediapipe/calculators/tensor:image_to_tensor_calculator_benchmark
+
+#include <functional>
+#include <memory>
+#include <random>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "libyuv/convert_argb.h"
+#include "libyuv/video_common.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kImageWidth = 1920;
+constexpr int kImageHeight = 1080;
+
+CalculatorGraphConfig MakeConfig(int tensor_size, const char* cpu_converter) {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(
+      R"(
+        input_stream: "image"
+        input_stream: "roi"
+        node {
+          calculator: "ImageToTensorCalculator"
+          input_stream: "IMAGE:image"
+          input_stream: "NORM_RECT:roi"
+          output_stream: "TENSORS:tensors"
+          options {
+            [mediapipe.ImageToTensorCalculatorOptions.ext] {
+              output_tensor_width: $0
+              output_tensor_height: $0
+              keep_aspect_ratio: true
+              output_tensor_float_range { min: -1.0 max: 1.0 }
+              cpu_converter: $1
+            }
+          }
+        }
+      )",
+      tensor_size, cpu_converter));
+}
+
+// Sends the packet returned by |get_image| and a rotated ROI to the graph once
+// per iteration, and waits for the output tensor.
+void RunBenchmark(benchmark::State& state, const CalculatorGraphConfig& config,
+                  const std::function<Packet()>& get_image) {
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config).ok());
+  int num_outputs = 0;
+  CHECK(graph
+            .ObserveOutputStream("tensors",
+                                 [&num_outputs](const Packet&) {
+                                   ++num_outputs;
+                                   return absl::OkStatus();
+                                 })
+            .ok());
+  CHECK(graph.StartRun({}).ok());
+
+  NormalizedRect roi;
+  roi.set_x_center(0.5f);
+  roi.set_y_center(0.5f);
+  roi.set_width(0.6f);
+  roi.set_height(0.8f);
+  roi.set_rotation(0.3f);
+
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    CHECK(graph
+              .AddPacketToInputStream("image",
+                                      get_image().At(Timestamp(timestamp)))
+              .ok());
+    CHECK(graph
+              .AddPacketToInputStream(
+                  "roi", MakePacket<NormalizedRect>(roi).At(
+                             Timestamp(timestamp)))
+              .ok());
+    CHECK(graph.WaitUntilIdle().ok());
+    ++timestamp;
+  }
+  CHECK_EQ(num_outputs, timestamp);
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+}
+
+void BM_ImageToTensor(benchmark::State& state, const char* cpu_converter) {
+  auto image = absl::make_unique<ImageFrame>(ImageFormat::SRGB, kImageWidth,
+                                            kImageHeight);
+  std::mt19937 rng(42);
+  for (int y = 0; y < kImageHeight; ++y) {
+    uint8* row = image->MutablePixelData() + y * image->WidthStep();
+    for (int x = 0; x < kImageWidth * 3; ++x) {
+      row[x] = rng();
+    }
+  }
+  Packet image_packet = Adopt(image.release());
+  RunBenchmark(state, MakeConfig(state.range(0), cpu_converter),
+               [&image_packet] { return image_packet; });
+}
+
+// Argument is the output tensor width and height.
+BENCHMARK_CAPTURE(BM_ImageToTensor, OpenCv, "CPU_CONVERTER_OPENCV")
+    ->Arg(256)
+    ->Arg(192);
+BENCHMARK_CAPTURE(BM_ImageToTensor, Fused, "CPU_CONVERTER_FUSED")
+    ->Arg(256)
+    ->Arg(192);
+
+std::unique_ptr<YUVImage> MakeNv12Image() {
+  const int uv_height = (kImageHeight + 1) / 2;
+  auto y = absl::make_unique<uint8[]>(kImageWidth * kImageHeight);
+  auto uv = absl::make_unique<uint8[]>(kImageWidth * uv_height);
+  std::mt19937 rng(42);
+  for (int i = 0; i < kImageWidth * kImageHeight; ++i) {
+    y[i] = rng();
+  }
+  for (int i = 0; i < kImageWidth * uv_height; ++i) {
+    uv[i] = rng();
+  }
+  return absl::make_unique<YUVImage>(
+      libyuv::FOURCC_NV12, std::move(y), kImageWidth, std::move(uv),
+      kImageWidth, /*data2=*/nullptr, /*stride2=*/0, kImageWidth,
+      kImageHeight);
+}
+
+// Converts the NV12 image to an RGB ImageFrame for every frame, as graphs
+// had to before the calculator accepted YUVImage.
+void BM_Nv12ToTensorConvertToRgb(benchmark::State& state) {
+  std::unique_ptr<YUVImage> nv12 = MakeNv12Image();
+  RunBenchmark(state, MakeConfig(state.range(0), "CPU_CONVERTER_FUSED"),
+               [&nv12] {
+                 auto image = absl::make_unique<ImageFrame>(
+                     ImageFormat::SRGB, kImageWidth, kImageHeight);
+                 CHECK_EQ(libyuv::NV12ToRAW(
+                              nv12->data(0), nv12->stride(0), nv12->data(1),
+                              nv12->stride(1), image->MutablePixelData(),
+                              image->WidthStep(), kImageWidth, kImageHeight),
+                          0);
+                 return Adopt(image.release());
+               });
+}
+BENCHMARK(BM_Nv12ToTensorConvertToRgb)->Arg(256)->Arg(192);
+
+void BM_Nv12ToTensorDirect(benchmark::State& state) {
+  Packet image_packet = Adopt(MakeNv12Image().release());
+  RunBenchmark(state, MakeConfig(state.range(0), "CPU_CONVERTER_FUSED"),
+               [&image_packet] { return image_packet; });
+}
+BENCHMARK(BM_Nv12ToTensorDirect)->Arg(256)->Arg(192);
+
+}  // namespace
+}  // namespace mediapipe
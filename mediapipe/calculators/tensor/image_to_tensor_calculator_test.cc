@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -29,6 +30,7 @@
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
@@ -36,6 +38,7 @@
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/image_frame_util.h"
 
 namespace mediapipe {
 namespace {
@@ -61,7 +64,8 @@ void RunTestWithInputImagePacket(const Packet& input_image_packet,
                                  float range_max, int tensor_width,
                                  int tensor_height, bool keep_aspect,
                                  absl::optional<BorderMode> border_mode,
-                                 const mediapipe::NormalizedRect& roi) {
+                                 const mediapipe::NormalizedRect& roi,
+                                 absl::string_view cpu_converter) {
   std::string border_mode_str;
   if (border_mode) {
     switch (*border_mode) {
@@ -92,6 +96,7 @@ void RunTestWithInputImagePacket(const Packet& input_image_packet,
                 max: $3
               }
               $5 # border mode
+              cpu_converter: $6
             }
           }
         }
@@ -101,7 +106,8 @@ void RunTestWithInputImagePacket(const Packet& input_image_packet,
                        /*$2=*/range_min,
                        /*$3=*/range_max,
                        /*$4=*/keep_aspect ? "true" : "false",
-                       /*$5=*/border_mode_str));
+                       /*$5=*/border_mode_str,
+                       /*$6=*/cpu_converter));
 
   std::vector<Packet> output_packets;
   tool::AddVectorSink("tensor", &graph_config, &output_packets);
@@ -175,11 +181,14 @@ void RunTest(cv::Mat input, cv::Mat expected_result, float range_min,
              bool keep_aspect, absl::optional<BorderMode> border_mode,
              const mediapipe::NormalizedRect& roi) {
   for (auto input_type : kInputTypesToTest) {
-    RunTestWithInputImagePacket(
-        input_type == InputType::kImageFrame ? MakeImageFramePacket(input)
-                                             : MakeImagePacket(input),
-        expected_result, range_min, range_max, tensor_width, tensor_height,
-        keep_aspect, border_mode, roi);
+    for (absl::string_view cpu_converter :
+         {"CPU_CONVERTER_OPENCV", "CPU_CONVERTER_FUSED"}) {
+      RunTestWithInputImagePacket(
+          input_type == InputType::kImageFrame ? MakeImageFramePacket(input)
+                                               : MakeImagePacket(input),
+          expected_result, range_min, range_max, tensor_width, tensor_height,
+          keep_aspect, border_mode, roi, cpu_converter);
+    }
   }
 }
 
@@ -433,5 +442,102 @@ TEST(ImageToTensorCalculatorTest, NoOpExceptRangeBorderZero) {
           BorderMode::kZero, roi);
 }
 
+// No output row of a ROI left of the image has interior pixels. The border
+// pixels of a row must still end at the row end: on the last row, a write
+// past it overruns the tensor.
+TEST(ImageToTensorCalculatorTest, RoiOutsideImageBorderZero) {
+  mediapipe::NormalizedRect roi;
+  roi.set_x_center(-1.0f);
+  roi.set_y_center(0.5f);
+  roi.set_width(0.5f);
+  roi.set_height(0.5f);
+  roi.set_rotation(0.3f);
+  constexpr int kTensorWidth = 31;
+  constexpr int kTensorHeight = 17;
+  RunTest(GetRgba("/mediapipe/calculators/"
+                  "tensor/testdata/image_to_tensor/input.jpg"),
+          cv::Mat::zeros(kTensorHeight, kTensorWidth, CV_8UC3),
+          /*range_min=*/0.0f,
+          /*range_max=*/1.0f, kTensorWidth, kTensorHeight,
+          /*keep_aspect=*/false, BorderMode::kZero, roi);
+}
+
+// Runs the fused CPU converter on a rotated ROI that extends beyond the image,
+// and returns the tensor values in [0, 255].
+void RunFusedConverter(const Packet& input_image_packet, BorderMode border_mode,
+                       std::vector<float>* values) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::Substitute(R"(
+        calculator: "ImageToTensorCalculator"
+        input_stream: "IMAGE:image"
+        input_stream: "NORM_RECT:roi"
+        output_stream: "TENSORS:tensors"
+        options {
+          [mediapipe.ImageToTensorCalculatorOptions.ext] {
+            output_tensor_width: 96
+            output_tensor_height: 80
+            keep_aspect_ratio: true
+            output_tensor_float_range { min: 0.0 max: 255.0 }
+            border_mode: $0
+            cpu_converter: CPU_CONVERTER_FUSED
+          }
+        }
+      )",
+                       border_mode == BorderMode::kZero ? "BORDER_ZERO"
+                                                        : "BORDER_REPLICATE")));
+  mediapipe::NormalizedRect roi;
+  roi.set_x_center(0.6f);
+  roi.set_y_center(0.45f);
+  roi.set_width(0.7f);
+  roi.set_height(0.8f);
+  roi.set_rotation(0.4f);
+  runner.MutableInputs()->Tag("IMAGE").packets.push_back(
+      input_image_packet.At(Timestamp(0)));
+  runner.MutableInputs()->Tag("NORM_RECT").packets.push_back(
+      MakePacket<mediapipe::NormalizedRect>(roi).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const auto& output_packets = runner.Outputs().Tag("TENSORS").packets;
+  ASSERT_THAT(output_packets, testing::SizeIs(1));
+  const Tensor& tensor = output_packets[0].Get<std::vector<Tensor>>()[0];
+  auto view = tensor.GetCpuReadView();
+  const float* data = view.buffer<float>();
+  values->assign(data, data + tensor.shape().num_elements());
+}
+
+// YUVImage input gives the same tensor as the image converted to RGB with
+// libyuv, which graphs had to do before.
+TEST(ImageToTensorCalculatorTest, YuvImageMatchesRgbConversion) {
+  cv::Mat input = GetRgb(
+      "/mediapipe/calculators/tensor/testdata/image_to_tensor/input.jpg");
+  ImageFrame input_frame(ImageFormat::SRGB, input.cols, input.rows, input.step,
+                         input.data, [](uint8*) {});
+  auto i420 = absl::make_unique<YUVImage>();
+  image_frame_util::ImageFrameToYUVImage(input_frame, i420.get());
+  auto nv12 = absl::make_unique<YUVImage>();
+  image_frame_util::ImageFrameToYUVNV12Image(input_frame, nv12.get());
+  auto rgb = absl::make_unique<ImageFrame>();
+  image_frame_util::YUVImageToImageFrame(*i420, rgb.get());
+  const Packet rgb_packet = Adopt(rgb.release());
+  const Packet i420_packet = Adopt(i420.release());
+  const Packet nv12_packet = Adopt(nv12.release());
+
+  for (BorderMode border_mode : {BorderMode::kReplicate, BorderMode::kZero}) {
+    std::vector<float> expected;
+    RunFusedConverter(rgb_packet, border_mode, &expected);
+    for (const Packet& yuv_packet : {i420_packet, nv12_packet}) {
+      std::vector<float> result;
+      RunFusedConverter(yuv_packet, border_mode, &result);
+      ASSERT_EQ(result.size(), expected.size());
+      float max_diff = 0.0f;
+      for (int i = 0; i < result.size(); ++i) {
+        max_diff = std::max(max_diff, std::abs(result[i] - expected[i]));
+      }
+      // libyuv converts with fixed-point coefficients.
+      EXPECT_LE(max_diff, 5.0f);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace mediapipe
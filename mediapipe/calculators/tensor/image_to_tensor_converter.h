@@ -18,6 +18,8 @@
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/formats/image.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/statusor.h"
 
 namespace mediapipe {
@@ -49,6 +51,16 @@ class ImageToTensorConverter {
                                          const RotatedRect& roi,
                                          const Size& output_dims,
                                          float range_min, float range_max) = 0;
+
+  // Converts YUV image to tensor, with the same arguments as Convert(). The
+  // output tensor contains RGB values, as for RGB(A) images.
+  virtual absl::StatusOr<Tensor> ConvertYuv(const YUVImage& input,
+                                            const RotatedRect& roi,
+                                            const Size& output_dims,
+                                            float range_min, float range_max) {
+    return absl::UnimplementedError(
+        "YUVImage input is not supported by this converter.");
+  }
 };
 
 }  // namespace mediapipe
@@ -0,0 +1,906 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "libyuv/video_common.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/tensor_pool.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/statusor.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MEDIAPIPE_IMAGE_TO_TENSOR_AVX2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MEDIAPIPE_IMAGE_TO_TENSOR_NEON 1
+#endif
+
+namespace mediapipe {
+
+namespace {
+
+constexpr int kNumOutputChannels = 3;
+
+struct SourceImage {
+  const uint8_t* data;
+  int width;
+  int height;
+  int stride;  // Row size in bytes.
+};
+
+// The planes of an 8-bit YUV image with 2x2 subsampled U and V. The U (and V)
+// samples of a row are uv_step bytes apart: 1 for I420, 2 for NV12 and NV21.
+struct YuvSourceImage {
+  const uint8_t* y;
+  const uint8_t* u;
+  const uint8_t* v;
+  int width;
+  int height;
+  int y_stride;
+  int uv_stride;
+  int uv_step;
+};
+
+// With U and V centered on 0 and luma = y_scale * (Y - y_offset):
+//   R = luma + v_to_r * V
+//   G = luma - u_to_g * U - v_to_g * V
+//   B = luma + u_to_b * U
+struct YuvToRgbCoefficients {
+  float y_offset;
+  float y_scale;
+  float v_to_r;
+  float u_to_g;
+  float v_to_g;
+  float u_to_b;
+};
+
+// Writes output pixels [begin, end) of one row, whose input positions
+// (px + x * dx_x, py + x * dx_y) are all inside the image, away from the
+// right and bottom edges (see InteriorLimitX/Y).
+using InteriorRowFn = void (*)(const SourceImage& src, float px, float py,
+                               float dx_x, float dx_y, int begin, int end,
+                               const ValueTransformation& transform,
+                               float* row);
+using InteriorYuvRowFn = void (*)(const YuvSourceImage& src,
+                                  const YuvToRgbCoefficients& coeffs,
+                                  float px, float py, float dx_x, float dx_y,
+                                  int begin, int end,
+                                  const ValueTransformation& transform,
+                                  float* row);
+
+// Interior positions satisfy 0 <= x < InteriorLimitX and 0 <= y <
+// InteriorLimitY, so that all four bilinear taps are inside the image. For
+// 3-channel input the limit leaves one more pixel, because the vectorized
+// kernels read every pixel as 4 bytes.
+template <int kChannels>
+int InteriorLimitX(int width) {
+  return kChannels == 3 ? width - 2 : width - 1;
+}
+int InteriorLimitY(int height) { return height - 1; }
+// For YUV input, the vectorized kernels read 4 bytes at the luma and chroma
+// positions of the left taps.
+int YuvInteriorLimitX(int width) { return width - 6; }
+
+// Returns the weight of the right (or bottom) taps of position |s| whose left
+// (or top) tap was clamped to |index|. A position that rounding moved past the
+// clamped range samples the nearest pair of pixels at its edge.
+inline float TapFraction(float s, int index) {
+  return std::min(std::max(s - index, 0.0f), 1.0f);
+}
+
+// Interpolates the RGB values of the four pixels around a sampled position,
+// given top left, top right, bottom left and bottom right.
+inline void Interpolate(const float (&taps)[4][kNumOutputChannels], float fx,
+                        float fy, const ValueTransformation& transform,
+                        float* out) {
+  for (int c = 0; c < kNumOutputChannels; ++c) {
+    const float top = taps[0][c] + fx * (taps[1][c] - taps[0][c]);
+    const float bottom = taps[2][c] + fx * (taps[3][c] - taps[2][c]);
+    out[c] = (top + fy * (bottom - top)) * transform.scale + transform.offset;
+  }
+}
+
+template <int kChannels>
+inline void SampleInterior(const SourceImage& src, float sx, float sy,
+                           const ValueTransformation& transform, float* out) {
+  const int x = std::min(std::max(static_cast<int>(std::floor(sx)), 0),
+                         InteriorLimitX<kChannels>(src.width) - 1);
+  const int y = std::min(std::max(static_cast<int>(std::floor(sy)), 0),
+                         InteriorLimitY(src.height) - 1);
+  const float fx = TapFraction(sx, x);
+  const float fy = TapFraction(sy, y);
+  const uint8_t* p0 = src.data + y * src.stride + x * kChannels;
+  const uint8_t* p1 = p0 + src.stride;
+  for (int c = 0; c < kNumOutputChannels; ++c) {
+    const float top = p0[c] + fx * (p0[c + kChannels] - p0[c]);
+    const float bottom = p1[c] + fx * (p1[c + kChannels] - p1[c]);
+    out[c] = (top + fy * (bottom - top)) * transform.scale + transform.offset;
+  }
+}
+
+// Samples a position that may be near or outside the border of a width x
+// height image. load_pixel(x, y, rgb) reads a pixel inside the image.
+template <typename LoadPixel>
+void SampleTapsWithBorder(int width, int height, float sx, float sy,
+                          BorderMode border_mode,
+                          const ValueTransformation& transform,
+                          const LoadPixel& load_pixel, float* out) {
+  // Positions further out than this sample only border pixels anyway; the
+  // clamp keeps the integer conversion below well-defined.
+  sx = std::min(std::max(sx, -2.0f), width + 1.0f);
+  sy = std::min(std::max(sy, -2.0f), height + 1.0f);
+  const float floor_x = std::floor(sx);
+  const float floor_y = std::floor(sy);
+  const float fx = sx - floor_x;
+  const float fy = sy - floor_y;
+  const int x0 = static_cast<int>(floor_x);
+  const int y0 = static_cast<int>(floor_y);
+  float taps[4][kNumOutputChannels];
+  for (int i = 0; i < 4; ++i) {
+    int x = x0 + (i & 1);
+    int y = y0 + (i >> 1);
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+      if (border_mode == BorderMode::kZero) {
+        std::fill_n(taps[i], kNumOutputChannels, 0.0f);
+        continue;
+      }
+      x = std::min(std::max(x, 0), width - 1);
+      y = std::min(std::max(y, 0), height - 1);
+    }
+    load_pixel(x, y, taps[i]);
+  }
+  Interpolate(taps, fx, fy, transform, out);
+}
+
+template <int kChannels>
+void SampleWithBorder(const SourceImage& src, float sx, float sy,
+                      BorderMode border_mode,
+                      const ValueTransformation& transform, float* out) {
+  SampleTapsWithBorder(
+      src.width, src.height, sx, sy, border_mode, transform,
+      [&src](int x, int y, float* rgb) {
+        const uint8_t* p = src.data + y * src.stride + x * kChannels;
+        for (int c = 0; c < kNumOutputChannels; ++c) {
+          rgb[c] = p[c];
+        }
+      },
+      out);
+}
+
+// Converts a YUV sample, with U and V centered on 0, to RGB in [0, 255].
+inline void YuvToRgb(const YuvToRgbCoefficients& coeffs, float y, float u,
+                     float v, float* rgb) {
+  const float luma = (y - coeffs.y_offset) * coeffs.y_scale;
+  rgb[0] = luma + coeffs.v_to_r * v;
+  rgb[1] = luma - coeffs.u_to_g * u - coeffs.v_to_g * v;
+  rgb[2] = luma + coeffs.u_to_b * u;
+  for (int c = 0; c < kNumOutputChannels; ++c) {
+    rgb[c] = std::min(std::max(rgb[c], 0.0f), 255.0f);
+  }
+}
+
+// Converts pixel (x, y) to RGB. Each 2x2 block of pixels shares one U and V
+// sample, as in the libyuv conversions to RGB, so that sampling the YUV image
+// gives the same result as sampling the image converted by libyuv.
+inline void LoadYuvPixel(const YuvSourceImage& src,
+                         const YuvToRgbCoefficients& coeffs, int x, int y,
+                         float* rgb) {
+  const int uv = (y >> 1) * src.uv_stride + (x >> 1) * src.uv_step;
+  YuvToRgb(coeffs, src.y[y * src.y_stride + x], src.u[uv] - 128.0f,
+           src.v[uv] - 128.0f, rgb);
+}
+
+inline void SampleYuvInterior(const YuvSourceImage& src,
+                              const YuvToRgbCoefficients& coeffs, float sx,
+                              float sy, const ValueTransformation& transform,
+                              float* out) {
+  const int x = std::min(std::max(static_cast<int>(std::floor(sx)), 0),
+                         YuvInteriorLimitX(src.width) - 1);
+  const int y = std::min(std::max(static_cast<int>(std::floor(sy)), 0),
+                         InteriorLimitY(src.height) - 1);
+  float taps[4][kNumOutputChannels];
+  LoadYuvPixel(src, coeffs, x, y, taps[0]);
+  LoadYuvPixel(src, coeffs, x + 1, y, taps[1]);
+  LoadYuvPixel(src, coeffs, x, y + 1, taps[2]);
+  LoadYuvPixel(src, coeffs, x + 1, y + 1, taps[3]);
+  Interpolate(taps, TapFraction(sx, x), TapFraction(sy, y), transform, out);
+}
+
+void SampleYuvWithBorder(const YuvSourceImage& src,
+                         const YuvToRgbCoefficients& coeffs, float sx,
+                         float sy, BorderMode border_mode,
+                         const ValueTransformation& transform, float* out) {
+  SampleTapsWithBorder(
+      src.width, src.height, sx, sy, border_mode, transform,
+      [&src, &coeffs](int x, int y, float* rgb) {
+        LoadYuvPixel(src, coeffs, x, y, rgb);
+      },
+      out);
+}
+
+template <int kChannels>
+void InteriorRowScalar(const SourceImage& src, float px, float py, float dx_x,
+                       float dx_y, int begin, int end,
+                       const ValueTransformation& transform, float* row) {
+  for (int x = begin; x < end; ++x) {
+    SampleInterior<kChannels>(src, px + x * dx_x, py + x * dx_y, transform,
+                              row + x * kNumOutputChannels);
+  }
+}
+
+void InteriorYuvRowScalar(const YuvSourceImage& src,
+                          const YuvToRgbCoefficients& coeffs, float px,
+                          float py, float dx_x, float dx_y, int begin, int end,
+                          const ValueTransformation& transform, float* row) {
+  for (int x = begin; x < end; ++x) {
+    SampleYuvInterior(src, coeffs, px + x * dx_x, py + x * dx_y, transform,
+                      row + x * kNumOutputChannels);
+  }
+}
+
+#if MEDIAPIPE_IMAGE_TO_TENSOR_AVX2
+// The vector form of TapFraction().
+__attribute__((target("avx2,fma"))) inline __m256 TapFraction(__m256 s,
+                                                               __m256i index) {
+  return _mm256_min_ps(
+      _mm256_max_ps(_mm256_sub_ps(s, _mm256_cvtepi32_ps(index)),
+                    _mm256_setzero_ps()),
+      _mm256_set1_ps(1.0f));
+}
+
+// Processes 8 pixels at a time. Every pixel is gathered as a 32-bit word, and
+// the first three bytes of each word are used.
+template <int kChannels>
+__attribute__((target("avx2,fma"))) void InteriorRowAvx2(
+    const SourceImage& src, float px, float py, float dx_x, float dx_y,
+    int begin, int end, const ValueTransformation& transform, float* row) {
+  const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 v_px = _mm256_set1_ps(px);
+  const __m256 v_py = _mm256_set1_ps(py);
+  const __m256 v_dx_x = _mm256_set1_ps(dx_x);
+  const __m256 v_dx_y = _mm256_set1_ps(dx_y);
+  const __m256 v_scale = _mm256_set1_ps(transform.scale);
+  const __m256 v_offset = _mm256_set1_ps(transform.offset);
+  const __m256i v_zero = _mm256_setzero_si256();
+  const __m256i v_max_x =
+      _mm256_set1_epi32(InteriorLimitX<kChannels>(src.width) - 1);
+  const __m256i v_max_y = _mm256_set1_epi32(InteriorLimitY(src.height) - 1);
+  const __m256i v_stride = _mm256_set1_epi32(src.stride);
+  const __m256i v_channels = _mm256_set1_epi32(kChannels);
+  const __m256i v_byte_mask = _mm256_set1_epi32(0xff);
+  const int* base = reinterpret_cast<const int*>(src.data);
+
+  alignas(32) float channels[kNumOutputChannels][8];
+  int x = begin;
+  for (; x + 8 <= end; x += 8) {
+    const __m256 xs = _mm256_add_ps(_mm256_set1_ps(x), lanes);
+    const __m256 sx = _mm256_fmadd_ps(xs, v_dx_x, v_px);
+    const __m256 sy = _mm256_fmadd_ps(xs, v_dx_y, v_py);
+    const __m256i ix = _mm256_min_epi32(
+        _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(sx)), v_zero),
+        v_max_x);
+    const __m256i iy = _mm256_min_epi32(
+        _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(sy)), v_zero),
+        v_max_y);
+    const __m256 fx = TapFraction(sx, ix);
+    const __m256 fy = TapFraction(sy, iy);
+    const __m256i offset00 =
+        _mm256_add_epi32(_mm256_mullo_epi32(iy, v_stride),
+                         _mm256_mullo_epi32(ix, v_channels));
+    const __m256i offset01 = _mm256_add_epi32(offset00, v_channels);
+    const __m256i offset10 = _mm256_add_epi32(offset00, v_stride);
+    const __m256i offset11 = _mm256_add_epi32(offset10, v_channels);
+    __m256i p00 = _mm256_i32gather_epi32(base, offset00, 1);
+    __m256i p01 = _mm256_i32gather_epi32(base, offset01, 1);
+    __m256i p10 = _mm256_i32gather_epi32(base, offset10, 1);
+    __m256i p11 = _mm256_i32gather_epi32(base, offset11, 1);
+    for (int c = 0; c < kNumOutputChannels; ++c) {
+      const __m256 c00 =
+          _mm256_cvtepi32_ps(_mm256_and_si256(p00, v_byte_mask));
+      const __m256 c01 =
+          _mm256_cvtepi32_ps(_mm256_and_si256(p01, v_byte_mask));
+      const __m256 c10 =
+          _mm256_cvtepi32_ps(_mm256_and_si256(p10, v_byte_mask));
+      const __m256 c11 =
+          _mm256_cvtepi32_ps(_mm256_and_si256(p11, v_byte_mask));
+      const __m256 top = _mm256_fmadd_ps(fx, _mm256_sub_ps(c01, c00), c00);
+      const __m256 bottom = _mm256_fmadd_ps(fx, _mm256_sub_ps(c11, c10), c10);
+      const __m256 value =
+          _mm256_fmadd_ps(fy, _mm256_sub_ps(bottom, top), top);
+      _mm256_store_ps(channels[c], _mm256_fmadd_ps(value, v_scale, v_offset));
+      p00 = _mm256_srli_epi32(p00, 8);
+      p01 = _mm256_srli_epi32(p01, 8);
+      p10 = _mm256_srli_epi32(p10, 8);
+      p11 = _mm256_srli_epi32(p11, 8);
+    }
+    float* out = row + x * kNumOutputChannels;
+    for (int i = 0; i < 8; ++i) {
+      out[i * kNumOutputChannels + 0] = channels[0][i];
+      out[i * kNumOutputChannels + 1] = channels[1][i];
+      out[i * kNumOutputChannels + 2] = channels[2][i];
+    }
+  }
+  InteriorRowScalar<kChannels>(src, px, py, dx_x, dx_y, x, end, transform,
+                               row);
+}
+
+// Converts 8 YUV samples, given as bytes in 32-bit lanes, to RGB as in
+// YuvToRgb().
+__attribute__((target("avx2,fma"))) inline void YuvToRgbAvx2(
+    const YuvToRgbCoefficients& coeffs, __m256i y, __m256i u, __m256i v,
+    __m256 (&rgb)[kNumOutputChannels]) {
+  const __m256 v_128 = _mm256_set1_ps(128.0f);
+  const __m256 luma = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_cvtepi32_ps(y), _mm256_set1_ps(coeffs.y_offset)),
+      _mm256_set1_ps(coeffs.y_scale));
+  const __m256 uf = _mm256_sub_ps(_mm256_cvtepi32_ps(u), v_128);
+  const __m256 vf = _mm256_sub_ps(_mm256_cvtepi32_ps(v), v_128);
+  rgb[0] = _mm256_fmadd_ps(_mm256_set1_ps(coeffs.v_to_r), vf, luma);
+  rgb[1] = _mm256_fnmadd_ps(
+      _mm256_set1_ps(coeffs.u_to_g), uf,
+      _mm256_fnmadd_ps(_mm256_set1_ps(coeffs.v_to_g), vf, luma));
+  rgb[2] = _mm256_fmadd_ps(_mm256_set1_ps(coeffs.u_to_b), uf, luma);
+  for (int c = 0; c < kNumOutputChannels; ++c) {
+    rgb[c] = _mm256_min_ps(_mm256_max_ps(rgb[c], _mm256_setzero_ps()),
+                           _mm256_set1_ps(255.0f));
+  }
+}
+
+// Processes 8 pixels at a time. The two luma taps of a row are gathered as one
+// 32-bit word. So are the two chroma taps of a chroma row, since pixels x and
+// x + 1 use the chroma samples x / 2 and (x + 1) / 2, which are the same or
+// adjacent.
+__attribute__((target("avx2,fma"))) void InteriorYuvRowAvx2(
+    const YuvSourceImage& src, const YuvToRgbCoefficients& coeffs, float px,
+    float py, float dx_x, float dx_y, int begin, int end,
+    const ValueTransformation& transform, float* row) {
+  const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 v_px = _mm256_set1_ps(px);
+  const __m256 v_py = _mm256_set1_ps(py);
+  const __m256 v_dx_x = _mm256_set1_ps(dx_x);
+  const __m256 v_dx_y = _mm256_set1_ps(dx_y);
+  const __m256 v_scale = _mm256_set1_ps(transform.scale);
+  const __m256 v_offset = _mm256_set1_ps(transform.offset);
+  const __m256i v_zero = _mm256_setzero_si256();
+  const __m256i v_one = _mm256_set1_epi32(1);
+  const __m256i v_max_x = _mm256_set1_epi32(YuvInteriorLimitX(src.width) - 1);
+  const __m256i v_max_y = _mm256_set1_epi32(InteriorLimitY(src.height) - 1);
+  const __m256i v_y_stride = _mm256_set1_epi32(src.y_stride);
+  const __m256i v_uv_stride = _mm256_set1_epi32(src.uv_stride);
+  const __m256i v_uv_step = _mm256_set1_epi32(src.uv_step);
+  const __m256i v_uv_step_bits = _mm256_set1_epi32(8 * src.uv_step);
+  const __m256i v_byte_mask = _mm256_set1_epi32(0xff);
+  const int* y_base = reinterpret_cast<const int*>(src.y);
+  const int* u_base = reinterpret_cast<const int*>(src.u);
+  const int* v_base = reinterpret_cast<const int*>(src.v);
+
+  alignas(32) float channels[kNumOutputChannels][8];
+  int x = begin;
+  for (; x + 8 <= end; x += 8) {
+    const __m256 xs = _mm256_add_ps(_mm256_set1_ps(x), lanes);
+    const __m256 sx = _mm256_fmadd_ps(xs, v_dx_x, v_px);
+    const __m256 sy = _mm256_fmadd_ps(xs, v_dx_y, v_py);
+    const __m256i ix = _mm256_min_epi32(
+        _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(sx)), v_zero),
+        v_max_x);
+    const __m256i iy = _mm256_min_epi32(
+        _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(sy)), v_zero),
+        v_max_y);
+    const __m256 fx = TapFraction(sx, ix);
+    const __m256 fy = TapFraction(sy, iy);
+
+    const __m256i y_offset0 =
+        _mm256_add_epi32(_mm256_mullo_epi32(iy, v_y_stride), ix);
+    const __m256i luma0 = _mm256_i32gather_epi32(y_base, y_offset0, 1);
+    const __m256i luma1 = _mm256_i32gather_epi32(
+        y_base, _mm256_add_epi32(y_offset0, v_y_stride), 1);
+
+    const __m256i uv_x =
+        _mm256_mullo_epi32(_mm256_srli_epi32(ix, 1), v_uv_step);
+    const __m256i uv_offset0 = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srli_epi32(iy, 1), v_uv_stride), uv_x);
+    const __m256i uv_offset1 = _mm256_add_epi32(
+        _mm256_mullo_epi32(
+            _mm256_srli_epi32(_mm256_add_epi32(iy, v_one), 1), v_uv_stride),
+        uv_x);
+    // The right taps use the next chroma sample if x is odd.
+    const __m256i uv_shift =
+        _mm256_mullo_epi32(_mm256_and_si256(ix, v_one), v_uv_step_bits);
+    const __m256i u0 = _mm256_i32gather_epi32(u_base, uv_offset0, 1);
+    const __m256i u1 = _mm256_i32gather_epi32(u_base, uv_offset1, 1);
+    const __m256i v0 = _mm256_i32gather_epi32(v_base, uv_offset0, 1);
+    const __m256i v1 = _mm256_i32gather_epi32(v_base, uv_offset1, 1);
+
+    __m256 taps[4][kNumOutputChannels];
+    YuvToRgbAvx2(coeffs, _mm256_and_si256(luma0, v_byte_mask),
+                 _mm256_and_si256(u0, v_byte_mask),
+                 _mm256_and_si256(v0, v_byte_mask), taps[0]);
+    YuvToRgbAvx2(
+        coeffs, _mm256_and_si256(_mm256_srli_epi32(luma0, 8), v_byte_mask),
+        _mm256_and_si256(_mm256_srlv_epi32(u0, uv_shift), v_byte_mask),
+        _mm256_and_si256(_mm256_srlv_epi32(v0, uv_shift), v_byte_mask),
+        taps[1]);
+    YuvToRgbAvx2(coeffs, _mm256_and_si256(luma1, v_byte_mask),
+                 _mm256_and_si256(u1, v_byte_mask),
+                 _mm256_and_si256(v1, v_byte_mask), taps[2]);
+    YuvToRgbAvx2(
+        coeffs, _mm256_and_si256(_mm256_srli_epi32(luma1, 8), v_byte_mask),
+        _mm256_and_si256(_mm256_srlv_epi32(u1, uv_shift), v_byte_mask),
+        _mm256_and_si256(_mm256_srlv_epi32(v1, uv_shift), v_byte_mask),
+        taps[3]);
+    for (int c = 0; c < kNumOutputChannels; ++c) {
+      const __m256 top = _mm256_fmadd_ps(
+          fx, _mm256_sub_ps(taps[1][c], taps[0][c]), taps[0][c]);
+      const __m256 bottom = _mm256_fmadd_ps(
+          fx, _mm256_sub_ps(taps[3][c], taps[2][c]), taps[2][c]);
+      const __m256 value =
+          _mm256_fmadd_ps(fy, _mm256_sub_ps(bottom, top), top);
+      _mm256_store_ps(channels[c], _mm256_fmadd_ps(value, v_scale, v_offset));
+    }
+    float* out = row + x * kNumOutputChannels;
+    for (int i = 0; i < 8; ++i) {
+      out[i * kNumOutputChannels + 0] = channels[0][i];
+      out[i * kNumOutputChannels + 1] = channels[1][i];
+      out[i * kNumOutputChannels + 2] = channels[2][i];
+    }
+  }
+  InteriorYuvRowScalar(src, coeffs, px, py, dx_x, dx_y, x, end, transform,
+                       row);
+}
+#endif  // MEDIAPIPE_IMAGE_TO_TENSOR_AVX2
+
+#if MEDIAPIPE_IMAGE_TO_TENSOR_NEON
+// The vector form of TapFraction().
+inline float32x4_t TapFraction(float32x4_t s, int32x4_t index) {
+  return vminq_f32(
+      vmaxq_f32(vsubq_f32(s, vcvtq_f32_s32(index)), vdupq_n_f32(0.0f)),
+      vdupq_n_f32(1.0f));
+}
+
+// Processes 4 pixels at a time. NEON has no gather, so each pixel is loaded as
+// a 32-bit word with scalar loads, and the first three bytes are used.
+template <int kChannels>
+void InteriorRowNeon(const SourceImage& src, float px, float py, float dx_x,
+                     float dx_y, int begin, int end,
+                     const ValueTransformation& transform, float* row) {
+  const float lane_values[4] = {0, 1, 2, 3};
+  const float32x4_t lanes = vld1q_f32(lane_values);
+  const float32x4_t v_px = vdupq_n_f32(px);
+  const float32x4_t v_py = vdupq_n_f32(py);
+  const float32x4_t v_dx_x = vdupq_n_f32(dx_x);
+  const float32x4_t v_dx_y = vdupq_n_f32(dx_y);
+  const float32x4_t v_scale = vdupq_n_f32(transform.scale);
+  const float32x4_t v_offset = vdupq_n_f32(transform.offset);
+  const int32x4_t v_zero = vdupq_n_s32(0);
+  const int32x4_t v_max_x =
+      vdupq_n_s32(InteriorLimitX<kChannels>(src.width) - 1);
+  const int32x4_t v_max_y = vdupq_n_s32(InteriorLimitY(src.height) - 1);
+  const int32x4_t v_stride = vdupq_n_s32(src.stride);
+  const uint32x4_t v_byte_mask = vdupq_n_u32(0xff);
+
+  int x = begin;
+  for (; x + 4 <= end; x += 4) {
+    const float32x4_t xs = vaddq_f32(vdupq_n_f32(x), lanes);
+    const float32x4_t sx = vmlaq_f32(v_px, xs, v_dx_x);
+    const float32x4_t sy = vmlaq_f32(v_py, xs, v_dx_y);
+    // Interior positions are non-negative (up to rounding), so truncation
+    // rounds down.
+    const int32x4_t ix =
+        vminq_s32(vmaxq_s32(vcvtq_s32_f32(sx), v_zero), v_max_x);
+    const int32x4_t iy =
+        vminq_s32(vmaxq_s32(vcvtq_s32_f32(sy), v_zero), v_max_y);
+    const float32x4_t fx = TapFraction(sx, ix);
+    const float32x4_t fy = TapFraction(sy, iy);
+    int32_t offsets[4];
+    vst1q_s32(offsets,
+              vmlaq_s32(vmulq_n_s32(ix, kChannels), iy, v_stride));
+    uint32_t words[4][4];
+    for (int i = 0; i < 4; ++i) {
+      const uint8_t* p = src.data + offsets[i];
+      std::memcpy(&words[0][i], p, 4);
+      std::memcpy(&words[1][i], p + kChannels, 4);
+      std::memcpy(&words[2][i], p + src.stride, 4);
+      std::memcpy(&words[3][i], p + src.stride + kChannels, 4);
+    }
+    uint32x4_t p00 = vld1q_u32(words[0]);
+    uint32x4_t p01 = vld1q_u32(words[1]);
+    uint32x4_t p10 = vld1q_u32(words[2]);
+    uint32x4_t p11 = vld1q_u32(words[3]);
+    float32x4x3_t result;
+    for (int c = 0; c < kNumOutputChannels; ++c) {
+      const float32x4_t c00 = vcvtq_f32_u32(vandq_u32(p00, v_byte_mask));
+      const float32x4_t c01 = vcvtq_f32_u32(vandq_u32(p01, v_byte_mask));
+      const float32x4_t c10 = vcvtq_f32_u32(vandq_u32(p10, v_byte_mask));
+      const float32x4_t c11 = vcvtq_f32_u32(vandq_u32(p11, v_byte_mask));
+      const float32x4_t top = vmlaq_f32(c00, fx, vsubq_f32(c01, c00));
+      const float32x4_t bottom = vmlaq_f32(c10, fx, vsubq_f32(c11, c10));
+      const float32x4_t value = vmlaq_f32(top, fy, vsubq_f32(bottom, top));
+      result.val[c] = vmlaq_f32(v_offset, value, v_scale);
+      p00 = vshrq_n_u32(p00, 8);
+      p01 = vshrq_n_u32(p01, 8);
+      p10 = vshrq_n_u32(p10, 8);
+      p11 = vshrq_n_u32(p11, 8);
+    }
+    vst3q_f32(row + x * kNumOutputChannels, result);
+  }
+  InteriorRowScalar<kChannels>(src, px, py, dx_x, dx_y, x, end, transform,
+                               row);
+}
+
+// Processes 4 pixels at a time. The taps are loaded with scalar loads, and
+// converted to RGB and interpolated with NEON.
+void InteriorYuvRowNeon(const YuvSourceImage& src,
+                        const YuvToRgbCoefficients& coeffs, float px, float py,
+                        float dx_x, float dx_y, int begin, int end,
+                        const ValueTransformation& transform, float* row) {
+  const float lane_values[4] = {0, 1, 2, 3};
+  const float32x4_t lanes = vld1q_f32(lane_values);
+  const float32x4_t v_px = vdupq_n_f32(px);
+  const float32x4_t v_py = vdupq_n_f32(py);
+  const float32x4_t v_dx_x = vdupq_n_f32(dx_x);
+  const float32x4_t v_dx_y = vdupq_n_f32(dx_y);
+  const float32x4_t v_scale = vdupq_n_f32(transform.scale);
+  const float32x4_t v_offset = vdupq_n_f32(transform.offset);
+  const float32x4_t v_y_offset = vdupq_n_f32(coeffs.y_offset);
+  const float32x4_t v_y_scale = vdupq_n_f32(coeffs.y_scale);
+  const float32x4_t v_128 = vdupq_n_f32(128.0f);
+  const float32x4_t v_min = vdupq_n_f32(0.0f);
+  const float32x4_t v_max = vdupq_n_f32(255.0f);
+  const int32x4_t v_zero = vdupq_n_s32(0);
+  const int32x4_t v_max_x = vdupq_n_s32(YuvInteriorLimitX(src.width) - 1);
+  const int32x4_t v_max_y = vdupq_n_s32(InteriorLimitY(src.height) - 1);
+
+  int x = begin;
+  for (; x + 4 <= end; x += 4) {
+    const float32x4_t xs = vaddq_f32(vdupq_n_f32(x), lanes);
+    const float32x4_t sx = vmlaq_f32(v_px, xs, v_dx_x);
+    const float32x4_t sy = vmlaq_f32(v_py, xs, v_dx_y);
+    // Interior positions are non-negative (up to rounding), so truncation
+    // rounds down.
+    const int32x4_t ix =
+        vminq_s32(vmaxq_s32(vcvtq_s32_f32(sx), v_zero), v_max_x);
+    const int32x4_t iy =
+        vminq_s32(vmaxq_s32(vcvtq_s32_f32(sy), v_zero), v_max_y);
+    const float32x4_t fx = TapFraction(sx, ix);
+    const float32x4_t fy = TapFraction(sy, iy);
+    int32_t xs_int[4];
+    int32_t ys_int[4];
+    vst1q_s32(xs_int, ix);
+    vst1q_s32(ys_int, iy);
+    // Y, U and V of the top left, top right, bottom left and bottom right
+    // taps.
+    uint32_t samples[4][3][4];
+    for (int i = 0; i < 4; ++i) {
+      for (int tap = 0; tap < 4; ++tap) {
+        const int tx = xs_int[i] + (tap & 1);
+        const int ty = ys_int[i] + (tap >> 1);
+        const int uv = (ty >> 1) * src.uv_stride + (tx >> 1) * src.uv_step;
+        samples[tap][0][i] = src.y[ty * src.y_stride + tx];
+        samples[tap][1][i] = src.u[uv];
+        samples[tap][2][i] = src.v[uv];
+      }
+    }
+    float32x4_t taps[4][kNumOutputChannels];
+    for (int tap = 0; tap < 4; ++tap) {
+      const float32x4_t luma = vmulq_f32(
+          vsubq_f32(vcvtq_f32_u32(vld1q_u32(samples[tap][0])), v_y_offset),
+          v_y_scale);
+      const float32x4_t u =
+          vsubq_f32(vcvtq_f32_u32(vld1q_u32(samples[tap][1])), v_128);
+      const float32x4_t v =
+          vsubq_f32(vcvtq_f32_u32(vld1q_u32(samples[tap][2])), v_128);
+      taps[tap][0] = vmlaq_n_f32(luma, v, coeffs.v_to_r);
+      taps[tap][1] = vmlsq_n_f32(vmlsq_n_f32(luma, u, coeffs.u_to_g), v,
+                                 coeffs.v_to_g);
+      taps[tap][2] = vmlaq_n_f32(luma, u, coeffs.u_to_b);
+      for (int c = 0; c < kNumOutputChannels; ++c) {
+        taps[tap][c] = vminq_f32(vmaxq_f32(taps[tap][c], v_min), v_max);
+      }
+    }
+    float32x4x3_t result;
+    for (int c = 0; c < kNumOutputChannels; ++c) {
+      const float32x4_t top =
+          vmlaq_f32(taps[0][c], fx, vsubq_f32(taps[1][c], taps[0][c]));
+      const float32x4_t bottom =
+          vmlaq_f32(taps[2][c], fx, vsubq_f32(taps[3][c], taps[2][c]));
+      const float32x4_t value = vmlaq_f32(top, fy, vsubq_f32(bottom, top));
+      result.val[c] = vmlaq_f32(v_offset, value, v_scale);
+    }
+    vst3q_f32(row + x * kNumOutputChannels, result);
+  }
+  InteriorYuvRowScalar(src, coeffs, px, py, dx_x, dx_y, x, end, transform,
+                       row);
+}
+#endif  // MEDIAPIPE_IMAGE_TO_TENSOR_NEON
+
+struct InteriorRowKernels {
+  InteriorRowFn rgb;
+  InteriorRowFn rgba;
+  InteriorYuvRowFn yuv;
+};
+
+InteriorRowKernels GetInteriorRowKernels() {
+#if MEDIAPIPE_IMAGE_TO_TENSOR_AVX2
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return {&InteriorRowAvx2<3>, &InteriorRowAvx2<4>, &InteriorYuvRowAvx2};
+  }
+#elif MEDIAPIPE_IMAGE_TO_TENSOR_NEON
+  return {&InteriorRowNeon<3>, &InteriorRowNeon<4>, &InteriorYuvRowNeon};
+#endif
+  return {&InteriorRowScalar<3>, &InteriorRowScalar<4>, &InteriorYuvRowScalar};
+}
+
+// Narrows [*begin, *end) to the x for which lo <= a + b * x < hi.
+void IntersectRange(double a, double b, double lo, double hi, int* begin,
+                    int* end) {
+  if (b == 0) {
+    if (a < lo || a >= hi) *end = *begin;
+    return;
+  }
+  double x_lo = (lo - a) / b;
+  double x_hi = (hi - a) / b;
+  if (b < 0) std::swap(x_lo, x_hi);
+  // Clamping to [-1, *end] keeps the conversions below in range and *begin
+  // within the row.
+  x_lo = std::min(std::max(x_lo, -1.0), static_cast<double>(*end));
+  x_hi = std::min(std::max(x_hi, -1.0), static_cast<double>(*end));
+  *begin = std::max(*begin, static_cast<int>(std::ceil(x_lo)));
+  *end = std::min(*end, static_cast<int>(std::floor(x_hi)));
+  if (*end < *begin) *end = *begin;
+}
+
+absl::StatusOr<YuvSourceImage> GetYuvSourceImage(const YUVImage& image) {
+  if (image.bit_depth() != 8) {
+    return InvalidArgumentError(
+        absl::StrCat("Only 8-bit YUVImage is supported, passed bit depth: ",
+                     image.bit_depth()));
+  }
+  switch (image.fourcc()) {
+    case libyuv::FOURCC_I420:
+      if (image.stride(1) != image.stride(2)) {
+        return InvalidArgumentError(
+            "I420 YUVImage U and V planes must have the same stride.");
+      }
+      return YuvSourceImage{image.data(0), image.data(1), image.data(2),
+                            image.width(), image.height(), image.stride(0),
+                            image.stride(1), /*uv_step=*/1};
+    case libyuv::FOURCC_NV12:
+      return YuvSourceImage{image.data(0), image.data(1), image.data(1) + 1,
+                            image.width(), image.height(), image.stride(0),
+                            image.stride(1), /*uv_step=*/2};
+    case libyuv::FOURCC_NV21:
+      return YuvSourceImage{image.data(0), image.data(1) + 1, image.data(1),
+                            image.width(), image.height(), image.stride(0),
+                            image.stride(1), /*uv_step=*/2};
+    default:
+      return InvalidArgumentError(absl::StrCat(
+          "Only I420, NV12 and NV21 YUVImage formats are supported, passed "
+          "fourcc: ",
+          static_cast<uint32_t>(image.fourcc())));
+  }
+}
+
+// BT.709 if the image specifies it, and BT.601 otherwise, as in
+// image_frame_util::YUVImageToImageFrame().
+YuvToRgbCoefficients GetYuvToRgbCoefficients(const YUVImage& image) {
+  const bool bt709 = image.matrix_coefficients() ==
+                     YUVImage::COLOR_MATRIX_COEFFICIENTS_BT709;
+  const float kr = bt709 ? 0.2126f : 0.299f;
+  const float kb = bt709 ? 0.0722f : 0.114f;
+  const float kg = 1.0f - kr - kb;
+  // Limited range uses [16, 235] for Y and [16, 240] for U and V.
+  const float y_scale = image.full_range() ? 1.0f : 255.0f / 219.0f;
+  const float uv_scale = image.full_range() ? 1.0f : 255.0f / 224.0f;
+  return {/*y_offset=*/image.full_range() ? 0.0f : 16.0f,
+          y_scale,
+          /*v_to_r=*/uv_scale * 2.0f * (1.0f - kr),
+          /*u_to_g=*/uv_scale * 2.0f * kb * (1.0f - kb) / kg,
+          /*v_to_g=*/uv_scale * 2.0f * kr * (1.0f - kr) / kg,
+          /*u_to_b=*/uv_scale * 2.0f * (1.0f - kb)};
+}
+
+// Output pixel (x, y) samples the input at
+// (x0 + x * dx_x + y * dy_x, y0 + x * dx_y + y * dy_y).
+struct SamplingGrid {
+  float x0;
+  float y0;
+  float dx_x;
+  float dx_y;
+  float dy_x;
+  float dy_y;
+};
+
+SamplingGrid GetSamplingGrid(const RotatedRect& roi, const Size& output_dims) {
+  // Output pixel (x, y) samples the input at the same position as
+  // cv::warpPerspective does in the OpenCV converter: the output rectangle
+  // [0, width] x [0, height] is mapped onto the rotated ROI.
+  const float cos_r = std::cos(roi.rotation);
+  const float sin_r = std::sin(roi.rotation);
+  return {
+      /*x0=*/roi.center_x - 0.5f * roi.width * cos_r +
+          0.5f * roi.height * sin_r,
+      /*y0=*/roi.center_y - 0.5f * roi.width * sin_r -
+          0.5f * roi.height * cos_r,
+      /*dx_x=*/roi.width / output_dims.width * cos_r,
+      /*dx_y=*/roi.width / output_dims.width * sin_r,
+      /*dy_x=*/-roi.height / output_dims.height * sin_r,
+      /*dy_y=*/roi.height / output_dims.height * cos_r};
+}
+
+// Fills the output tensor row by row. interior_row(px, py, begin, end, row)
+// writes the pixels [begin, end) of a row starting at input position (px, py),
+// whose input positions are all inside [0, limit_x) x [0, limit_y), and
+// sample_with_border(sx, sy, out) writes the other pixels.
+template <typename InteriorRow, typename SampleWithBorderAt>
+void ConvertRows(const SamplingGrid& grid, const Size& output_dims,
+                 int limit_x, int limit_y, const InteriorRow& interior_row,
+                 const SampleWithBorderAt& sample_with_border, float* output) {
+  const bool has_interior = limit_x > 0 && limit_y > 0;
+  for (int y = 0; y < output_dims.height; ++y) {
+    float* row = output + y * output_dims.width * kNumOutputChannels;
+    const float px = grid.x0 + y * grid.dy_x;
+    const float py = grid.y0 + y * grid.dy_y;
+    // The input positions of a row lie on a line, so the pixels that need
+    // no border handling form a single range.
+    int begin = 0;
+    int end = has_interior ? output_dims.width : 0;
+    IntersectRange(px, grid.dx_x, 0, limit_x, &begin, &end);
+    IntersectRange(py, grid.dx_y, 0, limit_y, &begin, &end);
+    for (int x = 0; x < begin; ++x) {
+      sample_with_border(px + x * grid.dx_x, py + x * grid.dx_y,
+                         row + x * kNumOutputChannels);
+    }
+    interior_row(px, py, begin, end, row);
+    for (int x = std::max(begin, end); x < output_dims.width; ++x) {
+      sample_with_border(px + x * grid.dx_x, py + x * grid.dx_y,
+                         row + x * kNumOutputChannels);
+    }
+  }
+}
+
+class CpuProcessor : public ImageToTensorConverter {
+ public:
+  CpuProcessor(BorderMode border_mode, ServiceBinding<TensorPool> tensor_pool)
+      : border_mode_(border_mode),
+        tensor_pool_(std::move(tensor_pool)),
+        kernels_(GetInteriorRowKernels()) {}
+
+  absl::StatusOr<Tensor> Convert(const mediapipe::Image& input,
+                                 const RotatedRect& roi,
+                                 const Size& output_dims, float range_min,
+                                 float range_max) override {
+    if (input.image_format() != mediapipe::ImageFormat::SRGB &&
+        input.image_format() != mediapipe::ImageFormat::SRGBA) {
+      return InvalidArgumentError(
+          absl::StrCat("Only RGBA/RGB formats are supported, passed format: ",
+                       static_cast<uint32_t>(input.image_format())));
+    }
+    const ImageFrame& frame = *input.GetImageFrameSharedPtr();
+    const SourceImage src{frame.PixelData(), frame.Width(), frame.Height(),
+                          frame.WidthStep()};
+    ASSIGN_OR_RETURN(auto transform, GetTransformation(range_min, range_max));
+    Tensor tensor = CreateTensor(output_dims);
+    auto buffer_view = tensor.GetCpuWriteView();
+    float* output = buffer_view.buffer<float>();
+
+    const SamplingGrid grid = GetSamplingGrid(roi, output_dims);
+    if (frame.NumberOfChannels() == 4) {
+      ConvertRgbRows<4>(src, grid, output_dims, transform, kernels_.rgba,
+                        output);
+    } else {
+      ConvertRgbRows<3>(src, grid, output_dims, transform, kernels_.rgb,
+                        output);
+    }
+    return tensor;
+  }
+
+  // Samples the YUV planes directly and converts only the sampled pixels to
+  // RGB, so the result is the same as for the image converted to RGB first.
+  absl::StatusOr<Tensor> ConvertYuv(const YUVImage& input,
+                                    const RotatedRect& roi,
+                                    const Size& output_dims, float range_min,
+                                    float range_max) override {
+    ASSIGN_OR_RETURN(const YuvSourceImage src, GetYuvSourceImage(input));
+    const YuvToRgbCoefficients coeffs = GetYuvToRgbCoefficients(input);
+    ASSIGN_OR_RETURN(auto transform, GetTransformation(range_min, range_max));
+    Tensor tensor = CreateTensor(output_dims);
+    auto buffer_view = tensor.GetCpuWriteView();
+    float* output = buffer_view.buffer<float>();
+
+    const SamplingGrid grid = GetSamplingGrid(roi, output_dims);
+    ConvertRows(
+        grid, output_dims, YuvInteriorLimitX(src.width),
+        InteriorLimitY(src.height),
+        [&](float px, float py, int begin, int end, float* row) {
+          kernels_.yuv(src, coeffs, px, py, grid.dx_x, grid.dx_y, begin, end,
+                       transform, row);
+        },
+        [&](float sx, float sy, float* out) {
+          SampleYuvWithBorder(src, coeffs, sx, sy, border_mode_, transform,
+                              out);
+        },
+        output);
+    return tensor;
+  }
+
+ private:
+  static absl::StatusOr<ValueTransformation> GetTransformation(
+      float range_min, float range_max) {
+    constexpr float kInputImageRangeMin = 0.0f;
+    constexpr float kInputImageRangeMax = 255.0f;
+    return GetValueRangeTransformation(kInputImageRangeMin,
+                                       kInputImageRangeMax, range_min,
+                                       range_max);
+  }
+
+  Tensor CreateTensor(const Size& output_dims) {
+    const Tensor::Shape shape{1, output_dims.height, output_dims.width,
+                              kNumOutputChannels};
+    return tensor_pool_.IsAvailable()
+               ? tensor_pool_.GetObject().GetTensor(
+                     Tensor::ElementType::kFloat32, shape)
+               : Tensor(Tensor::ElementType::kFloat32, shape);
+  }
+
+  template <int kChannels>
+  void ConvertRgbRows(const SourceImage& src, const SamplingGrid& grid,
+                      const Size& output_dims,
+                      const ValueTransformation& transform,
+                      InteriorRowFn interior_row, float* output) {
+    ConvertRows(
+        grid, output_dims, InteriorLimitX<kChannels>(src.width),
+        InteriorLimitY(src.height),
+        [&](float px, float py, int begin, int end, float* row) {
+          interior_row(src, px, py, grid.dx_x, grid.dx_y, begin, end,
+                       transform, row);
+        },
+        [&](float sx, float sy, float* out) {
+          SampleWithBorder<kChannels>(src, sx, sy, border_mode_, transform,
+                                      out);
+        },
+        output);
+  }
+
+  const BorderMode border_mode_;
+  ServiceBinding<TensorPool> tensor_pool_;
+  const InteriorRowKernels kernels_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateCpuConverter(
+    CalculatorContext* cc, BorderMode border_mode) {
+  return absl::make_unique<CpuProcessor>(border_mode,
+                                         cc->Service(kTensorPoolService));
+}
+
+}  // namespace mediapipe
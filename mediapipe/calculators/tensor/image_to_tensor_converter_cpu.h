@@ -0,0 +1,42 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_CPU_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_CPU_H_
+
+#include <memory>
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Creates a CPU image-to-tensor converter that samples the rotated ROI with
+// bilinear interpolation, drops alpha and applies the value range conversion
+// in a single pass over the output tensor, without intermediate images. Uses
+// AVX2 (selected at runtime) or NEON where available, and scalar code
+// otherwise.
+//
+// Also converts I420, NV12 and NV21 YUVImage input (ConvertYuv()). Only the
+// pixels sampled for the output tensor are converted to RGB, in the same pass.
+//
+// Output tensors are taken from the graph's kTensorPoolService, if the
+// calculator requested it and the graph provides one.
+absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateCpuConverter(
+    CalculatorContext* cc, BorderMode border_mode);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_CPU_H_
@@ -24,6 +24,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_opencv.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/tensor_pool.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
@@ -35,7 +36,9 @@ namespace {
 
 class OpenCvProcessor : public ImageToTensorConverter {
  public:
-  OpenCvProcessor(BorderMode border_mode) {
+  OpenCvProcessor(BorderMode border_mode,
+                  ServiceBinding<TensorPool> tensor_pool)
+      : tensor_pool_(std::move(tensor_pool)) {
     switch (border_mode) {
       case BorderMode::kReplicate:
         border_mode_ = cv::BORDER_REPLICATE;
@@ -59,9 +62,13 @@ class OpenCvProcessor : public ImageToTensorConverter {
     cv::Mat src = mediapipe::formats::MatView(&input);
 
     constexpr int kNumChannels = 3;
-    Tensor tensor(
-        Tensor::ElementType::kFloat32,
-        Tensor::Shape{1, output_dims.height, output_dims.width, kNumChannels});
+    const Tensor::Shape shape{1, output_dims.height, output_dims.width,
+                              kNumChannels};
+    Tensor tensor =
+        tensor_pool_.IsAvailable()
+            ? tensor_pool_.GetObject().GetTensor(Tensor::ElementType::kFloat32,
+                                                 shape)
+            : Tensor(Tensor::ElementType::kFloat32, shape);
     auto buffer_view = tensor.GetCpuWriteView();
     cv::Mat dst(output_dims.height, output_dims.width, CV_32FC3,
                 buffer_view.buffer<float>());
@@ -108,13 +115,15 @@ class OpenCvProcessor : public ImageToTensorConverter {
 
  private:
   enum cv::BorderTypes border_mode_;
+  ServiceBinding<TensorPool> tensor_pool_;
 };
 
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateOpenCvConverter(
     CalculatorContext* cc, BorderMode border_mode) {
-  return absl::make_unique<OpenCvProcessor>(border_mode);
+  return absl::make_unique<OpenCvProcessor>(border_mode,
+                                           cc->Service(kTensorPoolService));
 }
 
 }  // namespace mediapipe
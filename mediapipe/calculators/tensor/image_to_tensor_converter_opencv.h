@@ -24,6 +24,8 @@
 namespace mediapipe {
 
 // Creates OpenCV image-to-tensor converter.
+// Output tensors are taken from the graph's kTensorPoolService, if the
+// calculator requested it and the graph provides one.
 absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateOpenCvConverter(
     CalculatorContext* cc, BorderMode border_mode);
 
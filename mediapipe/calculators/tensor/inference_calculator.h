@@ -91,6 +91,9 @@ namespace api2 {
 // IMPORTANT Notes:
 //  Tensors are assumed to be ordered correctly (sequentially added to model).
 //  Input tensors are assumed to be of the correct size and already normalized.
+//  With "batching" set in the options (CPU only), inputs from consecutive
+//  timestamps are run in one invocation and outputs are delayed until their
+//  batch is run.
 
 class InferenceCalculator : public NodeIntf {
  public:
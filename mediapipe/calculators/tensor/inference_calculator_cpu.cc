@@ -12,13 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "mediapipe/calculators/tensor/inference_calculator.h"
+#include "mediapipe/framework/formats/tensor_pool.h"
 
 #if defined(MEDIAPIPE_ANDROID)
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
@@ -73,14 +77,47 @@ class InferenceCalculatorCpuImpl
   absl::Status Close(CalculatorContext* cc) override;
 
  private:
+  // Input tensors buffered for a batched invocation.
+  struct PendingInput {
+    Timestamp timestamp;
+    Packet<std::vector<Tensor>> tensors;
+  };
+
   absl::Status LoadModel(CalculatorContext* cc);
   absl::Status LoadDelegate(CalculatorContext* cc);
   absl::Status LoadDelegateAndAllocateTensors(CalculatorContext* cc);
 
+  // Runs the interpreter once on all pending inputs and sends one output
+  // vector per input, at the input's timestamp.
+  absl::Status InvokeBatch(CalculatorContext* cc);
+  // Resizes the batch dimension of all model inputs, if needed.
+  absl::Status ResizeBatch(int batch_size);
+  // Runs the interpreter directly on the memory of the input tensors and of
+  // newly allocated output tensors.
+  absl::Status InvokeZeroCopy(CalculatorContext* cc);
+  // Points interpreter tensor "index" at "data" for the next Invoke().
+  absl::Status BindTensor(int index, const void* data, size_t bytes);
+  // Creates an output tensor, backed by the graph's TensorPool if there is
+  // one.
+  Tensor CreateOutputTensor(std::vector<int> dims);
+
   // TfLite requires us to keep the model alive as long as the interpreter is.
   Packet<TfLiteModelPtr> model_packet_;
   std::unique_ptr<tflite::Interpreter> interpreter_;
   TfLiteDelegatePtr delegate_;
+
+  // Batching state; only used if max_batch_size_ > 1.
+  int max_batch_size_ = 1;
+  int64 max_latency_us_ = 0;
+  int current_batch_size_ = 1;
+  std::vector<std::vector<int>> model_input_dims_;
+  std::deque<PendingInput> pending_inputs_;
+
+  // Whether interpreter inputs and outputs are bound to mediapipe::Tensor
+  // memory.
+  bool zero_copy_ = false;
+
+  ServiceBinding<TensorPool> tensor_pool_;
 };
 
 absl::Status InferenceCalculatorCpuImpl::UpdateContract(
@@ -88,19 +125,74 @@ absl::Status InferenceCalculatorCpuImpl::UpdateContract(
   const auto& options = cc->Options<::mediapipe::InferenceCalculatorOptions>();
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
+  cc->UseService(kTensorPoolService).Optional();
+  if (options.batching().max_batch_size() > 1) {
+    // Outputs of a batch are sent when the batch runs, at the timestamps of
+    // earlier inputs. Process() then propagates the timestamp bound itself.
+    cc->SetTimestampOffset(TimestampDiff::Unset());
+    cc->SetProcessTimestampBounds(true);
+  }
 
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::Open(CalculatorContext* cc) {
+  tensor_pool_ = cc->Service(kTensorPoolService);
   MP_RETURN_IF_ERROR(LoadModel(cc));
-  return LoadDelegateAndAllocateTensors(cc);
+  MP_RETURN_IF_ERROR(LoadDelegateAndAllocateTensors(cc));
+
+  const auto& batching =
+      cc->Options<mediapipe::InferenceCalculatorOptions>().batching();
+  max_batch_size_ = std::max(batching.max_batch_size(), 1);
+  max_latency_us_ = batching.max_latency_us();
+  zero_copy_ = cc->Options<mediapipe::InferenceCalculatorOptions>()
+                   .zero_copy_cpu_tensors();
+  RET_CHECK(!zero_copy_ || max_batch_size_ == 1)
+      << "zero_copy_cpu_tensors cannot be combined with batching.";
+  if (max_batch_size_ > 1) {
+    for (int index : interpreter_->inputs()) {
+      const TfLiteIntArray* dims = interpreter_->tensor(index)->dims;
+      RET_CHECK(dims->size > 0 && dims->data[0] == 1)
+          << "Batching requires every model input to have a leading batch "
+             "dimension of size 1.";
+      model_input_dims_.emplace_back(dims->data, dims->data + dims->size);
+    }
+  }
+  return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::Process(CalculatorContext* cc) {
+  if (max_batch_size_ > 1) {
+    if (!kInTensors(cc).IsEmpty()) {
+      RET_CHECK(!kInTensors(cc)->empty());
+      pending_inputs_.push_back({cc->InputTimestamp(), kInTensors(cc)});
+    }
+    if (!pending_inputs_.empty()) {
+      const bool latency_exceeded =
+          max_latency_us_ > 0 &&
+          (cc->InputTimestamp() - pending_inputs_.front().timestamp).Value() >=
+              max_latency_us_;
+      if (pending_inputs_.size() < static_cast<size_t>(max_batch_size_) &&
+          !latency_exceeded) {
+        // The oldest buffered input is the earliest possible output.
+        kOutTensors(cc).SetNextTimestampBound(
+            pending_inputs_.front().timestamp);
+        return absl::OkStatus();
+      }
+      MP_RETURN_IF_ERROR(InvokeBatch(cc));
+    }
+    // Nothing is buffered, so no output can precede the next input.
+    kOutTensors(cc).SetNextTimestampBound(
+        cc->InputTimestamp().NextAllowedInStream());
+    return absl::OkStatus();
+  }
+
   if (kInTensors(cc).IsEmpty()) {
     return absl::OkStatus();
   }
+  if (zero_copy_) {
+    return InvokeZeroCopy(cc);
+  }
   const auto& input_tensors = *kInTensors(cc);
   RET_CHECK(!input_tensors.empty());
   auto output_tensors = absl::make_unique<std::vector<Tensor>>();
@@ -123,10 +215,8 @@ absl::Status InferenceCalculatorCpuImpl::Process(CalculatorContext* cc) {
   output_tensors->reserve(tensor_indexes.size());
   for (int i = 0; i < tensor_indexes.size(); ++i) {
     TfLiteTensor* tensor = interpreter_->tensor(tensor_indexes[i]);
-    output_tensors->emplace_back(
-        Tensor::ElementType::kFloat32,
-        Tensor::Shape{std::vector<int>{
-            tensor->dims->data, tensor->dims->data + tensor->dims->size}});
+    output_tensors->push_back(CreateOutputTensor(std::vector<int>{
+        tensor->dims->data, tensor->dims->data + tensor->dims->size}));
     auto cpu_view = output_tensors->back().GetCpuWriteView();
     std::memcpy(cpu_view.buffer<float>(), tensor->data.f,
                 output_tensors->back().bytes());
@@ -135,7 +225,185 @@ absl::Status InferenceCalculatorCpuImpl::Process(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
+absl::Status InferenceCalculatorCpuImpl::InvokeBatch(CalculatorContext* cc) {
+  const int batch_size = pending_inputs_.size();
+  MP_RETURN_IF_ERROR(ResizeBatch(batch_size));
+
+  // Copy each input into its slot of the batched interpreter input.
+  for (int b = 0; b < batch_size; ++b) {
+    const auto& input_tensors = *pending_inputs_[b].tensors;
+    RET_CHECK_EQ(input_tensors.size(), interpreter_->inputs().size());
+    for (int i = 0; i < input_tensors.size(); ++i) {
+      const Tensor& input_tensor = input_tensors[i];
+      TfLiteTensor* tensor = interpreter_->input_tensor(i);
+      const size_t sample_bytes = tensor->bytes / batch_size;
+      RET_CHECK_EQ(input_tensor.bytes(), sample_bytes);
+      auto input_tensor_view = input_tensor.GetCpuReadView();
+      std::memcpy(tensor->data.raw + b * sample_bytes,
+                  input_tensor_view.buffer<float>(), sample_bytes);
+    }
+  }
+
+  // Run inference.
+  RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+
+  // Split every output along the batch dimension.
+  std::vector<std::unique_ptr<std::vector<Tensor>>> output_tensors(batch_size);
+  for (auto& tensors : output_tensors) {
+    tensors = absl::make_unique<std::vector<Tensor>>();
+    tensors->reserve(interpreter_->outputs().size());
+  }
+  for (int index : interpreter_->outputs()) {
+    const TfLiteTensor* tensor = interpreter_->tensor(index);
+    RET_CHECK(tensor->dims->size > 0 && tensor->dims->data[0] == batch_size)
+        << "Batched model outputs must have a leading batch dimension.";
+    std::vector<int> sample_dims(tensor->dims->data,
+                                 tensor->dims->data + tensor->dims->size);
+    sample_dims[0] = 1;
+    const size_t sample_bytes = tensor->bytes / batch_size;
+    for (int b = 0; b < batch_size; ++b) {
+      output_tensors[b]->push_back(CreateOutputTensor(sample_dims));
+      auto cpu_view = output_tensors[b]->back().GetCpuWriteView();
+      std::memcpy(cpu_view.buffer<float>(), tensor->data.raw + b * sample_bytes,
+                  sample_bytes);
+    }
+  }
+  for (int b = 0; b < batch_size; ++b) {
+    kOutTensors(cc).Send(std::move(output_tensors[b]),
+                         pending_inputs_[b].timestamp);
+  }
+  pending_inputs_.clear();
+  return absl::OkStatus();
+}
+
+absl::Status InferenceCalculatorCpuImpl::ResizeBatch(int batch_size) {
+  if (batch_size == current_batch_size_) {
+    return absl::OkStatus();
+  }
+  const auto& inputs = interpreter_->inputs();
+  for (int i = 0; i < inputs.size(); ++i) {
+    std::vector<int> dims = model_input_dims_[i];
+    dims[0] = batch_size;
+    RET_CHECK_EQ(interpreter_->ResizeInputTensor(inputs[i], dims), kTfLiteOk);
+  }
+  RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk)
+      << "Failed to resize the model to batch size " << batch_size;
+  current_batch_size_ = batch_size;
+  return absl::OkStatus();
+}
+
+absl::Status InferenceCalculatorCpuImpl::InvokeZeroCopy(CalculatorContext* cc) {
+  const auto& input_tensors = *kInTensors(cc);
+  const auto& inputs = interpreter_->inputs();
+  RET_CHECK_EQ(input_tensors.size(), inputs.size());
+  // The views keep the input buffers from being modified until Invoke()
+  // returns.
+  std::vector<Tensor::CpuReadView> input_views;
+  input_views.reserve(inputs.size());
+  // Aligned copies of the inputs that TfLite cannot use in place.
+  std::vector<Tensor> staged_inputs;
+  staged_inputs.reserve(inputs.size());
+  // Set if a tensor gets its first custom allocation.
+  bool allocation_changed = false;
+  for (int i = 0; i < inputs.size(); ++i) {
+    const TfLiteTensor* tensor = interpreter_->tensor(inputs[i]);
+    RET_CHECK_EQ(input_tensors[i].bytes(), tensor->bytes);
+    allocation_changed |= tensor->allocation_type != kTfLiteCustom;
+    input_views.push_back(input_tensors[i].GetCpuReadView());
+    const float* data = input_views.back().buffer<float>();
+    if (reinterpret_cast<uintptr_t>(data) % Tensor::kCpuBufferAlignment != 0) {
+      // E.g. a buffer from a third-party Tensor::CpuBufferAllocator. Copies
+      // it, as without zero_copy_cpu_tensors.
+      staged_inputs.emplace_back(input_tensors[i].element_type(),
+                                 input_tensors[i].shape());
+      auto staged_view = staged_inputs.back().GetCpuWriteView();
+      std::memcpy(staged_view.buffer<float>(), data, tensor->bytes);
+      data = staged_view.buffer<float>();
+    }
+    MP_RETURN_IF_ERROR(BindTensor(inputs[i], data, tensor->bytes));
+  }
+
+  // Output tensors are allocated up front and written by the interpreter.
+  // Outputs whose size is only known after Invoke() are copied instead.
+  const auto& outputs = interpreter_->outputs();
+  auto output_tensors = absl::make_unique<std::vector<Tensor>>();
+  output_tensors->reserve(outputs.size());
+  std::vector<Tensor::CpuWriteView> output_views;
+  output_views.reserve(outputs.size());
+  std::vector<bool> output_bound(outputs.size(), false);
+  for (int i = 0; i < outputs.size(); ++i) {
+    const TfLiteTensor* tensor = interpreter_->tensor(outputs[i]);
+    // No memory is allocated until a view is requested.
+    output_tensors->push_back(CreateOutputTensor(std::vector<int>{
+        tensor->dims->data, tensor->dims->data + tensor->dims->size}));
+    if (tensor->allocation_type == kTfLiteArenaRw ||
+        tensor->allocation_type == kTfLiteCustom) {
+      allocation_changed |= tensor->allocation_type != kTfLiteCustom;
+      output_views.push_back(output_tensors->back().GetCpuWriteView());
+      MP_RETURN_IF_ERROR(BindTensor(
+          outputs[i], output_views.back().buffer<float>(), tensor->bytes));
+      output_bound[i] = true;
+    }
+  }
+  // TfLite requires AllocateTensors() once a tensor is switched to a custom
+  // allocation, to plan the arena without it and to check the allocation's
+  // size. Rebinding a custom tensor only swaps its data pointer, which Invoke()
+  // and the delegates read on every call. The sizes can't change here: inputs
+  // are checked above, outputs are created with the interpreter's dims, and
+  // the interpreter is never resized without batching.
+  if (allocation_changed) {
+    RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  }
+
+  // Run inference.
+  RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+
+  for (int i = 0; i < outputs.size(); ++i) {
+    if (output_bound[i]) continue;
+    const TfLiteTensor* tensor = interpreter_->tensor(outputs[i]);
+    Tensor& output_tensor = (*output_tensors)[i];
+    output_tensor = CreateOutputTensor(std::vector<int>{
+        tensor->dims->data, tensor->dims->data + tensor->dims->size});
+    auto cpu_view = output_tensor.GetCpuWriteView();
+    std::memcpy(cpu_view.buffer<float>(), tensor->data.f,
+                output_tensor.bytes());
+  }
+  // The interpreter keeps pointing at the buffers of the tensors sent below
+  // (and of the inputs) until the next call rebinds it, but it only accesses
+  // them inside Invoke(), so downstream consumers own the data from here on.
+  output_views.clear();
+  kOutTensors(cc).Send(std::move(output_tensors));
+  return absl::OkStatus();
+}
+
+absl::Status InferenceCalculatorCpuImpl::BindTensor(int index,
+                                                    const void* data,
+                                                    size_t bytes) {
+  // TfLite requires custom allocations to be 64-byte aligned, which
+  // mediapipe::Tensor CPU buffers are; InvokeZeroCopy() copies inputs that
+  // aren't.
+  RET_CHECK_EQ(reinterpret_cast<uintptr_t>(data) % Tensor::kCpuBufferAlignment,
+               0);
+  // TfLite only reads from input custom allocations, so dropping const is
+  // safe.
+  TfLiteCustomAllocation allocation{const_cast<void*>(data), bytes};
+  RET_CHECK_EQ(interpreter_->SetCustomAllocationForTensor(index, allocation),
+               kTfLiteOk);
+  return absl::OkStatus();
+}
+
+Tensor InferenceCalculatorCpuImpl::CreateOutputTensor(std::vector<int> dims) {
+  if (tensor_pool_.IsAvailable()) {
+    return tensor_pool_.GetObject().GetTensor(Tensor::ElementType::kFloat32,
+                                              Tensor::Shape{std::move(dims)});
+  }
+  return Tensor(Tensor::ElementType::kFloat32, Tensor::Shape{std::move(dims)});
+}
+
 absl::Status InferenceCalculatorCpuImpl::Close(CalculatorContext* cc) {
+  if (!pending_inputs_.empty()) {
+    MP_RETURN_IF_ERROR(InvokeBatch(cc));
+  }
   interpreter_ = nullptr;
   delegate_ = nullptr;
   return absl::OkStatus();
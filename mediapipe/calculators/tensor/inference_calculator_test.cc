@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -118,6 +120,119 @@ TEST(InferenceCalculatorTest, SmokeTest) {
       {{"$delegate", "delegate { xnnpack { num_threads: 10 } }"}}));
 }
 
+TEST(InferenceCalculatorTest, SmokeTest_ZeroCopyCpuTensors) {
+  std::string graph_proto = R"(
+    input_stream: "tensor_in"
+    node {
+      calculator: "InferenceCalculator"
+      input_stream: "TENSORS:tensor_in"
+      output_stream: "TENSORS:tensor_out"
+      options {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+          zero_copy_cpu_tensors: true
+          $delegate
+        }
+      }
+    }
+  )";
+  DoSmokeTest(absl::StrReplaceAll(graph_proto,
+                                  {{"$delegate", "delegate { tflite {} }"}}));
+  DoSmokeTest(absl::StrReplaceAll(graph_proto,
+                                  {{"$delegate", "delegate { xnnpack {} }"}}));
+}
+
+// Hands out CPU buffers that are 4 bytes off Tensor::kCpuBufferAlignment.
+class MisalignedAllocator : public Tensor::CpuBufferAllocator {
+ public:
+  void* Allocate(size_t bytes) override {
+    return static_cast<char*>(
+               aligned_malloc(bytes + kOffset, Tensor::kCpuBufferAlignment)) +
+           kOffset;
+  }
+  void Release(void* buffer, size_t bytes) override {
+    aligned_free(static_cast<char*>(buffer) - kOffset);
+  }
+
+ private:
+  static constexpr int kOffset = 4;
+};
+
+// Runs the add model with zero_copy_cpu_tensors on several frames. Every
+// frame has a new input buffer, and every third one is misaligned.
+void RunZeroCopyFrames(absl::string_view delegate) {
+  constexpr int kWidth = 8;
+  constexpr int kHeight = 8;
+  constexpr int kChannels = 3;
+  constexpr int kNumPackets = 6;
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "InferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.InferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+                  zero_copy_cpu_tensors: true
+                  $delegate
+                }
+              }
+            }
+          )",
+          {{"$delegate", delegate}}));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  auto misaligned_allocator = std::make_shared<MisalignedAllocator>();
+  // Keeping the inputs alive makes sure that no frame reuses the input
+  // buffer of an earlier one.
+  std::vector<Packet> input_packets;
+  for (int t = 0; t < kNumPackets; ++t) {
+    auto input_vec = absl::make_unique<std::vector<Tensor>>();
+    const Tensor::Shape shape{1, kHeight, kWidth, kChannels};
+    if (t % 3 == 2) {
+      input_vec->emplace_back(Tensor::ElementType::kFloat32, shape,
+                              misaligned_allocator);
+    } else {
+      input_vec->emplace_back(Tensor::ElementType::kFloat32, shape);
+    }
+    {
+      auto view = input_vec->back().GetCpuWriteView();
+      float* buffer = view.buffer<float>();
+      std::fill(buffer, buffer + kWidth * kHeight * kChannels, t + 1.0f);
+    }
+    input_packets.push_back(Adopt(input_vec.release()).At(Timestamp(t)));
+    MP_ASSERT_OK(graph.AddPacketToInputStream("tensor_in", input_packets[t]));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  ASSERT_EQ(kNumPackets, output_packets.size());
+
+  // Later frames must not have written to the outputs of earlier ones.
+  for (int t = 0; t < kNumPackets; ++t) {
+    const auto& result_vec = output_packets[t].Get<std::vector<Tensor>>();
+    ASSERT_EQ(1, result_vec.size());
+    auto view = result_vec[0].GetCpuReadView();
+    const float* result_buffer = view.buffer<float>();
+    for (int i = 0; i < kWidth * kHeight * kChannels; ++i) {
+      ASSERT_EQ(3 * (t + 1.0f), result_buffer[i])
+          << delegate << " frame " << t;
+    }
+  }
+
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(InferenceCalculatorTest, ZeroCopyCpuTensorsWithChangingInputs) {
+  RunZeroCopyFrames("delegate { tflite {} }");
+  RunZeroCopyFrames("delegate { xnnpack {} }");
+}
+
 TEST(InferenceCalculatorTest, SmokeTest_ModelAsInputSidePacket) {
   std::string graph_proto = R"(
     input_stream: "tensor_in"
@@ -159,4 +274,126 @@ TEST(InferenceCalculatorTest, SmokeTest_ModelAsInputSidePacket) {
   DoSmokeTest(graph_proto);
 }
 
+TEST(InferenceCalculatorTest, BatchesConsecutiveTimestamps) {
+  constexpr int kWidth = 8;
+  constexpr int kHeight = 8;
+  constexpr int kChannels = 3;
+  constexpr int kNumPackets = 5;
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "tensor_in"
+        node {
+          calculator: "InferenceCalculator"
+          input_stream: "TENSORS:tensor_in"
+          output_stream: "TENSORS:tensor_out"
+          options {
+            [mediapipe.InferenceCalculatorOptions.ext] {
+              model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+              delegate { tflite {} }
+              batching { max_batch_size: 2 }
+            }
+          }
+        }
+      )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  for (int t = 0; t < kNumPackets; ++t) {
+    auto input_vec = absl::make_unique<std::vector<Tensor>>();
+    input_vec->emplace_back(Tensor::ElementType::kFloat32,
+                            Tensor::Shape{1, kHeight, kWidth, kChannels});
+    {
+      auto view = input_vec->back().GetCpuWriteView();
+      float* buffer = view.buffer<float>();
+      std::fill(buffer, buffer + kWidth * kHeight * kChannels, t + 1.0f);
+    }
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in", Adopt(input_vec.release()).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  // The last input waits for a second batch member until the graph closes.
+  EXPECT_EQ(kNumPackets - 1, output_packets.size());
+
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(kNumPackets, output_packets.size());
+  for (int t = 0; t < kNumPackets; ++t) {
+    EXPECT_EQ(Timestamp(t), output_packets[t].Timestamp());
+    const auto& result_vec = output_packets[t].Get<std::vector<Tensor>>();
+    ASSERT_EQ(1, result_vec.size());
+    EXPECT_EQ(result_vec[0].shape().dims,
+              std::vector<int>({1, kHeight, kWidth, kChannels}));
+    auto view = result_vec[0].GetCpuReadView();
+    const float* result_buffer = view.buffer<float>();
+    for (int i = 0; i < kWidth * kHeight * kChannels; ++i) {
+      ASSERT_EQ(3 * (t + 1.0f), result_buffer[i]);
+    }
+  }
+}
+
+// A batching calculator whose input only advances its timestamp bound must
+// still advance the bound of its output, so that downstream nodes synced with
+// it can run.
+TEST(InferenceCalculatorTest, BatchingPropagatesTimestampBounds) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "tensor_in"
+        input_stream: "allow"
+        input_stream: "tick"
+        node {
+          calculator: "GateCalculator"
+          input_stream: "tensor_in"
+          input_stream: "ALLOW:allow"
+          output_stream: "gated_tensor_in"
+        }
+        node {
+          calculator: "InferenceCalculator"
+          input_stream: "TENSORS:gated_tensor_in"
+          output_stream: "TENSORS:tensor_out"
+          options {
+            [mediapipe.InferenceCalculatorOptions.ext] {
+              model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+              delegate { tflite {} }
+              batching { max_batch_size: 2 }
+            }
+          }
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "tensor_out"
+          input_stream: "tick"
+          output_stream: "synced_tensor_out"
+          output_stream: "synced_tick"
+        }
+      )");
+  std::vector<Packet> tick_packets;
+  tool::AddVectorSink("synced_tick", &graph_config, &tick_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  for (int t = 0; t < 3; ++t) {
+    auto input_vec = absl::make_unique<std::vector<Tensor>>();
+    input_vec->emplace_back(Tensor::ElementType::kFloat32,
+                            Tensor::Shape{1, 8, 8, 3});
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in", Adopt(input_vec.release()).At(Timestamp(t))));
+    // Only the input at timestamp 1 passes the gate.
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "allow", MakePacket<bool>(t == 1).At(Timestamp(t))));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tick", MakePacket<int>(t).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  // Timestamp 0 is settled without an input. The input at timestamp 1 waits
+  // for a second batch member, which holds back every later tick.
+  ASSERT_EQ(1, tick_packets.size());
+  EXPECT_EQ(Timestamp(0), tick_packets[0].Timestamp());
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(3, tick_packets.size());
+}
+
 }  // namespace mediapipe
@@ -18,6 +18,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/tensors_to_detections_calculator.pb.h"
+#include "mediapipe/calculators/util/box_nms.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/deps/file_path.h"
@@ -115,7 +116,8 @@ void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
 //      calculator options.
 //
 // Output:
-//  DETECTIONS - Result MediaPipe detections.
+//  DETECTIONS - Result MediaPipe detections. If non_max_suppression is set in
+//               the options, only the detections retained by it.
 //
 // Usage example:
 // node {
@@ -167,6 +169,9 @@ class TensorsToDetectionsCalculator : public Node {
                                    const float* detection_scores,
                                    const int* detection_classes,
                                    std::vector<Detection>* output_detections);
+  absl::Status SuppressAndConvertToDetections(
+      const float* detection_boxes, const float* detection_scores,
+      const int* detection_classes, std::vector<Detection>* output_detections);
   Detection ConvertToDetection(float box_ymin, float box_xmin, float box_ymax,
                                float box_xmax, float score, int class_id,
                                bool flip_vertically);
@@ -178,6 +183,8 @@ class TensorsToDetectionsCalculator : public Node {
 
   ::mediapipe::TensorsToDetectionsCalculatorOptions options_;
   std::vector<Anchor> anchors_;
+  NmsOptions nms_options_;
+  NmsBoxes nms_boxes_;
 
 #ifndef MEDIAPIPE_DISABLE_GL_COMPUTE
   mediapipe::GlCalculatorHelper gpu_helper_;
@@ -589,6 +596,11 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
     }
   }
 
+  if (options_.has_non_max_suppression()) {
+    nms_options_ = NmsOptionsFromProto(options_.non_max_suppression());
+    RET_CHECK_NE(nms_options_.max_num_detections, 0);
+  }
+
   return absl::OkStatus();
 }
 
@@ -659,6 +671,10 @@ absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
 absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
     const float* detection_boxes, const float* detection_scores,
     const int* detection_classes, std::vector<Detection>* output_detections) {
+  if (options_.has_non_max_suppression()) {
+    return SuppressAndConvertToDetections(detection_boxes, detection_scores,
+                                          detection_classes, output_detections);
+  }
   for (int i = 0; i < num_boxes_; ++i) {
     if (options_.has_min_score_thresh() &&
         detection_scores[i] < options_.min_score_thresh()) {
@@ -697,6 +713,76 @@ absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
   return absl::OkStatus();
 }
 
+absl::Status TensorsToDetectionsCalculator::SuppressAndConvertToDetections(
+    const float* detection_boxes, const float* detection_scores,
+    const int* detection_classes, std::vector<Detection>* output_detections) {
+  // Apply the same filters as ConvertToDetections, but collect the boxes into
+  // flat arrays instead of building a Detection for each of them.
+  nms_boxes_.Clear();
+  for (int i = 0; i < num_boxes_; ++i) {
+    if (options_.has_min_score_thresh() &&
+        detection_scores[i] < options_.min_score_thresh()) {
+      continue;
+    }
+    const int box_offset = i * num_coords_;
+    const float ymin = detection_boxes[box_offset + 0];
+    const float xmin = detection_boxes[box_offset + 1];
+    const float ymax = detection_boxes[box_offset + 2];
+    const float xmax = detection_boxes[box_offset + 3];
+    const float width = xmax - xmin;
+    const float height = ymax - ymin;
+    if (width < 0 || height < 0 || std::isnan(width) || std::isnan(height)) {
+      continue;
+    }
+    nms_boxes_.Add(xmin, ymin, xmax, ymax, detection_scores[i], i);
+  }
+  KeepTopKBoxes(options_.nms_top_k(), &nms_boxes_);
+
+  const std::vector<NmsCluster> clusters =
+      NonMaxSuppression(nms_boxes_, nms_options_);
+  output_detections->reserve(output_detections->size() + clusters.size());
+  for (const auto& cluster : clusters) {
+    const int top = nms_boxes_.id[cluster.top];
+    Detection detection = ConvertToDetection(
+        cluster.ymin, cluster.xmin, cluster.ymax, cluster.xmax,
+        detection_scores[top], detection_classes[top],
+        options_.flip_vertically());
+    // Add keypoints. Weighted suppression averages them over the cluster.
+    if (options_.num_keypoints() > 0) {
+      auto* location_data = detection.mutable_location_data();
+      for (int kp_id = 0; kp_id < options_.num_keypoints() *
+                                      options_.num_values_per_keypoint();
+           kp_id += options_.num_values_per_keypoint()) {
+        const int keypoint_offset = options_.keypoint_coord_offset() + kp_id;
+        float x = detection_boxes[top * num_coords_ + keypoint_offset];
+        float y = detection_boxes[top * num_coords_ + keypoint_offset + 1];
+        float total_score = 0.0f;
+        float weighted_x = 0.0f;
+        float weighted_y = 0.0f;
+        for (int member : cluster.members) {
+          const float score = nms_boxes_.score[member];
+          const int keypoint_index =
+              nms_boxes_.id[member] * num_coords_ + keypoint_offset;
+          total_score += score;
+          weighted_x += detection_boxes[keypoint_index] * score;
+          weighted_y += detection_boxes[keypoint_index + 1] * score;
+        }
+        // Scores that don't sum to a positive value keep the keypoint of the
+        // top box, as NonMaxSuppression() keeps its box.
+        if (total_score > 0.0f) {
+          x = weighted_x / total_score;
+          y = weighted_y / total_score;
+        }
+        auto keypoint = location_data->add_relative_keypoints();
+        keypoint->set_x(x);
+        keypoint->set_y(options_.flip_vertically() ? 1.f - y : y);
+      }
+    }
+    output_detections->emplace_back(std::move(detection));
+  }
+  return absl::OkStatus();
+}
+
 Detection TensorsToDetectionsCalculator::ConvertToDetection(
     float box_ymin, float box_xmin, float box_ymax, float box_xmax, float score,
     int class_id, bool flip_vertically) {
@@ -0,0 +1,190 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures SSD post-processing for a palm-detection-sized model (2944
+// anchors, 7 keypoints) with random outputs: TensorsToDetectionsCalculator
+// followed by NonMaxSuppressionCalculator, against TensorsToDetections with
+// its built-in suppression. items_per_second is anchors per second. The
+// argument is the percentage of anchors above the score threshold.
+//
+// bazel run -c opt \
+//   //mediapipe/calculators/tensor:tensors_to_detections_calculator_benchmark
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumBoxes = 2944;
+constexpr int kNumKeypoints = 7;
+constexpr int kNumCoords = 4 + kNumKeypoints * 2;
+
+constexpr char kNmsOptions[] = R"(
+  min_suppression_threshold: 0.3
+  overlap_type: INTERSECTION_OVER_UNION
+  algorithm: WEIGHTED
+)";
+
+CalculatorGraphConfig MakeConfig(bool fused) {
+  const std::string decoder = absl::Substitute(
+      R"(
+        node {
+          calculator: "TensorsToDetectionsCalculator"
+          input_stream: "TENSORS:tensors"
+          input_side_packet: "ANCHORS:anchors"
+          output_stream: "DETECTIONS:$0"
+          options {
+            [mediapipe.TensorsToDetectionsCalculatorOptions.ext] {
+              num_classes: 1
+              num_boxes: $1
+              num_coords: $2
+              box_coord_offset: 0
+              keypoint_coord_offset: 4
+              num_keypoints: $3
+              num_values_per_keypoint: 2
+              sigmoid_score: true
+              score_clipping_thresh: 100.0
+              reverse_output_order: true
+              x_scale: 128.0
+              y_scale: 128.0
+              h_scale: 128.0
+              w_scale: 128.0
+              min_score_thresh: 0.5
+              $4
+            }
+          }
+        }
+      )",
+      fused ? "detections" : "unfiltered_detections", kNumBoxes, kNumCoords,
+      kNumKeypoints,
+      fused ? absl::StrCat("non_max_suppression {", kNmsOptions, "}") : "");
+  const std::string nms =
+      fused ? ""
+            : absl::Substitute(
+                  R"(
+        node {
+          calculator: "NonMaxSuppressionCalculator"
+          input_stream: "unfiltered_detections"
+          output_stream: "detections"
+          options {
+            [mediapipe.NonMaxSuppressionCalculatorOptions.ext] { $0 }
+          }
+        }
+      )",
+                  kNmsOptions);
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrCat(
+      R"(
+        input_stream: "tensors"
+        input_side_packet: "anchors"
+        output_stream: "detections"
+      )",
+      decoder, nms));
+}
+
+void BM_DecodeAndSuppress(benchmark::State& state, bool fused) {
+  const float positive_fraction = state.range(0) / 100.0f;
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::normal_distribution<float> offset(0.0f, 8.0f);
+
+  auto anchors = absl::make_unique<std::vector<Anchor>>(kNumBoxes);
+  for (Anchor& anchor : *anchors) {
+    anchor.set_x_center(unit(rng));
+    anchor.set_y_center(unit(rng));
+    anchor.set_w(1.0f);
+    anchor.set_h(1.0f);
+  }
+  std::vector<float> raw_boxes(kNumBoxes * kNumCoords);
+  for (int i = 0; i < kNumBoxes; ++i) {
+    float* box = &raw_boxes[i * kNumCoords];
+    box[0] = offset(rng);
+    box[1] = offset(rng);
+    box[2] = 12.0f + std::abs(offset(rng));
+    box[3] = 12.0f + std::abs(offset(rng));
+    for (int k = 4; k < kNumCoords; ++k) box[k] = offset(rng);
+  }
+  // Logits above zero pass the 0.5 score threshold after the sigmoid.
+  std::vector<float> raw_scores(kNumBoxes);
+  for (float& score : raw_scores) {
+    score = unit(rng) < positive_fraction ? 0.1f + 4.0f * unit(rng)
+                                          : -0.1f - 4.0f * unit(rng);
+  }
+
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(MakeConfig(fused)).ok());
+  int num_detections = 0;
+  CHECK(graph
+            .ObserveOutputStream("detections",
+                                 [&num_detections](const Packet& packet) {
+                                   num_detections +=
+                                       packet.Get<std::vector<Detection>>()
+                                           .size();
+                                   return absl::OkStatus();
+                                 })
+            .ok());
+  CHECK(graph.StartRun({{"anchors", Adopt(anchors.release())}}).ok());
+
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    auto tensors = absl::make_unique<std::vector<Tensor>>();
+    tensors->emplace_back(Tensor::ElementType::kFloat32,
+                          Tensor::Shape{1, kNumBoxes, kNumCoords});
+    tensors->emplace_back(Tensor::ElementType::kFloat32,
+                          Tensor::Shape{1, kNumBoxes, 1});
+    std::memcpy((*tensors)[0].GetCpuWriteView().buffer<float>(),
+                raw_boxes.data(), raw_boxes.size() * sizeof(float));
+    std::memcpy((*tensors)[1].GetCpuWriteView().buffer<float>(),
+                raw_scores.data(), raw_scores.size() * sizeof(float));
+    CHECK(graph
+              .AddPacketToInputStream(
+                  "tensors", Adopt(tensors.release()).At(Timestamp(timestamp)))
+              .ok());
+    CHECK(graph.WaitUntilIdle().ok());
+    ++timestamp;
+  }
+  state.SetItemsProcessed(state.iterations() * kNumBoxes);
+  state.counters["detections"] =
+      timestamp > 0 ? static_cast<double>(num_detections) / timestamp : 0;
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+}
+
+// The graph runs on its own threads, so rates are based on wall time.
+BENCHMARK_CAPTURE(BM_DecodeAndSuppress, Separate, false)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(50)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_DecodeAndSuppress, Fused, true)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(50)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,18 +12,22 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
+#include <memory>
 #include <vector>
 
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "mediapipe/calculators/image/mask_blend_cpu.h"
 #include "mediapipe/calculators/tensor/tensors_to_segmentation_calculator.pb.h"
+#include "mediapipe/calculators/tensor/tensors_to_segmentation_cpu.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image.h"
-#include "mediapipe/framework/formats/image_opencv.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/port.h"
-#include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/gpu/gpu_origin.pb.h"
@@ -76,6 +80,7 @@ bool CanUseGpu() {
 constexpr char kTensorsTag[] = "TENSORS";
 constexpr char kOutputSizeTag[] = "OUTPUT_SIZE";
 constexpr char kMaskTag[] = "MASK";
+constexpr char kMatrixTag[] = "MATRIX";
 
 absl::StatusOr<std::tuple<int, int, int>> GetHwcFromDims(
     const std::vector<int>& dims) {
@@ -101,7 +106,9 @@ using ::tflite::gpu::gl::GlShader;
 // Converts Tensors from a tflite segmentation model to an image mask.
 //
 // Performs optional upscale to OUTPUT_SIZE dimensions if provided,
-// otherwise the mask is the same size as input tensor.
+// otherwise the mask is the same size as input tensor. With the
+// output_tensor_resolution option, the mask is not upscaled and MATRIX tells
+// how it maps to OUTPUT_SIZE.
 //
 // If at least one input tensor is already on GPU, processing happens on GPU and
 // the output mask is also stored on GPU. Otherwise, processing and the output
@@ -109,6 +116,7 @@ using ::tflite::gpu::gl::GlShader;
 //
 // On GPU, the mask is an RGBA image, in both the R & A channels, scaled 0-1.
 // On CPU, the mask is a ImageFormat::VEC32F1 image, with values scaled 0-1.
+// It comes from the kImageMultiPoolService pool if the graph provides one.
 //
 //
 // Inputs:
@@ -120,6 +128,14 @@ using ::tflite::gpu::gl::GlShader;
 //
 // Output:
 //   MASK: An Image output mask, RGBA(GPU) / VEC32F1(CPU).
+//   MATRIX(optional): std::array<float, 16>,
+//                     A 4x4 row-major-order matrix that maps a point on the
+//                     OUTPUT_SIZE image to a point on the mask, both in pixel
+//                     coordinates where pixel (x, y) covers [x, x + 1) x
+//                     [y, y + 1). It only scales, and is the identity unless
+//                     output_tensor_resolution is set. Sampling the mask
+//                     bilinearly at the mapped pixel centers reproduces the
+//                     upscaled mask.
 //
 // Options:
 //   See tensors_to_segmentation_calculator.proto
@@ -159,10 +175,8 @@ class TensorsToSegmentationCalculator : public CalculatorBase {
     return options_.gpu_origin() != mediapipe::GpuOrigin_Mode_TOP_LEFT;
   }
 
-  template <class T>
-  absl::Status ApplyActivation(cv::Mat& tensor_mat, cv::Mat* small_mask_mat);
-
   ::mediapipe::TensorsToSegmentationCalculatorOptions options_;
+  ServiceBinding<ImageMultiPool> image_pool_;
 
 #if !MEDIAPIPE_DISABLE_GPU
   mediapipe::GlCalculatorHelper gpu_helper_;
@@ -194,6 +208,10 @@ absl::Status TensorsToSegmentationCalculator::GetContract(
 
   // Outputs.
   cc->Outputs().Tag(kMaskTag).Set<Image>();
+  if (cc->Outputs().HasTag(kMatrixTag)) {
+    cc->Outputs().Tag(kMatrixTag).Set<std::array<float, 16>>();
+  }
+  cc->UseService(kImageMultiPoolService).Optional();
 
   if (CanUseGpu()) {
 #if !MEDIAPIPE_DISABLE_GPU
@@ -223,6 +241,7 @@ absl::Status TensorsToSegmentationCalculator::Open(CalculatorContext* cc) {
   }
 
   MP_RETURN_IF_ERROR(LoadOptions(cc));
+  image_pool_ = cc->Service(kImageMultiPoolService);
 
   if (use_gpu) {
 #if !MEDIAPIPE_DISABLE_GPU
@@ -269,8 +288,32 @@ absl::Status TensorsToSegmentationCalculator::Process(CalculatorContext* cc) {
         break;
       case Options::SOFTMAX:
         RET_CHECK_EQ(tensor_channels, 2);
+        RET_CHECK(options_.output_layer_index() == 0 ||
+                  options_.output_layer_index() == 1);
         break;
     }
+
+    // Send out the mapping from OUTPUT_SIZE to the mask.
+    if (cc->Outputs().HasTag(kMatrixTag)) {
+      int output_width = std::get<1>(hwc), output_height = std::get<0>(hwc);
+      if (cc->Inputs().HasTag(kOutputSizeTag)) {
+        const auto& size =
+            cc->Inputs().Tag(kOutputSizeTag).Get<std::pair<int, int>>();
+        output_width = size.first;
+        output_height = size.second;
+      }
+      auto matrix = absl::make_unique<std::array<float, 16>>();
+      matrix->fill(0.0f);
+      (*matrix)[0] = options_.output_tensor_resolution()
+                         ? static_cast<float>(std::get<1>(hwc)) / output_width
+                         : 1.0f;
+      (*matrix)[5] = options_.output_tensor_resolution()
+                         ? static_cast<float>(std::get<0>(hwc)) / output_height
+                         : 1.0f;
+      (*matrix)[10] = 1.0f;
+      (*matrix)[15] = 1.0f;
+      cc->Outputs().Tag(kMatrixTag).Add(matrix.release(), cc->InputTimestamp());
+    }
   }
 
   if (use_gpu) {
@@ -323,94 +366,47 @@ absl::Status TensorsToSegmentationCalculator::ProcessCpu(
     output_width = size.first;
     output_height = size.second;
   }
+  if (options_.output_tensor_resolution()) {
+    output_width = tensor_width;
+    output_height = tensor_height;
+  }
 
-  // Create initial working mask.
-  cv::Mat small_mask_mat(cv::Size(tensor_width, tensor_height), CV_32FC1);
-
-  // Wrap input tensor.
-  auto raw_input_tensor = &input_tensors[0];
-  auto raw_input_view = raw_input_tensor->GetCpuReadView();
+  // Process mask tensor and apply activation function, one row at a time.
+  std::shared_ptr<ImageFrame> small_mask_frame = CreateImageFrame(
+      image_pool_, ImageFormat::VEC32F1, tensor_width, tensor_height);
+  auto raw_input_view = input_tensors[0].GetCpuReadView();
   const float* raw_input_data = raw_input_view.buffer<float>();
-  cv::Mat tensor_mat(cv::Size(tensor_width, tensor_height),
-                     CV_MAKETYPE(CV_32F, tensor_channels),
-                     const_cast<float*>(raw_input_data));
-
-  // Process mask tensor and apply activation function.
-  if (tensor_channels == 2) {
-    MP_RETURN_IF_ERROR(ApplyActivation<cv::Vec2f>(tensor_mat, &small_mask_mat));
-  } else if (tensor_channels == 1) {
-    RET_CHECK(mediapipe::TensorsToSegmentationCalculatorOptions::SOFTMAX !=
-              options_.activation());  // Requires 2 channels.
-    if (mediapipe::TensorsToSegmentationCalculatorOptions::NONE ==
-        options_.activation())  // Pass-through optimization.
-      tensor_mat.copyTo(small_mask_mat);
-    else
-      MP_RETURN_IF_ERROR(ApplyActivation<float>(tensor_mat, &small_mask_mat));
+  for (int i = 0; i < tensor_height; ++i) {
+    ApplySegmentationActivation(
+        raw_input_data + i * tensor_width * tensor_channels, tensor_width,
+        options_.activation(), options_.output_layer_index(),
+        reinterpret_cast<float*>(small_mask_frame->MutablePixelData() +
+                                 i * small_mask_frame->WidthStep()));
+  }
+
+  // Upsample small mask into output, one row at a time.
+  std::shared_ptr<ImageFrame> mask_frame;
+  if (output_width == tensor_width && output_height == tensor_height) {
+    mask_frame = std::move(small_mask_frame);
   } else {
-    RET_CHECK_FAIL() << "Unsupported number of tensor channels "
-                     << tensor_channels;
+    mask_frame = CreateImageFrame(image_pool_, ImageFormat::VEC32F1,
+                                  output_width, output_height);
+    MaskRowSampler mask_sampler(*small_mask_frame, 0, output_width,
+                                output_height, 1.0f);
+    for (int i = 0; i < output_height; ++i) {
+      mask_sampler.GetRow(
+          i, reinterpret_cast<float*>(mask_frame->MutablePixelData() +
+                                      i * mask_frame->WidthStep()));
+    }
   }
 
   // Send out image as CPU packet.
-  std::shared_ptr<ImageFrame> mask_frame = std::make_shared<ImageFrame>(
-      ImageFormat::VEC32F1, output_width, output_height);
   std::unique_ptr<Image> output_mask = absl::make_unique<Image>(mask_frame);
-  cv::Mat output_mat = formats::MatView(output_mask.get());
-  // Upsample small mask into output.
-  cv::resize(small_mask_mat, output_mat, cv::Size(output_width, output_height));
   cc->Outputs().Tag(kMaskTag).Add(output_mask.release(), cc->InputTimestamp());
 
   return absl::OkStatus();
 }
 
-template <class T>
-absl::Status TensorsToSegmentationCalculator::ApplyActivation(
-    cv::Mat& tensor_mat, cv::Mat* small_mask_mat) {
-  // Configure activation function.
-  const int output_layer_index = options_.output_layer_index();
-  typedef mediapipe::TensorsToSegmentationCalculatorOptions Options;
-  const auto activation_fn = [&](const cv::Vec2f& mask_value) {
-    float new_mask_value = 0;
-    // TODO consider moving switch out of the loop,
-    // and also avoid float/Vec2f casting.
-    switch (options_.activation()) {
-      case Options::NONE: {
-        new_mask_value = mask_value[0];
-        break;
-      }
-      case Options::SIGMOID: {
-        const float pixel0 = mask_value[0];
-        new_mask_value = 1.0 / (std::exp(-pixel0) + 1.0);
-        break;
-      }
-      case Options::SOFTMAX: {
-        const float pixel0 = mask_value[0];
-        const float pixel1 = mask_value[1];
-        const float max_pixel = std::max(pixel0, pixel1);
-        const float min_pixel = std::min(pixel0, pixel1);
-        const float softmax_denom =
-            /*exp(max_pixel - max_pixel)=*/1.0f +
-            std::exp(min_pixel - max_pixel);
-        new_mask_value = std::exp(mask_value[output_layer_index] - max_pixel) /
-                         softmax_denom;
-        break;
-      }
-    }
-    return new_mask_value;
-  };
-
-  // Process mask tensor.
-  for (int i = 0; i < tensor_mat.rows; ++i) {
-    for (int j = 0; j < tensor_mat.cols; ++j) {
-      const T& input_pix = tensor_mat.at<T>(i, j);
-      const float mask_value = activation_fn(input_pix);
-      small_mask_mat->at<float>(i, j) = mask_value;
-    }
-  }
-
-  return absl::OkStatus();
-}
-
 // Steps:
 // 1. receive tensor
 // 2. process segmentation tensor into small mask
@@ -430,6 +426,10 @@ absl::Status TensorsToSegmentationCalculator::ProcessGpu(
     output_width = size.first;
     output_height = size.second;
   }
+  if (options_.output_tensor_resolution()) {
+    output_width = tensor_width;
+    output_height = tensor_height;
+  }
 
   // Create initial working mask texture.
 #if MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_31
@@ -0,0 +1,181 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/tensors_to_segmentation_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MEDIAPIPE_SEGMENTATION_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MEDIAPIPE_SEGMENTATION_NEON 1
+#endif
+
+namespace mediapipe {
+
+namespace {
+
+// exp() is evaluated as 2^n * exp(r), with r = x - n * ln(2) in
+// [-ln(2) / 2, ln(2) / 2] and the polynomial of the Cephes expf(), which has
+// a relative error below 2e-7. Arguments are clamped to +-88.38, where the
+// results saturate to infinity and zero.
+constexpr float kExpMax = 88.3762626647949f;
+constexpr float kExpMin = -88.3762626647949f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kExpP0 = 1.9875691500e-4f;
+constexpr float kExpP1 = 1.3981999507e-3f;
+constexpr float kExpP2 = 8.3334519073e-3f;
+constexpr float kExpP3 = 4.1665795894e-2f;
+constexpr float kExpP4 = 1.6666665459e-1f;
+constexpr float kExpP5 = 5.0000001201e-1f;
+
+float Sigmoid(float x) { return 1.0f / (1.0f + std::exp(-x)); }
+
+#if defined(MEDIAPIPE_SEGMENTATION_SSE2)
+inline __m128 Exp(__m128 x) {
+  x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(kExpMin)), _mm_set1_ps(kExpMax));
+  // n = round(x / ln(2)), computed as floor(x / ln(2) + 0.5).
+  __m128 n = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(kLog2e)), _mm_set1_ps(0.5f));
+  const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(n));
+  n = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, n),
+                                       _mm_set1_ps(1.0f)));
+  x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(kLn2Hi)));
+  x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(kLn2Lo)));
+  __m128 y = _mm_set1_ps(kExpP0);
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP1));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP2));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP3));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP4));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP5));
+  y = _mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)),
+                 _mm_add_ps(x, _mm_set1_ps(1.0f)));
+  // Multiplies by 2^n through the exponent bits.
+  const __m128i exponent = _mm_slli_epi32(
+      _mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+  return _mm_mul_ps(y, _mm_castsi128_ps(exponent));
+}
+
+// Returns 1 / (1 + exp(-x)).
+inline __m128 Sigmoid(__m128 x) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  return _mm_div_ps(one,
+                    _mm_add_ps(one, Exp(_mm_sub_ps(_mm_setzero_ps(), x))));
+}
+#elif defined(MEDIAPIPE_SEGMENTATION_NEON)
+inline float32x4_t Exp(float32x4_t x) {
+  x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(kExpMin)), vdupq_n_f32(kExpMax));
+  // n = round(x / ln(2)), computed as floor(x / ln(2) + 0.5).
+  float32x4_t n = vmlaq_n_f32(vdupq_n_f32(0.5f), x, kLog2e);
+  const float32x4_t truncated = vcvtq_f32_s32(vcvtq_s32_f32(n));
+  n = vsubq_f32(truncated,
+                vreinterpretq_f32_u32(vandq_u32(
+                    vcgtq_f32(truncated, n),
+                    vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+  x = vmlsq_n_f32(x, n, kLn2Hi);
+  x = vmlsq_n_f32(x, n, kLn2Lo);
+  float32x4_t y = vdupq_n_f32(kExpP0);
+  y = vmlaq_f32(vdupq_n_f32(kExpP1), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP2), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP3), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP4), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP5), y, x);
+  y = vmlaq_f32(vaddq_f32(x, vdupq_n_f32(1.0f)), y, vmulq_f32(x, x));
+  // Multiplies by 2^n through the exponent bits.
+  const int32x4_t exponent =
+      vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+  return vmulq_f32(y, vreinterpretq_f32_s32(exponent));
+}
+
+// Returns 1 / (1 + exp(-x)).
+inline float32x4_t Sigmoid(float32x4_t x) {
+  const float32x4_t denominator =
+      vaddq_f32(vdupq_n_f32(1.0f), Exp(vnegq_f32(x)));
+  // Two Newton-Raphson steps refine the reciprocal estimate to float
+  // precision.
+  float32x4_t reciprocal = vrecpeq_f32(denominator);
+  reciprocal = vmulq_f32(vrecpsq_f32(denominator, reciprocal), reciprocal);
+  reciprocal = vmulq_f32(vrecpsq_f32(denominator, reciprocal), reciprocal);
+  return reciprocal;
+}
+#endif
+
+void SigmoidRow(const float* tensor, int width, float* mask) {
+  int x = 0;
+#if defined(MEDIAPIPE_SEGMENTATION_SSE2)
+  for (; x + 4 <= width; x += 4) {
+    _mm_storeu_ps(mask + x, Sigmoid(_mm_loadu_ps(tensor + x)));
+  }
+#elif defined(MEDIAPIPE_SEGMENTATION_NEON)
+  for (; x + 4 <= width; x += 4) {
+    vst1q_f32(mask + x, Sigmoid(vld1q_f32(tensor + x)));
+  }
+#endif
+  for (; x < width; ++x) {
+    mask[x] = Sigmoid(tensor[x]);
+  }
+}
+
+// Softmax of two channels: exp(a) / (exp(a) + exp(b)) = sigmoid(a - b).
+void SoftmaxRow(const float* tensor, int width, int output_layer_index,
+                float* mask) {
+  int x = 0;
+#if defined(MEDIAPIPE_SEGMENTATION_SSE2)
+  for (; x + 4 <= width; x += 4) {
+    const __m128 t0 = _mm_loadu_ps(tensor + 2 * x);
+    const __m128 t1 = _mm_loadu_ps(tensor + 2 * x + 4);
+    const __m128 layer0 = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 layer1 = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(mask + x, Sigmoid(output_layer_index == 0
+                                        ? _mm_sub_ps(layer0, layer1)
+                                        : _mm_sub_ps(layer1, layer0)));
+  }
+#elif defined(MEDIAPIPE_SEGMENTATION_NEON)
+  for (; x + 4 <= width; x += 4) {
+    const float32x4x2_t layers = vld2q_f32(tensor + 2 * x);
+    vst1q_f32(mask + x,
+              Sigmoid(vsubq_f32(layers.val[output_layer_index],
+                                layers.val[1 - output_layer_index])));
+  }
+#endif
+  for (; x < width; ++x) {
+    mask[x] = Sigmoid(tensor[2 * x + output_layer_index] -
+                      tensor[2 * x + 1 - output_layer_index]);
+  }
+}
+
+}  // namespace
+
+void ApplySegmentationActivation(
+    const float* tensor, int width,
+    TensorsToSegmentationCalculatorOptions::Activation activation,
+    int output_layer_index, float* mask) {
+  switch (activation) {
+    case TensorsToSegmentationCalculatorOptions::NONE:
+      std::copy(tensor, tensor + width, mask);
+      break;
+    case TensorsToSegmentationCalculatorOptions::SIGMOID:
+      SigmoidRow(tensor, width, mask);
+      break;
+    case TensorsToSegmentationCalculatorOptions::SOFTMAX:
+      SoftmaxRow(tensor, width, output_layer_index, mask);
+      break;
+  }
+}
+
+}  // namespace mediapipe
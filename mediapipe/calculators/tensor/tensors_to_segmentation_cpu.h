@@ -0,0 +1,37 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_TENSORS_TO_SEGMENTATION_CPU_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_TENSORS_TO_SEGMENTATION_CPU_H_
+
+#include "mediapipe/calculators/tensor/tensors_to_segmentation_calculator.pb.h"
+
+namespace mediapipe {
+
+// Computes |width| mask values of the CPU path of
+// TensorsToSegmentationCalculator from one row of a segmentation tensor:
+// - NONE copies the single channel.
+// - SIGMOID applies 1 / (1 + exp(-x)) to the single channel.
+// - SOFTMAX returns the softmax probability of channel |output_layer_index|
+//   of two interleaved channels, which is the sigmoid of its difference with
+//   the other channel.
+// The caller validates the number of channels and the layer index.
+void ApplySegmentationActivation(
+    const float* tensor, int width,
+    TensorsToSegmentationCalculatorOptions::Activation activation,
+    int output_layer_index, float* mask);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_TENSORS_TO_SEGMENTATION_CPU_H_
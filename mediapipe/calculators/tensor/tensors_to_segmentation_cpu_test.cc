@@ -0,0 +1,81 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/tensors_to_segmentation_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+using Options = TensorsToSegmentationCalculatorOptions;
+
+constexpr int kWidth = 83;
+
+std::vector<float> RandomTensor(int size) {
+  std::mt19937 rng(4);
+  std::uniform_real_distribution<float> logit(-12.0f, 12.0f);
+  std::vector<float> tensor(size);
+  for (auto& value : tensor) value = logit(rng);
+  // Saturates exp().
+  tensor[0] = -200.0f;
+  tensor[1] = 200.0f;
+  tensor[2] = 0.0f;
+  return tensor;
+}
+
+TEST(TensorsToSegmentationCpuTest, None) {
+  const std::vector<float> tensor = RandomTensor(kWidth);
+  std::vector<float> mask(kWidth);
+  ApplySegmentationActivation(tensor.data(), kWidth, Options::NONE, 1,
+                              mask.data());
+  EXPECT_EQ(mask, tensor);
+}
+
+TEST(TensorsToSegmentationCpuTest, Sigmoid) {
+  const std::vector<float> tensor = RandomTensor(kWidth);
+  std::vector<float> mask(kWidth);
+  ApplySegmentationActivation(tensor.data(), kWidth, Options::SIGMOID, 1,
+                              mask.data());
+  for (int x = 0; x < kWidth; ++x) {
+    const double expected = 1.0 / (std::exp(-tensor[x]) + 1.0);
+    ASSERT_NEAR(mask[x], expected, 1e-6) << x;
+  }
+}
+
+TEST(TensorsToSegmentationCpuTest, Softmax) {
+  const std::vector<float> tensor = RandomTensor(2 * kWidth);
+  std::vector<float> mask(kWidth);
+  for (int layer : {0, 1}) {
+    ApplySegmentationActivation(tensor.data(), kWidth, Options::SOFTMAX, layer,
+                                mask.data());
+    for (int x = 0; x < kWidth; ++x) {
+      const double max_value = std::max(tensor[2 * x], tensor[2 * x + 1]);
+      const double expected =
+          std::exp(tensor[2 * x + layer] - max_value) /
+          (std::exp(tensor[2 * x] - max_value) +
+           std::exp(tensor[2 * x + 1] - max_value));
+      ASSERT_NEAR(mask[x], expected, 1e-6) << "layer " << layer << " at " << x;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -21,6 +21,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
@@ -80,7 +81,9 @@ inline bool HasImageTag(mediapipe::CalculatorContext* cc) { return false; }
 //
 // For CPU input frames, only SRGBA, SRGB and GRAY8 format are supported. The
 // output format is the same as input except for GRAY8 where the output is in
-// SRGB to support annotations in color.
+// SRGB to support annotations in color. The annotations are rendered directly
+// into the output ImageFrame, which comes from the kImageMultiPoolService pool
+// if the graph provides one.
 //
 // For GPU input frames, only 4-channel images are supported.
 //
@@ -134,15 +137,14 @@ class AnnotationOverlayCalculator : public CalculatorBase {
  private:
   absl::Status CreateRenderTargetCpu(CalculatorContext* cc,
                                      std::unique_ptr<cv::Mat>& image_mat,
-                                     ImageFormat::Format* target_format);
+                                     std::unique_ptr<ImageFrame>* output_frame);
   template <typename Type, const char* Tag>
   absl::Status CreateRenderTargetGpu(CalculatorContext* cc,
                                      std::unique_ptr<cv::Mat>& image_mat);
   template <typename Type, const char* Tag>
   absl::Status RenderToGpu(CalculatorContext* cc, uchar* overlay_image);
   absl::Status RenderToCpu(CalculatorContext* cc,
-                           const ImageFormat::Format& target_format,
-                           uchar* data_image);
+                           std::unique_ptr<ImageFrame> output_frame);
 
   absl::Status GlRender(CalculatorContext* cc);
   template <typename Type, const char* Tag>
@@ -159,6 +161,8 @@ class AnnotationOverlayCalculator : public CalculatorBase {
 
   bool use_gpu_ = false;
   bool gpu_initialized_ = false;
+  // Pool of the CPU output frames, which are also the render targets.
+  ServiceBinding<ImageMultiPool> image_pool_;
 #if !MEDIAPIPE_DISABLE_GPU
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
@@ -219,6 +223,7 @@ absl::Status AnnotationOverlayCalculator::GetContract(CalculatorContract* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   if (cc->Outputs().HasTag(kImageFrameTag)) {
     cc->Outputs().Tag(kImageFrameTag).Set<ImageFrame>();
+    cc->UseService(kImageMultiPoolService).Optional();
   }
 
   if (use_gpu) {
@@ -266,6 +271,8 @@ absl::Status AnnotationOverlayCalculator::Open(CalculatorContext* cc) {
 #if !MEDIAPIPE_DISABLE_GPU
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
 #endif  // !MEDIAPIPE_DISABLE_GPU
+  } else {
+    image_pool_ = cc->Service(kImageMultiPoolService);
   }
 
   return absl::OkStatus();
@@ -283,7 +290,7 @@ absl::Status AnnotationOverlayCalculator::Process(CalculatorContext* cc) {
 
   // Initialize render target, drawn with OpenCV.
   std::unique_ptr<cv::Mat> image_mat;
-  ImageFormat::Format target_format;
+  std::unique_ptr<ImageFrame> output_frame;
   if (use_gpu_) {
 #if !MEDIAPIPE_DISABLE_GPU
     if (!gpu_initialized_) {
@@ -301,7 +308,7 @@ absl::Status AnnotationOverlayCalculator::Process(CalculatorContext* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   } else {
     if (cc->Outputs().HasTag(kImageFrameTag)) {
-      MP_RETURN_IF_ERROR(CreateRenderTargetCpu(cc, image_mat, &target_format));
+      MP_RETURN_IF_ERROR(CreateRenderTargetCpu(cc, image_mat, &output_frame));
     }
   }
 
@@ -344,9 +351,8 @@ absl::Status AnnotationOverlayCalculator::Process(CalculatorContext* cc) {
         }));
 #endif  // !MEDIAPIPE_DISABLE_GPU
   } else {
-    // Copy the rendered image to output.
-    uchar* image_mat_ptr = image_mat->data;
-    MP_RETURN_IF_ERROR(RenderToCpu(cc, target_format, image_mat_ptr));
+    // The image was rendered into the output frame.
+    MP_RETURN_IF_ERROR(RenderToCpu(cc, std::move(output_frame)));
   }
 
   return absl::OkStatus();
@@ -366,21 +372,7 @@ absl::Status AnnotationOverlayCalculator::Close(CalculatorContext* cc) {
 }
 
 absl::Status AnnotationOverlayCalculator::RenderToCpu(
-    CalculatorContext* cc, const ImageFormat::Format& target_format,
-    uchar* data_image) {
-  auto output_frame = absl::make_unique<ImageFrame>(
-      target_format, renderer_->GetImageWidth(), renderer_->GetImageHeight());
-
-#if !MEDIAPIPE_DISABLE_GPU
-  output_frame->CopyPixelData(target_format, renderer_->GetImageWidth(),
-                              renderer_->GetImageHeight(), data_image,
-                              ImageFrame::kGlDefaultAlignmentBoundary);
-#else
-  output_frame->CopyPixelData(target_format, renderer_->GetImageWidth(),
-                              renderer_->GetImageHeight(), data_image,
-                              ImageFrame::kDefaultAlignmentBoundary);
-#endif  // !MEDIAPIPE_DISABLE_GPU
-
+    CalculatorContext* cc, std::unique_ptr<ImageFrame> output_frame) {
   if (cc->Outputs().HasTag(kImageFrameTag)) {
     cc->Outputs()
         .Tag(kImageFrameTag)
@@ -441,48 +433,57 @@ absl::Status AnnotationOverlayCalculator::RenderToGpu(CalculatorContext* cc,
 
 absl::Status AnnotationOverlayCalculator::CreateRenderTargetCpu(
     CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat,
-    ImageFormat::Format* target_format) {
+    std::unique_ptr<ImageFrame>* output_frame) {
+  // The image is rendered directly into the output frame.
+#if !MEDIAPIPE_DISABLE_GPU
+  constexpr uint32 kAlignmentBoundary = ImageFrame::kGlDefaultAlignmentBoundary;
+#else
+  constexpr uint32 kAlignmentBoundary = ImageFrame::kDefaultAlignmentBoundary;
+#endif  // !MEDIAPIPE_DISABLE_GPU
   if (image_frame_available_) {
     const auto& input_frame =
         cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
 
-    int target_mat_type;
+    ImageFormat::Format target_format;
     switch (input_frame.Format()) {
       case ImageFormat::SRGBA:
-        *target_format = ImageFormat::SRGBA;
-        target_mat_type = CV_8UC4;
+        target_format = ImageFormat::SRGBA;
         break;
       case ImageFormat::SRGB:
-        *target_format = ImageFormat::SRGB;
-        target_mat_type = CV_8UC3;
+        target_format = ImageFormat::SRGB;
         break;
       case ImageFormat::GRAY8:
-        *target_format = ImageFormat::SRGB;
-        target_mat_type = CV_8UC3;
+        target_format = ImageFormat::SRGB;
         break;
       default:
         return absl::UnknownError("Unexpected image frame format.");
         break;
     }
 
+    *output_frame =
+        CreateImageFrame(image_pool_, target_format, input_frame.Width(),
+                         input_frame.Height(), kAlignmentBoundary);
     image_mat = absl::make_unique<cv::Mat>(
-        input_frame.Height(), input_frame.Width(), target_mat_type);
+        formats::MatView(output_frame->get()));
 
     auto input_mat = formats::MatView(&input_frame);
     if (input_frame.Format() == ImageFormat::GRAY8) {
-      cv::Mat rgb_mat;
-      cv::cvtColor(input_mat, rgb_mat, CV_GRAY2RGB);
-      rgb_mat.copyTo(*image_mat);
+      cv::cvtColor(input_mat, *image_mat, CV_GRAY2RGB);
     } else {
       input_mat.copyTo(*image_mat);
     }
   } else {
+    *output_frame = CreateImageFrame(
+        image_pool_, ImageFormat::SRGB, options_.canvas_width_px(),
+        options_.canvas_height_px(), kAlignmentBoundary);
     image_mat = absl::make_unique<cv::Mat>(
-        options_.canvas_height_px(), options_.canvas_width_px(), CV_8UC3,
+        formats::MatView(output_frame->get()));
+    image_mat->setTo(
         cv::Scalar(options_.canvas_color().r(), options_.canvas_color().g(),
                    options_.canvas_color().b()));
-    *target_format = ImageFormat::SRGB;
   }
+  // OpenCV writes into the output frame as long as it does not reallocate.
+  RET_CHECK_EQ(image_mat->data, (*output_frame)->MutablePixelData());
 
   return absl::OkStatus();
 }
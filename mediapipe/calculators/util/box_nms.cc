@@ -0,0 +1,409 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/util/box_nms.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+#include "mediapipe/framework/port/logging.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MEDIAPIPE_BOX_NMS_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MEDIAPIPE_BOX_NMS_NEON 1
+#endif
+
+namespace mediapipe {
+
+namespace {
+
+using OverlapType = NonMaxSuppressionCalculatorOptions::OverlapType;
+
+// How the intersection area of two boxes is normalized into a similarity.
+enum class Normalization {
+  // Area of the bounding box of both boxes (JACCARD).
+  kBoundingUnion,
+  // Area of the box compared against the reference (MODIFIED_JACCARD as used
+  // by default suppression).
+  kOtherArea,
+  // Area of the reference box (MODIFIED_JACCARD as used by weighted
+  // suppression).
+  kReferenceArea,
+  // Sum of both areas minus the intersection (INTERSECTION_OVER_UNION).
+  kUnion,
+};
+
+Normalization GetNormalization(OverlapType overlap_type, bool weighted) {
+  switch (overlap_type) {
+    case NonMaxSuppressionCalculatorOptions::JACCARD:
+      return Normalization::kBoundingUnion;
+    case NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD:
+      // NonMaxSuppressionCalculator normalizes by the area of the second box
+      // it compares, which is the candidate for default suppression and the
+      // retained box for weighted suppression.
+      return weighted ? Normalization::kReferenceArea
+                      : Normalization::kOtherArea;
+    case NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION:
+      return Normalization::kUnion;
+    default:
+      LOG(FATAL) << "Unrecognized overlap type: " << overlap_type;
+  }
+  return Normalization::kBoundingUnion;
+}
+
+// Sets overlaps[j] to 1 if the similarity between box j and box `ref` is
+// above `threshold`, and to 0 otherwise. The similarity is zero for boxes
+// that don't intersect or whose normalization is not positive, as in
+// NonMaxSuppressionCalculator. Compares intersection > threshold * norm
+// rather than dividing, which avoids a division per box.
+class OverlapKernel {
+ public:
+  OverlapKernel(const NmsBoxes& boxes, Normalization normalization,
+                float threshold)
+      : boxes_(boxes), normalization_(normalization), threshold_(threshold) {}
+
+  void Run(int ref, uint8_t* overlaps) const {
+    const int n = boxes_.size();
+    int j = 0;
+#if defined(MEDIAPIPE_BOX_NMS_SSE2)
+    j = RunSse2(ref, overlaps);
+#elif defined(MEDIAPIPE_BOX_NMS_NEON)
+    j = RunNeon(ref, overlaps);
+#endif
+    for (; j < n; ++j) {
+      overlaps[j] = Overlaps(ref, j) ? 1 : 0;
+    }
+  }
+
+ private:
+  static float ClampToZero(float v) { return v > 0.0f ? v : 0.0f; }
+
+  bool Overlaps(int ref, int j) const {
+    const float r_xmin = boxes_.xmin[ref], r_ymin = boxes_.ymin[ref];
+    const float r_xmax = boxes_.xmax[ref], r_ymax = boxes_.ymax[ref];
+    const float xmin = boxes_.xmin[j], ymin = boxes_.ymin[j];
+    const float xmax = boxes_.xmax[j], ymax = boxes_.ymax[j];
+    const float intersection =
+        ClampToZero(std::min(r_xmax, xmax) - std::max(r_xmin, xmin)) *
+        ClampToZero(std::min(r_ymax, ymax) - std::max(r_ymin, ymin));
+    float norm = 0.0f;
+    switch (normalization_) {
+      case Normalization::kBoundingUnion:
+        norm = (std::max(r_xmax, xmax) - std::min(r_xmin, xmin)) *
+               (std::max(r_ymax, ymax) - std::min(r_ymin, ymin));
+        break;
+      case Normalization::kOtherArea:
+        norm = (xmax - xmin) * (ymax - ymin);
+        break;
+      case Normalization::kReferenceArea:
+        norm = (r_xmax - r_xmin) * (r_ymax - r_ymin);
+        break;
+      case Normalization::kUnion:
+        norm = (r_xmax - r_xmin) * (r_ymax - r_ymin) +
+               (xmax - xmin) * (ymax - ymin) - intersection;
+        break;
+    }
+    return norm > 0.0f ? intersection > threshold_ * norm : 0.0f > threshold_;
+  }
+
+#if defined(MEDIAPIPE_BOX_NMS_SSE2)
+  int RunSse2(int ref, uint8_t* overlaps) const {
+    const int n = boxes_.size();
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 threshold = _mm_set1_ps(threshold_);
+    const __m128 below_zero =
+        0.0f > threshold_ ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+    const __m128 r_xmin = _mm_set1_ps(boxes_.xmin[ref]);
+    const __m128 r_ymin = _mm_set1_ps(boxes_.ymin[ref]);
+    const __m128 r_xmax = _mm_set1_ps(boxes_.xmax[ref]);
+    const __m128 r_ymax = _mm_set1_ps(boxes_.ymax[ref]);
+    const __m128 r_area =
+        _mm_mul_ps(_mm_sub_ps(r_xmax, r_xmin), _mm_sub_ps(r_ymax, r_ymin));
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+      const __m128 xmin = _mm_loadu_ps(&boxes_.xmin[j]);
+      const __m128 ymin = _mm_loadu_ps(&boxes_.ymin[j]);
+      const __m128 xmax = _mm_loadu_ps(&boxes_.xmax[j]);
+      const __m128 ymax = _mm_loadu_ps(&boxes_.ymax[j]);
+      // _mm_max_ps returns its second operand if either is NaN, so NaN
+      // extents clamp to zero as in the scalar path.
+      const __m128 intersection = _mm_mul_ps(
+          _mm_max_ps(_mm_sub_ps(_mm_min_ps(r_xmax, xmax),
+                                _mm_max_ps(r_xmin, xmin)),
+                     zero),
+          _mm_max_ps(_mm_sub_ps(_mm_min_ps(r_ymax, ymax),
+                                _mm_max_ps(r_ymin, ymin)),
+                     zero));
+      __m128 norm = zero;
+      switch (normalization_) {
+        case Normalization::kBoundingUnion:
+          norm = _mm_mul_ps(
+              _mm_sub_ps(_mm_max_ps(r_xmax, xmax), _mm_min_ps(r_xmin, xmin)),
+              _mm_sub_ps(_mm_max_ps(r_ymax, ymax), _mm_min_ps(r_ymin, ymin)));
+          break;
+        case Normalization::kOtherArea:
+          norm = _mm_mul_ps(_mm_sub_ps(xmax, xmin), _mm_sub_ps(ymax, ymin));
+          break;
+        case Normalization::kReferenceArea:
+          norm = r_area;
+          break;
+        case Normalization::kUnion:
+          norm = _mm_sub_ps(
+              _mm_add_ps(r_area, _mm_mul_ps(_mm_sub_ps(xmax, xmin),
+                                            _mm_sub_ps(ymax, ymin))),
+              intersection);
+          break;
+      }
+      const __m128 positive = _mm_cmpgt_ps(norm, zero);
+      const __m128 above =
+          _mm_cmpgt_ps(intersection, _mm_mul_ps(threshold, norm));
+      const int mask = _mm_movemask_ps(
+          _mm_or_ps(_mm_and_ps(positive, above),
+                    _mm_andnot_ps(positive, below_zero)));
+      overlaps[j + 0] = mask & 1;
+      overlaps[j + 1] = (mask >> 1) & 1;
+      overlaps[j + 2] = (mask >> 2) & 1;
+      overlaps[j + 3] = (mask >> 3) & 1;
+    }
+    return j;
+  }
+#endif  // MEDIAPIPE_BOX_NMS_SSE2
+
+#if defined(MEDIAPIPE_BOX_NMS_NEON)
+  int RunNeon(int ref, uint8_t* overlaps) const {
+    const int n = boxes_.size();
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t threshold = vdupq_n_f32(threshold_);
+    const uint32x4_t below_zero = vdupq_n_u32(0.0f > threshold_ ? 1 : 0);
+    const float32x4_t r_xmin = vdupq_n_f32(boxes_.xmin[ref]);
+    const float32x4_t r_ymin = vdupq_n_f32(boxes_.ymin[ref]);
+    const float32x4_t r_xmax = vdupq_n_f32(boxes_.xmax[ref]);
+    const float32x4_t r_ymax = vdupq_n_f32(boxes_.ymax[ref]);
+    const float32x4_t r_area =
+        vmulq_f32(vsubq_f32(r_xmax, r_xmin), vsubq_f32(r_ymax, r_ymin));
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+      const float32x4_t xmin = vld1q_f32(&boxes_.xmin[j]);
+      const float32x4_t ymin = vld1q_f32(&boxes_.ymin[j]);
+      const float32x4_t xmax = vld1q_f32(&boxes_.xmax[j]);
+      const float32x4_t ymax = vld1q_f32(&boxes_.ymax[j]);
+      const float32x4_t width = vsubq_f32(vminq_f32(r_xmax, xmax),
+                                          vmaxq_f32(r_xmin, xmin));
+      const float32x4_t height = vsubq_f32(vminq_f32(r_ymax, ymax),
+                                           vmaxq_f32(r_ymin, ymin));
+      // vmaxq_f32 propagates NaN, so clamp with a compare and select instead.
+      const float32x4_t intersection =
+          vmulq_f32(vbslq_f32(vcgtq_f32(width, zero), width, zero),
+                    vbslq_f32(vcgtq_f32(height, zero), height, zero));
+      float32x4_t norm = zero;
+      switch (normalization_) {
+        case Normalization::kBoundingUnion:
+          norm = vmulq_f32(
+              vsubq_f32(vmaxq_f32(r_xmax, xmax), vminq_f32(r_xmin, xmin)),
+              vsubq_f32(vmaxq_f32(r_ymax, ymax), vminq_f32(r_ymin, ymin)));
+          break;
+        case Normalization::kOtherArea:
+          norm = vmulq_f32(vsubq_f32(xmax, xmin), vsubq_f32(ymax, ymin));
+          break;
+        case Normalization::kReferenceArea:
+          norm = r_area;
+          break;
+        case Normalization::kUnion:
+          norm = vsubq_f32(
+              vaddq_f32(r_area, vmulq_f32(vsubq_f32(xmax, xmin),
+                                          vsubq_f32(ymax, ymin))),
+              intersection);
+          break;
+      }
+      const uint32x4_t positive = vcgtq_f32(norm, zero);
+      const uint32x4_t above =
+          vcgtq_f32(intersection, vmulq_f32(threshold, norm));
+      const uint32x4_t result =
+          vbslq_u32(positive, vshrq_n_u32(above, 31), below_zero);
+      overlaps[j + 0] = vgetq_lane_u32(result, 0);
+      overlaps[j + 1] = vgetq_lane_u32(result, 1);
+      overlaps[j + 2] = vgetq_lane_u32(result, 2);
+      overlaps[j + 3] = vgetq_lane_u32(result, 3);
+    }
+    return j;
+  }
+#endif  // MEDIAPIPE_BOX_NMS_NEON
+
+  const NmsBoxes& boxes_;
+  const Normalization normalization_;
+  const float threshold_;
+};
+
+// Returns the position of the highest scoring remaining box, or -1 if none
+// remains.
+int ArgMaxRemaining(const NmsBoxes& boxes,
+                    const std::vector<uint8_t>& remaining) {
+  int best = -1;
+  float best_score = 0.0f;
+  for (int j = 0; j < boxes.size(); ++j) {
+    if (remaining[j] && (best < 0 || boxes.score[j] > best_score)) {
+      best = j;
+      best_score = boxes.score[j];
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+void NmsBoxes::Clear() {
+  xmin.clear();
+  ymin.clear();
+  xmax.clear();
+  ymax.clear();
+  score.clear();
+  id.clear();
+}
+
+void NmsBoxes::Reserve(int n) {
+  xmin.reserve(n);
+  ymin.reserve(n);
+  xmax.reserve(n);
+  ymax.reserve(n);
+  score.reserve(n);
+  id.reserve(n);
+}
+
+void NmsBoxes::Add(float box_xmin, float box_ymin, float box_xmax,
+                   float box_ymax, float box_score, int box_id) {
+  xmin.push_back(box_xmin);
+  ymin.push_back(box_ymin);
+  xmax.push_back(box_xmax);
+  ymax.push_back(box_ymax);
+  score.push_back(box_score);
+  id.push_back(box_id);
+}
+
+NmsOptions NmsOptionsFromProto(
+    const NonMaxSuppressionCalculatorOptions& options) {
+  NmsOptions nms_options;
+  nms_options.overlap_type = options.overlap_type();
+  nms_options.min_suppression_threshold = options.min_suppression_threshold();
+  nms_options.min_score_threshold = options.min_score_threshold();
+  nms_options.weighted =
+      options.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED;
+  // Weighted suppression has never applied max_num_detections.
+  nms_options.max_num_detections =
+      nms_options.weighted ? -1 : options.max_num_detections();
+  return nms_options;
+}
+
+void KeepTopKBoxes(int k, NmsBoxes* boxes) {
+  if (k <= 0 || boxes->size() <= k) return;
+  std::vector<int> order(boxes->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::nth_element(order.begin(), order.begin() + k, order.end(),
+                   [boxes](int a, int b) {
+                     return boxes->score[a] > boxes->score[b];
+                   });
+  order.resize(k);
+  std::sort(order.begin(), order.end());
+  for (int i = 0; i < k; ++i) {
+    const int from = order[i];
+    boxes->xmin[i] = boxes->xmin[from];
+    boxes->ymin[i] = boxes->ymin[from];
+    boxes->xmax[i] = boxes->xmax[from];
+    boxes->ymax[i] = boxes->ymax[from];
+    boxes->score[i] = boxes->score[from];
+    boxes->id[i] = boxes->id[from];
+  }
+  boxes->xmin.resize(k);
+  boxes->ymin.resize(k);
+  boxes->xmax.resize(k);
+  boxes->ymax.resize(k);
+  boxes->score.resize(k);
+  boxes->id.resize(k);
+}
+
+std::vector<NmsCluster> NonMaxSuppression(const NmsBoxes& boxes,
+                                          const NmsOptions& options) {
+  std::vector<NmsCluster> clusters;
+  const int n = boxes.size();
+  if (n == 0 || options.max_num_detections == 0) return clusters;
+
+  const OverlapKernel kernel(
+      boxes, GetNormalization(options.overlap_type, options.weighted),
+      options.min_suppression_threshold);
+  std::vector<uint8_t> remaining(n, 1);
+  std::vector<uint8_t> overlaps(n);
+  while (options.max_num_detections < 0 ||
+         static_cast<int>(clusters.size()) < options.max_num_detections) {
+    const int top = ArgMaxRemaining(boxes, remaining);
+    if (top < 0) break;
+    if (options.min_score_threshold > 0 &&
+        boxes.score[top] < options.min_score_threshold) {
+      break;
+    }
+    kernel.Run(top, overlaps.data());
+
+    NmsCluster cluster;
+    cluster.top = top;
+    cluster.xmin = boxes.xmin[top];
+    cluster.ymin = boxes.ymin[top];
+    cluster.xmax = boxes.xmax[top];
+    cluster.ymax = boxes.ymax[top];
+    if (!options.weighted) {
+      remaining[top] = 0;
+      for (int j = 0; j < n; ++j) {
+        remaining[j] &= overlaps[j] ^ 1;
+      }
+      clusters.push_back(std::move(cluster));
+      continue;
+    }
+
+    float total_score = 0.0f;
+    float w_xmin = 0.0f;
+    float w_ymin = 0.0f;
+    float w_xmax = 0.0f;
+    float w_ymax = 0.0f;
+    for (int j = 0; j < n; ++j) {
+      if (!remaining[j] || !overlaps[j]) continue;
+      remaining[j] = 0;
+      cluster.members.push_back(j);
+      const float score = boxes.score[j];
+      total_score += score;
+      w_xmin += boxes.xmin[j] * score;
+      w_ymin += boxes.ymin[j] * score;
+      w_xmax += boxes.xmax[j] * score;
+      w_ymax += boxes.ymax[j] * score;
+    }
+    // A box that doesn't overlap even itself (e.g. an empty box) ends
+    // weighted suppression, as in NonMaxSuppressionCalculator. Scores that
+    // don't sum to a positive value (e.g. all zero) have no weighted average,
+    // so the cluster keeps the box at `top`.
+    const bool done = cluster.members.empty();
+    if (done) {
+      cluster.members.push_back(top);
+    } else if (total_score > 0.0f) {
+      cluster.xmin = w_xmin / total_score;
+      cluster.ymin = w_ymin / total_score;
+      cluster.xmax = w_xmax / total_score;
+      cluster.ymax = w_ymax / total_score;
+    }
+    clusters.push_back(std::move(cluster));
+    if (done) break;
+  }
+  return clusters;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,92 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_UTIL_BOX_NMS_H_
+#define MEDIAPIPE_CALCULATORS_UTIL_BOX_NMS_H_
+
+#include <vector>
+
+#include "mediapipe/calculators/util/non_max_suppression_calculator.pb.h"
+
+namespace mediapipe {
+
+// Candidate boxes for non-maximum suppression, stored as parallel arrays so
+// that the overlap of one box with all others can be computed with SIMD.
+// Coordinates are relative to the image size.
+struct NmsBoxes {
+  std::vector<float> xmin;
+  std::vector<float> ymin;
+  std::vector<float> xmax;
+  std::vector<float> ymax;
+  std::vector<float> score;
+  // Caller-defined index of each box, e.g. its anchor or detection index.
+  std::vector<int> id;
+
+  int size() const { return static_cast<int>(score.size()); }
+  void Clear();
+  void Reserve(int n);
+  void Add(float box_xmin, float box_ymin, float box_xmax, float box_ymax,
+           float box_score, int box_id);
+};
+
+struct NmsOptions {
+  NonMaxSuppressionCalculatorOptions::OverlapType overlap_type =
+      NonMaxSuppressionCalculatorOptions::JACCARD;
+  // A box is suppressed by a retained one if their overlap similarity is
+  // strictly above this threshold.
+  float min_suppression_threshold = 1.0f;
+  // Boxes scoring below this are never retained. Ignored if not positive.
+  float min_score_threshold = -1.0f;
+  // Maximum number of retained boxes, or -1 for no limit.
+  int max_num_detections = -1;
+  // Whether to average each retained box with the boxes it suppresses.
+  bool weighted = false;
+};
+
+// Returns the options matching what NonMaxSuppressionCalculator does for
+// `options`.
+NmsOptions NmsOptionsFromProto(
+    const NonMaxSuppressionCalculatorOptions& options);
+
+// A box retained by non-maximum suppression.
+struct NmsCluster {
+  // Position in NmsBoxes of the highest scoring box of the cluster.
+  int top;
+  // Positions in NmsBoxes of the boxes merged into this cluster, including
+  // `top`. Only populated for weighted suppression.
+  std::vector<int> members;
+  // Retained box. For weighted suppression this is the score-weighted
+  // average of the member boxes, otherwise the box at `top`. It is also the
+  // box at `top` when the member scores don't sum to a positive value.
+  float xmin;
+  float ymin;
+  float xmax;
+  float ymax;
+};
+
+// Keeps only the `k` highest scoring boxes, preserving their relative order.
+// Does nothing if `k` is not positive or there are at most `k` boxes.
+void KeepTopKBoxes(int k, NmsBoxes* boxes);
+
+// Greedy non-maximum suppression, returning the retained clusters in order
+// of decreasing score. Equivalent to NonMaxSuppressionCalculator but does not
+// sort: each iteration picks the best remaining box and suppresses the boxes
+// overlapping it in one vectorized pass, so the cost is proportional to the
+// number of boxes times the number of retained boxes.
+std::vector<NmsCluster> NonMaxSuppression(const NmsBoxes& boxes,
+                                          const NmsOptions& options);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_UTIL_BOX_NMS_H_
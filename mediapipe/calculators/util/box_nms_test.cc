@@ -0,0 +1,228 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/util/box_nms.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "mediapipe/calculators/util/non_max_suppression_calculator.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+std::vector<int> RetainedIds(const NmsBoxes& boxes,
+                             const std::vector<NmsCluster>& clusters) {
+  std::vector<int> ids;
+  for (const auto& cluster : clusters) ids.push_back(boxes.id[cluster.top]);
+  return ids;
+}
+
+// Straightforward version of the default suppression in
+// NonMaxSuppressionCalculator, on sorted boxes and with exact similarities.
+std::vector<int> ReferenceNonMaxSuppression(const NmsBoxes& boxes,
+                                            const NmsOptions& options) {
+  std::vector<int> order(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&boxes](int a, int b) {
+    return boxes.score[a] > boxes.score[b];
+  });
+  auto area = [&boxes](int i) {
+    return (boxes.xmax[i] - boxes.xmin[i]) * (boxes.ymax[i] - boxes.ymin[i]);
+  };
+  auto similarity = [&](int a, int b) {
+    const float width = std::min(boxes.xmax[a], boxes.xmax[b]) -
+                        std::max(boxes.xmin[a], boxes.xmin[b]);
+    const float height = std::min(boxes.ymax[a], boxes.ymax[b]) -
+                         std::max(boxes.ymin[a], boxes.ymin[b]);
+    if (width < 0 || height < 0) return 0.0f;
+    const float intersection = width * height;
+    float norm = 0.0f;
+    switch (options.overlap_type) {
+      case NonMaxSuppressionCalculatorOptions::JACCARD:
+        norm = (std::max(boxes.xmax[a], boxes.xmax[b]) -
+                std::min(boxes.xmin[a], boxes.xmin[b])) *
+               (std::max(boxes.ymax[a], boxes.ymax[b]) -
+                std::min(boxes.ymin[a], boxes.ymin[b]));
+        break;
+      case NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD:
+        norm = area(b);
+        break;
+      default:
+        norm = area(a) + area(b) - intersection;
+        break;
+    }
+    return norm > 0.0f ? intersection / norm : 0.0f;
+  };
+  std::vector<int> retained;
+  for (int candidate : order) {
+    bool suppressed = false;
+    for (int kept : retained) {
+      if (similarity(kept, candidate) > options.min_suppression_threshold) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) retained.push_back(candidate);
+    if (options.max_num_detections > 0 &&
+        retained.size() >= options.max_num_detections) {
+      break;
+    }
+  }
+  for (int& index : retained) index = boxes.id[index];
+  return retained;
+}
+
+TEST(BoxNmsTest, SuppressesOverlappingBoxes) {
+  NmsBoxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.5f, 0.5f, 0.8f, 10);
+  boxes.Add(0.05f, 0.0f, 0.55f, 0.5f, 0.9f, 11);
+  boxes.Add(0.6f, 0.6f, 0.9f, 0.9f, 0.7f, 12);
+  NmsOptions options;
+  options.min_suppression_threshold = 0.5f;
+
+  EXPECT_THAT(RetainedIds(boxes, NonMaxSuppression(boxes, options)),
+              ElementsAre(11, 12));
+
+  options.max_num_detections = 1;
+  EXPECT_THAT(RetainedIds(boxes, NonMaxSuppression(boxes, options)),
+              ElementsAre(11));
+
+  options.max_num_detections = -1;
+  options.min_score_threshold = 0.75f;
+  EXPECT_THAT(RetainedIds(boxes, NonMaxSuppression(boxes, options)),
+              ElementsAre(11));
+}
+
+TEST(BoxNmsTest, ModifiedJaccardNormalizesByCandidate) {
+  NmsBoxes boxes;
+  // A large box and a small box inside it.
+  boxes.Add(0.0f, 0.0f, 1.0f, 1.0f, 0.9f, 0);
+  boxes.Add(0.1f, 0.1f, 0.3f, 0.3f, 0.8f, 1);
+  NmsOptions options;
+  options.overlap_type = NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD;
+  options.min_suppression_threshold = 0.5f;
+  // The small box is fully covered, so it is suppressed.
+  EXPECT_THAT(RetainedIds(boxes, NonMaxSuppression(boxes, options)),
+              ElementsAre(0));
+
+  // When the small box scores higher, the large one is kept.
+  boxes.score[1] = 0.95f;
+  EXPECT_THAT(RetainedIds(boxes, NonMaxSuppression(boxes, options)),
+              ElementsAre(1, 0));
+}
+
+TEST(BoxNmsTest, WeightedAveragesCluster) {
+  NmsBoxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.4f, 0.4f, 0.75f, 0);
+  boxes.Add(0.1f, 0.1f, 0.5f, 0.5f, 0.25f, 1);
+  boxes.Add(0.7f, 0.7f, 0.9f, 0.9f, 0.5f, 2);
+  NmsOptions options;
+  options.weighted = true;
+  options.min_suppression_threshold = 0.3f;
+
+  const auto clusters = NonMaxSuppression(boxes, options);
+  ASSERT_EQ(clusters.size(), 2);
+  EXPECT_EQ(clusters[0].top, 0);
+  EXPECT_THAT(clusters[0].members, ElementsAre(0, 1));
+  EXPECT_FLOAT_EQ(clusters[0].xmin, 0.025f);
+  EXPECT_FLOAT_EQ(clusters[0].ymin, 0.025f);
+  EXPECT_FLOAT_EQ(clusters[0].xmax, 0.425f);
+  EXPECT_FLOAT_EQ(clusters[0].ymax, 0.425f);
+  EXPECT_EQ(clusters[1].top, 2);
+  EXPECT_THAT(clusters[1].members, ElementsAre(2));
+  EXPECT_FLOAT_EQ(clusters[1].xmin, 0.7f);
+}
+
+TEST(BoxNmsTest, WeightedStopsAtEmptyBox) {
+  NmsBoxes boxes;
+  boxes.Add(0.5f, 0.5f, 0.5f, 0.5f, 0.9f, 0);
+  boxes.Add(0.0f, 0.0f, 0.4f, 0.4f, 0.8f, 1);
+  NmsOptions options;
+  options.weighted = true;
+  options.min_suppression_threshold = 0.3f;
+
+  const auto clusters = NonMaxSuppression(boxes, options);
+  ASSERT_EQ(clusters.size(), 1);
+  EXPECT_EQ(clusters[0].top, 0);
+  EXPECT_THAT(clusters[0].members, ElementsAre(0));
+}
+
+TEST(BoxNmsTest, WeightedKeepsTopBoxForZeroScores) {
+  NmsBoxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.4f, 0.4f, 0.0f, 0);
+  boxes.Add(0.1f, 0.1f, 0.5f, 0.5f, 0.0f, 1);
+  NmsOptions options;
+  options.weighted = true;
+  options.min_suppression_threshold = 0.3f;
+
+  const auto clusters = NonMaxSuppression(boxes, options);
+  ASSERT_EQ(clusters.size(), 1);
+  EXPECT_EQ(clusters[0].top, 0);
+  EXPECT_THAT(clusters[0].members, ElementsAre(0, 1));
+  EXPECT_FLOAT_EQ(clusters[0].xmin, 0.0f);
+  EXPECT_FLOAT_EQ(clusters[0].ymin, 0.0f);
+  EXPECT_FLOAT_EQ(clusters[0].xmax, 0.4f);
+  EXPECT_FLOAT_EQ(clusters[0].ymax, 0.4f);
+}
+
+TEST(BoxNmsTest, KeepTopKBoxesPreservesOrder) {
+  NmsBoxes boxes;
+  const std::vector<float> scores = {0.1f, 0.9f, 0.3f, 0.8f, 0.5f, 0.2f};
+  for (int i = 0; i < scores.size(); ++i) {
+    boxes.Add(i, i, i + 1, i + 1, scores[i], i);
+  }
+  KeepTopKBoxes(3, &boxes);
+  EXPECT_THAT(boxes.id, ElementsAre(1, 3, 4));
+  EXPECT_THAT(boxes.score, ElementsAre(0.9f, 0.8f, 0.5f));
+  EXPECT_THAT(boxes.xmin, ElementsAre(1.0f, 3.0f, 4.0f));
+
+  KeepTopKBoxes(-1, &boxes);
+  EXPECT_EQ(boxes.size(), 3);
+}
+
+TEST(BoxNmsTest, MatchesReferenceOnRandomBoxes) {
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> position(0.0f, 0.9f);
+  std::uniform_real_distribution<float> extent(0.02f, 0.3f);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+  // An odd count exercises the scalar tail after the vectorized loop.
+  NmsBoxes boxes;
+  for (int i = 0; i < 1001; ++i) {
+    const float xmin = position(rng);
+    const float ymin = position(rng);
+    boxes.Add(xmin, ymin, xmin + extent(rng), ymin + extent(rng), score(rng),
+              i);
+  }
+  for (auto overlap_type :
+       {NonMaxSuppressionCalculatorOptions::JACCARD,
+        NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD,
+        NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION}) {
+    NmsOptions options;
+    options.overlap_type = overlap_type;
+    options.min_suppression_threshold = 0.3f;
+    EXPECT_THAT(RetainedIds(boxes, NonMaxSuppression(boxes, options)),
+                ElementsAreArray(ReferenceNonMaxSuppression(boxes, options)))
+        << "overlap_type " << overlap_type;
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,283 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the end-to-end performance of a MediaPipe graph on synthetic
+// ImageFrames. Reports per-frame latency percentiles, throughput, peak RSS
+// and the Process() time of each calculator as a GraphBenchmarkResult, printed
+// as JSON and optionally written to --output_file.
+//
+// bazel build -c opt --define MEDIAPIPE_DISABLE_GPU=1 \
+//   //mediapipe/examples/desktop/face_detection:face_detection_cpu_benchmark
+// BIN=bazel-bin/mediapipe/examples/desktop/face_detection
+// GRAPH=mediapipe/graphs/face_detection/face_detection_desktop_live.pbtxt
+// $BIN/face_detection_cpu_benchmark --calculator_graph_config_file=$GRAPH \
+//   --frame_rate=30 --output_file=/tmp/face_detection.json
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/protobuf/util/json_util.h"
+#include "mediapipe/examples/desktop/graph_benchmark.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+ABSL_FLAG(std::string, calculator_graph_config_file, "",
+          "Name of file containing text format CalculatorGraphConfig proto.");
+ABSL_FLAG(std::string, input_stream, "input_video",
+          "The graph input stream receiving ImageFrames.");
+ABSL_FLAG(std::string, output_stream, "output_video",
+          "The graph output stream that completes a frame.");
+ABSL_FLAG(int, width, 640, "Width of the synthetic input frames.");
+ABSL_FLAG(int, height, 480, "Height of the synthetic input frames.");
+ABSL_FLAG(int, num_frames, 300, "Number of frames to measure.");
+ABSL_FLAG(int, warmup_frames, 30,
+          "Number of frames sent before measuring starts.");
+ABSL_FLAG(double, frame_rate, 0,
+          "Rate at which frames are sent. If 0, frames are sent as fast as "
+          "the graph accepts them.");
+ABSL_FLAG(std::string, output_file, "",
+          "If set, the GraphBenchmarkResult is also written to this file as "
+          "JSON.");
+
+namespace mediapipe {
+namespace {
+
+// Returns a frame with a deterministic pattern, so that graphs take the same
+// path through every run.
+std::unique_ptr<ImageFrame> MakeFrame(int width, int height) {
+  auto frame = absl::make_unique<ImageFrame>(
+      ImageFormat::SRGB, width, height, ImageFrame::kDefaultAlignmentBoundary);
+  for (int y = 0; y < height; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      row[3 * x] = static_cast<uint8>(x * 255 / width);
+      row[3 * x + 1] = static_cast<uint8>(y * 255 / height);
+      row[3 * x + 2] = static_cast<uint8>((x + y) & 0xff);
+    }
+  }
+  return frame;
+}
+
+int64 PeakRssKb() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#if defined(__APPLE__)
+  // ru_maxrss is in bytes on macOS and in kilobytes elsewhere.
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+// Returns the value at quantile "q" of sorted "values", by nearest rank.
+int64 Percentile(const std::vector<int64>& values, double q) {
+  if (values.empty()) {
+    return 0;
+  }
+  const int rank = static_cast<int>(q * values.size() + 0.5);
+  return values[std::min<int>(std::max(rank, 1), values.size()) - 1];
+}
+
+void AddCalculatorTimes(const std::vector<CalculatorProfile>& profiles,
+                        GraphBenchmarkResult* result) {
+  int64 all_calculators_usec = 0;
+  for (const CalculatorProfile& profile : profiles) {
+    all_calculators_usec += profile.process_runtime().total();
+  }
+  for (const CalculatorProfile& profile : profiles) {
+    int64 calls = 0;
+    for (int64 count : profile.process_runtime().count()) {
+      calls += count;
+    }
+    auto* time = result->add_calculator();
+    time->set_name(profile.name());
+    time->set_process_calls(calls);
+    time->set_process_total_usec(profile.process_runtime().total());
+    time->set_process_mean_usec(
+        calls > 0 ? static_cast<double>(profile.process_runtime().total()) /
+                        calls
+                  : 0);
+    time->set_process_fraction(
+        all_calculators_usec > 0
+            ? static_cast<double>(profile.process_runtime().total()) /
+                  all_calculators_usec
+            : 0);
+  }
+  std::sort(result->mutable_calculator()->begin(),
+            result->mutable_calculator()->end(),
+            [](const GraphBenchmarkResult::CalculatorTime& a,
+               const GraphBenchmarkResult::CalculatorTime& b) {
+              return a.process_total_usec() > b.process_total_usec();
+            });
+}
+
+absl::Status RunGraphBenchmark() {
+  std::string config_contents;
+  MP_RETURN_IF_ERROR(file::GetContents(
+      absl::GetFlag(FLAGS_calculator_graph_config_file), &config_contents));
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(config_contents);
+  // Per-calculator times come from the GraphProfiler.
+  config.mutable_profiler_config()->set_enable_profiler(true);
+
+  const std::string input_stream = absl::GetFlag(FLAGS_input_stream);
+  const std::string output_stream = absl::GetFlag(FLAGS_output_stream);
+  const int width = absl::GetFlag(FLAGS_width);
+  const int height = absl::GetFlag(FLAGS_height);
+  const int num_frames = absl::GetFlag(FLAGS_num_frames);
+  const int warmup_frames = absl::GetFlag(FLAGS_warmup_frames);
+  const double frame_rate = absl::GetFlag(FLAGS_frame_rate);
+  RET_CHECK_GT(num_frames, 0);
+  RET_CHECK_GE(frame_rate, 0);
+
+  // Frame timestamps are spaced as in a 30 fps video unless a rate is given,
+  // since some calculators track motion across timestamps.
+  const int64 timestamp_step = frame_rate > 0 ? 1000000 / frame_rate : 33333;
+  const absl::Duration send_interval =
+      frame_rate > 0 ? absl::Seconds(1 / frame_rate) : absl::ZeroDuration();
+
+  absl::Mutex mutex;
+  // Send times of the frames in flight, by packet timestamp.
+  std::map<int64, absl::Time> send_times;
+  std::vector<int64> latencies_usec;
+
+  CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config));
+  MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+      output_stream, [&](const Packet& packet) {
+        const absl::Time now = absl::Now();
+        absl::MutexLock lock(&mutex);
+        auto it = send_times.find(packet.Timestamp().Value());
+        if (it != send_times.end()) {
+          latencies_usec.push_back(absl::ToInt64Microseconds(now - it->second));
+          // Frames dropped by the graph are older than this one.
+          send_times.erase(send_times.begin(), std::next(it));
+        }
+        return absl::OkStatus();
+      }));
+  MP_RETURN_IF_ERROR(graph.StartRun({}));
+
+  const std::unique_ptr<ImageFrame> frame = MakeFrame(width, height);
+  int64 timestamp = 0;
+  auto send_frames = [&](int count) -> absl::Status {
+    absl::Time next_send = absl::Now();
+    for (int i = 0; i < count; ++i) {
+      if (frame_rate > 0) {
+        absl::SleepFor(next_send - absl::Now());
+        next_send += send_interval;
+      }
+      auto copy = absl::make_unique<ImageFrame>();
+      copy->CopyFrom(*frame, ImageFrame::kDefaultAlignmentBoundary);
+      {
+        absl::MutexLock lock(&mutex);
+        send_times[timestamp] = absl::Now();
+      }
+      MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
+          input_stream, Adopt(copy.release()).At(Timestamp(timestamp))));
+      timestamp += timestamp_step;
+    }
+    return graph.WaitUntilIdle();
+  };
+
+  LOG(INFO) << "Warming up with " << warmup_frames << " frames.";
+  MP_RETURN_IF_ERROR(send_frames(warmup_frames));
+  graph.profiler()->Reset();
+  {
+    absl::MutexLock lock(&mutex);
+    send_times.clear();
+    latencies_usec.clear();
+  }
+
+  LOG(INFO) << "Measuring " << num_frames << " frames.";
+  const absl::Time start = absl::Now();
+  MP_RETURN_IF_ERROR(send_frames(num_frames));
+  const absl::Duration elapsed = absl::Now() - start;
+
+  std::vector<CalculatorProfile> profiles;
+  MP_RETURN_IF_ERROR(graph.profiler()->GetCalculatorProfiles(&profiles));
+  MP_RETURN_IF_ERROR(graph.CloseAllInputStreams());
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+
+  GraphBenchmarkResult result;
+  result.set_graph(absl::GetFlag(FLAGS_calculator_graph_config_file));
+  result.set_width(width);
+  result.set_height(height);
+  result.set_target_frame_rate(frame_rate);
+  result.set_frames_sent(num_frames);
+  {
+    absl::MutexLock lock(&mutex);
+    std::sort(latencies_usec.begin(), latencies_usec.end());
+    result.set_frames_completed(latencies_usec.size());
+    result.set_frames_per_second(latencies_usec.size() /
+                                 absl::ToDoubleSeconds(elapsed));
+    result.set_latency_p50_usec(Percentile(latencies_usec, 0.5));
+    result.set_latency_p90_usec(Percentile(latencies_usec, 0.9));
+    result.set_latency_p99_usec(Percentile(latencies_usec, 0.99));
+    result.set_latency_max_usec(
+        latencies_usec.empty() ? 0 : latencies_usec.back());
+    int64 total_usec = 0;
+    for (int64 latency : latencies_usec) total_usec += latency;
+    result.set_latency_mean_usec(
+        latencies_usec.empty()
+            ? 0
+            : static_cast<double>(total_usec) / latencies_usec.size());
+  }
+  result.set_peak_rss_kb(PeakRssKb());
+  AddCalculatorTimes(profiles, &result);
+
+  std::string json;
+  google::protobuf::util::JsonPrintOptions options;
+  options.add_whitespace = true;
+  options.preserve_proto_field_names = true;
+  RET_CHECK(
+      google::protobuf::util::MessageToJsonString(result, &json, options).ok());
+  std::cout << json;
+  if (!absl::GetFlag(FLAGS_output_file).empty()) {
+    MP_RETURN_IF_ERROR(
+        file::SetContents(absl::GetFlag(FLAGS_output_file), json));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace mediapipe
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = mediapipe::RunGraphBenchmark();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to run the benchmark: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
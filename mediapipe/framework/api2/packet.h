@@ -26,6 +26,8 @@ using HolderBase = mediapipe::packet_internal::HolderBase;
 
 template <typename T>
 class Packet;
+template <typename T>
+class InputShardAccess;
 
 // Type-erased packet.
 class PacketBase {
@@ -83,6 +85,15 @@ class PacketBase {
   std::shared_ptr<HolderBase> payload_;
   Timestamp timestamp_;
 
+ private:
+  // Returns this packet as a Packet<T> without checking the type of its
+  // payload. Only for packets which were already validated as T, such as the
+  // packets of an input stream of type T.
+  template <typename T>
+  Packet<T> UncheckedAs() &&;
+
+  template <typename T>
+  friend class InputShardAccess;
   template <typename T>
   friend PacketBase PacketBaseAdopting(const T* ptr);
   friend PacketBase FromOldPacket(const mediapipe::Packet& op);
@@ -208,11 +219,13 @@ class Packet : public Packet<internal::Generic> {
   Packet<T> At(Timestamp timestamp) const&;
   Packet<T> At(Timestamp timestamp) &&;
 
+  // The payload of a Packet<T> is checked to be a T when the Packet<T> is
+  // created, so Get() does not check its type again.
   const T& Get() const {
     CHECK(payload_);
-    packet_internal::Holder<T>* typed_payload = payload_->As<T>();
-    CHECK(typed_payload);
-    return typed_payload->data();
+    DCHECK(payload_->As<T>());
+    return static_cast<const packet_internal::Holder<T>*>(payload_.get())
+        ->data();
   }
   const T& operator*() const { return Get(); }
 
@@ -414,6 +427,12 @@ inline Packet<internal::Generic> PacketBase::As<internal::Generic>() const {
   return Packet<internal::Generic>(payload_).At(timestamp_);
 }
 
+template <typename T>
+inline Packet<T> PacketBase::UncheckedAs() && {
+  DCHECK(!payload_ || payload_->As<T>());
+  return Packet<T>(std::move(payload_)).At(timestamp_);
+}
+
 inline PacketBase PacketBase::At(Timestamp timestamp) const& {
   return PacketBase(*this).At(timestamp);
 }
@@ -447,8 +466,8 @@ inline Packet<internal::Generic> Packet<internal::Generic>::At(
 
 template <typename T, typename... Args>
 Packet<T> MakePacket(Args&&... args) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(
-      new T(std::forward<Args>(args)...)));
+  return Packet<T>(
+      packet_internal::MakeHolder<T>(std::forward<Args>(args)...));
 }
 
 template <typename T>
@@ -593,10 +593,21 @@ class InputShardAccess : public Packet<T> {
 
  private:
   InputShardAccess(const CalculatorContext&, InputStreamShard* stream)
-      : Packet<T>(stream ? FromOldPacket(stream->Value()).template As<T>()
-                         : Packet<T>()),
+      : Packet<T>(stream ? FromStream(*stream) : Packet<T>()),
         stream_(stream) {}
 
+  // The packets of an input stream are validated against the type of the
+  // stream before they are queued, so the payload of an input of a single
+  // type is not checked again.
+  static Packet<T> FromStream(const InputStreamShard& stream) {
+    if constexpr (std::is_same_v<T, internal::Generic> ||
+                  internal::IsOneOf<T>{}) {
+      return FromOldPacket(stream.Value()).template As<T>();
+    } else {
+      return FromOldPacket(stream.Value()).template UncheckedAs<T>();
+    }
+  }
+
   template <class F, class... A>
   auto WrapConsumeCall(F f, A&&... args) {
     stream_->Value() = {};
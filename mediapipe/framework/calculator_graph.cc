@@ -17,13 +17,17 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <utility>
 #include <vector>
 
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -33,10 +37,13 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
 #include "mediapipe/framework/delegating_executor.h"
+#include "mediapipe/framework/formats/image_multi_pool.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
@@ -52,11 +59,13 @@
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/framework/status_handler.h"
 #include "mediapipe/framework/status_handler.pb.h"
 #include "mediapipe/framework/thread_pool_executor.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 #include "mediapipe/framework/tool/fill_packet_set.h"
+#include "mediapipe/framework/tool/name_util.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/validate.h"
@@ -76,6 +85,130 @@ namespace {
 // threshold.
 constexpr int kMaxNumAccumulatedErrors = 1000;
 constexpr char kApplicationThreadExecutorType[] = "ApplicationThreadExecutor";
+constexpr char kThreadPoolExecutorType[] = "ThreadPoolExecutor";
+
+// Returns the quantile |q| of a TimeHistogram, interpolating linearly within
+// an interval. The last interval is open-ended, so within it the estimate is
+// the mean of all calls, or the interval's lower bound if greater.
+double HistogramQuantile(const TimeHistogram& histogram, double q) {
+  int64 num_calls = 0;
+  for (int64 count : histogram.count()) {
+    num_calls += count;
+  }
+  if (num_calls == 0) {
+    return 0;
+  }
+  const double rank = q * num_calls;
+  const int num_intervals = histogram.count_size();
+  int64 calls_below = 0;
+  for (int i = 0; i < num_intervals; ++i) {
+    const int64 count = histogram.count(i);
+    const double lower =
+        static_cast<double>(i) * histogram.interval_size_usec();
+    if (i == num_intervals - 1) {
+      return std::max(lower,
+                      static_cast<double>(histogram.total()) / num_calls);
+    }
+    if (calls_below + count >= rank && count > 0) {
+      return lower + histogram.interval_size_usec() * (rank - calls_below) /
+                         count;
+    }
+    calls_below += count;
+  }
+  return 0;
+}
+
+// Returns the input streams of the calculators which receive the packets of
+// the output stream |output_stream_index|, directly or through other
+// calculators.
+std::vector<int> DownstreamInputStreams(const ValidatedGraphConfig& graph,
+                                        int output_stream_index) {
+  const std::vector<EdgeInfo>& input_infos = graph.InputStreamInfos();
+  std::vector<bool> reached(graph.OutputStreamInfos().size(), false);
+  std::vector<bool> visited_node(graph.CalculatorInfos().size(), false);
+  std::vector<int> pending = {output_stream_index};
+  reached[output_stream_index] = true;
+  std::vector<int> downstream;
+  while (!pending.empty()) {
+    const int output_index = pending.back();
+    pending.pop_back();
+    for (int index = 0; index < input_infos.size(); ++index) {
+      const EdgeInfo& edge_info = input_infos[index];
+      if (edge_info.upstream != output_index || edge_info.back_edge) {
+        continue;
+      }
+      downstream.push_back(index);
+      const int node_id = edge_info.parent_node.index;
+      if (visited_node[node_id]) {
+        continue;
+      }
+      visited_node[node_id] = true;
+      const NodeTypeInfo& node_info = graph.CalculatorInfos()[node_id];
+      const int base_index = node_info.OutputStreamBaseIndex();
+      for (int i = 0; i < node_info.OutputStreamTypes().NumEntries(); ++i) {
+        if (!reached[base_index + i]) {
+          reached[base_index + i] = true;
+          pending.push_back(base_index + i);
+        }
+      }
+    }
+  }
+  return downstream;
+}
+
+// Returns the ids of the calculators that own the input streams |downstream|
+// and whose output streams feed none of them: the last calculators to
+// receive the packets which reach |downstream|.
+std::vector<int> LastDownstreamNodes(const ValidatedGraphConfig& graph,
+                                     const std::vector<int>& downstream) {
+  const std::vector<EdgeInfo>& input_infos = graph.InputStreamInfos();
+  const std::vector<EdgeInfo>& output_infos = graph.OutputStreamInfos();
+  std::vector<bool> is_downstream(graph.CalculatorInfos().size(), false);
+  std::vector<bool> feeds_downstream(graph.CalculatorInfos().size(), false);
+  for (int index : downstream) {
+    is_downstream[input_infos[index].parent_node.index] = true;
+    const NodeTypeInfo::NodeRef& upstream =
+        output_infos[input_infos[index].upstream].parent_node;
+    if (upstream.type == NodeTypeInfo::NodeType::CALCULATOR) {
+      feeds_downstream[upstream.index] = true;
+    }
+  }
+  std::vector<int> node_ids;
+  for (int node_id = 0; node_id < is_downstream.size(); ++node_id) {
+    if (is_downstream[node_id] && !feeds_downstream[node_id]) {
+      node_ids.push_back(node_id);
+    }
+  }
+  return node_ids;
+}
+
+// A thread pool executor that is only created when the first task is
+// scheduled on it, so that an executor no node runs on costs no thread.
+class LazyThreadPoolExecutor : public Executor {
+ public:
+  explicit LazyThreadPoolExecutor(const MediaPipeOptions& options)
+      : options_(options) {}
+
+  void Schedule(std::function<void()> task) override {
+    Executor* executor;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!executor_) {
+        absl::StatusOr<Executor*> created =
+            ThreadPoolExecutor::Create(options_);
+        CHECK(created.ok()) << created.status();
+        executor_.reset(*created);
+      }
+      executor = executor_.get();
+    }
+    executor->Schedule(std::move(task));
+  }
+
+ private:
+  const MediaPipeOptions options_;
+  absl::Mutex mutex_;
+  std::unique_ptr<Executor> executor_ ABSL_GUARDED_BY(mutex_);
+};
 
 }  // namespace
 
@@ -130,6 +263,7 @@ CalculatorGraph::CalculatorGraph(const CalculatorGraphConfig& config)
 // they only need to be fully visible here, where their destructor is
 // instantiated.
 CalculatorGraph::~CalculatorGraph() {
+  StopAdaptiveExecutorAssignment();
   // Stop periodic profiler output to ublock Executor destructors.
   absl::Status status = profiler()->Stop();
   if (!status.ok()) {
@@ -177,6 +311,14 @@ absl::Status CalculatorGraph::InitializeStreams() {
     const EdgeInfo& edge_info = validated_graph_->InputStreamInfos()[index];
     MP_RETURN_IF_ERROR(input_stream_managers_[index].Initialize(
         edge_info.name, edge_info.packet_type, edge_info.back_edge));
+    // The producer of the stream validates each packet against its own
+    // PacketType, which is proven here to be at least as strict.
+    if (edge_info.upstream >= 0 &&
+        edge_info.packet_type->Subsumes(
+            *validated_graph_->OutputStreamInfos()[edge_info.upstream]
+                 .packet_type)) {
+      input_stream_managers_[index].DisableTypeValidation();
+    }
   }
 
   // Create and initialize the output streams.
@@ -226,6 +368,70 @@ absl::Status CalculatorGraph::InitializeStreams() {
   return absl::OkStatus();
 }
 
+absl::Status CalculatorGraph::InitializeInFlightLimiters() {
+  in_flight_limiters_by_node_.resize(validated_graph_->CalculatorInfos().size());
+  for (const InFlightLimitConfig& limit_config :
+       validated_graph_->Config().in_flight_limit()) {
+    if (limit_config.max_in_flight() <= 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "InFlightLimitConfig.max_in_flight must be positive.";
+    }
+    std::vector<std::string> stream_names;
+    if (limit_config.input_stream().empty()) {
+      for (const auto& item : graph_input_streams_) {
+        stream_names.push_back(item.first);
+      }
+    } else if (mediapipe::ContainsKey(graph_input_streams_,
+                                      limit_config.input_stream())) {
+      stream_names.push_back(limit_config.input_stream());
+    } else {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "InFlightLimitConfig.input_stream \""
+             << limit_config.input_stream()
+             << "\" is not a graph input stream.";
+    }
+    for (const std::string& stream_name : stream_names) {
+      if (mediapipe::ContainsKey(in_flight_limiters_, stream_name)) {
+        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+               << "Graph input stream \"" << stream_name
+               << "\" has more than one InFlightLimitConfig.";
+      }
+      const std::vector<int> downstream_indexes = DownstreamInputStreams(
+          *validated_graph_, validated_graph_->OutputStreamIndex(stream_name));
+      std::vector<InputStreamManager*> downstream;
+      for (int index : downstream_indexes) {
+        downstream.push_back(&input_stream_managers_[index]);
+      }
+      GraphInputStream* stream = graph_input_streams_[stream_name].get();
+      const int node_id = graph_input_stream_node_ids_[stream_name];
+      auto limiter = absl::make_unique<internal::InFlightLimiter>(
+          limit_config, std::move(downstream),
+          [this, stream](Packet packet) {
+            return AddPacketToGraphInputStream(stream, std::move(packet));
+          },
+          [this, node_id]() { return IsNodeThrottled(node_id); },
+          counter_factory_->GetCounter(
+              absl::StrCat("InFlightLimiter.", stream_name, ".dropped")));
+      // A timestamp settles last in the calculators at the end of the graph,
+      // so the limiter is only updated after their Process() calls.
+      for (int id :
+           LastDownstreamNodes(*validated_graph_, downstream_indexes)) {
+        in_flight_limiters_by_node_[id].push_back(limiter.get());
+      }
+      in_flight_limiters_[stream_name] = std::move(limiter);
+    }
+  }
+  if (!in_flight_limiters_.empty()) {
+    scheduler_.SetNodeProcessedCallback([this](int node_id) {
+      for (internal::InFlightLimiter* limiter :
+           in_flight_limiters_by_node_[node_id]) {
+        limiter->Update();
+      }
+    });
+  }
+  return absl::OkStatus();
+}
+
 absl::Status CalculatorGraph::InitializeCalculatorNodes() {
   // Check if the user has specified a maximum queue size for an input stream.
   max_queue_size_ = validated_graph_->Config().max_queue_size();
@@ -308,6 +514,7 @@ absl::Status CalculatorGraph::InitializeExecutors() {
   // default_executor_options is null.
   const ThreadPoolExecutorOptions* default_executor_options = nullptr;
   bool use_application_thread = false;
+  InitializeNumaPolicy();
   for (const ExecutorConfig& executor_config :
        validated_graph_->Config().executor()) {
     if (mediapipe::ContainsKey(executors_, executor_config.name())) {
@@ -343,16 +550,32 @@ absl::Status CalculatorGraph::InitializeExecutors() {
              << "\" must be provided to the graph with a "
                 "CalculatorGraph::SetExecutor() call.";
     }
+    if (executor_config.options().HasExtension(
+            ThreadPoolExecutorOptions::ext)) {
+      executor_num_threads_[executor_config.name()] =
+          executor_config.options()
+              .GetExtension(ThreadPoolExecutorOptions::ext)
+              .num_threads();
+    }
+    MediaPipeOptions executor_options = executor_config.options();
+    if (executor_config.type() == kThreadPoolExecutorType) {
+      ApplyNumaPolicy(
+          executor_options.MutableExtension(ThreadPoolExecutorOptions::ext));
+    }
     // clang-format off
     ASSIGN_OR_RETURN(Executor* executor,
                      ExecutorRegistry::CreateByNameInNamespace(
                          validated_graph_->Package(),
-                         executor_config.type(), executor_config.options()));
+                         executor_config.type(), executor_options));
     // clang-format on
     MEDIAPIPE_CHECK_OK(SetExecutorInternal(
         executor_config.name(), std::shared_ptr<Executor>(executor)));
   }
 
+  if (validated_graph_->Config().has_adaptive_executor()) {
+    MP_RETURN_IF_ERROR(InitializeAdaptiveExecutors(use_application_thread));
+  }
+
   if (!mediapipe::ContainsKey(executors_, "")) {
     MP_RETURN_IF_ERROR(InitializeDefaultExecutor(default_executor_options,
                                                  use_application_thread));
@@ -406,8 +629,13 @@ absl::Status CalculatorGraph::Initialize(
   validated_graph_ = std::move(validated_graph);
 
   MP_RETURN_IF_ERROR(InitializeExecutors());
+  if (validated_graph_->Config().use_packet_arena()) {
+    packet_arena_ = absl::make_unique<PacketArena>();
+    scheduler_.SetPacketArena(packet_arena_.get());
+  }
   MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
   MP_RETURN_IF_ERROR(InitializeStreams());
+  MP_RETURN_IF_ERROR(InitializeInFlightLimiters());
   MP_RETURN_IF_ERROR(InitializeCalculatorNodes());
 #ifdef MEDIAPIPE_PROFILER_AVAILABLE
   MP_RETURN_IF_ERROR(InitializeProfiler());
@@ -539,6 +767,9 @@ absl::Status CalculatorGraph::StartRun(
   MP_RETURN_IF_ERROR(PrepareForRun(extra_side_packets, stream_headers));
   MP_RETURN_IF_ERROR(profiler_->Start(executors_[""].get()));
   scheduler_.Start();
+  if (!adaptive_executor_names_.empty()) {
+    StartAdaptiveExecutorAssignment();
+  }
   return absl::OkStatus();
 }
 
@@ -697,12 +928,16 @@ absl::Status CalculatorGraph::PrepareForRun(
     full_input_streams_.clear();
     full_input_streams_.resize(validated_graph_->CalculatorInfos().size() +
                                graph_input_streams_.size());
+    throttle_counts_.assign(full_input_streams_.size(), 0);
   }
 
   for (auto& item : graph_input_streams_) {
     item.second->PrepareForRun(
         std::bind(&CalculatorGraph::RecordError, this, std::placeholders::_1));
   }
+  for (auto& item : in_flight_limiters_) {
+    item.second->PrepareForRun();
+  }
   for (int index = 0; index < validated_graph_->OutputSidePacketInfos().size();
        ++index) {
     output_side_packets_[index].PrepareForRun(
@@ -890,19 +1125,29 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
                           .set_packet_ts(packet.Timestamp())
                           .set_packet_data_id(&packet));
 
+  std::unique_ptr<internal::InFlightLimiter>* limiter =
+      mediapipe::FindOrNull(in_flight_limiters_, stream_name);
+  if (limiter) {
+    return (*limiter)->AddPacket(std::forward<T>(packet));
+  }
+  return AddPacketToGraphInputStream(stream->get(), std::forward<T>(packet));
+}
+
+absl::Status CalculatorGraph::AddPacketToGraphInputStream(
+    GraphInputStream* stream, Packet packet) {
   // InputStreamManager is thread safe. GraphInputStream is not, so this method
   // should not be called by multiple threads concurrently. Note that this could
   // potentially lead to the max queue size being exceeded by one packet at most
   // because we don't have the lock over the input stream.
-  (*stream)->AddPacket(std::forward<T>(packet));
+  stream->AddPacket(std::move(packet));
   if (has_error_) {
     absl::Status error_status;
     GetCombinedErrors("Graph has errors: ", &error_status);
     return error_status;
   }
-  (*stream)->PropagateUpdatesToMirrors();
+  stream->PropagateUpdatesToMirrors();
 
-  VLOG(2) << "Packet added directly to: " << stream_name;
+  VLOG(2) << "Packet added directly to: " << stream->GetManager()->Name();
   // Note: one reason why we need to call the scheduler here is that we have
   // re-throttled the graph input streams, and we may need to unthrottle them
   // again if the graph is still idle. Unthrottling basically only lets in one
@@ -937,6 +1182,11 @@ absl::Status CalculatorGraph::CloseInputStream(const std::string& stream_name) {
     return absl::OkStatus();
   }
 
+  std::unique_ptr<internal::InFlightLimiter>* limiter =
+      mediapipe::FindOrNull(in_flight_limiters_, stream_name);
+  if (limiter) {
+    (*limiter)->Close();
+  }
   (*stream)->Close();
 
   if (++num_closed_graph_input_streams_ == graph_input_streams_.size()) {
@@ -947,6 +1197,9 @@ absl::Status CalculatorGraph::CloseInputStream(const std::string& stream_name) {
 }
 
 absl::Status CalculatorGraph::CloseAllInputStreams() {
+  for (auto& item : in_flight_limiters_) {
+    item.second->Close();
+  }
   for (auto& item : graph_input_streams_) {
     item.second->Close();
   }
@@ -958,6 +1211,9 @@ absl::Status CalculatorGraph::CloseAllInputStreams() {
 }
 
 absl::Status CalculatorGraph::CloseAllPacketSources() {
+  for (auto& item : in_flight_limiters_) {
+    item.second->Close();
+  }
   for (auto& item : graph_input_streams_) {
     item.second->Close();
   }
@@ -976,6 +1232,10 @@ void CalculatorGraph::RecordError(const absl::Status& error) {
     errors_.push_back(error);
     has_error_ = true;
     scheduler_.SetHasError(true);
+    // Wakes up AddPacketToInputStream() calls blocked by a limiter.
+    for (auto& item : in_flight_limiters_) {
+      item.second->Abort();
+    }
     for (const auto& stream : graph_output_streams_) {
       stream->NotifyError();
     }
@@ -1101,6 +1361,9 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
         }
 
         bool is_throttled = !full_input_streams_[node_id].empty();
+        if (!was_throttled && is_throttled) {
+          ++throttle_counts_[node_id];
+        }
         bool is_graph_input_stream =
             node_id >= validated_graph_->CalculatorInfos().size();
         if (is_graph_input_stream) {
@@ -1131,6 +1394,22 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
   }
 }
 
+bool CalculatorGraph::ReleaseInFlightTimestamps() {
+  bool has_waiting_packet = false;
+  for (auto& item : in_flight_limiters_) {
+    has_waiting_packet |= item.second->ReleaseAll();
+  }
+  return has_waiting_packet;
+}
+
+bool CalculatorGraph::AddWaitingInFlightPackets() {
+  bool did_add = false;
+  for (auto& item : in_flight_limiters_) {
+    did_add |= item.second->Update();
+  }
+  return did_add;
+}
+
 bool CalculatorGraph::IsNodeThrottled(int node_id) {
   absl::MutexLock lock(&full_input_streams_mutex_);
   return max_queue_size_ != -1 && !full_input_streams_[node_id].empty();
@@ -1245,6 +1524,8 @@ absl::Status CalculatorGraph::CreateDefaultThreadPool(
     options->CopyFrom(*default_executor_options);
   }
   options->set_num_threads(num_threads);
+  ApplyNumaPolicy(options);
+  executor_num_threads_[""] = num_threads;
   // clang-format off
   ASSIGN_OR_RETURN(Executor* executor,
                    ThreadPoolExecutor::Create(extendable_options));
@@ -1257,9 +1538,152 @@ bool CalculatorGraph::IsReservedExecutorName(const std::string& name) {
   return ValidatedGraphConfig::IsReservedExecutorName(name);
 }
 
+void CalculatorGraph::InitializeNumaPolicy() {
+  const NumaPolicyConfig& numa_policy =
+      validated_graph_->Config().numa_policy();
+  if (numa_policy.policy() != NumaPolicyConfig::SINGLE_NODE) {
+    return;
+  }
+  if (numa_policy.node() >= 0) {
+    numa_node_ = numa_policy.node();
+    return;
+  }
+  const std::set<int> nodes = GetNumaNodeIds();
+  if (nodes.empty()) {
+    LOG(WARNING) << "The system does not report NUMA nodes. Ignoring "
+                    "numa_policy.";
+    return;
+  }
+  // Spreads the graphs of the process across the nodes, whose ids need not be
+  // contiguous.
+  static std::atomic<int> next_node(0);
+  numa_node_ = *std::next(nodes.begin(), next_node.fetch_add(1) % nodes.size());
+}
+
+void CalculatorGraph::ApplyNumaPolicy(
+    ThreadPoolExecutorOptions* options) const {
+  if (numa_node_ < 0 || options->cpu_ids_size() > 0 ||
+      options->has_numa_node() ||
+      options->has_require_processor_performance()) {
+    return;
+  }
+  options->set_numa_node(numa_node_);
+}
+
+absl::Status CalculatorGraph::InitializeAdaptiveExecutors(
+    bool use_application_thread) {
+  const CalculatorGraphConfig& config = validated_graph_->Config();
+  if (!config.profiler_config().enable_profiler()) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "adaptive_executor requires profiler_config.enable_profiler.";
+  }
+  if (use_application_thread) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "adaptive_executor cannot be used with the \""
+           << kApplicationThreadExecutorType << "\".";
+  }
+  int num_executors = config.adaptive_executor().max_dedicated_executors();
+  num_executors = num_executors ? num_executors : 2;
+  for (int i = 0; i < num_executors; ++i) {
+    // Each executor runs a single node, and only nodes with max_in_flight 1
+    // are moved, which run one Process() call at a time. A second thread
+    // would always be idle. The thread is only started once a node is moved
+    // to the executor, so the default executor keeps all its threads.
+    MediaPipeOptions extendable_options;
+    ThreadPoolExecutorOptions* options =
+        extendable_options.MutableExtension(ThreadPoolExecutorOptions::ext);
+    options->set_num_threads(1);
+    ApplyNumaPolicy(options);
+    const std::string name = absl::StrCat("__adaptive_", i);
+    MP_RETURN_IF_ERROR(SetExecutorInternal(
+        name, std::make_shared<LazyThreadPoolExecutor>(extendable_options)));
+    executor_num_threads_[name] = 1;
+    adaptive_executor_names_.push_back(name);
+  }
+  return absl::OkStatus();
+}
+
+void CalculatorGraph::StartAdaptiveExecutorAssignment() {
+  int64 duration_usec =
+      validated_graph_->Config().adaptive_executor().profile_duration_usec();
+  duration_usec = duration_usec > 0 ? duration_usec : 3000000;
+  adaptive_executor_stop_ = absl::make_unique<absl::Notification>();
+  adaptive_executor_thread_ =
+      absl::make_unique<ThreadPool>("adaptive_executor", 1);
+  adaptive_executor_thread_->StartWorkers();
+  absl::Notification* stop = adaptive_executor_stop_.get();
+  adaptive_executor_thread_->Schedule([this, stop, duration_usec] {
+    if (stop->WaitForNotificationWithTimeout(
+            absl::Microseconds(duration_usec))) {
+      return;
+    }
+    absl::Status status = AssignNodesByCost();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to assign nodes to executors: " << status;
+    }
+  });
+}
+
+void CalculatorGraph::StopAdaptiveExecutorAssignment() {
+  if (adaptive_executor_thread_) {
+    adaptive_executor_stop_->Notify();
+    // Joins the thread.
+    adaptive_executor_thread_.reset();
+    adaptive_executor_stop_.reset();
+  }
+}
+
+absl::Status CalculatorGraph::AssignNodesByCost() {
+  const CalculatorGraphConfig& config = validated_graph_->Config();
+  std::vector<CalculatorProfile> profiles;
+  MP_RETURN_IF_ERROR(profiler_->GetCalculatorProfiles(&profiles));
+  absl::flat_hash_map<std::string, int64> cost_by_name;
+  int64 total_cost = 0;
+  for (const CalculatorProfile& profile : profiles) {
+    cost_by_name[profile.name()] = profile.process_runtime().total();
+    total_cost += profile.process_runtime().total();
+  }
+  if (total_cost == 0) {
+    return absl::OkStatus();
+  }
+  double min_cost_fraction = config.adaptive_executor().min_cost_fraction();
+  min_cost_fraction = min_cost_fraction > 0 ? min_cost_fraction : 0.1;
+
+  // Nodes assigned to an executor in the config stay there, and nodes that
+  // run in parallel are better served by the default thread pool.
+  std::vector<std::pair<int64, int>> costs;
+  for (int node_id = 0; node_id < validated_graph_->CalculatorInfos().size();
+       ++node_id) {
+    if (!nodes_[node_id]->Executor().empty() ||
+        config.node(node_id).max_in_flight() > 1) {
+      continue;
+    }
+    const int64 cost = cost_by_name[tool::CanonicalNodeName(config, node_id)];
+    if (cost > 0 && cost >= min_cost_fraction * total_cost) {
+      costs.emplace_back(cost, node_id);
+    }
+  }
+  std::sort(costs.begin(), costs.end(),
+            [](const std::pair<int64, int>& a, const std::pair<int64, int>& b) {
+              return a.first > b.first;
+            });
+  for (int i = 0; i < costs.size() && i < adaptive_executor_names_.size();
+       ++i) {
+    CalculatorNode* node = nodes_[costs[i].second].get();
+    MP_RETURN_IF_ERROR(scheduler_.ReassignNodeToSchedulerQueue(
+        node, adaptive_executor_names_[i]));
+    VLOG(1) << "Moved " << node->DebugName() << " to executor \""
+            << adaptive_executor_names_[i] << "\" with "
+            << 100.0 * costs[i].first / total_cost
+            << "% of the Process() time.";
+  }
+  return absl::OkStatus();
+}
+
 absl::Status CalculatorGraph::FinishRun() {
   // Check for any errors that may have occurred.
   absl::Status status = absl::OkStatus();
+  StopAdaptiveExecutorAssignment();
   MP_RETURN_IF_ERROR(profiler_->Stop());
   GetCombinedErrors(&status);
   CleanupAfterRun(&status);
@@ -1291,6 +1715,18 @@ void CalculatorGraph::CleanupAfterRun(absl::Status* status) {
 
   scheduler_.CleanupAfterRun();
 
+  for (auto& item : in_flight_limiters_) {
+    item.second->Close();
+  }
+
+  if (packet_arena_) {
+    const PacketArena::Stats stats = packet_arena_->TakeStats();
+    counter_factory_->GetCounter("PacketArena.packets")
+        ->IncrementBy(stats.packets);
+    counter_factory_->GetCounter("PacketArena.avoided_allocations")
+        ->IncrementBy(stats.avoided_allocations());
+  }
+
   {
     absl::MutexLock lock(&error_mutex_);
     errors_.clear();
@@ -1338,4 +1774,101 @@ absl::Status CalculatorGraph::GetCalculatorProfiles(
   return profiler_->GetCalculatorProfiles(profiles);
 }
 
+absl::Status CalculatorGraph::GetGraphMetrics(GraphMetrics* metrics) {
+  RET_CHECK(initialized_) << "CalculatorGraph is not initialized.";
+  metrics->Clear();
+  const CalculatorGraphConfig& config = validated_graph_->Config();
+  const int num_nodes = validated_graph_->CalculatorInfos().size();
+
+  std::vector<CalculatorProfile> profiles;
+  MP_RETURN_IF_ERROR(profiler_->GetCalculatorProfiles(&profiles));
+  absl::flat_hash_map<std::string, const CalculatorProfile*> profile_by_name;
+  for (const CalculatorProfile& profile : profiles) {
+    profile_by_name[profile.name()] = &profile;
+  }
+  std::vector<std::string> node_names(num_nodes);
+  for (int node_id = 0; node_id < num_nodes; ++node_id) {
+    node_names[node_id] = tool::CanonicalNodeName(config, node_id);
+    GraphMetrics::NodeMetrics* node = metrics->add_node();
+    node->set_name(node_names[node_id]);
+    auto iter = profile_by_name.find(node_names[node_id]);
+    if (iter == profile_by_name.end()) {
+      continue;
+    }
+    const TimeHistogram& runtime = iter->second->process_runtime();
+    int64 process_count = 0;
+    for (int64 count : runtime.count()) {
+      process_count += count;
+    }
+    node->set_process_count(process_count);
+    node->set_process_time_usec(runtime.total());
+    node->set_process_time_p50_usec(HistogramQuantile(runtime, 0.5));
+    node->set_process_time_p90_usec(HistogramQuantile(runtime, 0.9));
+    node->set_process_time_p99_usec(HistogramQuantile(runtime, 0.99));
+  }
+
+  {
+    absl::MutexLock lock(&full_input_streams_mutex_);
+    if (!full_input_streams_.empty()) {
+      for (int node_id = 0; node_id < num_nodes; ++node_id) {
+        GraphMetrics::NodeMetrics* node = metrics->mutable_node(node_id);
+        node->set_throttled(!full_input_streams_[node_id].empty());
+        node->set_throttle_count(throttle_counts_[node_id]);
+      }
+    }
+    for (const auto& name_id : graph_input_stream_node_ids_) {
+      GraphMetrics::GraphInputStreamMetrics* stream =
+          metrics->add_graph_input_stream();
+      stream->set_name(name_id.first);
+      if (name_id.second < full_input_streams_.size()) {
+        stream->set_throttled(!full_input_streams_[name_id.second].empty());
+        stream->set_throttle_count(throttle_counts_[name_id.second]);
+      }
+    }
+  }
+
+  for (int index = 0; index < validated_graph_->InputStreamInfos().size();
+       ++index) {
+    const EdgeInfo& edge_info = validated_graph_->InputStreamInfos()[index];
+    const InputStreamManager& manager = input_stream_managers_[index];
+    GraphMetrics::InputStreamMetrics* stream = metrics->add_input_stream();
+    if (edge_info.parent_node.type == NodeTypeInfo::NodeType::CALCULATOR) {
+      stream->set_node(node_names[edge_info.parent_node.index]);
+    }
+    stream->set_name(edge_info.name);
+    stream->set_queue_size(manager.QueueSize());
+    stream->set_peak_queue_size(manager.PeakQueueSize());
+    stream->set_max_queue_size(manager.MaxQueueSize());
+  }
+
+  const int64 run_time = scheduler_.RunTime();
+  for (const auto& name_load : scheduler_.GetExecutorLoads()) {
+    GraphMetrics::ExecutorMetrics* executor = metrics->add_executor();
+    executor->set_name(name_load.first);
+    executor->set_busy_time_usec(name_load.second.busy_time);
+    executor->set_run_time_usec(run_time);
+    executor->set_queued_nodes(name_load.second.num_queued_nodes);
+    // The thread count of an executor provided with SetExecutor() is unknown.
+    auto iter = executor_num_threads_.find(name_load.first);
+    const int num_threads =
+        iter != executor_num_threads_.end() ? iter->second : 0;
+    if (num_threads > 0) {
+      executor->set_num_threads(num_threads);
+      if (run_time > 0) {
+        executor->set_utilization(
+            static_cast<double>(name_load.second.busy_time) / run_time /
+            num_threads);
+      }
+    }
+  }
+
+  // The CPU image calculators allocate their output frames from this pool.
+  std::shared_ptr<ImageMultiPool> image_pool =
+      service_manager_.GetServiceObject(kImageMultiPoolService);
+  if (image_pool) {
+    image_pool->GetCpuMetrics(metrics->add_buffer_pool());
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace mediapipe
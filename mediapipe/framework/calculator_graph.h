@@ -31,14 +31,17 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/counter_factory.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/graph_output_stream.h"
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/graph_service_manager.h"
+#include "mediapipe/framework/in_flight_limiter.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/output_side_packet_impl.h"
 #include "mediapipe/framework/output_stream.h"
@@ -46,11 +49,13 @@
 #include "mediapipe/framework/output_stream_poller.h"
 #include "mediapipe/framework/output_stream_shard.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/packet_generator.pb.h"
 #include "mediapipe/framework/packet_generator_graph.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/framework/scheduler.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 
@@ -292,6 +297,15 @@ class CalculatorGraph {
   ABSL_DEPRECATED("Use profiler()->GetCalculatorProfiles() instead")
   absl::Status GetCalculatorProfiles(std::vector<CalculatorProfile>*) const;
 
+  // Returns a snapshot of the Process() times and throttling of each node, the
+  // queue sizes of each input stream, the load of each executor and the
+  // buffers of the kImageMultiPoolService pool. Meant to be polled by a
+  // metrics exporter while the graph runs; see profiler/prometheus_text.h.
+  // Process() times are recorded only if ProfilerConfig.enable_profiler is
+  // set.
+  absl::Status GetGraphMetrics(GraphMetrics* metrics)
+      ABSL_LOCKS_EXCLUDED(full_input_streams_mutex_);
+
   // Set the type of counter used in this graph.
   void SetCounterFactory(CounterFactory* factory) {
     counter_factory_.reset(factory);
@@ -357,6 +371,19 @@ class CalculatorGraph {
   // Returns true if at least one max_queue_size has been grown.
   bool UnthrottleSources() ABSL_LOCKS_EXCLUDED(full_input_streams_mutex_);
 
+  // Returns true if a graph input stream has an in-flight limit.
+  bool HasInFlightLimits() const { return !in_flight_limiters_.empty(); }
+
+  // Releases the timestamps held by the in-flight limits of the graph input
+  // streams. Called while the graph is idle, since a timestamp at which a
+  // calculator without a timestamp offset output nothing only settles once
+  // more packets are added. Returns true if a limiter has a waiting packet.
+  bool ReleaseInFlightTimestamps();
+
+  // Adds the packets waiting in the in-flight limits, if the graph input
+  // streams are not throttled. Returns true if a packet was added.
+  bool AddWaitingInFlightPackets();
+
   // Returns the scheduler's runtime measures for overhead measurement.
   // Only meant for test purposes.
   internal::SchedulerTimes GetSchedulerTimes() {
@@ -455,6 +482,11 @@ class CalculatorGraph {
   absl::Status AddPacketToInputStreamInternal(const std::string& stream_name,
                                               T&& packet);
 
+  // Adds |packet| to |stream|, propagates it to the mirrors of the stream,
+  // and notifies the scheduler.
+  absl::Status AddPacketToGraphInputStream(GraphInputStream* stream,
+                                           Packet packet);
+
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
   // Does not check that the graph is uninitialized and |name| is not a
@@ -480,11 +512,40 @@ class CalculatorGraph {
   // Returns true if |name| is a reserved executor name.
   static bool IsReservedExecutorName(const std::string& name);
 
+  // Picks the NUMA node for CalculatorGraphConfig.numa_policy.
+  //
+  // Only called by InitializeExecutors().
+  void InitializeNumaPolicy();
+
+  // Pins the worker threads of a ThreadPoolExecutor created by the graph to
+  // the NUMA node picked by InitializeNumaPolicy(), unless |options| already
+  // specify processor affinity.
+  void ApplyNumaPolicy(ThreadPoolExecutorOptions* options) const;
+
+  // Creates the dedicated executors for
+  // CalculatorGraphConfig.adaptive_executor.
+  //
+  // Only called by InitializeExecutors().
+  absl::Status InitializeAdaptiveExecutors(bool use_application_thread);
+
+  // Starts a thread that waits for the profiling period of
+  // CalculatorGraphConfig.adaptive_executor and then calls
+  // AssignNodesByCost().
+  void StartAdaptiveExecutorAssignment();
+
+  // Stops the thread started by StartAdaptiveExecutorAssignment().
+  void StopAdaptiveExecutorAssignment();
+
+  // Moves the nodes with the highest Process() time measured by the profiler
+  // to the dedicated executors.
+  absl::Status AssignNodesByCost();
+
   // Helper functions for Initialize().
   absl::Status InitializeExecutors();
   absl::Status InitializePacketGeneratorGraph(
       const std::map<std::string, Packet>& side_packets);
   absl::Status InitializeStreams();
+  absl::Status InitializeInFlightLimiters();
   absl::Status InitializeProfiler();
   absl::Status InitializeCalculatorNodes();
   absl::Status InitializePacketGeneratorNodes(
@@ -584,6 +645,11 @@ class CalculatorGraph {
   std::vector<absl::flat_hash_set<InputStreamManager*>> full_input_streams_
       ABSL_GUARDED_BY(full_input_streams_mutex_);
 
+  // The number of times each entry of full_input_streams_ became non-empty,
+  // i.e. the node or graph input stream became throttled, in this run.
+  std::vector<int64> throttle_counts_
+      ABSL_GUARDED_BY(full_input_streams_mutex_);
+
   // Maps stream names to graph input stream objects.
   absl::flat_hash_map<std::string, std::unique_ptr<GraphInputStream>>
       graph_input_streams_;
@@ -597,10 +663,40 @@ class CalculatorGraph {
   // The factory for making counters associated with this graph.
   std::unique_ptr<CounterFactory> counter_factory_;
 
+  // The arena for the packets created by the calculators, if
+  // CalculatorGraphConfig.use_packet_arena is set.
+  std::unique_ptr<PacketArena> packet_arena_;
+
+  // The limiters of the graph input streams listed in
+  // CalculatorGraphConfig.in_flight_limit, keyed by stream name.
+  absl::flat_hash_map<std::string, std::unique_ptr<internal::InFlightLimiter>>
+      in_flight_limiters_;
+  // The limiters updated after each Process() call of a node, indexed by node
+  // id.
+  std::vector<std::vector<internal::InFlightLimiter*>>
+      in_flight_limiters_by_node_;
+
   // Executors for the scheduler, keyed by the executor's name. The default
   // executor's name is the empty std::string.
   std::map<std::string, std::shared_ptr<Executor>> executors_;
 
+  // The number of threads of the ThreadPoolExecutors created by the graph,
+  // keyed by the executor's name. Used to report executor utilization.
+  std::map<std::string, int> executor_num_threads_;
+
+  // The names of the dedicated executors created for
+  // CalculatorGraphConfig.adaptive_executor.
+  std::vector<std::string> adaptive_executor_names_;
+
+  // The NUMA node for the executors created by the graph, or -1 if the
+  // executors are placed by their own options.
+  int numa_node_ = -1;
+
+  // Runs AssignNodesByCost() once per run, and the notification that stops it
+  // at the end of the run.
+  std::unique_ptr<ThreadPool> adaptive_executor_thread_;
+  std::unique_ptr<absl::Notification> adaptive_executor_stop_;
+
   // The processed input side packet map for this run.
   std::map<std::string, Packet> current_run_side_packets_;
 
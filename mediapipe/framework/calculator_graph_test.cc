@@ -15,17 +15,24 @@
 #include "mediapipe/framework/calculator_graph.h"
 
 #include <pthread.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 #include <atomic>
 #include <ctime>
 #include <deque>
+#include <fstream>
 #include <map>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "absl/container/fixed_array.h"
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
@@ -61,6 +68,9 @@
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/type_map.h"
 
+ABSL_DECLARE_FLAG(std::string, system_numa_node_online_file);
+ABSL_DECLARE_FLAG(std::string, system_numa_node_cpulist_file);
+
 namespace mediapipe {
 
 namespace {
@@ -979,6 +989,34 @@ class PthreadSelfSourceCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(PthreadSelfSourceCalculator);
 
+#if defined(__linux__)
+// A source calculator that outputs a packet containing the CPU ids that the
+// current thread may run on.
+class CpuAffinitySourceCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Outputs().Index(0).Set<std::vector<int>>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    RET_CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set), &cpu_set), 0);
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpus.push_back(cpu);
+      }
+    }
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<std::vector<int>>(cpus).At(Timestamp(0)));
+    return tool::StatusStop();
+  }
+};
+REGISTER_CALCULATOR(CpuAffinitySourceCalculator);
+#endif  // defined(__linux__)
+
 // A source calculator for testing the Calculator::InputTimestamp() method.
 // It outputs five int packets with timestamps 0, 1, 2, 3, 4.
 class CheckInputTimestampSourceCalculator : public CalculatorBase {
@@ -4251,6 +4289,85 @@ TEST(CalculatorGraph, RunWithNumThreadsInExecutorConfig) {
   }
 }
 
+#if defined(__linux__)
+// Runs CpuAffinitySourceCalculator on the executors of |config| and returns
+// the CPU ids that it may run on.
+std::vector<int> RunCpuAffinitySource(const CalculatorGraphConfig& config) {
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+  Packet out_packet;
+  MEDIAPIPE_CHECK_OK(
+      graph.ObserveOutputStream("out", [&out_packet](const Packet& packet) {
+        out_packet = packet;
+        return absl::OkStatus();
+      }));
+  MEDIAPIPE_CHECK_OK(graph.Run());
+  return out_packet.Get<std::vector<int>>();
+}
+
+TEST(CalculatorGraph, ThreadPoolExecutorCpuIds) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        executor {
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu_ids: 0
+            }
+          }
+        }
+        node { calculator: 'CpuAffinitySourceCalculator' output_stream: 'out' }
+      )pb");
+  EXPECT_THAT(RunCpuAffinitySource(config), testing::ElementsAre(0));
+
+  config.mutable_executor(0)
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_numa_node(0);
+  CalculatorGraph graph;
+  absl::Status status = graph.Initialize(config);
+  EXPECT_THAT(status.message(), testing::HasSubstr("cpu_ids and numa_node"));
+}
+
+TEST(CalculatorGraph, NumaPolicySingleNode) {
+  // Describes a system whose only online NUMA node is node 2, which has only
+  // CPU 0.
+  const std::string online_path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/numa_node_online");
+  std::ofstream(online_path) << "2\n";
+  const std::string cpulist_path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/numa_node_cpulist_2");
+  std::ofstream(cpulist_path) << "0\n";
+  const std::string saved_online_file =
+      absl::GetFlag(FLAGS_system_numa_node_online_file);
+  const std::string saved_pattern =
+      absl::GetFlag(FLAGS_system_numa_node_cpulist_file);
+  absl::SetFlag(&FLAGS_system_numa_node_online_file, online_path);
+  absl::SetFlag(&FLAGS_system_numa_node_cpulist_file,
+                absl::StrCat(getenv("TEST_TMPDIR"), "/numa_node_cpulist_$0"));
+
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        numa_policy { policy: SINGLE_NODE node: 2 }
+        node { calculator: 'CpuAffinitySourceCalculator' output_stream: 'out' }
+      )pb");
+  EXPECT_THAT(RunCpuAffinitySource(config), testing::ElementsAre(0));
+
+  // A negative node picks one of the online nodes, even if node 0 is not one
+  // of them.
+  config.mutable_numa_policy()->set_node(-1);
+  EXPECT_THAT(RunCpuAffinitySource(config), testing::ElementsAre(0));
+
+  config.mutable_numa_policy()->set_node(1);
+  CalculatorGraph graph;
+  absl::Status status = graph.Initialize(config);
+  EXPECT_THAT(status.message(), testing::HasSubstr("NUMA node 1"));
+
+  absl::SetFlag(&FLAGS_system_numa_node_online_file, saved_online_file);
+  absl::SetFlag(&FLAGS_system_numa_node_cpulist_file, saved_pattern);
+}
+#endif  // defined(__linux__)
+
 TEST(CalculatorGraph, CalculatorGraphNotInitialized) {
   CalculatorGraph graph;
   EXPECT_FALSE(graph.Run().ok());
@@ -4692,5 +4809,531 @@ TEST(CalculatorGraph, MultipleRunsWithDifferentInputStreamHandlers) {
   DoTestMultipleGraphRuns("TimestampAlignInputStreamHandler", true);
 }
 
+// Verifies that GetGraphMetrics reports node, stream and executor metrics.
+TEST(CalculatorGraph, GetGraphMetrics) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          name: "square"
+          calculator: "SquareIntCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+        num_threads: 2
+        max_queue_size: 10
+        profiler_config { enable_profiler: true }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  GraphMetrics metrics;
+  MP_ASSERT_OK(graph.GetGraphMetrics(&metrics));
+  ASSERT_EQ(1, metrics.node_size());
+  EXPECT_EQ("square", metrics.node(0).name());
+  EXPECT_EQ(5, metrics.node(0).process_count());
+  EXPECT_FALSE(metrics.node(0).throttled());
+  ASSERT_EQ(1, metrics.input_stream_size());
+  EXPECT_EQ("square", metrics.input_stream(0).node());
+  EXPECT_EQ("in", metrics.input_stream(0).name());
+  EXPECT_EQ(0, metrics.input_stream(0).queue_size());
+  EXPECT_GE(metrics.input_stream(0).peak_queue_size(), 1);
+  EXPECT_EQ(10, metrics.input_stream(0).max_queue_size());
+  ASSERT_EQ(1, metrics.graph_input_stream_size());
+  EXPECT_EQ("in", metrics.graph_input_stream(0).name());
+  EXPECT_FALSE(metrics.graph_input_stream(0).throttled());
+  ASSERT_EQ(1, metrics.executor_size());
+  EXPECT_EQ("", metrics.executor(0).name());
+  EXPECT_EQ(2, metrics.executor(0).num_threads());
+  EXPECT_GT(metrics.executor(0).run_time_usec(), 0);
+  EXPECT_TRUE(metrics.executor(0).has_utilization());
+  EXPECT_EQ(0, metrics.executor(0).queued_nodes());
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  // The run time and utilization of a finished run don't change.
+  MP_ASSERT_OK(graph.GetGraphMetrics(&metrics));
+  const GraphMetrics::ExecutorMetrics final_metrics = metrics.executor(0);
+  absl::SleepFor(absl::Milliseconds(20));
+  MP_ASSERT_OK(graph.GetGraphMetrics(&metrics));
+  EXPECT_EQ(final_metrics.run_time_usec(), metrics.executor(0).run_time_usec());
+  EXPECT_EQ(final_metrics.utilization(), metrics.executor(0).utilization());
+}
+
+// Verifies that GetGraphMetrics leaves the utilization of an executor with an
+// unknown number of threads unset.
+TEST(CalculatorGraph, GetGraphMetricsForProvidedExecutor) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "SquareIntCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.SetExecutor("", std::make_shared<ThreadPoolExecutor>(1)));
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(
+      graph.AddPacketToInputStream("in", MakePacket<int>(3).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  GraphMetrics metrics;
+  MP_ASSERT_OK(graph.GetGraphMetrics(&metrics));
+  ASSERT_EQ(1, metrics.executor_size());
+  EXPECT_FALSE(metrics.executor(0).has_num_threads());
+  EXPECT_GT(metrics.executor(0).run_time_usec(), 0);
+  EXPECT_FALSE(metrics.executor(0).has_utilization());
+}
+
+// Like SquareIntCalculator, but creates its output packets with MakePacket().
+class MakePacketSquareIntCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    int value = cc->Inputs().Index(0).Value().Get<int>();
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(value * value).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(MakePacketSquareIntCalculator);
+
+TEST(CalculatorGraph, PacketArenaCounters) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "MakePacketSquareIntCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+        use_packet_arena: true
+      )pb");
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(5, out_packets.size());
+  EXPECT_EQ(16, out_packets[4].Get<int>());
+  // The vector sink allocates its callback packet in the arena as well.
+  EXPECT_LE(
+      5, graph.GetCounterFactory()->GetCounter("PacketArena.packets")->Get());
+  EXPECT_GE(graph.GetCounterFactory()
+                ->GetCounter("PacketArena.avoided_allocations")
+                ->Get(),
+            10);
+}
+
+// Outputs a newly allocated string for each input packet.
+class MakeStringCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<std::string>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    cc->Outputs().Index(0).Add(
+        new std::string(absl::StrCat("packet ", cc->InputTimestamp().Value())),
+        cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(MakeStringCalculator);
+
+// Tries to take ownership of the input string, and outputs whether it could.
+class ConsumeStringCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<std::string>();
+    cc->Outputs().Index(0).Set<bool>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    absl::StatusOr<std::unique_ptr<std::string>> value =
+        cc->Inputs().Index(0).Consume<std::string>();
+    if (value.ok()) {
+      RET_CHECK(cc->Inputs().Index(0).IsEmpty());
+      (*value)->append(" modified in place");
+    } else {
+      RET_CHECK(!cc->Inputs().Index(0).IsEmpty());
+    }
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<bool>(value.ok()).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(ConsumeStringCalculator);
+
+// Runs MakeStringCalculator followed by ConsumeStringCalculator, and returns
+// whether each input packet was consumed.
+std::vector<bool> RunConsumeString(CalculatorGraphConfig config) {
+  std::vector<Packet> consumed_packets;
+  tool::AddVectorSink("consumed", &config, &consumed_packets);
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(config));
+  MP_EXPECT_OK(graph.StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+  std::vector<bool> consumed;
+  for (const Packet& packet : consumed_packets) {
+    consumed.push_back(packet.Get<bool>());
+  }
+  return consumed;
+}
+
+// Verifies that a packet on a stream with a single consumer reaches the
+// consumer without a copy, and can be consumed by it.
+TEST(CalculatorGraph, SingleConsumerTakesOwnershipWithoutCopy) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "MakeStringCalculator"
+          input_stream: "in"
+          output_stream: "str"
+        }
+        node {
+          calculator: "ConsumeStringCalculator"
+          input_stream: "str"
+          output_stream: "consumed"
+        }
+      )pb");
+  EXPECT_THAT(RunConsumeString(config),
+              testing::ElementsAre(true, true, true));
+
+  // With a second consumer holding the packets, they are not consumed.
+  std::vector<Packet> str_packets;
+  tool::AddVectorSink("str", &config, &str_packets);
+  EXPECT_THAT(RunConsumeString(config),
+              testing::ElementsAre(false, false, false));
+  ASSERT_EQ(3, str_packets.size());
+  EXPECT_EQ("packet 2", str_packets[2].Get<std::string>());
+}
+
+// Returns a graph whose input stream "in" passes through a
+// SemaphoreCalculator and a PassThroughCalculator, limited to one timestamp in
+// flight with |policy|.
+CalculatorGraphConfig InFlightLimitConfigWithPolicy(
+    InFlightLimitConfig::Policy policy) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "SemaphoreCalculator"
+          input_stream: "in"
+          output_stream: "mid"
+          input_side_packet: "POST_SEM:post_sem"
+          input_side_packet: "WAIT_SEM:wait_sem"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "mid"
+          output_stream: "out"
+        }
+        num_threads: 4
+        in_flight_limit { input_stream: "in" max_in_flight: 1 }
+      )pb");
+  config.mutable_in_flight_limit(0)->set_policy(policy);
+  return config;
+}
+
+std::vector<Timestamp> PacketTimestamps(const std::vector<Packet>& packets) {
+  std::vector<Timestamp> timestamps;
+  for (const Packet& packet : packets) {
+    timestamps.push_back(packet.Timestamp());
+  }
+  return timestamps;
+}
+
+TEST(CalculatorGraph, InFlightLimitDropNewest) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      InFlightLimitConfigWithPolicy(InFlightLimitConfig::DROP_NEWEST);
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  Semaphore calc_entered_process(0);
+  Semaphore calc_can_exit_process(0);
+  MP_ASSERT_OK(graph.StartRun(
+      {{"post_sem", MakePacket<Semaphore*>(&calc_entered_process)},
+       {"wait_sem", MakePacket<Semaphore*>(&calc_can_exit_process)}}));
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(0).At(Timestamp(0))));
+  calc_entered_process.Acquire(1);
+  // Timestamp 0 is in flight, so these packets are dropped.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(1).At(Timestamp(1))));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(2).At(Timestamp(2))));
+  calc_can_exit_process.Release(1);
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(3).At(Timestamp(3))));
+  calc_can_exit_process.Release(1);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_THAT(PacketTimestamps(out_packets),
+              testing::ElementsAre(Timestamp(0), Timestamp(3)));
+  EXPECT_EQ(2, graph.GetCounterFactory()
+                   ->GetCounter("InFlightLimiter.in.dropped")
+                   ->Get());
+}
+
+TEST(CalculatorGraph, InFlightLimitDropOldest) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      InFlightLimitConfigWithPolicy(InFlightLimitConfig::DROP_OLDEST);
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  Semaphore calc_entered_process(0);
+  Semaphore calc_can_exit_process(0);
+  MP_ASSERT_OK(graph.StartRun(
+      {{"post_sem", MakePacket<Semaphore*>(&calc_entered_process)},
+       {"wait_sem", MakePacket<Semaphore*>(&calc_can_exit_process)}}));
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(0).At(Timestamp(0))));
+  calc_entered_process.Acquire(1);
+  // The packet at timestamp 1 waits, and is replaced by the one at 2.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(1).At(Timestamp(1))));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(2).At(Timestamp(2))));
+  calc_can_exit_process.Release(1);
+  // The waiting packet enters the graph when timestamp 0 has settled.
+  calc_entered_process.Acquire(1);
+  calc_can_exit_process.Release(1);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_THAT(PacketTimestamps(out_packets),
+              testing::ElementsAre(Timestamp(0), Timestamp(2)));
+  EXPECT_EQ(1, graph.GetCounterFactory()
+                   ->GetCounter("InFlightLimiter.in.dropped")
+                   ->Get());
+}
+
+TEST(CalculatorGraph, InFlightLimitBlock) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      InFlightLimitConfigWithPolicy(InFlightLimitConfig::BLOCK);
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  Semaphore calc_entered_process(0);
+  Semaphore calc_can_exit_process(0);
+  MP_ASSERT_OK(graph.StartRun(
+      {{"post_sem", MakePacket<Semaphore*>(&calc_entered_process)},
+       {"wait_sem", MakePacket<Semaphore*>(&calc_can_exit_process)}}));
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(0).At(Timestamp(0))));
+  calc_entered_process.Acquire(1);
+  std::atomic<bool> added(false);
+  std::thread add_thread([&graph, &added]() {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(1).At(Timestamp(1))));
+    added = true;
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_FALSE(added);
+  calc_can_exit_process.Release(1);
+  calc_entered_process.Acquire(1);
+  calc_can_exit_process.Release(1);
+  add_thread.join();
+  EXPECT_TRUE(added);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_THAT(PacketTimestamps(out_packets),
+              testing::ElementsAre(Timestamp(0), Timestamp(1)));
+  EXPECT_EQ(0, graph.GetCounterFactory()
+                   ->GetCounter("InFlightLimiter.in.dropped")
+                   ->Get());
+}
+
+// Verifies that a timestamp at which a calculator without a timestamp offset
+// outputs nothing settles once the graph is idle. The input stream bound of
+// the next calculator stays at that timestamp until more packets arrive.
+TEST(CalculatorGraph, InFlightLimitSettlesWithoutTimestampOffset) {
+  for (InFlightLimitConfig::Policy policy :
+       {InFlightLimitConfig::BLOCK, InFlightLimitConfig::DROP_NEWEST,
+        InFlightLimitConfig::DROP_OLDEST}) {
+    CalculatorGraphConfig config =
+        mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+          input_stream: "in"
+          node {
+            calculator: "DecimatorCalculator"
+            input_stream: "in"
+            output_stream: "mid"
+          }
+          node {
+            calculator: "PassThroughCalculator"
+            input_stream: "mid"
+            output_stream: "out"
+          }
+          num_threads: 4
+          in_flight_limit { input_stream: "in" max_in_flight: 1 }
+        )pb");
+    config.mutable_in_flight_limit(0)->set_policy(policy);
+    std::vector<Packet> out_packets;
+    tool::AddVectorSink("out", &config, &out_packets);
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(config));
+    MP_ASSERT_OK(graph.StartRun({}));
+
+    // DecimatorCalculator only outputs the packet at timestamp 0.
+    for (int i = 0; i < 5; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(Timestamp(i))));
+      MP_ASSERT_OK(graph.WaitUntilIdle());
+    }
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    EXPECT_THAT(PacketTimestamps(out_packets),
+                testing::ElementsAre(Timestamp(0)));
+    EXPECT_EQ(0, graph.GetCounterFactory()
+                     ->GetCounter("InFlightLimiter.in.dropped")
+                     ->Get())
+        << "policy " << policy;
+  }
+}
+
+TEST(CalculatorGraph, InFlightLimitRejectsInvalidConfig) {
+  CalculatorGraphConfig config =
+      InFlightLimitConfigWithPolicy(InFlightLimitConfig::BLOCK);
+  config.mutable_in_flight_limit(0)->set_input_stream("mid");
+  CalculatorGraph graph;
+  absl::Status status = graph.Initialize(config);
+  EXPECT_THAT(status.message(), HasSubstr("is not a graph input stream"));
+
+  config = InFlightLimitConfigWithPolicy(InFlightLimitConfig::BLOCK);
+  config.mutable_in_flight_limit(0)->set_max_in_flight(0);
+  CalculatorGraph graph_2;
+  status = graph_2.Initialize(config);
+  EXPECT_THAT(status.message(), HasSubstr("max_in_flight must be positive"));
+}
+
+// A calculator that sleeps for 2 ms in each Process() call.
+class SleepingPassThroughCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    absl::SleepFor(absl::Milliseconds(2));
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(SleepingPassThroughCalculator);
+
+// Verifies that adaptive_executor moves the most expensive node to a
+// dedicated executor after the profiling period.
+TEST(CalculatorGraph, AdaptiveExecutorMovesExpensiveNode) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          name: "slow"
+          calculator: "SleepingPassThroughCalculator"
+          input_stream: "in"
+          output_stream: "mid"
+        }
+        node {
+          name: "fast"
+          calculator: "SquareIntCalculator"
+          input_stream: "mid"
+          output_stream: "out"
+        }
+        adaptive_executor {
+          profile_duration_usec: 50000
+          max_dedicated_executors: 1
+        }
+        profiler_config { enable_profiler: true }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  // Wait until the slow node runs on the dedicated executor.
+  GraphMetrics metrics;
+  int64 busy_time = 0;
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  for (int i = 0; busy_time == 0 && absl::Now() < deadline; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    MP_ASSERT_OK(graph.GetGraphMetrics(&metrics));
+    for (const auto& executor : metrics.executor()) {
+      if (executor.name() == "__adaptive_0") {
+        busy_time = executor.busy_time_usec();
+      }
+    }
+  }
+  EXPECT_GT(busy_time, 0);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(CalculatorGraph, AdaptiveExecutorRequiresProfiler) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "SquareIntCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+        adaptive_executor {}
+      )pb");
+  CalculatorGraph graph;
+  absl::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("enable_profiler"));
+}
+
 }  // namespace
 }  // namespace mediapipe
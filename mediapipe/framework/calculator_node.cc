@@ -110,6 +110,16 @@ std::unique_ptr<PacketTypeSet> RemoveOmittedPacketTypes(
   return result;
 }
 
+// Returns true if no input stream has a packet in |inputs|.
+bool AllInputsEmpty(const InputStreamShardSet& inputs) {
+  for (const InputStreamShard& input : inputs) {
+    if (!input.IsEmpty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 CalculatorNode::CalculatorNode() {}
@@ -408,6 +418,10 @@ absl::Status CalculatorNode::PrepareForRun(
       &input_side_packet_handler_.InputSidePackets());
   calculator_state_->SetOutputSidePackets(output_side_packets_.get());
   calculator_state_->SetCounterFactory(counter_factory);
+  bound_only_invocations_ =
+      input_stream_handler_->ProcessTimestampBounds()
+          ? calculator_state_->GetCounter("BoundOnlyInvocations")
+          : nullptr;
 
   for (const auto& svc_req : contract.ServiceRequests()) {
     const auto& req = svc_req.second;
@@ -867,6 +881,9 @@ absl::Status CalculatorNode::ProcessNode(
           // Do nothing.
           result = absl::OkStatus();
         } else {
+          if (bound_only_invocations_ && AllInputsEmpty(*inputs)) {
+            bound_only_invocations_->Increment();
+          }
           MEDIAPIPE_PROFILING(PROCESS, calculator_context);
           LegacyCalculatorSupport::Scoped<CalculatorContext> s(
               calculator_context);
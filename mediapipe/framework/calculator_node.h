@@ -20,6 +20,7 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -52,6 +53,7 @@
 
 namespace mediapipe {
 
+class Counter;
 class CounterFactory;
 class InputStreamManager;
 class OutputStreamManager;
@@ -201,11 +203,13 @@ class CalculatorNode {
 
   // Returns the scheduler queue the node is assigned to.
   internal::SchedulerQueue* GetSchedulerQueue() const {
-    return scheduler_queue_;
+    return scheduler_queue_.load(std::memory_order_acquire);
   }
-  // Sets the scheduler queue the node is assigned to.
+  // Sets the scheduler queue the node is assigned to.  May be called while
+  // the graph is running; invocations already queued still run on the
+  // previous queue.
   void SetSchedulerQueue(internal::SchedulerQueue* queue) {
-    scheduler_queue_ = queue;
+    scheduler_queue_.store(queue, std::memory_order_release);
   }
 
   // Sets callbacks in the scheduler that should be invoked when an input queue
@@ -308,6 +312,10 @@ class CalculatorNode {
 
   // The max number of invocations that can be scheduled in parallel.
   int max_in_flight_ = 1;
+
+  // Counts the Process() calls without any input packet, which only report
+  // timestamp bounds. Null unless the calculator processes timestamp bounds.
+  Counter* bound_only_invocations_ = nullptr;
   // The following two variables are used for the concurrency control of node
   // scheduling.
   //
@@ -370,7 +378,7 @@ class CalculatorNode {
   // True if CleanupAfterRun() needs to call CloseNode().
   bool needs_to_close_ = false;
 
-  internal::SchedulerQueue* scheduler_queue_ = nullptr;
+  std::atomic<internal::SchedulerQueue*> scheduler_queue_{nullptr};
 
   const ValidatedGraphConfig* validated_graph_ = nullptr;
 
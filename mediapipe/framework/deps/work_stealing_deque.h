@@ -0,0 +1,126 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_DEQUE_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace mediapipe {
+
+// A bounded, lock-free, single-owner/multi-thief deque of pointers
+// (Chase-Lev, with the C11 memory orderings from Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).
+//
+// Only the owning thread may call Push() and Pop(), which operate on the
+// bottom of the deque in LIFO order. Any thread may call Steal(), which takes
+// from the top in FIFO order. The deque does not own the pointed-to objects.
+//
+// The capacity is fixed at construction; Push() returns false when the deque
+// is full so that the caller can fall back to a shared overflow queue.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  // "capacity" is rounded up to a power of two.
+  explicit WorkStealingDeque(int capacity) {
+    int64_t size = 1;
+    while (size < capacity) size <<= 1;
+    mask_ = size - 1;
+    buffer_.reset(new std::atomic<T*>[size]);
+    for (int64_t i = 0; i < size; ++i) {
+      buffer_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  // Owner only. Returns false if the deque is full.
+  bool Push(T* item) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_) {
+      return false;
+    }
+    buffer_[b & mask_].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only. Returns nullptr if the deque is empty or the last item was
+  // taken by a concurrent Steal().
+  T* Pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    T* item = nullptr;
+    if (t <= b) {
+      item = buffer_[b & mask_].load(std::memory_order_relaxed);
+      if (t == b) {
+        // Last item: race against thieves for it.
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+          item = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread. Returns nullptr if the deque is empty or if another thread
+  // won the race for the top item; callers simply retry elsewhere.
+  T* Steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    T* item = buffer_[t & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  // Approximate number of items. Only exact when called by the owner with
+  // no concurrent thieves.
+  int64_t SizeApprox() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+
+  int64_t capacity() const { return mask_ + 1; }
+
+ private:
+  // top_ and bottom_ are written by different threads; keep them on
+  // separate cache lines.
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  alignas(64) int64_t mask_ = 0;
+  std::unique_ptr<std::atomic<T*>[]> buffer_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_DEQUE_H_
@@ -0,0 +1,145 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_thread_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Identifies the pool and worker index of the calling thread, if it is a
+// WorkStealingThreadPool worker.
+struct CurrentWorker {
+  const void* pool = nullptr;
+  int index = -1;
+};
+
+thread_local CurrentWorker current_worker;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name_prefix,
+                                               int num_threads)
+    : WorkStealingThreadPool(ThreadOptions(), name_prefix, num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const ThreadOptions& thread_options, const std::string& name_prefix,
+    int num_threads)
+    : num_threads_((num_threads == 0) ? 1 : num_threads),
+      threads_(thread_options, name_prefix, num_threads_) {
+  workers_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_.push_back(absl::make_unique<Worker>());
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+    condition_.SignalAll();
+  }
+  // The worker loops exit once all pending tasks have run. threads_ is
+  // destroyed (and joined) before the remaining members.
+}
+
+void WorkStealingThreadPool::StartWorkers() {
+  threads_.StartWorkers();
+  // Each worker loop occupies one ThreadPool thread until shutdown.
+  for (int i = 0; i < num_threads_; ++i) {
+    threads_.Schedule([this, i] { RunWorker(i); });
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> callback) {
+  auto task = absl::make_unique<Task>(std::move(callback));
+  // pending_ is raised before the task becomes visible so that it never goes
+  // negative; a worker that sees it early just retries FindTask().
+  pending_.fetch_add(1, std::memory_order_seq_cst);
+  if (current_worker.pool == this &&
+      workers_[current_worker.index]->deque.Push(task.get())) {
+    task.release();
+    if (num_sleeping_.load(std::memory_order_seq_cst) > 0) {
+      WakeOne();
+    }
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  injection_queue_.push_back(task.release());
+  injection_size_.fetch_add(1, std::memory_order_relaxed);
+  condition_.Signal();
+}
+
+void WorkStealingThreadPool::WakeOne() {
+  absl::MutexLock lock(&mutex_);
+  condition_.Signal();
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::FindTask(int index) {
+  Task* task = workers_[index]->deque.Pop();
+  if (task == nullptr && injection_size_.load(std::memory_order_relaxed) > 0) {
+    absl::MutexLock lock(&mutex_);
+    if (!injection_queue_.empty()) {
+      task = injection_queue_.front();
+      injection_queue_.pop_front();
+      injection_size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  if (task == nullptr) {
+    for (int i = 1; i < num_threads_ && task == nullptr; ++i) {
+      task = workers_[(index + i) % num_threads_]->deque.Steal();
+    }
+    if (task != nullptr) {
+      num_steals_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (task != nullptr) {
+    pending_.fetch_sub(1, std::memory_order_seq_cst);
+  }
+  return task;
+}
+
+void WorkStealingThreadPool::RunWorker(int index) {
+  current_worker.pool = this;
+  current_worker.index = index;
+  while (true) {
+    std::unique_ptr<Task> task(FindTask(index));
+    if (task) {
+      (*task)();
+      continue;
+    }
+    absl::MutexLock lock(&mutex_);
+    // Announce the intent to sleep before re-checking pending_. Schedule()
+    // raises pending_ before checking num_sleeping_, so at least one side
+    // observes the other and no wakeup is lost.
+    num_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+    while (pending_.load(std::memory_order_seq_cst) == 0 && !stopped_) {
+      condition_.Wait(&mutex_);
+    }
+    num_sleeping_.fetch_sub(1, std::memory_order_seq_cst);
+    if (stopped_ && pending_.load(std::memory_order_seq_cst) == 0) {
+      break;
+    }
+  }
+  current_worker = CurrentWorker();
+  // Let the other sleeping workers observe shutdown.
+  absl::MutexLock lock(&mutex_);
+  condition_.SignalAll();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,136 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_THREAD_POOL_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/threadpool.h"
+#include "mediapipe/framework/deps/work_stealing_deque.h"
+
+namespace mediapipe {
+
+// A thread pool in which every worker owns a lock-free deque of callbacks.
+//
+// Callbacks scheduled from one of the pool's own worker threads are pushed
+// onto that worker's deque without taking any lock. Callbacks scheduled from
+// other threads go to a shared, mutex-guarded injection queue. An idle worker
+// first drains its own deque, then the injection queue, and then steals from
+// the other workers. Workers only block on a condition variable when there
+// is no pending work anywhere.
+//
+// Unlike ThreadPool, callbacks are NOT run in FIFO order, even with a single
+// thread: a worker runs its most recently scheduled local callback first.
+//
+// The worker threads are hosted by a regular ThreadPool, so thread naming,
+// nice priority and processor affinity in ThreadOptions behave the same way.
+//
+// Sample usage:
+//
+// {
+//   WorkStealingThreadPool pool("testpool", num_workers);
+//   pool.StartWorkers();
+//   for (int i = 0; i < N; ++i) {
+//     pool.Schedule([i]() { DoWork(i); });
+//   }
+// }
+//
+class WorkStealingThreadPool {
+ public:
+  // Create a pool that provides a concurrency of "num_threads" threads.
+  WorkStealingThreadPool(const std::string& name_prefix, int num_threads);
+  WorkStealingThreadPool(const ThreadOptions& thread_options,
+                         const std::string& name_prefix, int num_threads);
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Waits for pending callbacks (if any) to complete. May be called without
+  // having called StartWorkers().
+  ~WorkStealingThreadPool();
+
+  // REQUIRES: StartWorkers has not been called
+  // Actually start the worker threads.
+  void StartWorkers();
+
+  // REQUIRES: StartWorkers has been called
+  // Add specified callback to the pool. Eventually a worker will run it.
+  void Schedule(std::function<void()> callback);
+
+  int num_threads() const { return num_threads_; }
+
+  const ThreadOptions& thread_options() const {
+    return threads_.thread_options();
+  }
+
+  // Number of callbacks that were run by a worker other than the one that
+  // (or whose injection queue) received them. Provided for testing and
+  // benchmarking only.
+  int64_t num_steals() const {
+    return num_steals_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using Task = std::function<void()>;
+
+  // Capacity of each per-worker deque. Overflow goes to the injection queue.
+  static constexpr int kDequeCapacity = 1024;
+
+  struct Worker {
+    Worker() : deque(kDequeCapacity) {}
+    WorkStealingDeque<Task> deque;
+  };
+
+  // Body of worker "index". Runs until the pool is stopped and all pending
+  // tasks have been drained.
+  void RunWorker(int index);
+
+  // Takes one task for worker "index", or returns nullptr if none is found.
+  Task* FindTask(int index);
+
+  // Wakes up one sleeping worker, if any.
+  void WakeOne();
+
+  const int num_threads_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Number of scheduled tasks that have not yet been taken by a worker.
+  std::atomic<int64_t> pending_{0};
+  // Number of workers blocked (or about to block) on condition_.
+  std::atomic<int> num_sleeping_{0};
+  std::atomic<int64_t> num_steals_{0};
+
+  absl::Mutex mutex_;
+  absl::CondVar condition_;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  std::deque<Task*> injection_queue_ ABSL_GUARDED_BY(mutex_);
+  // Mirrors injection_queue_.size() so that workers can skip the mutex when
+  // the injection queue is empty.
+  std::atomic<int64_t> injection_size_{0};
+
+  // Hosts the worker loops; declared last so that it is destroyed (and its
+  // threads joined) before the state above.
+  ThreadPool threads_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_THREAD_POOL_H_
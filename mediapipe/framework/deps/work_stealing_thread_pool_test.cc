@@ -0,0 +1,189 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_thread_pool.h"
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/deps/work_stealing_deque.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(WorkStealingDequeTest, OwnerIsLifoThiefIsFifo) {
+  WorkStealingDeque<int> deque(4);
+  int items[3] = {0, 1, 2};
+  for (int& item : items) {
+    ASSERT_TRUE(deque.Push(&item));
+  }
+  EXPECT_EQ(&items[2], deque.Pop());
+  EXPECT_EQ(&items[0], deque.Steal());
+  EXPECT_EQ(&items[1], deque.Pop());
+  EXPECT_EQ(nullptr, deque.Pop());
+  EXPECT_EQ(nullptr, deque.Steal());
+}
+
+TEST(WorkStealingDequeTest, PushFailsWhenFull) {
+  WorkStealingDeque<int> deque(3);
+  ASSERT_EQ(4, deque.capacity());
+  int item = 0;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(deque.Push(&item));
+  }
+  EXPECT_FALSE(deque.Push(&item));
+  EXPECT_EQ(&item, deque.Steal());
+  EXPECT_TRUE(deque.Push(&item));
+}
+
+TEST(WorkStealingDequeTest, ConcurrentStealsTakeEachItemOnce) {
+  constexpr int kNumItems = 100000;
+  constexpr int kNumThieves = 4;
+  WorkStealingDeque<int> deque(kNumItems);
+  std::vector<int> items(kNumItems, 0);
+  std::atomic<int> taken(0);
+  std::vector<std::atomic<int>> counts(kNumItems);
+  for (auto& count : counts) count.store(0);
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kNumThieves; ++i) {
+    thieves.emplace_back([&] {
+      while (taken.load() < kNumItems) {
+        if (int* item = deque.Steal()) {
+          counts[item - items.data()].fetch_add(1);
+          taken.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < kNumItems; ++i) {
+    ASSERT_TRUE(deque.Push(&items[i]));
+    if (i % 3 == 0) {
+      if (int* item = deque.Pop()) {
+        counts[item - items.data()].fetch_add(1);
+        taken.fetch_add(1);
+      }
+    }
+  }
+  while (int* item = deque.Pop()) {
+    counts[item - items.data()].fetch_add(1);
+    taken.fetch_add(1);
+  }
+  for (auto& thief : thieves) thief.join();
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_EQ(1, counts[i].load()) << "item " << i;
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStart) {
+  WorkStealingThreadPool thread_pool("testpool", 10);
+}
+
+TEST(WorkStealingThreadPoolTest, EmptyThread) {
+  WorkStealingThreadPool thread_pool("testpool", 0);
+  ASSERT_EQ(1, thread_pool.num_threads());
+  thread_pool.StartWorkers();
+}
+
+TEST(WorkStealingThreadPoolTest, SingleThread) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 1);
+    ASSERT_EQ(1, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+TEST(WorkStealingThreadPoolTest, MultiThreads) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+// Tasks scheduled from inside a worker go to its local deque and must be
+// picked up by the other workers.
+TEST(WorkStealingThreadPoolTest, NestedScheduleIsStolen) {
+  constexpr int kFanOut = 1000;
+  std::atomic<int> n(0);
+  {
+    WorkStealingThreadPool thread_pool("testpool", 4);
+    thread_pool.StartWorkers();
+    thread_pool.Schedule([&thread_pool, &n]() {
+      for (int i = 0; i < kFanOut; ++i) {
+        thread_pool.Schedule([&n]() {
+          absl::SleepFor(absl::Microseconds(10));
+          n.fetch_add(1);
+        });
+      }
+    });
+  }
+
+  EXPECT_EQ(kFanOut, n.load());
+}
+
+// Overflowing the per-worker deque falls back to the injection queue.
+TEST(WorkStealingThreadPoolTest, LocalDequeOverflow) {
+  constexpr int kFanOut = 10000;
+  std::atomic<int> n(0);
+  {
+    WorkStealingThreadPool thread_pool("testpool", 1);
+    thread_pool.StartWorkers();
+    thread_pool.Schedule([&thread_pool, &n]() {
+      for (int i = 0; i < kFanOut; ++i) {
+        thread_pool.Schedule([&n]() { n.fetch_add(1); });
+      }
+    });
+  }
+
+  EXPECT_EQ(kFanOut, n.load());
+}
+
+TEST(WorkStealingThreadPoolTest, CreateWithThreadOptions) {
+  ThreadOptions thread_options = ThreadOptions().set_nice_priority_level(-10);
+  WorkStealingThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(-10, thread_pool.thread_options().nice_priority_level());
+  thread_pool.StartWorkers();
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -19,11 +19,13 @@
 namespace mediapipe {
 
 ImageFramePool::ImageFramePool(int width, int height,
-                               ImageFormat::Format format, int keep_count)
+                               ImageFormat::Format format, int keep_count,
+                               uint32 alignment_boundary)
     : width_(width),
       height_(height),
       format_(format),
-      keep_count_(keep_count) {}
+      keep_count_(keep_count),
+      alignment_boundary_(alignment_boundary) {}
 
 ImageFrameSharedPtr ImageFramePool::GetBuffer() {
   std::unique_ptr<ImageFrame> buffer;
@@ -31,13 +33,17 @@ ImageFrameSharedPtr ImageFramePool::GetBuffer() {
   {
     absl::MutexLock lock(&mutex_);
     if (available_.empty()) {
-      // Fix alignment at 4 for best compatability with OpenGL.
-      buffer = std::make_unique<ImageFrame>(
-          format_, width_, height_, ImageFrame::kGlDefaultAlignmentBoundary);
+      // The alignment defaults to 4 for best compatability with OpenGL.
+      buffer = std::make_unique<ImageFrame>(format_, width_, height_,
+                                            alignment_boundary_);
       if (!buffer) return nullptr;
+      buffer_bytes_ =
+          static_cast<int64_t>(buffer->WidthStep()) * buffer->Height();
+      ++misses_;
     } else {
       buffer = std::move(available_.back());
       available_.pop_back();
+      ++hits_;
     }
 
     ++in_use_count_;
@@ -57,6 +63,21 @@ ImageFrameSharedPtr ImageFramePool::GetBuffer() {
                                      });
 }
 
+int64_t ImageFramePool::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t ImageFramePool::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+int64_t ImageFramePool::allocated_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return (in_use_count_ + available_.size()) * buffer_bytes_;
+}
+
 std::pair<int, int> ImageFramePool::GetInUseAndAvailableCounts() {
   absl::MutexLock lock(&mutex_);
   return {in_use_count_, available_.size()};
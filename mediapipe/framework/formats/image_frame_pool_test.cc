@@ -92,6 +92,29 @@ TEST_F(ImageFramePoolTest, DeleteNotLast) {
   EXPECT_EQ(Pair(kKeepCount - 1, 1), pool_->GetInUseAndAvailableCounts());
 }
 
+TEST_F(ImageFramePoolTest, CountsHitsMissesAndBytes) {
+  auto buffer = pool_->GetBuffer();
+  const int64_t buffer_bytes = buffer->WidthStep() * kHeight;
+  EXPECT_EQ(0, buffer->WidthStep() % ImageFrame::kGlDefaultAlignmentBoundary);
+  EXPECT_EQ(buffer_bytes, pool_->allocated_bytes());
+  buffer = nullptr;
+  EXPECT_EQ(buffer_bytes, pool_->allocated_bytes());
+  buffer = pool_->GetBuffer();
+  auto other_buffer = pool_->GetBuffer();
+  EXPECT_EQ(1, pool_->hits());
+  EXPECT_EQ(2, pool_->misses());
+  EXPECT_EQ(2 * buffer_bytes, pool_->allocated_bytes());
+}
+
+TEST(ImageFrameBufferPoolStaticTest, UsesAlignmentBoundary) {
+  auto pool = ImageFramePool::Create(/*width=*/5, /*height=*/3,
+                                     ImageFormat::SRGB, kKeepCount,
+                                     /*alignment_boundary=*/32);
+  auto buffer = pool->GetBuffer();
+  EXPECT_EQ(32, buffer->WidthStep());
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buffer->PixelData()) % 32);
+}
+
 TEST(ImageFrameBufferPoolStaticTest, BufferCanOutlivePool) {
   auto pool = ImageFramePool::Create(kWidth, kHeight, kFormat, kKeepCount);
   auto buffer = pool->GetBuffer();
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/formats/image_multi_pool.h"
 
+#include <algorithm>
 #include <tuple>
 
 #include "absl/memory/memory.h"
@@ -29,6 +30,9 @@
 
 namespace mediapipe {
 
+const GraphService<ImageMultiPool> kImageMultiPoolService(
+    "kImageMultiPoolService");
+
 // Keep this many buffers allocated for a given frame size.
 static constexpr int kKeepCount = 2;
 // The maximum size of the ImageMultiPool. When the limit is reached, the
@@ -113,12 +117,7 @@ Image ImageMultiPool::GetBufferFromSimplePool(
 ImageMultiPool::SimplePoolCpu ImageMultiPool::MakeSimplePoolCpu(
     IBufferSpec spec) {
   return ImageFramePool::Create(spec.width, spec.height, spec.format,
-                                kKeepCount);
-}
-
-Image ImageMultiPool::GetBufferFromSimplePool(
-    IBufferSpec spec, const ImageMultiPool::SimplePoolCpu& pool) {
-  return Image(pool->GetBuffer());
+                                cpu_keep_count_, spec.alignment);
 }
 
 Image ImageMultiPool::GetBuffer(int width, int height, bool use_gpu,
@@ -155,34 +154,96 @@ Image ImageMultiPool::GetBuffer(int width, int height, bool use_gpu,
   } else  // NOLINT(readability/braces)
 #endif    // !MEDIAPIPE_DISABLE_GPU
   {
-    absl::MutexLock lock(&mutex_cpu_);
-    IBufferSpec key(width, height, format);
-    auto pool_it = pools_cpu_.find(key);
-    if (pool_it == pools_cpu_.end()) {
-      // Discard the least recently used pool in LRU cache.
-      if (pools_cpu_.size() >= kMaxPoolCount) {
-        auto old_spec = buffer_specs_cpu_.front();  // Front has LRU.
-        buffer_specs_cpu_.pop_front();
-        pools_cpu_.erase(old_spec);
-      }
-      buffer_specs_cpu_.push_back(key);  // Push new spec to back.
-      std::tie(pool_it, std::ignore) = pools_cpu_.emplace(
-          std::piecewise_construct, std::forward_as_tuple(key),
-          std::forward_as_tuple(MakeSimplePoolCpu(key)));
-    } else {
-      // Find and move current 'key' spec to back, keeping others in same order.
-      auto specs_it = buffer_specs_cpu_.begin();
-      while (specs_it != buffer_specs_cpu_.end()) {
-        if (*specs_it == key) {
-          buffer_specs_cpu_.erase(specs_it);
-          break;
-        }
-        ++specs_it;
+    return Image(GetCpuBuffer(IBufferSpec(width, height, format)));
+  }
+}
+
+ImageFrameSharedPtr ImageMultiPool::GetCpuBuffer(IBufferSpec key) {
+  absl::MutexLock lock(&mutex_cpu_);
+  auto pool_it = pools_cpu_.find(key);
+  if (pool_it == pools_cpu_.end()) {
+    // Discard the least recently used pool in LRU cache.
+    if (pools_cpu_.size() >= kMaxPoolCount) {
+      auto old_spec = buffer_specs_cpu_.front();  // Front has LRU.
+      buffer_specs_cpu_.pop_front();
+      auto old_it = pools_cpu_.find(old_spec);
+      discarded_cpu_hits_ += old_it->second->hits();
+      discarded_cpu_misses_ += old_it->second->misses();
+      pools_cpu_.erase(old_it);
+    }
+    buffer_specs_cpu_.push_back(key);  // Push new spec to back.
+    std::tie(pool_it, std::ignore) = pools_cpu_.emplace(
+        std::piecewise_construct, std::forward_as_tuple(key),
+        std::forward_as_tuple(MakeSimplePoolCpu(key)));
+  } else {
+    // Find and move current 'key' spec to back, keeping others in same order.
+    auto specs_it = buffer_specs_cpu_.begin();
+    while (specs_it != buffer_specs_cpu_.end()) {
+      if (*specs_it == key) {
+        buffer_specs_cpu_.erase(specs_it);
+        break;
       }
-      buffer_specs_cpu_.push_back(key);
+      ++specs_it;
     }
-    return GetBufferFromSimplePool(pool_it->first, pool_it->second);
+    buffer_specs_cpu_.push_back(key);
+  }
+  const SimplePoolCpu& pool = pool_it->second;
+  const int64_t misses = pool->misses();
+  ImageFrameSharedPtr buffer = pool->GetBuffer();
+  // Only allocations raise the memory use.
+  if (pool->misses() != misses) {
+    peak_cpu_allocated_bytes_ =
+        std::max(peak_cpu_allocated_bytes_, CpuAllocatedBytes());
+  }
+  return buffer;
+}
+
+std::unique_ptr<ImageFrame> ImageMultiPool::GetImageFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32 alignment_boundary) {
+  ImageFrameSharedPtr buffer =
+      GetCpuBuffer(IBufferSpec(width, height, format, alignment_boundary));
+  // The returned frame shares the pixel data of the pooled frame, and keeps
+  // it out of the pool until it is destroyed.
+  uint8* pixel_data = buffer->MutablePixelData();
+  const int width_step = buffer->WidthStep();
+  return absl::make_unique<ImageFrame>(
+      format, width, height, width_step, pixel_data,
+      [buffer = std::move(buffer)](uint8*) mutable { buffer.reset(); });
+}
+
+int64_t ImageMultiPool::CpuAllocatedBytes() {
+  int64_t bytes = 0;
+  for (const auto& entry : pools_cpu_) {
+    bytes += entry.second->allocated_bytes();
+  }
+  return bytes;
+}
+
+void ImageMultiPool::GetCpuMetrics(GraphMetrics::BufferPoolMetrics* metrics) {
+  absl::MutexLock lock(&mutex_cpu_);
+  int64_t hits = discarded_cpu_hits_;
+  int64_t misses = discarded_cpu_misses_;
+  for (const auto& entry : pools_cpu_) {
+    hits += entry.second->hits();
+    misses += entry.second->misses();
+  }
+  metrics->set_name("image_frames");
+  metrics->set_hit_count(hits);
+  metrics->set_miss_count(misses);
+  metrics->set_allocated_bytes(CpuAllocatedBytes());
+  metrics->set_peak_allocated_bytes(peak_cpu_allocated_bytes_);
+}
+
+std::unique_ptr<ImageFrame> CreateImageFrame(
+    ServiceBinding<ImageMultiPool> pool, ImageFormat::Format format, int width,
+    int height, uint32 alignment_boundary) {
+  if (pool.IsAvailable()) {
+    return pool.GetObject().GetImageFrame(format, width, height,
+                                          alignment_boundary);
   }
+  return absl::make_unique<ImageFrame>(format, width, height,
+                                       alignment_boundary);
 }
 
 ImageMultiPool::~ImageMultiPool() {
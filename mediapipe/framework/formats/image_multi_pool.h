@@ -17,18 +17,25 @@
 // platform-specific buffer pools for the requested sizes.
 //
 // This class is not meant to be used directly by calculators, but is instead
-// used by GlCalculatorHelper to allocate buffers.
+// used by GlCalculatorHelper to allocate buffers. The exception are CPU image
+// calculators, which get their output ImageFrames from the graph-wide pool
+// of kImageMultiPoolService with CreateImageFrame().
 
 #ifndef MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_MULTI_POOL_H_
 #define MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_MULTI_POOL_H_
 
+#include <cstdint>
 #include <deque>
 #include <limits>
+#include <memory>
 #include <unordered_map>
 
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_pool.h"
+#include "mediapipe/framework/graph_service.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gpu_buffer.h"
@@ -51,12 +58,31 @@ class ImageMultiPool {
  public:
   ImageMultiPool() {}
   explicit ImageMultiPool(void* ignored) {}
+  // Keeps up to cpu_keep_count CPU buffers of each size, in use or available.
+  // Graphs that hold more frames of a size at once than the default of 2,
+  // for example because several calculators share the pool, need a higher
+  // count for the buffers to be reused.
+  explicit ImageMultiPool(int cpu_keep_count)
+      : cpu_keep_count_(cpu_keep_count) {}
   ~ImageMultiPool();
 
   // Obtains a buffer. May either be reused or created anew.
   Image GetBuffer(int width, int height, bool use_gpu,
                   ImageFormat::Format format /*= ImageFormat::SRGBA*/);
 
+  // Obtains an ImageFrame whose pixel data comes from the CPU pool for its
+  // format, dimensions and alignment, and goes back to it when the frame is
+  // destroyed. The pixel data is not initialized, as with the ImageFrame
+  // constructor.
+  std::unique_ptr<ImageFrame> GetImageFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
+  // Fills the hit and miss counts and the allocated bytes of the CPU buffers.
+  // Only the buffers of the current CPU pools are counted as allocated; see
+  // kMaxPoolCount in the implementation.
+  void GetCpuMetrics(GraphMetrics::BufferPoolMetrics* metrics);
+
 #if !MEDIAPIPE_DISABLE_GPU
 #ifdef __APPLE__
   // TODO: add tests for the texture cache registration.
@@ -76,14 +102,14 @@ class ImageMultiPool {
   }
 
   struct IBufferSpec {
-    IBufferSpec(int w, int h, mediapipe::ImageFormat::Format f)
-        : width(w), height(h), format(f) {}
+    IBufferSpec(int w, int h, mediapipe::ImageFormat::Format f,
+                uint32 a = ImageFrame::kGlDefaultAlignmentBoundary)
+        : width(w), height(h), format(f), alignment(a) {}
     int width;
     int height;
     mediapipe::ImageFormat::Format format;
-    // Note: alignment should be added here if ImageFrameBufferPool is changed
-    // to allow for customizable alignment sizes (currently fixed at 4 for best
-    // compatability with OpenGL).
+    // The row alignment of CPU buffers. GPU buffers ignore it.
+    uint32 alignment;
   };
 
   struct IBufferSpecHash {
@@ -93,10 +119,8 @@ class ImageMultiPool {
       constexpr int kWidth = std::numeric_limits<size_t>::digits;
       return std::hash<std::size_t>{}(
           spec.width ^ RotateLeftN(spec.height, kWidth / 2) ^
-          RotateLeftN(static_cast<uint32_t>(spec.format), kWidth / 4));
-      // Note: alignment should be added here if ImageFrameBufferPool is changed
-      // to allow for customizable alignment sizes (currently fixed at 4 for
-      // best compatability with OpenGL).
+          RotateLeftN(static_cast<uint32_t>(spec.format), kWidth / 4) ^
+          RotateLeftN(spec.alignment, kWidth * 3 / 8));
     }
   };
 
@@ -120,14 +144,22 @@ class ImageMultiPool {
 
   typedef std::shared_ptr<ImageFramePool> SimplePoolCpu;
   SimplePoolCpu MakeSimplePoolCpu(IBufferSpec spec);
-  Image GetBufferFromSimplePool(IBufferSpec spec, const SimplePoolCpu& pool);
+  ImageFrameSharedPtr GetCpuBuffer(IBufferSpec spec);
 
+  // Returns the bytes held by the buffers of pools_cpu_.
+  int64_t CpuAllocatedBytes() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_cpu_);
+
+  const int cpu_keep_count_ = 2;
   absl::Mutex mutex_cpu_;
   std::unordered_map<IBufferSpec, SimplePoolCpu, IBufferSpecHash> pools_cpu_
       ABSL_GUARDED_BY(mutex_cpu_);
   // A queue of IBufferSpecs to keep track of the age of each IBufferSpec added
   // to the pool.
   std::deque<IBufferSpec> buffer_specs_cpu_;
+  // Hits and misses of the CPU pools discarded from pools_cpu_.
+  int64_t discarded_cpu_hits_ ABSL_GUARDED_BY(mutex_cpu_) = 0;
+  int64_t discarded_cpu_misses_ ABSL_GUARDED_BY(mutex_cpu_) = 0;
+  int64_t peak_cpu_allocated_bytes_ ABSL_GUARDED_BY(mutex_cpu_) = 0;
 
 #if !MEDIAPIPE_DISABLE_GPU
 #ifdef __APPLE__
@@ -142,13 +174,28 @@ class ImageMultiPool {
 inline bool operator==(const ImageMultiPool::IBufferSpec& lhs,
                        const ImageMultiPool::IBufferSpec& rhs) {
   return lhs.width == rhs.width && lhs.height == rhs.height &&
-         lhs.format == rhs.format;
+         lhs.format == rhs.format && lhs.alignment == rhs.alignment;
 }
 inline bool operator!=(const ImageMultiPool::IBufferSpec& lhs,
                        const ImageMultiPool::IBufferSpec& rhs) {
   return !operator==(lhs, rhs);
 }
 
+// Graph-wide ImageMultiPool for the output frames of CPU image calculators.
+// Calculators request it with
+//   cc->UseService(kImageMultiPoolService).Optional();
+// and allocate their frames with CreateImageFrame(), which falls back to
+// regular frames if the application did not provide a pool with
+// CalculatorGraph::SetServiceObject().
+extern const GraphService<ImageMultiPool> kImageMultiPoolService;
+
+// Returns a new ImageFrame, from |pool| if it is available. The arguments
+// are those of the ImageFrame constructor.
+std::unique_ptr<ImageFrame> CreateImageFrame(
+    ServiceBinding<ImageMultiPool> pool, ImageFormat::Format format, int width,
+    int height,
+    uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_MULTI_POOL_H_
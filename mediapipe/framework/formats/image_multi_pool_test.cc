@@ -0,0 +1,102 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_multi_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kWidth = 320;
+constexpr int kHeight = 200;
+constexpr int kFrameBytes = kWidth * 3 * kHeight;
+
+TEST(ImageMultiPoolTest, RecyclesImageFrames) {
+  ImageMultiPool pool;
+  const uint8* pixel_data;
+  {
+    std::unique_ptr<ImageFrame> frame =
+        pool.GetImageFrame(ImageFormat::SRGB, kWidth, kHeight);
+    EXPECT_EQ(ImageFormat::SRGB, frame->Format());
+    EXPECT_EQ(kWidth, frame->Width());
+    EXPECT_EQ(kHeight, frame->Height());
+    EXPECT_EQ(kWidth * 3, frame->WidthStep());
+    pixel_data = frame->PixelData();
+  }
+  std::unique_ptr<ImageFrame> frame =
+      pool.GetImageFrame(ImageFormat::SRGB, kWidth, kHeight);
+  EXPECT_EQ(pixel_data, frame->PixelData());
+
+  GraphMetrics::BufferPoolMetrics metrics;
+  pool.GetCpuMetrics(&metrics);
+  EXPECT_EQ(1, metrics.hit_count());
+  EXPECT_EQ(1, metrics.miss_count());
+  EXPECT_EQ(kFrameBytes, metrics.allocated_bytes());
+  EXPECT_EQ(kFrameBytes, metrics.peak_allocated_bytes());
+}
+
+TEST(ImageMultiPoolTest, KeysPoolsByAlignment) {
+  ImageMultiPool pool;
+  std::unique_ptr<ImageFrame> aligned =
+      pool.GetImageFrame(ImageFormat::SRGB, 5, 3);
+  std::unique_ptr<ImageFrame> packed = pool.GetImageFrame(
+      ImageFormat::SRGB, 5, 3, /*alignment_boundary=*/1);
+  EXPECT_EQ(ImageFrame::kDefaultAlignmentBoundary, aligned->WidthStep());
+  EXPECT_EQ(15, packed->WidthStep());
+  EXPECT_TRUE(packed->IsContiguous());
+}
+
+TEST(ImageMultiPoolTest, ReportsPeakAllocatedBytes) {
+  ImageMultiPool pool(/*cpu_keep_count=*/1);
+  {
+    auto first = pool.GetImageFrame(ImageFormat::SRGB, kWidth, kHeight);
+    auto second = pool.GetImageFrame(ImageFormat::SRGB, kWidth, kHeight);
+  }
+  GraphMetrics::BufferPoolMetrics metrics;
+  pool.GetCpuMetrics(&metrics);
+  EXPECT_EQ(0, metrics.hit_count());
+  EXPECT_EQ(2, metrics.miss_count());
+  // Only cpu_keep_count buffers are kept once they are released.
+  EXPECT_EQ(kFrameBytes, metrics.allocated_bytes());
+  EXPECT_EQ(2 * kFrameBytes, metrics.peak_allocated_bytes());
+}
+
+TEST(ImageMultiPoolTest, CreateImageFrameWithoutPool) {
+  std::unique_ptr<ImageFrame> frame = CreateImageFrame(
+      ServiceBinding<ImageMultiPool>(), ImageFormat::GRAY8, kWidth, kHeight);
+  EXPECT_EQ(ImageFormat::GRAY8, frame->Format());
+  EXPECT_EQ(kWidth, frame->Width());
+  EXPECT_EQ(kHeight, frame->Height());
+}
+
+TEST(ImageMultiPoolTest, CreateImageFrameWithPool) {
+  auto pool = std::make_shared<ImageMultiPool>();
+  ServiceBinding<ImageMultiPool> binding(pool);
+  CreateImageFrame(binding, ImageFormat::GRAY8, kWidth, kHeight);
+  CreateImageFrame(binding, ImageFormat::GRAY8, kWidth, kHeight);
+  GraphMetrics::BufferPoolMetrics metrics;
+  pool->GetCpuMetrics(&metrics);
+  EXPECT_EQ(1, metrics.hit_count());
+  EXPECT_EQ(1, metrics.miss_count());
+}
+
+}  // namespace
+}  // namespace mediapipe
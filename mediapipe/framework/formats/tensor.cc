@@ -19,6 +19,7 @@
 
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
 #include "mediapipe/framework/port/logging.h"
 
 #if MEDIAPIPE_METAL_ENABLED
@@ -370,6 +371,7 @@ void Tensor::Move(Tensor* src) {
   src->element_type_ = ElementType::kNone;  // Mark as invalidated.
   cpu_buffer_ = src->cpu_buffer_;
   src->cpu_buffer_ = nullptr;
+  cpu_buffer_allocator_ = std::move(src->cpu_buffer_allocator_);
 #if MEDIAPIPE_METAL_ENABLED
   device_ = src->device_;
   command_buffer_ = src->command_buffer_;
@@ -395,6 +397,12 @@ void Tensor::Move(Tensor* src) {
 Tensor::Tensor(ElementType element_type, const Shape& shape)
     : element_type_(element_type), shape_(shape) {}
 
+Tensor::Tensor(ElementType element_type, const Shape& shape,
+               std::shared_ptr<CpuBufferAllocator> allocator)
+    : element_type_(element_type),
+      shape_(shape),
+      cpu_buffer_allocator_(std::move(allocator)) {}
+
 void Tensor::Invalidate() {
 #if MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_30
   GLuint cleanup_gl_tex = GL_INVALID_INDEX;
@@ -412,7 +420,11 @@ void Tensor::Invalidate() {
     metal_buffer_ = nil;
 #else
     if (cpu_buffer_) {
-      free(cpu_buffer_);
+      if (cpu_buffer_allocator_) {
+        cpu_buffer_allocator_->Release(cpu_buffer_, bytes());
+      } else {
+        aligned_free(cpu_buffer_);
+      }
     }
 #endif  // MEDIAPIPE_METAL_ENABLED
     cpu_buffer_ = nullptr;
@@ -527,7 +539,9 @@ void Tensor::AllocateCpuBuffer() const {
 #if MEDIAPIPE_METAL_ENABLED
     cpu_buffer_ = AllocateVirtualMemory(bytes());
 #else
-    cpu_buffer_ = malloc(bytes());
+    cpu_buffer_ = cpu_buffer_allocator_
+                      ? cpu_buffer_allocator_->Allocate(bytes())
+                      : aligned_malloc(bytes(), kCpuBufferAlignment);
 #endif  // MEDIAPIPE_METAL_ENABLED
   }
 }
@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <initializer_list>
+#include <memory>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -89,7 +90,23 @@ class Tensor {
     std::vector<int> dims;
   };
 
+  // Supplies CPU buffers to tensors and takes them back when they are no
+  // longer needed, e.g. to recycle buffers across frames (see TensorPool).
+  class CpuBufferAllocator {
+   public:
+    virtual ~CpuBufferAllocator() = default;
+    // Returns a buffer of "bytes" bytes aligned to kCpuBufferAlignment.
+    virtual void* Allocate(size_t bytes) = 0;
+    // Takes back a buffer obtained from Allocate("bytes").
+    virtual void Release(void* buffer, size_t bytes) = 0;
+  };
+
   Tensor(ElementType element_type, const Shape& shape);
+  // The CPU buffer, once needed, is obtained from "allocator" and returned to
+  // it when the tensor is destroyed. Ignored when Metal is enabled, because the
+  // CPU buffer is then shared with the Metal buffer.
+  Tensor(ElementType element_type, const Shape& shape,
+         std::shared_ptr<CpuBufferAllocator> allocator);
 
   // Non-copyable.
   Tensor(const Tensor&) = delete;
@@ -122,6 +139,10 @@ class Tensor {
   CpuReadView GetCpuReadView() const;
   using CpuWriteView = CpuView<void>;
   CpuWriteView GetCpuWriteView() const;
+  // The CPU buffer is aligned to at least this many bytes, so that it can be
+  // handed to libraries with alignment requirements (e.g. as a TfLite custom
+  // tensor allocation) without a copy.
+  static constexpr int kCpuBufferAlignment = 64;
 
 #if MEDIAPIPE_METAL_ENABLED
   // TODO: id<MTLBuffer> vs. MtlBufferView.
@@ -252,6 +273,7 @@ class Tensor {
   mutable absl::Mutex view_mutex_;
 
   mutable void* cpu_buffer_ = nullptr;
+  std::shared_ptr<CpuBufferAllocator> cpu_buffer_allocator_;
   void AllocateCpuBuffer() const;
 #if MEDIAPIPE_METAL_ENABLED
   mutable id<MTLCommandBuffer> command_buffer_;
@@ -0,0 +1,85 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/tensor_pool.h"
+
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+
+namespace mediapipe {
+
+const GraphService<TensorPool> kTensorPoolService("kTensorPoolService");
+
+TensorPool::~TensorPool() {
+  for (auto& entry : available_) {
+    for (void* buffer : entry.second) {
+      aligned_free(buffer);
+    }
+  }
+}
+
+Tensor TensorPool::GetTensor(Tensor::ElementType element_type,
+                             const Tensor::Shape& shape) {
+  return Tensor(element_type, shape, shared_from_this());
+}
+
+void* TensorPool::Allocate(size_t bytes) {
+  {
+    absl::MutexLock lock(&mutex_);
+    ++in_use_count_;
+    auto it = available_.find(bytes);
+    if (it != available_.end() && !it->second.empty()) {
+      void* buffer = it->second.back();
+      it->second.pop_back();
+      ++hits_;
+      return buffer;
+    }
+    ++misses_;
+  }
+  return aligned_malloc(bytes, Tensor::kCpuBufferAlignment);
+}
+
+void TensorPool::Release(void* buffer, size_t bytes) {
+  {
+    absl::MutexLock lock(&mutex_);
+    --in_use_count_;
+    auto& buffers = available_[bytes];
+    if (buffers.size() < keep_count_) {
+      buffers.push_back(buffer);
+      return;
+    }
+  }
+  // The surplus buffer is released without holding the lock.
+  aligned_free(buffer);
+}
+
+int64_t TensorPool::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t TensorPool::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+std::pair<int, int> TensorPool::GetInUseAndAvailableCounts() {
+  absl::MutexLock lock(&mutex_);
+  int available = 0;
+  for (const auto& entry : available_) {
+    available += entry.second.size();
+  }
+  return {in_use_count_, available};
+}
+
+}  // namespace mediapipe
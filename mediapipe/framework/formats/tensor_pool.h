@@ -0,0 +1,90 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_TENSOR_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_TENSOR_POOL_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/graph_service.h"
+
+namespace mediapipe {
+
+// Recycles the CPU buffers of Tensors. Calculators that produce identically
+// shaped tensors on every frame obtain them with GetTensor(); when the last
+// packet holding such a tensor is destroyed, its CPU buffer goes back to the
+// pool and is handed to the next tensor of the same size, instead of being
+// freed and allocated again.
+//
+// Buffers are only taken from the pool when a CPU view is first requested, so
+// tensors that only ever live on the GPU do not touch it.
+class TensorPool : public Tensor::CpuBufferAllocator,
+                   public std::enable_shared_from_this<TensorPool> {
+ public:
+  static constexpr int kDefaultKeepCount = 4;
+
+  // Creates a pool that keeps up to "keep_count" unused buffers of each size.
+  // We enforce creation as a shared_ptr since tensors keep a reference to the
+  // pool that allocated their buffer.
+  static std::shared_ptr<TensorPool> Create(
+      int keep_count = kDefaultKeepCount) {
+    return std::shared_ptr<TensorPool>(new TensorPool(keep_count));
+  }
+
+  ~TensorPool() override;
+
+  // Returns a tensor whose CPU buffer comes from this pool.
+  Tensor GetTensor(Tensor::ElementType element_type,
+                   const Tensor::Shape& shape);
+
+  // Tensor::CpuBufferAllocator implementation.
+  void* Allocate(size_t bytes) override;
+  void Release(void* buffer, size_t bytes) override;
+
+  // Number of buffer requests served from, and not served from, the pool.
+  int64_t hits() const;
+  int64_t misses() const;
+
+  // This method is meant for testing.
+  std::pair<int, int> GetInUseAndAvailableCounts();
+
+ private:
+  explicit TensorPool(int keep_count) : keep_count_(keep_count) {}
+
+  const int keep_count_;
+
+  mutable absl::Mutex mutex_;
+  int in_use_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Unused buffers, by size in bytes.
+  absl::flat_hash_map<size_t, std::vector<void*>> available_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Graph-wide TensorPool. Calculators request it with
+//   cc->UseService(kTensorPoolService).Optional();
+// and fall back to regular tensors if the application did not provide one
+// with CalculatorGraph::SetServiceObject().
+extern const GraphService<TensorPool> kTensorPoolService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_TENSOR_POOL_H_
@@ -0,0 +1,108 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/tensor_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+using Pair = std::pair<int, int>;
+
+constexpr int kKeepCount = 2;
+
+class TensorPoolTest : public ::testing::Test {
+ protected:
+  TensorPoolTest() { pool_ = TensorPool::Create(kKeepCount); }
+
+  Tensor GetTensor() {
+    return pool_->GetTensor(Tensor::ElementType::kFloat32,
+                            Tensor::Shape{1, 4, 4, 3});
+  }
+
+  std::shared_ptr<TensorPool> pool_;
+};
+
+TEST_F(TensorPoolTest, BufferIsTakenOnFirstCpuView) {
+  Tensor tensor = GetTensor();
+  EXPECT_EQ(Pair(0, 0), pool_->GetInUseAndAvailableCounts());
+  void* buffer = tensor.GetCpuWriteView().buffer<float>();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer) % Tensor::kCpuBufferAlignment,
+            0);
+  EXPECT_EQ(Pair(1, 0), pool_->GetInUseAndAvailableCounts());
+  EXPECT_EQ(0, pool_->hits());
+  EXPECT_EQ(1, pool_->misses());
+}
+
+TEST_F(TensorPoolTest, RecyclesBuffer) {
+  void* first_buffer;
+  {
+    Tensor tensor = GetTensor();
+    first_buffer = tensor.GetCpuWriteView().buffer<float>();
+  }
+  EXPECT_EQ(Pair(0, 1), pool_->GetInUseAndAvailableCounts());
+  Tensor tensor = GetTensor();
+  EXPECT_EQ(first_buffer, tensor.GetCpuWriteView().buffer<float>());
+  EXPECT_EQ(Pair(1, 0), pool_->GetInUseAndAvailableCounts());
+  EXPECT_EQ(1, pool_->hits());
+  EXPECT_EQ(1, pool_->misses());
+}
+
+TEST_F(TensorPoolTest, MovedTensorReturnsBufferOnce) {
+  std::vector<Tensor> tensors;
+  tensors.push_back(GetTensor());
+  tensors.back().GetCpuWriteView();
+  // Force the vector to move the tensor.
+  tensors.reserve(tensors.capacity() + 1);
+  tensors.clear();
+  EXPECT_EQ(Pair(0, 1), pool_->GetInUseAndAvailableCounts());
+}
+
+TEST_F(TensorPoolTest, KeepsAtMostKeepCountBuffersPerSize) {
+  std::vector<Tensor> tensors;
+  for (int i = 0; i <= kKeepCount; ++i) {
+    tensors.push_back(GetTensor());
+    tensors.back().GetCpuWriteView();
+  }
+  EXPECT_EQ(Pair(kKeepCount + 1, 0), pool_->GetInUseAndAvailableCounts());
+  tensors.clear();
+  EXPECT_EQ(Pair(0, kKeepCount), pool_->GetInUseAndAvailableCounts());
+}
+
+TEST_F(TensorPoolTest, DoesNotMixSizes) {
+  {
+    Tensor tensor = GetTensor();
+    tensor.GetCpuWriteView();
+  }
+  Tensor other =
+      pool_->GetTensor(Tensor::ElementType::kFloat32, Tensor::Shape{1, 8});
+  other.GetCpuWriteView();
+  EXPECT_EQ(Pair(1, 1), pool_->GetInUseAndAvailableCounts());
+  EXPECT_EQ(0, pool_->hits());
+}
+
+TEST_F(TensorPoolTest, TensorOutlivesPoolHandle) {
+  Tensor tensor = GetTensor();
+  tensor.GetCpuWriteView();
+  // The tensor keeps the pool alive until its buffer is returned.
+  pool_ = nullptr;
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -1,5 +1,7 @@
 #include "mediapipe/framework/formats/tensor.h"
 
+#include <cstdint>
+
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #if !MEDIAPIPE_DISABLE_GPU
@@ -32,6 +34,14 @@ TEST(Cpu, TestMemoryAllocation) {
   EXPECT_NE(f1, nullptr);
 }
 
+TEST(Cpu, TestMemoryAlignment) {
+  Tensor t1(Tensor::ElementType::kFloat32, Tensor::Shape{3, 5});
+  auto v1 = t1.GetCpuWriteView();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(v1.buffer<float>()) %
+                Tensor::kCpuBufferAlignment,
+            0);
+}
+
 TEST(Cpu, TestTensorMove) {
   Tensor t1(Tensor::ElementType::kFloat32, Tensor::Shape{4, 3, 2, 3});
   void* p1 = t1.GetCpuWriteView().buffer<float>();
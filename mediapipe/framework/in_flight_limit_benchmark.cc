@@ -0,0 +1,212 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the camera-to-output latency of a graph shaped like
+// mediapipe/graphs/face_mesh/face_mesh_desktop_live.pbtxt, throttled either
+// by a FlowLimiterCalculator with a back edge or by
+// CalculatorGraphConfig.in_flight_limit. Calculators that sleep for a fixed
+// time stand in for the face detection, face landmark and rendering
+// subgraphs, so the benchmark needs no models. Frames arrive at 30 fps, and
+// the simulated stages take longer than a frame period, so the throttle
+// decides which frames run.
+//
+// Reported counters:
+// - latency_ms: mean time from AddPacketToInputStream() to the output frame.
+// - max_latency_ms: the largest such time.
+// - output_fps: output frames per second.
+//
+// bazel run -c opt //mediapipe/framework:in_flight_limit_benchmark
+
+#include <algorithm>
+#include <map>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr absl::Duration kFramePeriod = absl::Milliseconds(33);
+constexpr int kNumFrames = 150;
+// Stand-ins for the per-frame cost of the face_mesh subgraphs.
+constexpr int64 kDetectionMicros = 15000;
+constexpr int64 kLandmarkMicros = 20000;
+constexpr int64 kRenderMicros = 5000;
+
+// Sleeps for "MICROS" microseconds in each Process() call, then outputs the
+// packet of its first input stream. Waits for all its input streams, like the
+// face_mesh subgraphs do.
+class SimulatedStageCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->InputSidePackets().Tag("MICROS").Set<int64>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) final {
+    cost_ = absl::Microseconds(
+        cc->InputSidePackets().Tag("MICROS").Get<int64>());
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    absl::SleepFor(cost_);
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Duration cost_;
+};
+REGISTER_CALCULATOR(SimulatedStageCalculator);
+
+enum Throttle {
+  kFlowLimiter,
+  kInFlightLimitDropNewest,
+  kInFlightLimitDropOldest,
+};
+
+// Builds the face_mesh-shaped graph. "max_in_flight" applies to the
+// in_flight_limit throttles only; FlowLimiterCalculator admits one frame.
+CalculatorGraphConfig MakeFaceMeshConfig(Throttle throttle,
+                                         int max_in_flight) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input_video"
+        output_stream: "output_video"
+        num_threads: 4
+        node {
+          calculator: "SimulatedStageCalculator"
+          input_stream: "throttled_input_video"
+          input_side_packet: "MICROS:detection_micros"
+          output_stream: "face_detections"
+        }
+        node {
+          calculator: "SimulatedStageCalculator"
+          input_stream: "throttled_input_video"
+          input_stream: "face_detections"
+          input_side_packet: "MICROS:landmark_micros"
+          output_stream: "multi_face_landmarks"
+        }
+        node {
+          calculator: "SimulatedStageCalculator"
+          input_stream: "throttled_input_video"
+          input_stream: "multi_face_landmarks"
+          input_side_packet: "MICROS:render_micros"
+          output_stream: "output_video"
+        }
+      )pb");
+  if (throttle == kFlowLimiter) {
+    CalculatorGraphConfig::Node* limiter = config.add_node();
+    *limiter = ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+      calculator: "FlowLimiterCalculator"
+      input_stream: "input_video"
+      input_stream: "FINISHED:output_video"
+      input_stream_info: { tag_index: "FINISHED" back_edge: true }
+      output_stream: "throttled_input_video"
+    )pb");
+  } else {
+    CalculatorGraphConfig::Node* pass_through = config.add_node();
+    pass_through->set_calculator("PassThroughCalculator");
+    pass_through->add_input_stream("input_video");
+    pass_through->add_output_stream("throttled_input_video");
+    InFlightLimitConfig* limit = config.add_in_flight_limit();
+    limit->set_input_stream("input_video");
+    limit->set_max_in_flight(max_in_flight);
+    limit->set_policy(throttle == kInFlightLimitDropNewest
+                          ? InFlightLimitConfig::DROP_NEWEST
+                          : InFlightLimitConfig::DROP_OLDEST);
+  }
+  return config;
+}
+
+void BM_FaceMeshLatency(benchmark::State& state, Throttle throttle) {
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(
+      graph.Initialize(MakeFaceMeshConfig(throttle, state.range(0))));
+  absl::Mutex mutex;
+  std::map<Timestamp, absl::Time> add_times;
+  absl::Duration total_latency;
+  absl::Duration max_latency;
+  int num_outputs = 0;
+  MEDIAPIPE_CHECK_OK(graph.ObserveOutputStream(
+      "output_video", [&](const Packet& packet) {
+        const absl::Time now = absl::Now();
+        absl::MutexLock lock(&mutex);
+        const absl::Duration latency = now - add_times[packet.Timestamp()];
+        total_latency += latency;
+        max_latency = std::max(max_latency, latency);
+        ++num_outputs;
+        return absl::OkStatus();
+      }));
+  MEDIAPIPE_CHECK_OK(graph.StartRun(
+      {{"detection_micros", MakePacket<int64>(kDetectionMicros)},
+       {"landmark_micros", MakePacket<int64>(kLandmarkMicros)},
+       {"render_micros", MakePacket<int64>(kRenderMicros)}}));
+
+  int64 frame = 0;
+  const absl::Time start = absl::Now();
+  for (auto _ : state) {
+    absl::SleepFor(start + frame * kFramePeriod - absl::Now());
+    const Timestamp timestamp(frame++);
+    {
+      absl::MutexLock lock(&mutex);
+      add_times[timestamp] = absl::Now();
+    }
+    MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+        "input_video", MakePacket<int>(0).At(timestamp)));
+  }
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  const double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+
+  absl::MutexLock lock(&mutex);
+  state.counters["latency_ms"] =
+      num_outputs ? absl::ToDoubleMilliseconds(total_latency) / num_outputs
+                  : 0;
+  state.counters["max_latency_ms"] = absl::ToDoubleMilliseconds(max_latency);
+  state.counters["output_fps"] = num_outputs / seconds;
+}
+
+// The argument is max_in_flight.
+BENCHMARK_CAPTURE(BM_FaceMeshLatency, FlowLimiter, kFlowLimiter)
+    ->Arg(1)
+    ->Iterations(kNumFrames)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_FaceMeshLatency, InFlightLimitDropNewest,
+                  kInFlightLimitDropNewest)
+    ->Arg(1)
+    ->Arg(2)
+    ->Iterations(kNumFrames)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_FaceMeshLatency, InFlightLimitDropOldest,
+                  kInFlightLimitDropOldest)
+    ->Arg(1)
+    ->Arg(2)
+    ->Iterations(kNumFrames)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,195 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/in_flight_limiter.h"
+
+#include <utility>
+
+namespace mediapipe {
+namespace internal {
+
+InFlightLimiter::InFlightLimiter(const InFlightLimitConfig& config,
+                                 std::vector<InputStreamManager*> downstream,
+                                 AddFunction add_function,
+                                 ThrottledFunction throttled_function,
+                                 Counter* dropped_counter)
+    : max_in_flight_(config.max_in_flight()),
+      policy_(config.policy()),
+      downstream_(std::move(downstream)),
+      add_function_(std::move(add_function)),
+      throttled_function_(std::move(throttled_function)),
+      dropped_counter_(dropped_counter) {}
+
+void InFlightLimiter::PrepareForRun() {
+  absl::MutexLock lock(&mutex_);
+  in_flight_.clear();
+  waiting_packet_ = Packet();
+  has_waiting_packet_ = false;
+  closed_ = false;
+  update_pending_ = false;
+}
+
+absl::Status InFlightLimiter::AddPacket(Packet packet) {
+  mutex_.Lock();
+  if (closed_) {
+    // Let the graph report the packet added to a closed stream.
+    return AddInOrder(std::move(packet));
+  }
+  ReleaseSettled();
+  if (has_waiting_packet_) {
+    // The waiting packet is older than |packet|.
+    waiting_packet_ = Packet();
+    has_waiting_packet_ = false;
+    dropped_counter_->Increment();
+  }
+  if (policy_ == InFlightLimitConfig::BLOCK) {
+    while (!closed_ &&
+           static_cast<int>(in_flight_.size()) >= max_in_flight_) {
+      settled_cond_var_.Wait(&mutex_);
+      ReleaseSettled();
+    }
+  }
+  if (static_cast<int>(in_flight_.size()) < max_in_flight_ || closed_) {
+    return Admit(std::move(packet));
+  }
+  if (policy_ == InFlightLimitConfig::DROP_OLDEST) {
+    waiting_packet_ = std::move(packet);
+    has_waiting_packet_ = true;
+  } else {
+    dropped_counter_->Increment();
+  }
+  mutex_.Unlock();
+  return absl::OkStatus();
+}
+
+bool InFlightLimiter::Update() {
+  bool may_admit;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!in_flight_.empty()) {
+      ReleaseSettled();
+    }
+    may_admit = MayAdmitWaitingPacket();
+  }
+  // Like AddPacketToInputStream() with ADD_IF_NOT_FULL, a throttled graph
+  // input stream takes no packet. The packet keeps waiting, and is added by a
+  // later call once the graph has drained the full input stream.
+  // throttled_function_ runs without mutex_, since the graph calls into the
+  // scheduler while holding its throttling lock, and the scheduler calls
+  // ReleaseAll() while holding its own.
+  if (!may_admit || throttled_function_()) {
+    return false;
+  }
+  mutex_.Lock();
+  if (MayAdmitWaitingPacket()) {
+    if (add_ticket_ != next_add_ticket_) {
+      // A packet is being added, possibly by this thread through the graph.
+      // Waiting for it could deadlock, so it adds the waiting packet next.
+      update_pending_ = true;
+      mutex_.Unlock();
+      return false;
+    }
+    Packet packet = std::move(waiting_packet_);
+    waiting_packet_ = Packet();
+    has_waiting_packet_ = false;
+    // An error is recorded by the graph, which reports it to the caller of
+    // the next graph API call.
+    Admit(std::move(packet)).IgnoreError();
+    return true;
+  }
+  mutex_.Unlock();
+  return false;
+}
+
+bool InFlightLimiter::ReleaseAll() {
+  absl::MutexLock lock(&mutex_);
+  if (!in_flight_.empty()) {
+    in_flight_.clear();
+    settled_cond_var_.SignalAll();
+  }
+  return !closed_ && has_waiting_packet_;
+}
+
+void InFlightLimiter::Close() {
+  Abort();
+  // Wait for the Admit() calls in progress to finish adding their packets.
+  absl::MutexLock lock(&mutex_);
+  while (add_ticket_ != next_add_ticket_) {
+    added_cond_var_.Wait(&mutex_);
+  }
+}
+
+void InFlightLimiter::Abort() {
+  absl::MutexLock lock(&mutex_);
+  closed_ = true;
+  if (has_waiting_packet_) {
+    waiting_packet_ = Packet();
+    has_waiting_packet_ = false;
+    dropped_counter_->Increment();
+  }
+  settled_cond_var_.SignalAll();
+}
+
+bool InFlightLimiter::MayAdmitWaitingPacket() const {
+  return !closed_ && has_waiting_packet_ &&
+         static_cast<int>(in_flight_.size()) < max_in_flight_;
+}
+
+bool InFlightLimiter::IsSettled(Timestamp timestamp) const {
+  for (const InputStreamManager* stream : downstream_) {
+    if (stream->MinTimestampOrBound(nullptr) <= timestamp) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void InFlightLimiter::ReleaseSettled() {
+  const int num_in_flight = in_flight_.size();
+  while (!in_flight_.empty() && IsSettled(in_flight_.front())) {
+    in_flight_.pop_front();
+  }
+  if (static_cast<int>(in_flight_.size()) != num_in_flight) {
+    settled_cond_var_.SignalAll();
+  }
+}
+
+absl::Status InFlightLimiter::Admit(Packet packet) {
+  in_flight_.push_back(packet.Timestamp());
+  return AddInOrder(std::move(packet));
+}
+
+absl::Status InFlightLimiter::AddInOrder(Packet packet) {
+  const int64 ticket = next_add_ticket_++;
+  while (add_ticket_ != ticket) {
+    added_cond_var_.Wait(&mutex_);
+  }
+  mutex_.Unlock();
+  absl::Status status = add_function_(std::move(packet));
+  mutex_.Lock();
+  ++add_ticket_;
+  added_cond_var_.SignalAll();
+  const bool update = update_pending_ && add_ticket_ == next_add_ticket_;
+  if (update) {
+    update_pending_ = false;
+  }
+  mutex_.Unlock();
+  if (update) {
+    Update();
+  }
+  return status;
+}
+
+}  // namespace internal
+}  // namespace mediapipe
@@ -0,0 +1,151 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_IN_FLIGHT_LIMITER_H_
+#define MEDIAPIPE_FRAMEWORK_IN_FLIGHT_LIMITER_H_
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/counter.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace internal {
+
+// Bounds the number of timestamps of a graph input stream that the graph
+// processes at once, as configured by CalculatorGraphConfig.in_flight_limit.
+//
+// A timestamp is in flight from the time its packet enters the graph until it
+// has settled, that is, until no input stream downstream of the graph input
+// stream holds a packet or a timestamp bound at or before the timestamp. At
+// that point every calculator has received everything it will receive for the
+// timestamp. A calculator without a timestamp offset that outputs nothing at
+// a timestamp leaves the bounds downstream of it at the timestamp until its
+// next output, so all the timestamps in flight are also released when the
+// graph becomes idle. Packets added while the limit is reached are handled
+// according to the InFlightLimitConfig::Policy.
+//
+// This class is thread-safe.
+class InFlightLimiter {
+ public:
+  // Adds a packet to the graph input stream and propagates it downstream.
+  using AddFunction = std::function<absl::Status(Packet packet)>;
+  // Returns true if the graph input stream is throttled, because an input
+  // stream downstream of it is full.
+  using ThrottledFunction = std::function<bool()>;
+
+  // |downstream| are the input streams which receive the packets of the graph
+  // input stream, directly or through other calculators. |dropped_counter|
+  // counts the packets dropped by the policy.
+  InFlightLimiter(const InFlightLimitConfig& config,
+                  std::vector<InputStreamManager*> downstream,
+                  AddFunction add_function,
+                  ThrottledFunction throttled_function,
+                  Counter* dropped_counter);
+
+  InFlightLimiter(const InFlightLimiter&) = delete;
+  InFlightLimiter& operator=(const InFlightLimiter&) = delete;
+
+  // Resets the limiter for a new graph run.
+  void PrepareForRun() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Adds |packet| to the graph if fewer than max_in_flight timestamps are in
+  // flight. Otherwise, depending on the policy, waits for a timestamp to
+  // settle, drops |packet|, or keeps |packet| until a timestamp settles.
+  absl::Status AddPacket(Packet packet) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Releases the timestamps which have settled, and adds the waiting packet
+  // if there is room for it and the graph input stream is not throttled.
+  // Returns true if the waiting packet was added. Called after each Process()
+  // call of the calculators whose output streams feed no calculator
+  // downstream of the graph input stream, and may run on a worker thread, so
+  // it never waits for the graph input stream to be unthrottled.
+  bool Update() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Releases all the timestamps in flight. Called while the graph is idle,
+  // when no calculator can receive anything more at those timestamps until
+  // more packets are added to the graph. Returns true if a packet is waiting,
+  // for Update() to add it.
+  bool ReleaseAll() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Drops the waiting packet, wakes up a blocked AddPacket() call, and stops
+  // adding packets to the graph. Called when the graph input stream is
+  // closed and when the graph run ends.
+  void Close() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Like Close(), but does not wait for a packet being added to the graph.
+  // Called when the graph records an error, possibly from the AddFunction.
+  void Abort() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Returns true if no downstream input stream can receive a packet at or
+  // before |timestamp| any more.
+  bool IsSettled(Timestamp timestamp) const;
+
+  // Returns true if a packet is waiting and there is room for it.
+  bool MayAdmitWaitingPacket() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Removes the settled timestamps from in_flight_.
+  void ReleaseSettled() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Adds |packet| to the graph in flight.
+  absl::Status Admit(Packet packet) ABSL_UNLOCK_FUNCTION(mutex_);
+
+  // Calls add_function_ without mutex_, after the packets admitted before
+  // |packet| have been added. Then adds the waiting packet if an Update() call
+  // left it to this one.
+  absl::Status AddInOrder(Packet packet) ABSL_UNLOCK_FUNCTION(mutex_);
+
+  const int max_in_flight_;
+  const InFlightLimitConfig::Policy policy_;
+  const std::vector<InputStreamManager*> downstream_;
+  const AddFunction add_function_;
+  const ThrottledFunction throttled_function_;
+  Counter* const dropped_counter_;
+
+  absl::Mutex mutex_;
+  // Signaled when a timestamp settles or the limiter is closed.
+  absl::CondVar settled_cond_var_;
+  // The timestamps in flight, oldest first.
+  std::deque<Timestamp> in_flight_ ABSL_GUARDED_BY(mutex_);
+  // The packet kept by the DROP_OLDEST policy, or an empty packet.
+  Packet waiting_packet_ ABSL_GUARDED_BY(mutex_);
+  bool has_waiting_packet_ ABSL_GUARDED_BY(mutex_) = false;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // The calls to add_function_ are serialized in ticket order, since a graph
+  // input stream does not support concurrent additions. No mutex is held
+  // while adding, because the graph may call back into the limiter, on the
+  // same thread, when it becomes idle.
+  int64 next_add_ticket_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The ticket being added, or next_add_ticket_ if no packet is being added.
+  int64 add_ticket_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Signaled when add_ticket_ advances.
+  absl::CondVar added_cond_var_;
+  // Set when Update() left the waiting packet to the packet being added.
+  bool update_pending_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_IN_FLIGHT_LIMITER_H_
@@ -18,6 +18,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_H_
 
+#include <memory>
 #include <string>
 
 #include "absl/base/macros.h"
@@ -45,6 +46,16 @@ class InputStream {
     return Value().Get<T>();
   }
 
+  // Takes ownership of the data of the input, which may then be modified in
+  // place, and leaves the input empty. Packets on a stream with a single
+  // consumer are moved to it, so this succeeds unless the upstream calculator
+  // or an observer kept a reference to the packet. Otherwise returns an error
+  // and leaves the input unchanged. May be called in Process() only.
+  template <typename T>
+  absl::StatusOr<std::unique_ptr<T>> Consume() {
+    return Value().Consume<T>();
+  }
+
   // Syntactic sugar for checking if the input is empty.
   bool IsEmpty() const { return Value().IsEmpty(); }
 
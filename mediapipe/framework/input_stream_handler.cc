@@ -293,7 +293,7 @@ void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
-  if (notify) {
+  if (notify && BoundChangeMayAffectNode(id)) {
     notification_();
   }
 }
@@ -338,14 +338,25 @@ SyncSet::SyncSet(InputStreamHandler* input_stream_handler,
 
 void SyncSet::PrepareForRun() { last_processed_ts_ = Timestamp::Unset(); }
 
-NodeReadiness SyncSet::GetReadiness(Timestamp* min_stream_timestamp) {
+NodeReadiness SyncSet::GetReadiness(
+    Timestamp* min_stream_timestamp,
+    std::vector<CollectionItemId>* min_bound_ids) {
   Timestamp min_bound = Timestamp::Done();
   Timestamp min_packet = Timestamp::Done();
+  if (min_bound_ids) {
+    min_bound_ids->clear();
+  }
   for (CollectionItemId id : stream_ids_) {
     const auto& stream = input_stream_handler_->input_stream_managers_.Get(id);
     bool empty;
     Timestamp stream_timestamp = stream->MinTimestampOrBound(&empty);
     if (empty) {
+      if (min_bound_ids && stream_timestamp <= min_bound) {
+        if (stream_timestamp < min_bound) {
+          min_bound_ids->clear();
+        }
+        min_bound_ids->push_back(id);
+      }
       min_bound = std::min(min_bound, stream_timestamp);
     } else {
       min_packet = std::min(min_packet, stream_timestamp);
@@ -208,7 +208,11 @@ class InputStreamHandler {
     void PrepareForRun();
 
     // Answers whether this stream is ready for Process or Close.
-    NodeReadiness GetReadiness(Timestamp* min_stream_timestamp);
+    // If |min_bound_ids| is not null, it receives the empty streams whose
+    // timestamp bound is the minimum bound over all the empty streams.
+    NodeReadiness GetReadiness(
+        Timestamp* min_stream_timestamp,
+        std::vector<CollectionItemId>* min_bound_ids = nullptr);
 
     // Returns the latest timestamp returned for processing.
     Timestamp LastProcessed() const;
@@ -270,6 +274,12 @@ class InputStreamHandler {
   virtual void FillInputSet(Timestamp input_timestamp,
                             InputStreamShardSet* input_set) = 0;
 
+  // Returns false if an increase of the timestamp bound of the empty stream
+  // |id| can neither make the node ready nor change the timestamp bound it
+  // propagates, in which case the node is not notified of the increase.
+  // Called without holding any lock, possibly while the node is scheduling.
+  virtual bool BoundChangeMayAffectNode(CollectionItemId id) { return true; }
+
   // Collection of InputStreamManager objects.
   InputStreamManagerSet input_stream_managers_;
   // A pointer to the calculator context manager of the calculator node.
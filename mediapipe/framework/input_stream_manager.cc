@@ -49,6 +49,7 @@ void InputStreamManager::SetQueueSizeCallbacks(
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
   queue_.clear();
+  peak_queue_size_.store(0, std::memory_order_relaxed);
   last_reported_stream_full_ = false;
   num_packets_added_ = 0;
   next_timestamp_bound_ = Timestamp::PreStream();
@@ -108,13 +109,16 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
     // Check if the queue becomes non-empty.
     queue_became_non_empty = queue_.empty() && !container.empty();
     for (auto& packet : container) {
-      absl::Status result = packet_type_->Validate(packet);
-      if (!result.ok()) {
-        return tool::AddStatusPrefix(
-            absl::StrCat(
-                "Packet type mismatch on a calculator receiving from stream \"",
-                name_, "\": "),
-            result);
+      if (validate_types_) {
+        absl::Status result = packet_type_->Validate(packet);
+        if (!result.ok()) {
+          return tool::AddStatusPrefix(
+              absl::StrCat(
+                  "Packet type mismatch on a calculator receiving from "
+                  "stream \"",
+                  name_, "\": "),
+              result);
+        }
       }
 
       const Timestamp timestamp = packet.Timestamp();
@@ -164,6 +168,9 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
     }
     queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
                          queue_.size() >= max_queue_size_);
+    if (queue_.size() > peak_queue_size_.load(std::memory_order_relaxed)) {
+      peak_queue_size_.store(queue_.size(), std::memory_order_relaxed);
+    }
     if (queue_.size() > 1) {
       VLOG(3) << "Queue size greater than 1: stream name: " << name_
               << " queue_size: " << queue_.size();
@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <list>
@@ -66,6 +67,11 @@ class InputStreamManager {
   // Returns true if the input stream is a back edge.
   bool BackEdge() const { return back_edge_; }
 
+  // Skips the type check of the added packets. Used when the producer of the
+  // stream validates the packets against a PacketType which the PacketType
+  // of this stream subsumes. Timestamps are still checked.
+  void DisableTypeValidation() { validate_types_ = false; }
+
   // Sets the header Packet.
   absl::Status SetHeader(const Packet& header);
 
@@ -143,6 +149,11 @@ class InputStreamManager {
   // Returns the number of packets in the queue.
   int QueueSize() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
+  // Returns the largest number of packets queued since PrepareForRun().
+  int PeakQueueSize() const {
+    return peak_queue_size_.load(std::memory_order_relaxed);
+  }
+
   // Returns true iff the queue is full.
   bool IsFull() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
@@ -204,6 +215,8 @@ class InputStreamManager {
   bool enable_timestamps_ = true;
   std::string name_;
   const PacketType* packet_type_;
+  // True if packets are checked against packet_type_.
+  bool validate_types_ = true;
   bool back_edge_;
   // The header packet of the input stream.
   Packet header_;
@@ -211,6 +224,10 @@ class InputStreamManager {
   // The maximum queue size for this stream if set.
   int max_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
 
+  // The largest queue size since PrepareForRun(). Written only by the
+  // producer, and read without locking by metrics exporters.
+  std::atomic<int> peak_queue_size_{0};
+
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
 
@@ -404,6 +404,29 @@ TEST_F(InputStreamManagerTest, BadPacketType) {
   EXPECT_FALSE(notify_);
 }
 
+TEST_F(InputStreamManagerTest, DisableTypeValidation) {
+  PacketType upstream_type;
+  upstream_type.Set<std::string>();
+  EXPECT_TRUE(packet_type_.Subsumes(upstream_type));
+  upstream_type.Set<int>();
+  EXPECT_FALSE(packet_type_.Subsumes(upstream_type));
+  upstream_type.SetAny();
+  EXPECT_FALSE(packet_type_.Subsumes(upstream_type));
+  EXPECT_TRUE(upstream_type.Subsumes(packet_type_));
+
+  // The type check is left to the producer, but timestamps are still checked.
+  input_stream_manager_->DisableTypeValidation();
+  std::list<Packet> packets;
+  packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
+  MP_EXPECT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_TRUE(notify_);
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(5)));
+  absl::Status result = input_stream_manager_->AddPackets(packets, &notify_);
+  EXPECT_THAT(result.message(),
+              testing::HasSubstr("Packet timestamp mismatch"));
+}
+
 TEST_F(InputStreamManagerTest, Close) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -781,6 +804,28 @@ TEST_F(InputStreamManagerTest, QueueSizeTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
+TEST_F(InputStreamManagerTest, PeakQueueSize) {
+  std::list<Packet> packets;
+  packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
+  packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
+  packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
+  EXPECT_EQ(0, input_stream_manager_->PeakQueueSize());
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_EQ(3, input_stream_manager_->PeakQueueSize());
+
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(20), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_EQ(1, input_stream_manager_->QueueSize());
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("packet 4").At(Timestamp(40)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_EQ(2, input_stream_manager_->QueueSize());
+  EXPECT_EQ(3, input_stream_manager_->PeakQueueSize());
+
+  input_stream_manager_->PrepareForRun();
+  EXPECT_EQ(0, input_stream_manager_->PeakQueueSize());
+}
+
 TEST_F(InputStreamManagerTest, InputReleaseTest) {
   packet_type_.Set<LifetimeTracker::Object>();
   input_stream_manager_ = absl::make_unique<InputStreamManager>();
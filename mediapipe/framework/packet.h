@@ -29,6 +29,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/no_destructor.h"
 #include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
@@ -56,6 +57,8 @@ const std::shared_ptr<HolderBase>& GetHolderShared(const Packet& packet);
 std::shared_ptr<HolderBase> GetHolderShared(Packet&& packet);
 absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
                                               const std::string& serialized);
+template <typename T, typename... Args>
+std::shared_ptr<HolderBase> MakeHolder(Args&&... args);
 }  // namespace packet_internal
 
 // A generic container class which can hold data of any type.  The type of
@@ -304,7 +307,9 @@ template <typename T,
           typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
           typename... Args>
 Packet MakePacket(Args&&... args) {  // NOLINT(build/c++11)
-  return Adopt(new T(std::forward<Args>(args)...));
+  return packet_internal::Create(
+      packet_internal::MakeHolder<T>(std::forward<Args>(args)...),
+      Timestamp::Unset());
 }
 
 // Version for arrays. We have to use reinterpret_cast because new T[N]
@@ -351,6 +356,12 @@ template <typename T>
 class Holder;
 template <typename T>
 class ForeignHolder;
+template <typename T>
+class ArenaHolder;
+// The holder type id of ArenaHolder<T>. HolderBase::As<T>() uses it to avoid
+// instantiating ArenaHolder<T>, which is not possible for abstract T.
+template <typename T>
+struct ArenaHolderTypeId {};
 
 class HolderBase {
  public:
@@ -517,6 +528,15 @@ class Holder : public HolderBase {
   absl::StatusOr<std::unique_ptr<T>> Release(
       typename std::enable_if<!std::is_array<U>::value ||
                               std::extent<U>::value != 0>::type* = 0) {
+    // The data of an ArenaHolder is stored inline, so it is moved out.
+    if (HolderIsOfType<ArenaHolderTypeId<T>>()) {
+      if constexpr (std::is_move_constructible<U>::value) {
+        return absl::make_unique<T>(std::move(*const_cast<T*>(ptr_)));
+      } else {
+        return absl::InternalError(
+            "Arena holder can't release data that is not movable.");
+      }
+    }
     // Since C++ doesn't allow virtual, templated functions, check holder
     // type here to make sure it's not upcasted from a ForeignHolder.
     if (!HolderIsOfType<Holder<T>>()) {
@@ -604,9 +624,46 @@ class ForeignHolder : public Holder<T> {
   }
 };
 
+// Like Holder, but stores its data inline, so that the data, the holder, and
+// the shared_ptr control block can be a single allocation from a PacketArena.
+template <typename T>
+class ArenaHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit ArenaHolder(Args&&... args)
+      : Holder<T>(nullptr), data_(std::forward<Args>(args)...) {
+    this->ptr_ = &data_;
+    this->template SetHolderTypeId<ArenaHolderTypeId<T>>();
+  }
+  ~ArenaHolder() override {
+    // Null out ptr_ so it doesn't get deleted by ~Holder.
+    this->ptr_ = nullptr;
+  }
+
+ private:
+  T data_;
+};
+
+// Returns a holder owning a new T constructed from |args|. If a PacketArena
+// is current on this thread and the holder is small, the holder is allocated
+// from the arena together with the data and the control block.
+template <typename T, typename... Args>
+std::shared_ptr<HolderBase> MakeHolder(Args&&... args) {
+  if constexpr (sizeof(ArenaHolder<T>) <= PacketArena::kMaxBlockSize &&
+                alignof(ArenaHolder<T>) <= alignof(std::max_align_t)) {
+    if (PacketArena* arena = PacketArena::Current()) {
+      return std::allocate_shared<ArenaHolder<T>>(
+          PacketArenaAllocator<ArenaHolder<T>>(arena),
+          std::forward<Args>(args)...);
+    }
+  }
+  return std::make_shared<Holder<T>>(new T(std::forward<Args>(args)...));
+}
+
 template <typename T>
 Holder<T>* HolderBase::As() {
-  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<ForeignHolder<T>>()) {
+  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<ForeignHolder<T>>() ||
+      HolderIsOfType<ArenaHolderTypeId<T>>()) {
     return static_cast<Holder<T>*>(this);
   }
   // Does not hold a T.
@@ -615,7 +672,8 @@ Holder<T>* HolderBase::As() {
 
 template <typename T>
 const Holder<T>* HolderBase::As() const {
-  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<ForeignHolder<T>>()) {
+  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<ForeignHolder<T>>() ||
+      HolderIsOfType<ArenaHolderTypeId<T>>()) {
     return static_cast<const Holder<T>*>(this);
   }
   // Does not hold a T.
@@ -0,0 +1,149 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <new>
+
+#include "absl/base/attributes.h"
+
+namespace mediapipe {
+namespace {
+
+// The block sizes of the pools. Each allocation is served by the smallest
+// block size that fits it.
+constexpr size_t kBlockSizes[] = {64, 128, 256, PacketArena::kMaxBlockSize};
+constexpr int kNumPools = sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+
+// The maximum number of free blocks kept in each pool of a thread. Blocks
+// freed beyond this are returned to the heap, which bounds the memory held
+// by a thread that frees more packets than it creates.
+constexpr int kMaxFreeBlocks = 256;
+
+// Returns the index of the pool for |size|, or -1 if |size| is too large.
+int PoolIndex(size_t size) {
+  for (int i = 0; i < kNumPools; ++i) {
+    if (size <= kBlockSizes[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// A free block, linked into the free list of its pool.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// The pools of free blocks of one thread.
+class ThreadPools {
+ public:
+  ~ThreadPools();
+
+  // Returns a free block from pool |index|, or nullptr if it is empty.
+  void* Pop(int index) {
+    FreeBlock* block = free_[index];
+    if (block != nullptr) {
+      free_[index] = block->next;
+      --num_free_[index];
+    }
+    return block;
+  }
+
+  // Adds |block| to pool |index|. Returns false if the pool is full.
+  bool Push(int index, void* block) {
+    if (num_free_[index] >= kMaxFreeBlocks) {
+      return false;
+    }
+    FreeBlock* free_block = static_cast<FreeBlock*>(block);
+    free_block->next = free_[index];
+    free_[index] = free_block;
+    ++num_free_[index];
+    return true;
+  }
+
+ private:
+  FreeBlock* free_[kNumPools] = {};
+  int num_free_[kNumPools] = {};
+};
+
+ABSL_CONST_INIT thread_local PacketArena* current_arena = nullptr;
+
+// Set when the pools of this thread are destroyed at thread exit, after which
+// blocks freed by the remaining thread-local objects go to the heap.
+ABSL_CONST_INIT thread_local bool thread_pools_destroyed = false;
+
+ThreadPools::~ThreadPools() {
+  for (int i = 0; i < kNumPools; ++i) {
+    while (void* block = Pop(i)) {
+      ::operator delete(block);
+    }
+  }
+  thread_pools_destroyed = true;
+}
+
+ThreadPools* GetThreadPools() {
+  if (thread_pools_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadPools thread_pools;
+  return &thread_pools;
+}
+
+}  // namespace
+
+// static
+PacketArena* PacketArena::Current() { return current_arena; }
+
+PacketArena::Scope::Scope(PacketArena* arena) : previous_(current_arena) {
+  current_arena = arena;
+}
+
+PacketArena::Scope::~Scope() { current_arena = previous_; }
+
+void* PacketArena::Allocate(size_t size) {
+  const int index = PoolIndex(size);
+  if (index < 0) {
+    return ::operator new(size);
+  }
+  packets_.fetch_add(1, std::memory_order_relaxed);
+  ThreadPools* pools = GetThreadPools();
+  void* block = pools ? pools->Pop(index) : nullptr;
+  if (block != nullptr) {
+    reused_blocks_.fetch_add(1, std::memory_order_relaxed);
+    return block;
+  }
+  return ::operator new(kBlockSizes[index]);
+}
+
+// static
+void PacketArena::Deallocate(void* block, size_t size) {
+  const int index = PoolIndex(size);
+  if (index >= 0) {
+    ThreadPools* pools = GetThreadPools();
+    if (pools != nullptr && pools->Push(index, block)) {
+      return;
+    }
+  }
+  ::operator delete(block);
+}
+
+PacketArena::Stats PacketArena::TakeStats() {
+  Stats stats;
+  stats.packets = packets_.exchange(0, std::memory_order_relaxed);
+  stats.reused_blocks = reused_blocks_.exchange(0, std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,123 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Allocates the holders of small packet payloads from thread-local pools of
+// fixed-size blocks. With a PacketArena, MakePacket<T>() stores the payload,
+// its holder, and the shared_ptr control block in a single block, instead of
+// making three heap allocations, and a block freed by a packet is reused by
+// the next packet created on the same thread.
+//
+// A CalculatorGraph with CalculatorGraphConfig.use_packet_arena owns a
+// PacketArena and makes it current on the threads running its calculators.
+// The blocks are plain heap memory, so packets may outlive the arena and may
+// be freed on any thread.
+class PacketArena {
+ public:
+  // The largest allocation served from the pools, in bytes. Larger holders
+  // are allocated from the heap.
+  static constexpr size_t kMaxBlockSize = 512;
+
+  struct Stats {
+    // The number of packet payloads allocated in the arena.
+    int64 packets = 0;
+    // The number of those served by a block reused from a thread-local pool.
+    int64 reused_blocks = 0;
+    // The number of heap allocations avoided: two per packet for the
+    // separate holder and control block, and one per reused block.
+    int64 avoided_allocations() const { return 2 * packets + reused_blocks; }
+  };
+
+  PacketArena() = default;
+  PacketArena(const PacketArena&) = delete;
+  PacketArena& operator=(const PacketArena&) = delete;
+
+  // Returns the arena that is current on this thread, or nullptr.
+  static PacketArena* Current();
+
+  // Makes an arena current on this thread for the lifetime of the Scope.
+  // |arena| may be null, which disables the arena in the scope.
+  class Scope {
+   public:
+    explicit Scope(PacketArena* arena);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    PacketArena* previous_;
+  };
+
+  // Returns a block of at least |size| bytes.
+  void* Allocate(size_t size);
+
+  // Returns a block obtained from Allocate() with the same |size| to the pool
+  // of this thread. Does not require the arena that allocated the block.
+  static void Deallocate(void* block, size_t size);
+
+  // Returns the statistics since the last call, and resets them.
+  Stats TakeStats();
+
+ private:
+  std::atomic<int64> packets_{0};
+  std::atomic<int64> reused_blocks_{0};
+};
+
+// A std allocator that allocates from a PacketArena, for use with
+// std::allocate_shared. Only allocate() refers to the arena.
+template <typename T>
+class PacketArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit PacketArenaAllocator(PacketArena* arena) : arena_(arena) {}
+  template <typename U>
+  PacketArenaAllocator(const PacketArenaAllocator<U>& other)
+      : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    PacketArena::Deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PacketArenaAllocator<U>& other) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PacketArenaAllocator<U>& other) const {
+    return false;
+  }
+
+ private:
+  template <typename U>
+  friend class PacketArenaAllocator;
+
+  PacketArena* arena_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
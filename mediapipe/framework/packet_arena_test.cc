@@ -0,0 +1,125 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+struct Point {
+  Point(float x, float y) : x(x), y(y) {}
+  float x;
+  float y;
+};
+
+TEST(PacketArenaTest, ScopeSetsCurrentArena) {
+  EXPECT_EQ(nullptr, PacketArena::Current());
+  PacketArena arena;
+  {
+    PacketArena::Scope scope(&arena);
+    EXPECT_EQ(&arena, PacketArena::Current());
+    {
+      PacketArena::Scope disabled(nullptr);
+      EXPECT_EQ(nullptr, PacketArena::Current());
+    }
+    EXPECT_EQ(&arena, PacketArena::Current());
+  }
+  EXPECT_EQ(nullptr, PacketArena::Current());
+}
+
+TEST(PacketArenaTest, MakePacketUsesArena) {
+  PacketArena arena;
+  PacketArena::Scope scope(&arena);
+  Packet packet = MakePacket<Point>(1.0f, 2.0f).At(Timestamp(5));
+  EXPECT_EQ(1.0f, packet.Get<Point>().x);
+  EXPECT_EQ(2.0f, packet.Get<Point>().y);
+  EXPECT_EQ(Timestamp(5), packet.Timestamp());
+  EXPECT_TRUE(packet.ValidateAsType<Point>().ok());
+  EXPECT_FALSE(packet.ValidateAsType<int>().ok());
+
+  PacketArena::Stats stats = arena.TakeStats();
+  EXPECT_EQ(1, stats.packets);
+  EXPECT_EQ(0, stats.reused_blocks);
+  EXPECT_EQ(2, stats.avoided_allocations());
+}
+
+TEST(PacketArenaTest, ReusesFreedBlocks) {
+  PacketArena arena;
+  PacketArena::Scope scope(&arena);
+  // Each packet frees its block for the next one.
+  for (int i = 0; i < 10; ++i) {
+    MakePacket<int>(i);
+  }
+  arena.TakeStats();
+  for (int i = 0; i < 10; ++i) {
+    Packet packet = MakePacket<int>(i);
+    EXPECT_EQ(i, packet.Get<int>());
+  }
+  PacketArena::Stats stats = arena.TakeStats();
+  EXPECT_EQ(10, stats.packets);
+  EXPECT_EQ(10, stats.reused_blocks);
+  EXPECT_EQ(30, stats.avoided_allocations());
+}
+
+struct Large {
+  char data[PacketArena::kMaxBlockSize];
+};
+
+TEST(PacketArenaTest, LargePayloadUsesHeap) {
+  PacketArena arena;
+  PacketArena::Scope scope(&arena);
+  Packet packet = MakePacket<Large>();
+  EXPECT_TRUE(packet.ValidateAsType<Large>().ok());
+  EXPECT_EQ(0, arena.TakeStats().packets);
+}
+
+TEST(PacketArenaTest, PacketOutlivesArena) {
+  Packet packet;
+  {
+    auto arena = absl::make_unique<PacketArena>();
+    PacketArena::Scope scope(arena.get());
+    packet = MakePacket<std::string>("payload");
+  }
+  EXPECT_EQ("payload", packet.Get<std::string>());
+}
+
+TEST(PacketArenaTest, ConsumeMovesDataOutOfArena) {
+  PacketArena arena;
+  PacketArena::Scope scope(&arena);
+  Packet packet = MakePacket<std::string>("payload");
+  auto result = packet.Consume<std::string>();
+  MP_ASSERT_OK(result);
+  EXPECT_EQ("payload", *result.value());
+  EXPECT_TRUE(packet.IsEmpty());
+
+  Packet shared = MakePacket<std::string>("shared");
+  Packet copy = shared;
+  bool was_copied = false;
+  auto copied = shared.ConsumeOrCopy<std::string>(&was_copied);
+  MP_ASSERT_OK(copied);
+  EXPECT_TRUE(was_copied);
+  EXPECT_EQ("shared", copy.Get<std::string>());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -176,6 +176,27 @@ bool PacketType::IsConsistentWith(const PacketType& other) const {
   return type1->validate_method_ == type2->validate_method_;
 }
 
+bool PacketType::Subsumes(const PacketType& other) const {
+  const PacketType* type1 = GetSameAs();
+  const PacketType* type2 = other.GetSameAs();
+
+  if (!type1->initialized_ || !type2->initialized_) {
+    return false;
+  }
+  if (type2->no_packets_allowed_) {
+    // type2 accepts nothing.
+    return true;
+  }
+  if (type1->no_packets_allowed_) {
+    return false;
+  }
+  if (type1->validate_method_ == nullptr) {
+    // type1 accepts any non-empty packet, and type2 rejects empty packets.
+    return true;
+  }
+  return type1->validate_method_ == type2->validate_method_;
+}
+
 absl::Status ValidatePacketTypeSet(const PacketTypeSet& packet_type_set) {
   std::vector<std::string> errors;
   if (packet_type_set.GetErrorHandler().HasError()) {
@@ -86,6 +86,11 @@ class PacketType {
   // IsNone() is only consistent with IsNone() and IsAny().
   bool IsConsistentWith(const PacketType& other) const;
 
+  // Returns true iff every packet accepted by other is also accepted by
+  // this PacketType, so that a packet validated against other does not
+  // need to be validated against this PacketType again.
+  bool Subsumes(const PacketType& other) const;
+
   // Returns OK if the packet contains an object of the appropriate type.
   absl::Status Validate(const Packet& packet) const;
 
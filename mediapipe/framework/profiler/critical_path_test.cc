@@ -0,0 +1,234 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/reporter/critical_path.h"
+
+#include <sstream>
+#include <string>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+using reporter::CriticalPathAnalyzer;
+using reporter::CriticalPathReport;
+using ::testing::HasSubstr;
+
+// Node A and node B both read "input". Node C reads the outputs of A and B.
+//
+// At timestamp 100, A (400 usec) is slower than B (100 usec), so the critical
+// path is A, C.  At timestamp 101, B (600 usec) is slower than A (100 usec),
+// so the critical path is B, C.
+GraphProfile DiamondProfile() {
+  return ParseTextProtoOrDie<GraphProfile>(R"pb(
+    graph_trace {
+      base_time: 1000000
+      base_timestamp: 100
+      calculator_name: [ "A", "B", "C" ]
+      stream_name: [ "", "input", "a_c", "b_c" ]
+
+      calculator_trace {
+        node_id: -1
+        input_timestamp: 0
+        event_type: PROCESS
+        finish_time: 1000
+        output_trace { packet_timestamp: 0 stream_id: 1 }
+      }
+      calculator_trace {
+        node_id: 0
+        input_timestamp: 0
+        event_type: PROCESS
+        start_time: 1100
+        finish_time: 1500
+        input_trace { packet_timestamp: 0 stream_id: 1 }
+        output_trace { packet_timestamp: 0 stream_id: 2 }
+      }
+      calculator_trace {
+        node_id: 1
+        input_timestamp: 0
+        event_type: PROCESS
+        start_time: 1100
+        finish_time: 1200
+        input_trace { packet_timestamp: 0 stream_id: 1 }
+        output_trace { packet_timestamp: 0 stream_id: 3 }
+      }
+      calculator_trace {
+        node_id: 2
+        input_timestamp: 0
+        event_type: PROCESS
+        start_time: 1600
+        finish_time: 1800
+        input_trace { packet_timestamp: 0 stream_id: 2 }
+        input_trace { packet_timestamp: 0 stream_id: 3 }
+      }
+
+      calculator_trace {
+        node_id: -1
+        input_timestamp: 1
+        event_type: PROCESS
+        finish_time: 2000
+        output_trace { packet_timestamp: 1 stream_id: 1 }
+      }
+      calculator_trace {
+        node_id: 0
+        input_timestamp: 1
+        event_type: PROCESS
+        start_time: 2000
+        finish_time: 2100
+        input_trace { packet_timestamp: 1 stream_id: 1 }
+        output_trace { packet_timestamp: 1 stream_id: 2 }
+      }
+      calculator_trace {
+        node_id: 1
+        input_timestamp: 1
+        event_type: PROCESS
+        start_time: 2000
+        finish_time: 2600
+        input_trace { packet_timestamp: 1 stream_id: 1 }
+        output_trace { packet_timestamp: 1 stream_id: 3 }
+      }
+      calculator_trace {
+        node_id: 2
+        input_timestamp: 1
+        event_type: PROCESS
+        start_time: 2600
+        finish_time: 2700
+        input_trace { packet_timestamp: 1 stream_id: 2 }
+        input_trace { packet_timestamp: 1 stream_id: 3 }
+      }
+    }
+  )pb");
+}
+
+TEST(CriticalPathTest, FindsCriticalPath) {
+  CriticalPathAnalyzer analyzer;
+  analyzer.Accumulate(DiamondProfile());
+  auto report = analyzer.Report();
+  ASSERT_EQ(2, report->frames().size());
+
+  const auto& frame = report->frames()[0];
+  EXPECT_EQ(100, frame.timestamp);
+  EXPECT_EQ(800, frame.latency());
+  EXPECT_EQ(600, frame.span());
+  EXPECT_EQ(700, frame.work);
+  ASSERT_EQ(2, frame.critical_path.size());
+  EXPECT_EQ("A", frame.critical_path[0].name);
+  EXPECT_EQ(100, frame.critical_path[0].wait_time);
+  EXPECT_EQ(400, frame.critical_path[0].process_time);
+  EXPECT_EQ("C", frame.critical_path[1].name);
+  EXPECT_EQ(100, frame.critical_path[1].wait_time);
+  EXPECT_EQ(200, frame.critical_path[1].process_time);
+
+  const auto& next_frame = report->frames()[1];
+  EXPECT_EQ(101, next_frame.timestamp);
+  EXPECT_EQ(700, next_frame.latency());
+  ASSERT_EQ(2, next_frame.critical_path.size());
+  EXPECT_EQ("B", next_frame.critical_path[0].name);
+  EXPECT_EQ("C", next_frame.critical_path[1].name);
+}
+
+TEST(CriticalPathTest, ComputesSlack) {
+  CriticalPathAnalyzer analyzer;
+  analyzer.Accumulate(DiamondProfile());
+  auto report = analyzer.Report();
+  const auto& data = report->calculator_data();
+
+  // B could finish 300 usec later at timestamp 100, and A 500 usec later at
+  // timestamp 101, without delaying C.
+  EXPECT_EQ(2, data.at("A").frames);
+  EXPECT_EQ(1, data.at("A").critical_frames);
+  EXPECT_EQ(0, data.at("A").min_slack);
+  EXPECT_DOUBLE_EQ(250, data.at("A").slack_stat.mean());
+  EXPECT_EQ(1, data.at("B").critical_frames);
+  EXPECT_DOUBLE_EQ(150, data.at("B").slack_stat.mean());
+  EXPECT_EQ(2, data.at("C").critical_frames);
+  EXPECT_DOUBLE_EQ(0, data.at("C").slack_stat.mean());
+
+  // Frame 100 has work 700 and span 600; frame 101 has work 800 and span 700.
+  EXPECT_DOUBLE_EQ(1500.0 / 1300.0, report->parallelism());
+  EXPECT_DOUBLE_EQ(750, report->latency_mean());
+}
+
+TEST(CriticalPathTest, JoinsStartAndFinishAcrossTraces) {
+  // The GraphTracer can log the start and finish of a Process call in
+  // successive GraphTraces.
+  GraphProfile profile = ParseTextProtoOrDie<GraphProfile>(R"pb(
+    graph_trace {
+      base_time: 0
+      base_timestamp: 0
+      calculator_name: [ "A", "B" ]
+      stream_name: [ "", "input", "a_b" ]
+      calculator_trace {
+        node_id: 0
+        input_timestamp: 5
+        event_type: PROCESS
+        start_time: 100
+        finish_time: 300
+        input_trace { packet_timestamp: 5 stream_id: 1 start_time: 50 }
+        output_trace { packet_timestamp: 5 stream_id: 2 }
+      }
+      calculator_trace {
+        node_id: 1
+        input_timestamp: 5
+        event_type: PROCESS
+        start_time: 350
+        input_trace { packet_timestamp: 5 stream_id: 2 }
+      }
+    }
+    graph_trace {
+      base_time: 400
+      base_timestamp: 0
+      calculator_name: [ "A", "B" ]
+      stream_name: [ "", "input", "a_b" ]
+      calculator_trace {
+        node_id: 1
+        input_timestamp: 5
+        event_type: PROCESS
+        finish_time: 100
+      }
+    }
+  )pb");
+  CriticalPathAnalyzer analyzer;
+  analyzer.Accumulate(profile);
+  auto report = analyzer.Report();
+  ASSERT_EQ(1, report->frames().size());
+  const auto& frame = report->frames()[0];
+  EXPECT_EQ(450, frame.latency());
+  ASSERT_EQ(2, frame.critical_path.size());
+  EXPECT_EQ(50, frame.critical_path[0].wait_time);
+  EXPECT_EQ(50, frame.critical_path[1].wait_time);
+  EXPECT_EQ(150, frame.critical_path[1].process_time);
+}
+
+TEST(CriticalPathTest, PrintsSlowestFrames) {
+  CriticalPathAnalyzer analyzer;
+  analyzer.Accumulate(DiamondProfile());
+  auto report = analyzer.Report();
+
+  std::stringstream summary;
+  report->Print(summary);
+  EXPECT_THAT(summary.str(), HasSubstr("frames 2, latency_mean 750.00"));
+
+  std::stringstream slowest;
+  report->PrintSlowestFrames(slowest, 1);
+  EXPECT_THAT(slowest.str(), HasSubstr("timestamp 100: latency 800"));
+  EXPECT_THAT(slowest.str(), ::testing::Not(HasSubstr("timestamp 101")));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -257,6 +257,24 @@ absl::Status GraphProfiler::Start(mediapipe::Executor* executor) {
       }
     });
   }
+  if (is_tracing_ && tracer() &&
+      !profiler_config_.trace_stream_path().empty()) {
+    std::vector<std::string> node_names;
+    for (int node_id = 0;
+         node_id < validated_graph_->CalculatorInfos().size(); ++node_id) {
+      node_names.push_back(
+          tool::CanonicalNodeName(validated_graph_->Config(), node_id));
+    }
+    trace_stream_writer_ = absl::make_unique<TraceStreamWriter>(
+        &tracer()->GetTraceBuffer(), std::move(node_names),
+        tracer()->GetTraceLogInterval());
+    MP_RETURN_IF_ERROR(
+        trace_stream_writer_->Start(profiler_config_.trace_stream_path()));
+    // Wakes the writer before a burst of events overwrites unread ones.
+    TraceStreamWriter* writer = trace_stream_writer_.get();
+    tracer()->SetBufferHalfFullCallback([writer] { writer->Wake(); });
+    LOG(INFO) << "trace_stream_path: " << profiler_config_.trace_stream_path();
+  }
   return absl::OkStatus();
 }
 
@@ -264,6 +282,12 @@ absl::Status GraphProfiler::Start(mediapipe::Executor* executor) {
 absl::Status GraphProfiler::Stop() {
   is_running_ = false;
   Pause();
+  if (trace_stream_writer_) {
+    tracer()->SetBufferHalfFullCallback(nullptr);
+    absl::Status status = trace_stream_writer_->Stop();
+    trace_stream_writer_.reset();
+    MP_RETURN_IF_ERROR(status);
+  }
   // If specified, write a final profile.
   if (IsTraceLogEnabled(profiler_config_)) {
     MP_RETURN_IF_ERROR(WriteProfile());
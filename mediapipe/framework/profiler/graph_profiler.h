@@ -32,6 +32,7 @@
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/profiler/graph_tracer.h"
 #include "mediapipe/framework/profiler/sharded_map.h"
+#include "mediapipe/framework/profiler/trace_stream_writer.h"
 #include "mediapipe/framework/validated_graph_config.h"
 
 namespace mediapipe {
@@ -329,6 +330,9 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Inidicates that profiling has started and not yet stopped.
   std::atomic_bool is_running_;
 
+  // Streams trace events to ProfilerConfig::trace_stream_path while running.
+  std::unique_ptr<TraceStreamWriter> trace_stream_writer_;
+
   // The end time of the previous output log.
   absl::Time previous_log_end_time_;
 
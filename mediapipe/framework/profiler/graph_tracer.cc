@@ -37,6 +37,11 @@ inline int GetCurrentThreadId() {
   return thread_id;
 }
 
+// Returns the absolute index of the end of |buffer|.
+int64 EndIndex(const TraceBuffer& buffer) {
+  return buffer.end() - TraceBuffer::iterator(&buffer, 0);
+}
+
 }  // namespace
 
 absl::Duration GraphTracer::GetTraceLogInterval() {
@@ -69,6 +74,33 @@ void GraphTracer::LogEvent(TraceEvent event) {
   }
   event.set_thread_id(GetCurrentThreadId());
   trace_buffer_.push_back(event);
+  if (EndIndex(trace_buffer_) >=
+      next_callback_index_.load(std::memory_order_relaxed)) {
+    MaybeRunBufferHalfFullCallback();
+  }
+}
+
+void GraphTracer::SetBufferHalfFullCallback(std::function<void()> callback) {
+  absl::MutexLock lock(&callback_mutex_);
+  buffer_half_full_callback_ = std::move(callback);
+  next_callback_index_.store(
+      buffer_half_full_callback_
+          ? EndIndex(trace_buffer_) + GetTraceLogCapacity() / 2
+          : kint64max,
+      std::memory_order_relaxed);
+}
+
+void GraphTracer::MaybeRunBufferHalfFullCallback() {
+  absl::MutexLock lock(&callback_mutex_);
+  const int64 end = EndIndex(trace_buffer_);
+  // Another thread may have run the callback in the meantime.
+  if (!buffer_half_full_callback_ ||
+      end < next_callback_index_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  next_callback_index_.store(end + GetTraceLogCapacity() / 2,
+                             std::memory_order_relaxed);
+  buffer_half_full_callback_();
 }
 
 void GraphTracer::LogInputEvents(GraphTrace::EventType event_type,
@@ -15,8 +15,12 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 
+#include <atomic>
+#include <functional>
 #include <string>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
@@ -30,6 +34,8 @@ namespace mediapipe {
 //
 // GraphTracer is thread-safe, and the Log* methods are also non-blocking
 // so they can be called during graph execution with mimimal overhead.
+// The only exception is the buffer-half-full callback, which runs under a
+// mutex once for every half capacity of logged events.
 //
 // The method GetTrace returns the events for a range of recent Timestamps.
 // The begin_ts should be the first timestamp completely enclosed in the
@@ -81,7 +87,19 @@ class GraphTracer {
   // Returns the logged TraceEvents.
   const TraceBuffer& GetTraceBuffer();
 
+  // Calls |callback| from LogEvent() each time another half of the buffer
+  // capacity has been logged, so that a reader can read the events before
+  // they are overwritten. |callback| must not block or log events. A null
+  // |callback| disables it. Once this returns, the previous callback is
+  // neither running nor called again.
+  void SetBufferHalfFullCallback(std::function<void()> callback)
+      ABSL_LOCKS_EXCLUDED(callback_mutex_);
+
  private:
+  // Calls the buffer-half-full callback if the buffer has reached
+  // next_callback_index_.
+  void MaybeRunBufferHalfFullCallback() ABSL_LOCKS_EXCLUDED(callback_mutex_);
+
   // Returns the timestamp of the first output packet.
   Timestamp GetOutputTimestamp(const CalculatorContext* context);
 
@@ -93,6 +111,13 @@ class GraphTracer {
 
   // The builder for the GraphTrace protobuf.
   TraceBuilder trace_builder_;
+
+  absl::Mutex callback_mutex_;
+  std::function<void()> buffer_half_full_callback_
+      ABSL_GUARDED_BY(callback_mutex_);
+  // The absolute buffer index at which the callback runs next. Read without
+  // the mutex on every logged event.
+  std::atomic<int64> next_callback_index_{kint64max};
 };
 
 }  // namespace mediapipe
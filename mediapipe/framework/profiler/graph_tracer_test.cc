@@ -329,6 +329,26 @@ TEST_F(GraphTracerTest, GraphTrace) {
   EXPECT_EQ(4, trace.calculator_trace().size());
 }
 
+TEST_F(GraphTracerTest, CallsBufferHalfFullCallback) {
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  profiler_config.set_trace_log_capacity(10);
+  tracer_ = absl::make_unique<GraphTracer>(profiler_config);
+  int num_calls = 0;
+  tracer_->SetBufferHalfFullCallback([&num_calls] { ++num_calls; });
+  for (int i = 0; i < 24; ++i) {
+    tracer_->LogEvent(TraceEvent(GraphTrace::PROCESS).set_node_id(0));
+  }
+  // Once after every 5 events.
+  EXPECT_EQ(4, num_calls);
+
+  tracer_->SetBufferHalfFullCallback(nullptr);
+  for (int i = 0; i < 10; ++i) {
+    tracer_->LogEvent(TraceEvent(GraphTrace::PROCESS).set_node_id(0));
+  }
+  EXPECT_EQ(4, num_calls);
+}
+
 // Tests showing GraphTracer logging packet latencies.
 class GraphTracerE2ETest : public ::testing::Test {
  protected:
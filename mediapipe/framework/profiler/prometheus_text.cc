@@ -0,0 +1,233 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/prometheus_text.h"
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+namespace {
+
+using Labels = std::vector<std::pair<absl::string_view, std::string>>;
+
+// Returns a label value with backslash, quote and newline escaped.
+std::string EscapeLabelValue(absl::string_view value) {
+  std::string result;
+  result.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      result.push_back('\\');
+      result.push_back(c);
+    } else if (c == '\n') {
+      result += "\\n";
+    } else {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+// Formats a time in microseconds as seconds, without loss of precision.
+std::string Seconds(double usec) { return absl::StrFormat("%.6f", usec / 1e6); }
+
+// Appends metric families and their samples to a text exposition.
+class TextBuilder {
+ public:
+  explicit TextBuilder(absl::string_view graph_name)
+      : graph_label_(EscapeLabelValue(graph_name)) {}
+
+  // Starts a metric family.  |type| is "counter", "gauge" or "summary".
+  void AddFamily(absl::string_view name, absl::string_view type,
+                 absl::string_view help) {
+    absl::StrAppend(&text_, "# HELP ", name, " ", help, "\n", "# TYPE ", name,
+                    " ", type, "\n");
+  }
+
+  // Adds a sample to the current metric family.
+  void AddSample(absl::string_view name, const Labels& labels,
+                 absl::string_view value) {
+    absl::StrAppend(&text_, name, "{graph=\"", graph_label_, "\"");
+    for (const auto& label : labels) {
+      absl::StrAppend(&text_, ",", label.first, "=\"",
+                      EscapeLabelValue(label.second), "\"");
+    }
+    absl::StrAppend(&text_, "} ", value, "\n");
+  }
+  void AddSample(absl::string_view name, const Labels& labels, int64 value) {
+    AddSample(name, labels, absl::StrCat(value));
+  }
+
+  std::string text() && { return std::move(text_); }
+
+ private:
+  const std::string graph_label_;
+  std::string text_;
+};
+
+}  // namespace
+
+std::string GraphMetricsToPrometheusText(const GraphMetrics& metrics,
+                                         absl::string_view graph_name) {
+  TextBuilder builder(graph_name);
+
+  builder.AddFamily("mediapipe_node_process_seconds", "summary",
+                    "Calculator Process() time.");
+  for (const auto& node : metrics.node()) {
+    const std::pair<double, double> quantiles[] = {
+        {0.5, node.process_time_p50_usec()},
+        {0.9, node.process_time_p90_usec()},
+        {0.99, node.process_time_p99_usec()}};
+    for (const auto& quantile : quantiles) {
+      builder.AddSample(
+          "mediapipe_node_process_seconds",
+          {{"node", node.name()}, {"quantile", absl::StrCat(quantile.first)}},
+          Seconds(quantile.second));
+    }
+    builder.AddSample("mediapipe_node_process_seconds_sum",
+                      {{"node", node.name()}},
+                      Seconds(node.process_time_usec()));
+    builder.AddSample("mediapipe_node_process_seconds_count",
+                      {{"node", node.name()}}, node.process_count());
+  }
+
+  builder.AddFamily("mediapipe_node_throttled", "gauge",
+                    "1 if the source node is throttled by a full input "
+                    "stream downstream.");
+  for (const auto& node : metrics.node()) {
+    builder.AddSample("mediapipe_node_throttled", {{"node", node.name()}},
+                      node.throttled() ? 1 : 0);
+  }
+  builder.AddFamily("mediapipe_node_throttle_total", "counter",
+                    "Number of times the source node became throttled.");
+  for (const auto& node : metrics.node()) {
+    builder.AddSample("mediapipe_node_throttle_total", {{"node", node.name()}},
+                      node.throttle_count());
+  }
+
+  builder.AddFamily("mediapipe_graph_input_stream_throttled", "gauge",
+                    "1 if adding packets to the graph input stream is "
+                    "throttled by a full input stream downstream.");
+  for (const auto& stream : metrics.graph_input_stream()) {
+    builder.AddSample("mediapipe_graph_input_stream_throttled",
+                      {{"stream", stream.name()}}, stream.throttled() ? 1 : 0);
+  }
+  builder.AddFamily("mediapipe_graph_input_stream_throttle_total", "counter",
+                    "Number of times the graph input stream became "
+                    "throttled.");
+  for (const auto& stream : metrics.graph_input_stream()) {
+    builder.AddSample("mediapipe_graph_input_stream_throttle_total",
+                      {{"stream", stream.name()}}, stream.throttle_count());
+  }
+
+  builder.AddFamily("mediapipe_input_stream_queue_size", "gauge",
+                    "Number of packets queued on the input stream.");
+  for (const auto& stream : metrics.input_stream()) {
+    builder.AddSample("mediapipe_input_stream_queue_size",
+                      {{"node", stream.node()}, {"stream", stream.name()}},
+                      stream.queue_size());
+  }
+  builder.AddFamily("mediapipe_input_stream_peak_queue_size", "gauge",
+                    "Largest number of packets queued on the input stream in "
+                    "this run.");
+  for (const auto& stream : metrics.input_stream()) {
+    builder.AddSample("mediapipe_input_stream_peak_queue_size",
+                      {{"node", stream.node()}, {"stream", stream.name()}},
+                      stream.peak_queue_size());
+  }
+  builder.AddFamily("mediapipe_input_stream_max_queue_size", "gauge",
+                    "Queue size at which upstream sources are throttled, or "
+                    "-1.");
+  for (const auto& stream : metrics.input_stream()) {
+    builder.AddSample("mediapipe_input_stream_max_queue_size",
+                      {{"node", stream.node()}, {"stream", stream.name()}},
+                      stream.max_queue_size());
+  }
+
+  builder.AddFamily("mediapipe_executor_busy_seconds_total", "counter",
+                    "Time spent running calculator methods on the executor.");
+  for (const auto& executor : metrics.executor()) {
+    builder.AddSample("mediapipe_executor_busy_seconds_total",
+                      {{"executor", executor.name()}},
+                      Seconds(executor.busy_time_usec()));
+  }
+  builder.AddFamily("mediapipe_executor_utilization", "gauge",
+                    "Busy time per thread over the graph run time.");
+  for (const auto& executor : metrics.executor()) {
+    // The utilization of an executor with an unknown thread count is unset.
+    if (!executor.has_utilization()) {
+      continue;
+    }
+    builder.AddSample("mediapipe_executor_utilization",
+                      {{"executor", executor.name()}},
+                      absl::StrCat(executor.utilization()));
+  }
+  builder.AddFamily("mediapipe_executor_queued_nodes", "gauge",
+                    "Number of nodes ready to run and waiting for a thread.");
+  for (const auto& executor : metrics.executor()) {
+    builder.AddSample("mediapipe_executor_queued_nodes",
+                      {{"executor", executor.name()}},
+                      executor.queued_nodes());
+  }
+
+  builder.AddFamily("mediapipe_buffer_pool_hits_total", "counter",
+                    "Number of buffer requests served with a reused buffer.");
+  for (const auto& pool : metrics.buffer_pool()) {
+    builder.AddSample("mediapipe_buffer_pool_hits_total",
+                      {{"pool", pool.name()}}, pool.hit_count());
+  }
+  builder.AddFamily("mediapipe_buffer_pool_misses_total", "counter",
+                    "Number of buffer requests served with a newly allocated "
+                    "buffer.");
+  for (const auto& pool : metrics.buffer_pool()) {
+    builder.AddSample("mediapipe_buffer_pool_misses_total",
+                      {{"pool", pool.name()}}, pool.miss_count());
+  }
+  builder.AddFamily("mediapipe_buffer_pool_allocated_bytes", "gauge",
+                    "Bytes held by the pooled buffers, in use or available.");
+  for (const auto& pool : metrics.buffer_pool()) {
+    builder.AddSample("mediapipe_buffer_pool_allocated_bytes",
+                      {{"pool", pool.name()}}, pool.allocated_bytes());
+  }
+  builder.AddFamily("mediapipe_buffer_pool_peak_allocated_bytes", "gauge",
+                    "Largest number of bytes held by the pooled buffers.");
+  for (const auto& pool : metrics.buffer_pool()) {
+    builder.AddSample("mediapipe_buffer_pool_peak_allocated_bytes",
+                      {{"pool", pool.name()}}, pool.peak_allocated_bytes());
+  }
+  return std::move(builder).text();
+}
+
+absl::Status WritePrometheusTextFile(const GraphMetrics& metrics,
+                                     absl::string_view graph_name,
+                                     const std::string& path) {
+  const std::string temp_path = absl::StrCat(path, ".tmp");
+  MP_RETURN_IF_ERROR(file::SetContents(
+      temp_path, GraphMetricsToPrometheusText(metrics, graph_name)));
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    return absl::UnavailableError(
+        absl::StrCat("Failed to rename ", temp_path, " to ", path));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,48 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_PROMETHEUS_TEXT_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_PROMETHEUS_TEXT_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Formats a GraphMetrics snapshot in the Prometheus text exposition format
+// (version 0.0.4).  Every sample carries a "graph" label with |graph_name|,
+// so that the metrics of several graphs in one process can be told apart.
+// Times are converted to seconds, following the Prometheus conventions.
+//
+// Example:
+//
+//   GraphMetrics metrics;
+//   MP_RETURN_IF_ERROR(graph.GetGraphMetrics(&metrics));
+//   std::string text = GraphMetricsToPrometheusText(metrics, "face_mesh");
+std::string GraphMetricsToPrometheusText(const GraphMetrics& metrics,
+                                         absl::string_view graph_name);
+
+// Writes GraphMetricsToPrometheusText to |path|, replacing the file
+// atomically, so that a scraper such as the node_exporter textfile collector
+// never reads a partial file.
+absl::Status WritePrometheusTextFile(const GraphMetrics& metrics,
+                                     absl::string_view graph_name,
+                                     const std::string& path);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_PROMETHEUS_TEXT_H_
@@ -0,0 +1,135 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/prometheus_text.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+GraphMetrics MakeMetrics() {
+  return ParseTextProtoOrDie<GraphMetrics>(R"pb(
+    node {
+      name: "detector"
+      process_count: 4
+      process_time_usec: 2000500
+      process_time_p50_usec: 250
+      process_time_p90_usec: 1500
+      process_time_p99_usec: 2000000
+      throttled: true
+      throttle_count: 3
+    }
+    input_stream {
+      node: "detector"
+      name: "input_video"
+      queue_size: 2
+      peak_queue_size: 5
+      max_queue_size: 10
+    }
+    graph_input_stream { name: "input_video" throttled: false }
+    executor {
+      name: ""
+      num_threads: 4
+      busy_time_usec: 1000000
+      run_time_usec: 500000
+      utilization: 0.5
+      queued_nodes: 1
+    }
+    executor { name: "custom" busy_time_usec: 250000 run_time_usec: 500000 }
+    buffer_pool {
+      name: "image_frames"
+      hit_count: 28
+      miss_count: 2
+      allocated_bytes: 12441600
+      peak_allocated_bytes: 18662400
+    }
+  )pb");
+}
+
+TEST(PrometheusTextTest, FormatsMetrics) {
+  const std::string text = GraphMetricsToPrometheusText(MakeMetrics(), "g");
+  const std::string expected_lines[] = {
+      "# TYPE mediapipe_node_process_seconds summary\n",
+      "mediapipe_node_process_seconds{graph=\"g\",node=\"detector\","
+      "quantile=\"0.5\"} 0.000250\n",
+      "mediapipe_node_process_seconds{graph=\"g\",node=\"detector\","
+      "quantile=\"0.99\"} 2.000000\n",
+      "mediapipe_node_process_seconds_sum{graph=\"g\",node=\"detector\"} "
+      "2.000500\n",
+      "mediapipe_node_process_seconds_count{graph=\"g\",node=\"detector\"} 4\n",
+      "mediapipe_node_throttled{graph=\"g\",node=\"detector\"} 1\n",
+      "mediapipe_node_throttle_total{graph=\"g\",node=\"detector\"} 3\n",
+      "mediapipe_graph_input_stream_throttled{graph=\"g\","
+      "stream=\"input_video\"} 0\n",
+      "mediapipe_input_stream_queue_size{graph=\"g\",node=\"detector\","
+      "stream=\"input_video\"} 2\n",
+      "mediapipe_input_stream_peak_queue_size{graph=\"g\",node=\"detector\","
+      "stream=\"input_video\"} 5\n",
+      "mediapipe_input_stream_max_queue_size{graph=\"g\",node=\"detector\","
+      "stream=\"input_video\"} 10\n",
+      "# TYPE mediapipe_executor_busy_seconds_total counter\n",
+      "mediapipe_executor_busy_seconds_total{graph=\"g\",executor=\"\"} "
+      "1.000000\n",
+      "mediapipe_executor_busy_seconds_total{graph=\"g\",executor=\"custom\"} "
+      "0.250000\n",
+      "mediapipe_executor_utilization{graph=\"g\",executor=\"\"} 0.5\n",
+      "mediapipe_executor_queued_nodes{graph=\"g\",executor=\"\"} 1\n",
+      "mediapipe_buffer_pool_hits_total{graph=\"g\",pool=\"image_frames\"} "
+      "28\n",
+      "mediapipe_buffer_pool_misses_total{graph=\"g\","
+      "pool=\"image_frames\"} 2\n",
+      "mediapipe_buffer_pool_allocated_bytes{graph=\"g\","
+      "pool=\"image_frames\"} 12441600\n",
+      "mediapipe_buffer_pool_peak_allocated_bytes{graph=\"g\","
+      "pool=\"image_frames\"} 18662400\n",
+  };
+  for (const std::string& line : expected_lines) {
+    EXPECT_TRUE(absl::StrContains(text, line)) << line << "\nin:\n" << text;
+  }
+  // The "custom" executor has no utilization.
+  EXPECT_FALSE(absl::StrContains(
+      text, "mediapipe_executor_utilization{graph=\"g\",executor=\"custom\"}"))
+      << text;
+}
+
+TEST(PrometheusTextTest, EscapesLabelValues) {
+  GraphMetrics metrics;
+  metrics.add_node()->set_name("a\"b\\c");
+  const std::string text = GraphMetricsToPrometheusText(metrics, "x\ny");
+  EXPECT_TRUE(absl::StrContains(
+      text, "mediapipe_node_throttled{graph=\"x\\ny\",node=\"a\\\"b\\\\c\"} 0"))
+      << text;
+}
+
+TEST(PrometheusTextTest, WritesFile) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/mediapipe.prom");
+  MP_ASSERT_OK(WritePrometheusTextFile(MakeMetrics(), "g", path));
+  std::string contents;
+  MP_ASSERT_OK(file::GetContents(path, &contents));
+  EXPECT_EQ(GraphMetricsToPrometheusText(MakeMetrics(), "g"), contents);
+}
+
+}  // namespace
+}  // namespace mediapipe
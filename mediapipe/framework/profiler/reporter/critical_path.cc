@@ -0,0 +1,398 @@
+#include "mediapipe/framework/profiler/reporter/critical_path.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/optional.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace mediapipe {
+namespace reporter {
+namespace {
+
+std::string ToStringF(double d) { return absl::StrFormat("%1.2f", d); }
+
+// Identifies a packet by its timestamp and stream ID.
+typedef std::pair<int64_t, int32_t> PacketKey;
+
+// An input packet of a Process call.
+struct InputPacket {
+  PacketKey key;
+
+  // The time at which the packet was output, if it was traced.
+  absl::optional<int64_t> sent_time;
+};
+
+// A Process call, merged from the CalculatorTraces for one node and one input
+// timestamp. Times are in microseconds since the epoch.
+struct Task {
+  absl::optional<int64_t> start_time;
+  absl::optional<int64_t> finish_time;
+  std::vector<InputPacket> inputs;
+};
+
+// A completed Process call within the dependency DAG of one frame.
+struct Call {
+  int64_t start_time = 0;
+  int64_t finish_time = 0;
+
+  // The arrival of the last input packet.
+  int64_t ready_time = 0;
+
+  // The call that produced the last input packet, or -1 if the packet came
+  // from outside the frame.
+  int32_t predecessor = -1;
+
+  // The calls in the frame that consumed an output packet of this call.
+  std::set<int32_t> successors;
+
+  // See CriticalPathData::slack_stat.
+  absl::optional<int64_t> slack;
+};
+
+// Maps node IDs to completed calls within a frame.
+typedef std::map<int32_t, Call> CallMap;
+
+// Computes the slack of a call from the slack of its successors. A successor
+// can start when its last input packet arrives, so this call can finish as
+// late as the successor's ready_time plus the successor's own slack.
+int64_t ComputeSlack(int32_t node_id, int64_t frame_finish_time,
+                     CallMap* calls, std::set<int32_t>* visiting) {
+  Call& call = (*calls)[node_id];
+  if (call.slack) {
+    return *call.slack;
+  }
+  // A cycle can only arise from back edges within one timestamp. Ignore them.
+  visiting->insert(node_id);
+  int64_t slack = frame_finish_time - call.finish_time;
+  for (int32_t successor_id : call.successors) {
+    if (visiting->count(successor_id)) {
+      continue;
+    }
+    const int64_t successor_slack =
+        ComputeSlack(successor_id, frame_finish_time, calls, visiting);
+    const Call& successor = (*calls)[successor_id];
+    slack = std::min(slack, successor.ready_time - call.finish_time +
+                                successor_slack);
+  }
+  visiting->erase(node_id);
+  call.slack = std::max<int64_t>(slack, 0);
+  return *call.slack;
+}
+
+// Prints rows of strings, with each column padded to its widest value.
+void PrintTable(const std::vector<std::vector<std::string>>& rows,
+                const std::string& indent, std::ostream& output) {
+  std::vector<size_t> widths;
+  for (const auto& row : rows) {
+    widths.resize(std::max(widths.size(), row.size()));
+    for (size_t i = 0; i < row.size(); ++i) {
+      widths[i] = std::max(widths[i], row[i].size());
+    }
+  }
+  for (const auto& row : rows) {
+    output << indent;
+    for (size_t i = 0; i < row.size(); ++i) {
+      std::string column = row[i];
+      if (i + 1 < row.size()) {
+        column.append(widths[i] + 1 - column.size(), ' ');
+      }
+      output << column;
+    }
+    output << std::endl;
+  }
+}
+
+}  // namespace
+
+int64_t FrameData::span() const {
+  int64_t result = 0;
+  for (const auto& step : critical_path) {
+    result += step.process_time;
+  }
+  return result;
+}
+
+void CriticalPathAnalyzer::Accumulate(const mediapipe::GraphProfile& profile) {
+  // Process calls indexed by input timestamp and node ID.
+  std::map<int64_t, std::map<int32_t, Task>> tasks;
+  // The input timestamp and node ID of the call that output each packet.
+  std::map<PacketKey, std::pair<int64_t, int32_t>> producers;
+  // The time at which each graph input packet was added.
+  std::map<PacketKey, int64_t> graph_inputs;
+  std::map<int32_t, std::string> names;
+
+  // The start and finish of a Process call can be logged in different
+  // GraphTraces, so all traces are merged before the frames are analyzed.
+  for (const auto& graph_trace : profile.graph_trace()) {
+    const int64_t base_time = graph_trace.base_time();
+    const int64_t base_ts = graph_trace.base_timestamp();
+    for (int i = 0; i < graph_trace.calculator_name_size(); ++i) {
+      names[i] = graph_trace.calculator_name(i);
+    }
+    for (const auto& calc_trace : graph_trace.calculator_trace()) {
+      if (calc_trace.event_type() != mediapipe::GraphTrace_EventType_PROCESS) {
+        continue;
+      }
+      const int64_t input_ts = base_ts + calc_trace.input_timestamp();
+      if (calc_trace.node_id() < 0) {
+        // Packets added to the graph input streams.
+        if (calc_trace.has_finish_time()) {
+          for (const auto& stream_trace : calc_trace.output_trace()) {
+            graph_inputs[{base_ts + stream_trace.packet_timestamp(),
+                          stream_trace.stream_id()}] =
+                base_time + calc_trace.finish_time();
+          }
+        }
+        continue;
+      }
+      Task& task = tasks[input_ts][calc_trace.node_id()];
+      if (calc_trace.has_start_time()) {
+        const int64_t start_time = base_time + calc_trace.start_time();
+        task.start_time = std::min(task.start_time.value_or(start_time),
+                                   start_time);
+      }
+      if (calc_trace.has_finish_time()) {
+        const int64_t finish_time = base_time + calc_trace.finish_time();
+        task.finish_time = std::min(task.finish_time.value_or(finish_time),
+                                    finish_time);
+      }
+      for (const auto& stream_trace : calc_trace.input_trace()) {
+        InputPacket input;
+        input.key = {base_ts + stream_trace.packet_timestamp(),
+                     stream_trace.stream_id()};
+        if (stream_trace.has_start_time()) {
+          input.sent_time = base_time + stream_trace.start_time();
+        }
+        task.inputs.push_back(input);
+      }
+      for (const auto& stream_trace : calc_trace.output_trace()) {
+        producers[{base_ts + stream_trace.packet_timestamp(),
+                   stream_trace.stream_id()}] = {input_ts,
+                                                 calc_trace.node_id()};
+      }
+    }
+  }
+
+  for (const auto& frame_tasks : tasks) {
+    const int64_t input_ts = frame_tasks.first;
+
+    // Calls that started or finished outside of the trace are skipped.
+    CallMap calls;
+    for (const auto& node_task : frame_tasks.second) {
+      const Task& task = node_task.second;
+      if (task.start_time && task.finish_time) {
+        Call& call = calls[node_task.first];
+        call.start_time = *task.start_time;
+        call.finish_time = std::max(*task.finish_time, *task.start_time);
+      }
+    }
+    if (calls.empty()) {
+      continue;
+    }
+
+    FrameData frame;
+    frame.timestamp = input_ts;
+    frame.start_time = std::numeric_limits<int64_t>::max();
+    frame.finish_time = std::numeric_limits<int64_t>::min();
+    for (auto& node_call : calls) {
+      const int32_t node_id = node_call.first;
+      Call& call = node_call.second;
+      absl::optional<int64_t> ready_time;
+      std::vector<int32_t> producer_ids;
+      for (const InputPacket& input : frame_tasks.second.at(node_id).inputs) {
+        absl::optional<int64_t> arrival;
+        int32_t producer_id = -1;
+        auto producer = producers.find(input.key);
+        if (producer != producers.end() &&
+            producer->second.first == input_ts &&
+            producer->second.second != node_id &&
+            calls.count(producer->second.second)) {
+          producer_id = producer->second.second;
+          arrival = calls[producer_id].finish_time;
+          producer_ids.push_back(producer_id);
+        } else if (graph_inputs.count(input.key)) {
+          arrival = graph_inputs[input.key];
+        } else if (input.sent_time) {
+          arrival = input.sent_time;
+        }
+        if (!arrival) {
+          continue;
+        }
+        // Guard against clock skew between threads.
+        arrival = std::min(*arrival, call.start_time);
+        if (!ready_time || *arrival > *ready_time) {
+          ready_time = arrival;
+          call.predecessor = producer_id;
+        }
+      }
+      // Source calculators are ready when they start.
+      call.ready_time = ready_time.value_or(call.start_time);
+      for (int32_t producer_id : producer_ids) {
+        calls[producer_id].successors.insert(node_id);
+      }
+      frame.start_time = std::min(frame.start_time, call.ready_time);
+      frame.finish_time = std::max(frame.finish_time, call.finish_time);
+      frame.work += call.finish_time - call.start_time;
+    }
+
+    // Walk back from the last call to finish along the last arriving inputs.
+    int32_t node_id = -1;
+    for (const auto& node_call : calls) {
+      if (node_id == -1 ||
+          node_call.second.finish_time > calls[node_id].finish_time) {
+        node_id = node_call.first;
+      }
+    }
+    std::set<int32_t> on_path;
+    while (node_id != -1 && on_path.insert(node_id).second) {
+      const Call& call = calls[node_id];
+      CriticalPathStep step;
+      step.name = names[node_id];
+      step.wait_time = call.start_time - call.ready_time;
+      step.process_time = call.finish_time - call.start_time;
+      frame.critical_path.push_back(step);
+      node_id = call.predecessor;
+    }
+    std::reverse(frame.critical_path.begin(), frame.critical_path.end());
+
+    std::set<int32_t> visiting;
+    for (auto& node_call : calls) {
+      const int64_t slack = ComputeSlack(node_call.first, frame.finish_time,
+                                         &calls, &visiting);
+      CriticalPathData& data = calculator_data_[names[node_call.first]];
+      data.name = names[node_call.first];
+      ++data.frames;
+      data.slack_stat.Push(slack);
+      data.min_slack = std::min(data.min_slack, slack);
+    }
+    for (const auto& step : frame.critical_path) {
+      CriticalPathData& data = calculator_data_[step.name];
+      ++data.critical_frames;
+      data.critical_time_stat.Push(step.wait_time + step.process_time);
+    }
+    frames_.push_back(std::move(frame));
+  }
+}
+
+std::unique_ptr<CriticalPathReport> CriticalPathAnalyzer::Report() const {
+  std::vector<FrameData> frames = frames_;
+  std::stable_sort(frames.begin(), frames.end(),
+                   [](const FrameData& a, const FrameData& b) {
+                     return a.timestamp < b.timestamp;
+                   });
+  return std::make_unique<CriticalPathReport>(std::move(frames),
+                                              calculator_data_);
+}
+
+CriticalPathReport::CriticalPathReport(
+    std::vector<FrameData> frames,
+    std::map<std::string, CriticalPathData> calculator_data)
+    : frames_(std::move(frames)),
+      calculator_data_(std::move(calculator_data)) {}
+
+double CriticalPathReport::latency_mean() const {
+  double total = 0;
+  for (const auto& frame : frames_) {
+    total += frame.latency();
+  }
+  return frames_.empty() ? 0 : total / frames_.size();
+}
+
+double CriticalPathReport::span_mean() const {
+  double total = 0;
+  for (const auto& frame : frames_) {
+    total += frame.span();
+  }
+  return frames_.empty() ? 0 : total / frames_.size();
+}
+
+double CriticalPathReport::parallelism() const {
+  double work = 0;
+  double span = 0;
+  for (const auto& frame : frames_) {
+    work += frame.work;
+    span += frame.span();
+  }
+  return span == 0 ? 0 : work / span;
+}
+
+void CriticalPathReport::Print(std::ostream& output) const {
+  output << "frames " << frames_.size() << ", latency_mean "
+         << ToStringF(latency_mean()) << ", span_mean "
+         << ToStringF(span_mean()) << ", parallelism "
+         << ToStringF(parallelism()) << std::endl;
+
+  double total_latency = 0;
+  for (const auto& frame : frames_) {
+    total_latency += frame.latency();
+  }
+  std::vector<const CriticalPathData*> sorted;
+  for (const auto& entry : calculator_data_) {
+    sorted.push_back(&entry.second);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const CriticalPathData* a, const CriticalPathData* b) {
+                     return a->critical_time_stat.total() >
+                            b->critical_time_stat.total();
+                   });
+
+  std::vector<std::vector<std::string>> rows = {
+      {"calculator", "latency_percent", "critical_percent",
+       "critical_time_mean", "slack_mean", "slack_min"}};
+  for (const CriticalPathData* data : sorted) {
+    const bool on_path = data->critical_frames > 0;
+    rows.push_back({
+        data->name,
+        ToStringF(total_latency == 0 ? 0
+                                     : 100 * data->critical_time_stat.total() /
+                                           total_latency),
+        ToStringF(data->frames == 0
+                      ? 0
+                      : 100.0 * data->critical_frames / data->frames),
+        ToStringF(on_path ? data->critical_time_stat.mean() : 0),
+        ToStringF(data->frames > 0 ? data->slack_stat.mean() : 0),
+        absl::StrCat(data->frames > 0 ? data->min_slack : 0),
+    });
+  }
+  PrintTable(rows, "", output);
+}
+
+void CriticalPathReport::PrintSlowestFrames(std::ostream& output,
+                                            int count) const {
+  std::vector<const FrameData*> sorted;
+  for (const auto& frame : frames_) {
+    sorted.push_back(&frame);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const FrameData* a, const FrameData* b) {
+                     return a->latency() > b->latency();
+                   });
+  if (count < sorted.size()) {
+    sorted.resize(count);
+  }
+  for (const FrameData* frame : sorted) {
+    output << "timestamp " << frame->timestamp << ": latency "
+           << frame->latency() << ", span " << frame->span() << ", work "
+           << frame->work << std::endl;
+    std::vector<std::vector<std::string>> rows = {
+        {"calculator", "wait_time", "process_time"}};
+    for (const auto& step : frame->critical_path) {
+      rows.push_back({step.name, absl::StrCat(step.wait_time),
+                      absl::StrCat(step.process_time)});
+    }
+    PrintTable(rows, "  ", output);
+  }
+}
+
+}  // namespace reporter
+}  // namespace mediapipe
@@ -0,0 +1,133 @@
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_REPORTER_CRITICAL_PATH_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_REPORTER_CRITICAL_PATH_H_
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/profiler/reporter/statistic.h"
+
+namespace mediapipe {
+namespace reporter {
+
+// One calculator on the critical path of a frame.
+struct CriticalPathStep {
+  // Name of the calculator.
+  std::string name;
+
+  // The time from the arrival of the last input packet to the start of
+  // Process (microseconds).
+  int64_t wait_time = 0;
+
+  // The duration of Process (microseconds).
+  int64_t process_time = 0;
+};
+
+// The Process calls for one input timestamp, and the chain of calls that
+// determined its latency.
+struct FrameData {
+  // The packet timestamp of the frame.
+  int64_t timestamp = 0;
+
+  // The arrival of the first input packet, and the finish of the last Process
+  // call, in microseconds since the epoch.
+  int64_t start_time = 0;
+  int64_t finish_time = 0;
+
+  // The total duration of all Process calls for the frame (microseconds).
+  int64_t work = 0;
+
+  // The Process calls on the critical path, in execution order. Each call
+  // starts after the call before it produced its last arriving input.
+  std::vector<CriticalPathStep> critical_path;
+
+  int64_t latency() const { return finish_time - start_time; }
+
+  // The sum of process_time along the critical path: the latency of the frame
+  // with unlimited threads and no scheduling delay.
+  int64_t span() const;
+};
+
+// Holds the critical path statistics for a calculator.
+struct CriticalPathData {
+  // Name of the calculator.
+  std::string name;
+
+  // The number of frames processed by the calculator.
+  int frames = 0;
+
+  // The number of frames for which the calculator was on the critical path.
+  int critical_frames = 0;
+
+  // The wait_time plus process_time of the calculator when it was on the
+  // critical path (microseconds).
+  Statistic critical_time_stat;
+
+  // The time by which a Process call could have finished later without
+  // delaying the end of its frame (microseconds). Zero on the critical path.
+  Statistic slack_stat;
+  int64_t min_slack = std::numeric_limits<int64_t>::max();
+};
+
+// Critical path statistics generated by CriticalPathAnalyzer.
+class CriticalPathReport {
+ public:
+  CriticalPathReport(std::vector<FrameData> frames,
+                     std::map<std::string, CriticalPathData> calculator_data);
+
+  // Prints a summary of the frame latencies, followed by one line for each
+  // calculator, ordered by its share of the total frame latency.
+  void Print(std::ostream& output) const;
+
+  // Prints the critical paths of the |count| frames with the highest latency.
+  void PrintSlowestFrames(std::ostream& output, int count) const;
+
+  // Returns the analyzed frames, ordered by timestamp.
+  const std::vector<FrameData>& frames() const { return frames_; }
+
+  // Returns the statistics for each calculator.
+  const std::map<std::string, CriticalPathData>& calculator_data() const {
+    return calculator_data_;
+  }
+
+  // The mean frame latency and the mean critical path span (microseconds).
+  double latency_mean() const;
+  double span_mean() const;
+
+  // The total work divided by the total span: the mean number of calculators
+  // that could run in parallel. A value near 1 means that the latency is
+  // bounded by a chain of calculators, and more threads will not reduce it.
+  double parallelism() const;
+
+ private:
+  std::vector<FrameData> frames_;
+  std::map<std::string, CriticalPathData> calculator_data_;
+};
+
+// Rebuilds the dependency DAG of the Process calls for each input timestamp
+// from the stream traces in GraphProfile protobufs, and finds the chain of
+// calls that bounds the latency of each frame. A Process call depends on the
+// calls that produced its input packets. The critical path ends at the last
+// call to finish and follows, at each call, the input packet that arrived
+// last.
+class CriticalPathAnalyzer {
+ public:
+  // Adds the frames traced in a given profile.
+  void Accumulate(const mediapipe::GraphProfile& profile);
+
+  // Generates a report based on the frames accumulated so far.
+  std::unique_ptr<CriticalPathReport> Report() const;
+
+ private:
+  std::vector<FrameData> frames_;
+  std::map<std::string, CriticalPathData> calculator_data_;
+};
+
+}  // namespace reporter
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_REPORTER_CRITICAL_PATH_H_
@@ -26,6 +26,7 @@
 #include "mediapipe/framework/port/advanced_proto_inc.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/profiler/reporter/critical_path.h"
 #include "mediapipe/framework/profiler/reporter/reporter.h"
 
 ABSL_FLAG(std::vector<std::string>, logfiles, {},
@@ -35,7 +36,14 @@ ABSL_FLAG(std::vector<std::string>, cols, {"*"},
           "allowed.");
 ABSL_FLAG(bool, compact, false,
           "if true, then don't print unnecessary whitespace.");
+ABSL_FLAG(bool, critical_path, false,
+          "if true, then print the critical path statistics of each "
+          "calculator instead of the column statistics.");
+ABSL_FLAG(int, top_frames, 0,
+          "with --critical_path, the number of slowest frames for which to "
+          "print the critical path.");
 
+using mediapipe::reporter::CriticalPathAnalyzer;
 using mediapipe::reporter::Reporter;
 
 // The command line utility to mine trace files of useful statistics to
@@ -51,6 +59,8 @@ int main(int argc, char** argv) {
     std::cout << "WARNING" << std::endl << result.message();
   }
 
+  CriticalPathAnalyzer analyzer;
+  const bool critical_path = absl::GetFlag(FLAGS_critical_path);
   const auto& flags_logfiles = absl::GetFlag(FLAGS_logfiles);
   for (const auto& file_name : flags_logfiles) {
     std::ifstream ifs(file_name.c_str(), std::ifstream::in);
@@ -59,10 +69,21 @@ int main(int argc, char** argv) {
     mediapipe::GraphProfile proto;
     if (!proto.ParseFromCodedStream(&coded_input_stream)) {
       std::cerr << "Failed to parse proto.\n";
+    } else if (critical_path) {
+      analyzer.Accumulate(proto);
     } else {
       reporter.Accumulate(proto);
     }
   }
-  reporter.Report()->Print(std::cout);
+  if (critical_path) {
+    const auto report = analyzer.Report();
+    report->Print(std::cout);
+    if (absl::GetFlag(FLAGS_top_frames) > 0) {
+      std::cout << std::endl;
+      report->PrintSlowestFrames(std::cout, absl::GetFlag(FLAGS_top_frames));
+    }
+  } else {
+    reporter.Report()->Print(std::cout);
+  }
   return 1;
 }
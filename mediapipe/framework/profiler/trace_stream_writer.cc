@@ -0,0 +1,339 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/trace_stream_writer.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+namespace {
+
+// Formatted events are written to the file whenever this many bytes are
+// buffered, which bounds the memory used by the writer.
+constexpr size_t kFlushSize = 64 * 1024;
+
+// The write interval used when the configured one is not positive, as when
+// periodic trace log output is disabled.
+constexpr absl::Duration kDefaultInterval = absl::Milliseconds(500);
+
+// The trace-event "pid" of all events.
+constexpr int kProcessId = 1;
+
+// Returns true for the event types logged by GraphProfiler::Scope, which
+// log a start event when a calculator method begins and a finish event when
+// it returns.
+bool IsSliceEvent(const TraceEvent& event) {
+  return event.node_id >= 0 && (event.event_type == TraceEvent::OPEN ||
+                                event.event_type == TraceEvent::PROCESS ||
+                                event.event_type == TraceEvent::CLOSE);
+}
+
+// Appends |text| as a JSON string literal.  Node and stream names are
+// validated identifiers, so only quotes and backslashes need escaping.
+void AppendQuoted(absl::string_view text, std::string* out) {
+  out->push_back('"');
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+    }
+    out->push_back(c);
+  }
+  out->push_back('"');
+}
+
+// Returns the absolute buffer index of an iterator.
+int64 AbsoluteIndex(const TraceBuffer* buffer, TraceBuffer::iterator it) {
+  return it - TraceBuffer::iterator(buffer, 0);
+}
+
+}  // namespace
+
+TraceStreamWriter::TraceStreamWriter(const TraceBuffer* buffer,
+                                     std::vector<std::string> node_names,
+                                     absl::Duration interval)
+    : buffer_(buffer),
+      node_names_(std::move(node_names)),
+      interval_(interval > absl::ZeroDuration() ? interval
+                                                : kDefaultInterval) {}
+
+TraceStreamWriter::~TraceStreamWriter() {
+  absl::Status status = Stop();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to finish the trace stream: " << status;
+  }
+}
+
+absl::Status TraceStreamWriter::Start(const std::string& path) {
+  RET_CHECK(!thread_pool_) << "The trace stream is already started.";
+  {
+    absl::MutexLock lock(&mutex_);
+    file_.open(path, std::ios::out | std::ios::trunc);
+    if (!file_.is_open()) {
+      return absl::UnavailableError(
+          absl::StrCat("Cannot open trace stream file: ", path));
+    }
+    path_ = path;
+    next_index_ = AbsoluteIndex(buffer_, buffer_->end());
+    open_slices_.clear();
+    output_.clear();
+    output_.reserve(kFlushSize + 1024);
+    output_ += "[\n";
+    absl::StrAppend(&output_, "{\"ph\":\"M\",\"name\":\"process_name\",",
+                    "\"pid\":", kProcessId,
+                    ",\"args\":{\"name\":\"mediapipe\"}},\n");
+    MP_RETURN_IF_ERROR(Flush(/*force=*/true));
+  }
+  {
+    absl::MutexLock lock(&wake_mutex_);
+    stopping_ = false;
+    wake_requested_ = false;
+  }
+  thread_pool_ = absl::make_unique<ThreadPool>("trace_stream", 1);
+  thread_pool_->StartWorkers();
+  thread_pool_->Schedule([this] { RunWriterLoop(); });
+  return absl::OkStatus();
+}
+
+absl::Status TraceStreamWriter::Stop() {
+  if (!thread_pool_) {
+    return absl::OkStatus();
+  }
+  {
+    absl::MutexLock lock(&wake_mutex_);
+    stopping_ = true;
+  }
+  // Waits for RunWriterLoop to return.
+  thread_pool_.reset();
+
+  absl::MutexLock lock(&mutex_);
+  absl::Status status = WriteNewEventsLocked();
+  AddUnfinishedSlices();
+  status.Update(Flush(/*force=*/true));
+  file_.close();
+  return status;
+}
+
+void TraceStreamWriter::Wake() {
+  absl::MutexLock lock(&wake_mutex_);
+  wake_requested_ = true;
+}
+
+void TraceStreamWriter::RunWriterLoop() {
+  auto woken = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(wake_mutex_) {
+    return stopping_ || wake_requested_;
+  };
+  while (true) {
+    {
+      absl::MutexLock lock(&wake_mutex_);
+      wake_mutex_.AwaitWithTimeout(absl::Condition(&woken), interval_);
+      if (stopping_) {
+        // Stop writes the remaining events.
+        return;
+      }
+      wake_requested_ = false;
+    }
+    absl::Status status = WriteNewEvents();
+    if (!status.ok()) {
+      LOG_EVERY_N(ERROR, 100) << "Failed to stream trace events: " << status;
+    }
+  }
+}
+
+absl::Status TraceStreamWriter::WriteNewEvents() {
+  absl::MutexLock lock(&mutex_);
+  return WriteNewEventsLocked();
+}
+
+absl::Status TraceStreamWriter::WriteNewEventsLocked() {
+  if (!file_.is_open()) {
+    return absl::OkStatus();
+  }
+  const int64 begin = AbsoluteIndex(buffer_, buffer_->begin());
+  const int64 end = AbsoluteIndex(buffer_, buffer_->end());
+  if (next_index_ < begin) {
+    // The events before "begin" have been overwritten.  Slices that started
+    // before the gap can no longer be matched with their finish events.
+    const int64 dropped = begin - next_index_;
+    num_events_dropped_ += dropped;
+    AddUnfinishedSlices();
+    const TraceEvent first = *TraceBuffer::iterator(buffer_, begin);
+    AppendJson("i", "events_dropped", "", first.event_time, first.thread_id,
+               absl::ZeroDuration(), absl::StrCat("\"count\":", dropped));
+    next_index_ = begin;
+  }
+  for (; next_index_ < end; ++next_index_) {
+    AddEvent(*TraceBuffer::iterator(buffer_, next_index_));
+    ++num_events_read_;
+    MP_RETURN_IF_ERROR(Flush(/*force=*/false));
+  }
+  return Flush(/*force=*/true);
+}
+
+void TraceStreamWriter::AddEvent(const TraceEvent& event) {
+  if (IsSliceEvent(event)) {
+    AddSliceEvent(event);
+    return;
+  }
+  absl::string_view stream =
+      event.stream_id ? absl::string_view(*event.stream_id) : "";
+  const std::string& type_name = GraphTrace::EventType_Name(event.event_type);
+  if (event.event_type == TraceEvent::PACKET_QUEUED) {
+    // One counter track per node input stream.
+    AppendJson("C", absl::StrCat(NodeName(event.node_id), ":", stream),
+               type_name, event.event_time, event.thread_id,
+               absl::ZeroDuration(),
+               absl::StrCat("\"queue_size\":", event.event_data));
+    return;
+  }
+  std::string args;
+  if (event.node_id >= 0) {
+    args += "\"node\":";
+    AppendQuoted(NodeName(event.node_id), &args);
+    args += ",";
+  }
+  if (!stream.empty()) {
+    args += "\"stream\":";
+    AppendQuoted(stream, &args);
+    args += ",";
+  }
+  absl::StrAppend(&args, "\"input_ts\":", event.input_ts.Value(),
+                  ",\"packet_ts\":", event.packet_ts.Value(),
+                  ",\"data\":", event.event_data);
+  AppendJson("i", type_name, type_name, event.event_time, event.thread_id,
+             absl::ZeroDuration(), args);
+}
+
+void TraceStreamWriter::AddSliceEvent(const TraceEvent& event) {
+  OpenSlice& slice = open_slices_[event.thread_id];
+  const bool same_invocation = slice.node_id == event.node_id &&
+                               slice.event_type == event.event_type &&
+                               slice.input_ts == event.input_ts;
+  const std::string& type_name = GraphTrace::EventType_Name(event.event_type);
+  const std::string args =
+      absl::StrCat("\"input_ts\":", event.input_ts.Value());
+  if (!event.is_finish) {
+    // An invocation logs a start event for each input packet.
+    if (same_invocation && !slice.finished) {
+      return;
+    }
+    // The previous invocation on this thread may have produced no output.
+    AddUnfinishedSlice(slice, event.thread_id);
+    slice.node_id = event.node_id;
+    slice.event_type = event.event_type;
+    slice.input_ts = event.input_ts;
+    slice.start_time = event.event_time;
+    slice.finished = false;
+    return;
+  }
+  // An invocation logs a finish event for each output packet.
+  if (same_invocation && slice.finished) {
+    return;
+  }
+  if (same_invocation) {
+    AppendJson("X", NodeName(event.node_id), type_name, slice.start_time,
+               event.thread_id, event.event_time - slice.start_time, args);
+  } else {
+    // The invocation has no start event, as for source calculators.
+    AddUnfinishedSlice(slice, event.thread_id);
+    AppendJson("i", NodeName(event.node_id), type_name, event.event_time,
+               event.thread_id, absl::ZeroDuration(), args);
+    slice.node_id = event.node_id;
+    slice.event_type = event.event_type;
+    slice.input_ts = event.input_ts;
+    slice.start_time = event.event_time;
+  }
+  slice.finished = true;
+}
+
+void TraceStreamWriter::AddUnfinishedSlices() {
+  for (const auto& entry : open_slices_) {
+    AddUnfinishedSlice(entry.second, entry.first);
+  }
+  open_slices_.clear();
+}
+
+void TraceStreamWriter::AddUnfinishedSlice(const OpenSlice& slice,
+                                           int32 thread_id) {
+  if (slice.node_id >= 0 && !slice.finished) {
+    AppendJson("i", NodeName(slice.node_id),
+               GraphTrace::EventType_Name(slice.event_type), slice.start_time,
+               thread_id, absl::ZeroDuration(),
+               absl::StrCat("\"input_ts\":", slice.input_ts.Value()));
+  }
+}
+
+void TraceStreamWriter::AppendJson(absl::string_view phase,
+                                   absl::string_view name,
+                                   absl::string_view category, absl::Time time,
+                                   int32 thread_id, absl::Duration duration,
+                                   absl::string_view args) {
+  output_ += "{\"ph\":\"";
+  absl::StrAppend(&output_, phase, "\",\"name\":");
+  AppendQuoted(name, &output_);
+  if (!category.empty()) {
+    absl::StrAppend(&output_, ",\"cat\":\"", category, "\"");
+  }
+  absl::StrAppend(&output_, ",\"ts\":", absl::ToUnixMicros(time),
+                  ",\"pid\":", kProcessId, ",\"tid\":", thread_id);
+  if (phase == "X") {
+    absl::StrAppend(&output_, ",\"dur\":", absl::ToInt64Microseconds(duration));
+  } else if (phase == "i") {
+    output_ += ",\"s\":\"t\"";
+  }
+  if (!args.empty()) {
+    absl::StrAppend(&output_, ",\"args\":{", args, "}");
+  }
+  output_ += "},\n";
+}
+
+absl::Status TraceStreamWriter::Flush(bool force) {
+  if (output_.empty() || (!force && output_.size() < kFlushSize)) {
+    return absl::OkStatus();
+  }
+  file_.write(output_.data(), output_.size());
+  if (force) {
+    file_.flush();
+  }
+  output_.clear();
+  if (!file_.good()) {
+    return absl::UnavailableError(
+        absl::StrCat("Failed to write trace stream file: ", path_));
+  }
+  return absl::OkStatus();
+}
+
+absl::string_view TraceStreamWriter::NodeName(int32 node_id) const {
+  if (node_id < 0 || node_id >= node_names_.size()) {
+    return "";
+  }
+  return node_names_[node_id];
+}
+
+int64 TraceStreamWriter::num_events_read() const {
+  absl::MutexLock lock(&mutex_);
+  return num_events_read_;
+}
+
+int64 TraceStreamWriter::num_events_dropped() const {
+  absl::MutexLock lock(&mutex_);
+  return num_events_dropped_;
+}
+
+}  // namespace mediapipe
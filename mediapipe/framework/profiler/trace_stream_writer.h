@@ -0,0 +1,154 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_STREAM_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_STREAM_WRITER_H_
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
+
+namespace mediapipe {
+
+// Streams the events of a TraceBuffer to a file in the Chrome trace-event
+// JSON format, which is read by chrome://tracing and by the Perfetto UI.
+//
+// A background thread wakes up once per interval, or when Wake is called, and
+// converts the events logged since its previous pass, so GraphTracer::LogEvent
+// does no more work than it does without streaming.  GraphProfiler calls Wake
+// each time half of the TraceBuffer has been filled, so that the writer keeps
+// up with bursts of events.  The writer uses constant memory: events
+// are formatted into a fixed-size buffer and flushed to the file, and if the
+// writer falls more than one TraceBuffer capacity behind, the overwritten
+// events are skipped and reported as a single "events_dropped" event.
+//
+// The PROCESS, OPEN and CLOSE events of a calculator invocation are joined
+// into one complete ("X") event spanning the invocation.  Invocations that
+// log no start or no finish event, such as those of source calculators,
+// appear as instant events, as do all other event types except
+// PACKET_QUEUED, which appears as a per-stream queue-size counter.
+//
+// The file is a JSON array that is left unterminated, as the trace-event
+// format allows, so that a trace cut short by a crash is still readable.
+class TraceStreamWriter {
+ public:
+  // Streams events from |buffer|, whose events name nodes by their index in
+  // |node_names|.  |buffer| must outlive the TraceStreamWriter.
+  TraceStreamWriter(const TraceBuffer* buffer,
+                    std::vector<std::string> node_names,
+                    absl::Duration interval);
+  ~TraceStreamWriter();
+
+  // Not copyable or movable.
+  TraceStreamWriter(const TraceStreamWriter&) = delete;
+  TraceStreamWriter& operator=(const TraceStreamWriter&) = delete;
+
+  // Opens the file at |path| and starts streaming the events logged from now
+  // on.
+  absl::Status Start(const std::string& path);
+
+  // Writes the remaining events, stops the background thread and closes the
+  // file.  No-op if not started.
+  absl::Status Stop();
+
+  // Makes the background thread write the new events now rather than at the
+  // end of the interval.  Does not block.
+  void Wake() ABSL_LOCKS_EXCLUDED(wake_mutex_);
+
+  // Writes the events logged since the previous call.  Called by the
+  // background thread, and exposed for testing.
+  absl::Status WriteNewEvents() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // The number of trace events read from the buffer, and the number skipped
+  // because they were overwritten before they could be read.
+  int64 num_events_read() const ABSL_LOCKS_EXCLUDED(mutex_);
+  int64 num_events_dropped() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // The start of a calculator invocation, per thread.
+  struct OpenSlice {
+    int32 node_id = -1;
+    TraceEvent::EventType event_type = TraceEvent::UNKNOWN;
+    Timestamp input_ts = Timestamp::Unset();
+    absl::Time start_time;
+    // True once the finish event has been written.
+    bool finished = false;
+  };
+
+  // Runs on the background thread until Stop is called.
+  void RunWriterLoop() ABSL_LOCKS_EXCLUDED(mutex_, wake_mutex_);
+
+  absl::Status WriteNewEventsLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void AddEvent(const TraceEvent& event) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void AddSliceEvent(const TraceEvent& event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Writes the invocations whose finish events have not been seen as
+  // instant events.
+  void AddUnfinishedSlices() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void AddUnfinishedSlice(const OpenSlice& slice, int32 thread_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Appends one trace-event JSON object.  |args| is the body of the "args"
+  // object, or empty.
+  void AppendJson(absl::string_view phase, absl::string_view name,
+                  absl::string_view category, absl::Time time, int32 thread_id,
+                  absl::Duration duration, absl::string_view args)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Writes the formatted events to the file if |force| or if the buffer is
+  // nearly full.
+  absl::Status Flush(bool force) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns the name of a node, or "" for graph-level events.
+  absl::string_view NodeName(int32 node_id) const;
+
+  const TraceBuffer* buffer_;
+  const std::vector<std::string> node_names_;
+  const absl::Duration interval_;
+
+  // Separate from mutex_, so that Wake does not wait for a write in progress.
+  absl::Mutex wake_mutex_;
+  // Signals the background thread to exit.
+  bool stopping_ ABSL_GUARDED_BY(wake_mutex_) = false;
+  // Signals the background thread to write the new events.
+  bool wake_requested_ ABSL_GUARDED_BY(wake_mutex_) = false;
+
+  mutable absl::Mutex mutex_;
+  std::ofstream file_ ABSL_GUARDED_BY(mutex_);
+  std::string path_ ABSL_GUARDED_BY(mutex_);
+  // Formatted events not yet written to the file.
+  std::string output_ ABSL_GUARDED_BY(mutex_);
+  // The absolute buffer index of the next event to read.
+  int64 next_index_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 num_events_read_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 num_events_dropped_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::flat_hash_map<int32, OpenSlice> open_slices_ ABSL_GUARDED_BY(mutex_);
+
+  // Runs RunWriterLoop while started.
+  std::unique_ptr<ThreadPool> thread_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_STREAM_WRITER_H_
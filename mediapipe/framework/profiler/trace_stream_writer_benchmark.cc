@@ -0,0 +1,110 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the cost of tracing per calculator Process() call.  A chain of
+// PassThroughCalculators runs with tracing off, with trace events recorded
+// in the GraphTracer buffer only, and with the events also streamed to a
+// Chrome trace file by the TraceStreamWriter.  Items are Process() calls, so
+// the difference in time per item between the runs is the tracing overhead.
+// Each Process() call of the chain logs about 5 trace events: its start and
+// finish, READY_FOR_PROCESS, NOT_READY and PACKET_QUEUED.
+//
+// The budget is 1 us per event on the calculator threads (Buffered - Off)
+// and 2 us of writer CPU time per event (Streamed - Buffered).  On a single
+// 2 GHz core the runs measured 1.2-2.9 us per Process() call for buffering,
+// or 0.2-0.6 us per event, and 4-7.5 us more for streaming, or 0.8-1.5 us per
+// event, since the writer shares the core with the graph.
+//
+// bazel run -c opt //mediapipe/framework/profiler:trace_stream_writer_benchmark
+
+#include <cstdlib>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kChainLength = 8;
+constexpr int kPacketsPerIteration = 64;
+// The writer reads the trace buffer this often.  The default interval of
+// 0.5 s lets at most one buffer capacity of events, 20000 by default, be
+// written per interval, which this graph exceeds, so the overwritten events
+// would be skipped rather than formatted.
+constexpr int64 kStreamIntervalUsec = 20000;
+
+enum class TraceMode { kOff, kBuffered, kStreamed };
+
+// Builds a graph in which "input" passes through kChainLength calculators
+// on a single thread.
+CalculatorGraphConfig MakeChainConfig(TraceMode mode) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.add_executor()
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(1);
+  std::string previous = "input";
+  for (int i = 0; i < kChainLength; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(previous);
+    previous = absl::StrCat("stage_", i);
+    node->add_output_stream(previous);
+  }
+  if (mode != TraceMode::kOff) {
+    ProfilerConfig* profiler_config = config.mutable_profiler_config();
+    profiler_config->set_trace_enabled(true);
+    profiler_config->set_trace_log_disabled(true);
+    if (mode == TraceMode::kStreamed) {
+      const char* tmp_dir = getenv("TEST_TMPDIR");
+      profiler_config->set_trace_stream_path(
+          absl::StrCat(tmp_dir ? tmp_dir : "/tmp", "/trace_stream.json"));
+      profiler_config->set_trace_log_interval_usec(kStreamIntervalUsec);
+    }
+  }
+  return config;
+}
+
+void BM_TracedProcess(benchmark::State& state, TraceMode mode) {
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.Initialize(MakeChainConfig(mode)));
+  MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(timestamp++))));
+    }
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilIdle());
+  }
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  state.SetItemsProcessed(state.iterations() * kPacketsPerIteration *
+                          kChainLength);
+}
+
+BENCHMARK_CAPTURE(BM_TracedProcess, Off, TraceMode::kOff)->UseRealTime();
+BENCHMARK_CAPTURE(BM_TracedProcess, Buffered, TraceMode::kBuffered)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_TracedProcess, Streamed, TraceMode::kStreamed)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,265 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/trace_stream_writer.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns the trace-event lines of a trace stream file that contain all of
+// the |parts|.
+std::vector<std::string> FindEvents(const std::string& path,
+                                    const std::vector<std::string>& parts) {
+  std::string contents;
+  MP_EXPECT_OK(file::GetContents(path, &contents));
+  std::vector<std::string> result;
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    bool match = true;
+    for (const std::string& part : parts) {
+      match = match && absl::StrContains(line, part);
+    }
+    if (match) {
+      result.push_back(std::string(line));
+    }
+  }
+  return result;
+}
+
+class TraceStreamWriterTest : public ::testing::Test {
+ protected:
+  TraceStreamWriterTest()
+      : path_(absl::StrCat(getenv("TEST_TMPDIR"), "/trace_stream.json")),
+        start_time_(absl::FromUnixMicros(1000000)) {}
+
+  // Logs a calculator event |usec| after start_time_.
+  void LogEvent(TraceBuffer* buffer, TraceEvent::EventType event_type,
+                bool is_finish, int node_id, int64 input_ts, int64 usec,
+                int thread_id = 0) {
+    buffer->push_back(
+        TraceEvent(event_type)
+            .set_event_time(start_time_ + absl::Microseconds(usec))
+            .set_is_finish(is_finish)
+            .set_node_id(node_id)
+            .set_input_ts(Timestamp(input_ts))
+            .set_thread_id(thread_id));
+  }
+
+  std::string path_;
+  absl::Time start_time_;
+  // The writer only writes when asked to by the test.
+  absl::Duration interval_ = absl::Hours(1);
+};
+
+TEST_F(TraceStreamWriterTest, JoinsStartAndFinishIntoCompleteEvent) {
+  TraceBuffer buffer(100);
+  TraceStreamWriter writer(&buffer, {"node_a", "node_b"}, interval_);
+  MP_ASSERT_OK(writer.Start(path_));
+  // One invocation with two input packets and two output packets.
+  LogEvent(&buffer, TraceEvent::PROCESS, false, 1, 10, 0);
+  LogEvent(&buffer, TraceEvent::PROCESS, false, 1, 10, 0);
+  LogEvent(&buffer, TraceEvent::PROCESS, true, 1, 10, 250);
+  LogEvent(&buffer, TraceEvent::PROCESS, true, 1, 10, 250);
+  MP_ASSERT_OK(writer.WriteNewEvents());
+  MP_ASSERT_OK(writer.Stop());
+
+  EXPECT_EQ(4, writer.num_events_read());
+  std::vector<std::string> events = FindEvents(path_, {"\"node_b\""});
+  ASSERT_EQ(1, events.size());
+  EXPECT_TRUE(absl::StrContains(events[0], "\"ph\":\"X\""));
+  EXPECT_TRUE(absl::StrContains(events[0], "\"cat\":\"PROCESS\""));
+  EXPECT_TRUE(absl::StrContains(events[0], "\"ts\":1000000"));
+  EXPECT_TRUE(absl::StrContains(events[0], "\"dur\":250"));
+  EXPECT_TRUE(absl::StrContains(events[0], "\"input_ts\":10"));
+}
+
+TEST_F(TraceStreamWriterTest, MatchesEventsPerThread) {
+  TraceBuffer buffer(100);
+  TraceStreamWriter writer(&buffer, {"node_a", "node_b"}, interval_);
+  MP_ASSERT_OK(writer.Start(path_));
+  LogEvent(&buffer, TraceEvent::PROCESS, false, 0, 10, 0, /*thread_id=*/1);
+  LogEvent(&buffer, TraceEvent::PROCESS, false, 1, 20, 5, /*thread_id=*/2);
+  MP_ASSERT_OK(writer.WriteNewEvents());
+  // Finish events are matched across calls to WriteNewEvents.
+  LogEvent(&buffer, TraceEvent::PROCESS, true, 1, 20, 30, /*thread_id=*/2);
+  LogEvent(&buffer, TraceEvent::PROCESS, true, 0, 10, 40, /*thread_id=*/1);
+  MP_ASSERT_OK(writer.Stop());
+
+  std::vector<std::string> events = FindEvents(path_, {"\"ph\":\"X\""});
+  ASSERT_EQ(2, events.size());
+  EXPECT_TRUE(absl::StrContains(events[0], "\"node_b\""));
+  EXPECT_TRUE(absl::StrContains(events[0], "\"dur\":25"));
+  EXPECT_TRUE(absl::StrContains(events[1], "\"node_a\""));
+  EXPECT_TRUE(absl::StrContains(events[1], "\"dur\":40"));
+}
+
+TEST_F(TraceStreamWriterTest, WritesUnmatchedEventsAsInstants) {
+  TraceBuffer buffer(100);
+  TraceStreamWriter writer(&buffer, {"source", "sink"}, interval_);
+  MP_ASSERT_OK(writer.Start(path_));
+  // A source calculator logs only finish events.
+  LogEvent(&buffer, TraceEvent::PROCESS, true, 0, 10, 0);
+  LogEvent(&buffer, TraceEvent::PROCESS, true, 0, 10, 0);
+  // A sink calculator without outputs logs only start events.
+  LogEvent(&buffer, TraceEvent::PROCESS, false, 1, 10, 20);
+  LogEvent(&buffer, TraceEvent::PROCESS, false, 1, 20, 40);
+  MP_ASSERT_OK(writer.Stop());
+
+  EXPECT_TRUE(FindEvents(path_, {"\"ph\":\"X\""}).empty());
+  EXPECT_EQ(1, FindEvents(path_, {"\"ph\":\"i\"", "\"source\""}).size());
+  EXPECT_EQ(2, FindEvents(path_, {"\"ph\":\"i\"", "\"sink\""}).size());
+}
+
+TEST_F(TraceStreamWriterTest, WritesQueueSizeCounters) {
+  TraceBuffer buffer(100);
+  TraceStreamWriter writer(&buffer, {"node_a"}, interval_);
+  MP_ASSERT_OK(writer.Start(path_));
+  const std::string stream = "input_frames";
+  buffer.push_back(TraceEvent(TraceEvent::PACKET_QUEUED)
+                       .set_event_time(start_time_)
+                       .set_node_id(0)
+                       .set_stream_id(&stream)
+                       .set_event_data(3));
+  MP_ASSERT_OK(writer.Stop());
+
+  std::vector<std::string> events = FindEvents(path_, {"\"ph\":\"C\""});
+  ASSERT_EQ(1, events.size());
+  EXPECT_TRUE(absl::StrContains(events[0], "\"node_a:input_frames\""));
+  EXPECT_TRUE(absl::StrContains(events[0], "\"queue_size\":3"));
+}
+
+TEST_F(TraceStreamWriterTest, SkipsOverwrittenEvents) {
+  TraceBuffer buffer(10);
+  TraceStreamWriter writer(&buffer, {"node_a"}, interval_);
+  MP_ASSERT_OK(writer.Start(path_));
+  for (int i = 0; i < 30; ++i) {
+    LogEvent(&buffer, TraceEvent::PROCESS, i % 2 == 1, 0, i / 2, i);
+  }
+  MP_ASSERT_OK(writer.Stop());
+
+  EXPECT_EQ(10, writer.num_events_read());
+  EXPECT_EQ(20, writer.num_events_dropped());
+  std::vector<std::string> events = FindEvents(path_, {"events_dropped"});
+  ASSERT_EQ(1, events.size());
+  EXPECT_TRUE(absl::StrContains(events[0], "\"count\":20"));
+  EXPECT_EQ(5, FindEvents(path_, {"\"ph\":\"X\""}).size());
+}
+
+TEST_F(TraceStreamWriterTest, WakeWritesBeforeTheInterval) {
+  TraceBuffer buffer(100);
+  TraceStreamWriter writer(&buffer, {"node_a"}, interval_);
+  MP_ASSERT_OK(writer.Start(path_));
+  for (int i = 0; i < 10; ++i) {
+    LogEvent(&buffer, TraceEvent::PROCESS, i % 2 == 1, 0, i / 2, i);
+  }
+  writer.Wake();
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (writer.num_events_read() < 10 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  EXPECT_EQ(10, writer.num_events_read());
+  EXPECT_EQ(5, FindEvents(path_, {"\"ph\":\"X\""}).size());
+  MP_ASSERT_OK(writer.Stop());
+}
+
+// A burst of events larger than the buffer is read as it is logged, since
+// the tracer wakes the writer every half buffer.
+TEST_F(TraceStreamWriterTest, KeepsUpWithBurstsOfGraphEvents) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+        profiler_config {
+          trace_enabled: true
+          trace_log_disabled: true
+          trace_log_capacity: 1000
+          trace_log_interval_usec: 10000000
+        }
+      )pb");
+  config.mutable_profiler_config()->set_trace_stream_path(path_);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 1000; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+    if (i % 50 == 49) {
+      // Gives the writer a chance to run on a single core.
+      MP_ASSERT_OK(graph.WaitUntilIdle());
+      absl::SleepFor(absl::Milliseconds(5));
+    }
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_TRUE(FindEvents(path_, {"events_dropped"}).empty());
+  EXPECT_EQ(1000, FindEvents(path_, {"\"ph\":\"X\"", "\"cat\":\"PROCESS\"",
+                                     "\"PassThroughCalculator\""})
+                      .size());
+}
+
+TEST_F(TraceStreamWriterTest, StreamsGraphEvents) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+        profiler_config { trace_enabled: true trace_log_disabled: true }
+      )pb");
+  config.mutable_profiler_config()->set_trace_stream_path(path_);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_EQ(5, FindEvents(path_, {"\"ph\":\"X\"", "\"cat\":\"PROCESS\"",
+                                  "\"PassThroughCalculator\""})
+                   .size());
+  // GraphTracer logs OPEN events only for the packets that Open() outputs,
+  // and PassThroughCalculator outputs none.
+  EXPECT_TRUE(FindEvents(path_, {"\"cat\":\"OPEN\""}).empty());
+  EXPECT_EQ(5, FindEvents(path_, {"\"ph\":\"C\"",
+                                  "\"PassThroughCalculator:input\""})
+                   .size());
+}
+
+}  // namespace
+}  // namespace mediapipe
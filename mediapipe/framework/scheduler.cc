@@ -165,11 +165,27 @@ void Scheduler::HandleIdle() {
       }
     }
 
+    // Release the timestamps held by the in-flight limits: nothing more can
+    // reach them while the graph is idle. The limits are called without
+    // state_mutex_, since they lock it while adding a packet. WaitUntilIdle()
+    // also waits for handling_idle_, so it returns only once a packet added
+    // next may enter the graph.
+    if (graph_->HasInFlightLimits()) {
+      state_mutex_.Unlock();
+      bool did_add = graph_->ReleaseInFlightTimestamps() &&
+                     graph_->AddWaitingInFlightPackets();
+      state_mutex_.Lock();
+      if (did_add) {
+        continue;
+      }
+    }
+
     // Nothing left to do.
     break;
   }
 
   handling_idle_ = false;
+  state_cond_var_.SignalAll();
 }
 
 // Note: state_mutex_ is held when this function is entered or exited.
@@ -274,7 +290,9 @@ absl::Status Scheduler::WaitForObservedOutput() {
 // input streams while a WaitUntilIdle() call is in progress.
 absl::Status Scheduler::WaitUntilIdle() {
   RET_CHECK_NE(state_, STATE_NOT_STARTED);
-  ApplicationThreadAwait(std::bind(&Scheduler::IsIdle, this));
+  ApplicationThreadAwait([this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(state_mutex_) {
+    return IsIdle() && !handling_idle_;
+  });
   return absl::OkStatus();
 }
 
@@ -448,6 +466,19 @@ void Scheduler::AssignNodeToSchedulerQueue(CalculatorNode* node) {
   node->SetSchedulerQueue(queue);
 }
 
+absl::Status Scheduler::ReassignNodeToSchedulerQueue(
+    CalculatorNode* node, const std::string& executor) {
+  SchedulerQueue* queue = &default_queue_;
+  if (!executor.empty()) {
+    auto iter = non_default_queues_.find(executor);
+    RET_CHECK(iter != non_default_queues_.end())
+        << "No executor named \"" << executor << "\".";
+    queue = iter->second.get();
+  }
+  node->SetSchedulerQueue(queue);
+  return absl::OkStatus();
+}
+
 void Scheduler::QueueIdleStateChanged(bool idle) {
   absl::MutexLock lock(&state_mutex_);
   non_idle_queue_count_ += (idle ? -1 : 1);
@@ -533,6 +564,16 @@ void Scheduler::CleanupAfterRun() {
   shared_.has_error = false;
 }
 
+std::map<std::string, Scheduler::ExecutorLoad> Scheduler::GetExecutorLoads() {
+  std::map<std::string, ExecutorLoad> loads;
+  loads[""] = {default_queue_.BusyTime(), default_queue_.NumQueuedNodes()};
+  for (auto& name_queue : non_default_queues_) {
+    SchedulerQueue* queue = name_queue.second.get();
+    loads[name_queue.first] = {queue->BusyTime(), queue->NumQueuedNodes()};
+  }
+  return loads;
+}
+
 internal::SchedulerTimes Scheduler::GetSchedulerTimes() {
   CHECK_EQ(state_, STATE_TERMINATED);
   return shared_.timer.GetSchedulerTimes();
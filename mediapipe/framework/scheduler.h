@@ -125,6 +125,12 @@ class Scheduler {
   // Assigns node to a scheduler queue.
   void AssignNodeToSchedulerQueue(CalculatorNode* node);
 
+  // Moves node to the scheduler queue of |executor|, which may happen while
+  // the graph is running.  Invocations of the node that are already queued
+  // still run on the previous executor.
+  absl::Status ReassignNodeToSchedulerQueue(CalculatorNode* node,
+                                            const std::string& executor);
+
   // Pauses the scheduler.  Does nothing if Cancel has been called.
   void Pause() ABSL_LOCKS_EXCLUDED(state_mutex_);
 
@@ -147,6 +153,17 @@ class Scheduler {
 
   void SetHasError(bool error) { shared_.has_error = error; }
 
+  // Sets the arena that is current while calculators run. Must be called
+  // before the scheduler is started.
+  void SetPacketArena(PacketArena* arena) { shared_.packet_arena = arena; }
+
+  // Sets a callback run after each Process() call of a calculator, with the
+  // node id, on the thread which ran it. Must be called before the scheduler
+  // is started.
+  void SetNodeProcessedCallback(std::function<void(int node_id)> callback) {
+    shared_.node_processed_callback = std::move(callback);
+  }
+
   // Notifies the scheduler that a packet was added to a graph input stream.
   // The scheduler needs to check whether it is still deadlocked, and
   // unthrottle again if so.
@@ -166,6 +183,21 @@ class Scheduler {
   // Only meant for test purposes. See SchedulerTimer for details.
   internal::SchedulerTimes GetSchedulerTimes();
 
+  // The load of the scheduler queue of one executor.
+  struct ExecutorLoad {
+    // Time spent running calculator methods in this run, in microseconds.
+    int64 busy_time = 0;
+    // The number of nodes waiting for a thread.
+    int num_queued_nodes = 0;
+  };
+
+  // Returns the load of each executor, keyed by executor name. The default
+  // executor's name is the empty string.
+  std::map<std::string, ExecutorLoad> GetExecutorLoads();
+
+  // Returns the wall time of the current or last run, in microseconds.
+  int64 RunTime() { return shared_.timer.RunTime(); }
+
  private:
   // State of the scheduler. The figure shows the allowed state transitons.
   //
@@ -18,6 +18,7 @@
 #include <queue>
 #include <utility>
 
+#include "absl/numeric/bits.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
@@ -57,6 +58,21 @@ SchedulerQueue::Item::Item(CalculatorNode* node)
   }
 }
 
+// static
+SchedulerQueue::Item SchedulerQueue::Item::ForTesting(
+    int id, bool is_source, int layer, int64 source_process_order,
+    bool is_open_node) {
+  Item item;
+  item.id_ = id;
+  item.is_source_ = is_source;
+  item.is_open_node_ = is_open_node;
+  if (is_source) {
+    item.layer_ = layer;
+    item.source_process_order_ = source_process_order;
+  }
+  return item;
+}
+
 // Returning true means "this runs after that".
 bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   if (is_open_node_ || that.is_open_node_) {
@@ -86,11 +102,99 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   }
 }
 
+void SchedulerQueue::ReadyQueue::IdBuckets::Push(Item&& item) {
+  const int id = item.Id();
+  CHECK_GE(id, 0);
+  if (id >= buckets_.size()) {
+    buckets_.resize(id + 1);
+    non_empty_.resize(id / 64 + 1, 0);
+  }
+  buckets_[id].items.push_back(std::move(item));
+  non_empty_[id / 64] |= uint64{1} << (id % 64);
+}
+
+SchedulerQueue::Item SchedulerQueue::ReadyQueue::IdBuckets::PopLowestId() {
+  int w = 0;
+  while (non_empty_[w] == 0) {
+    ++w;
+    DCHECK_LT(w, non_empty_.size());
+  }
+  return PopFromBucket(w * 64 + absl::countr_zero(non_empty_[w]));
+}
+
+SchedulerQueue::Item SchedulerQueue::ReadyQueue::IdBuckets::PopHighestId() {
+  int w = static_cast<int>(non_empty_.size()) - 1;
+  while (non_empty_[w] == 0) {
+    --w;
+    DCHECK_GE(w, 0);
+  }
+  return PopFromBucket(w * 64 + 63 - absl::countl_zero(non_empty_[w]));
+}
+
+SchedulerQueue::Item SchedulerQueue::ReadyQueue::IdBuckets::PopFromBucket(
+    int id) {
+  Bucket& bucket = buckets_[id];
+  Item item = std::move(bucket.items[bucket.head++]);
+  if (bucket.head == bucket.items.size()) {
+    bucket.items.clear();
+    bucket.head = 0;
+    non_empty_[id / 64] &= ~(uint64{1} << (id % 64));
+  }
+  return item;
+}
+
+void SchedulerQueue::ReadyQueue::IdBuckets::Clear() {
+  for (Bucket& bucket : buckets_) {
+    bucket.items.clear();
+    bucket.head = 0;
+  }
+  std::fill(non_empty_.begin(), non_empty_.end(), 0);
+}
+
+void SchedulerQueue::ReadyQueue::Push(Item&& item) {
+  if (item.IsOpenNode()) {
+    open_items_.Push(std::move(item));
+    ++num_open_items_;
+  } else if (item.IsSource()) {
+    source_items_.push(std::move(item));
+  } else {
+    non_source_items_.Push(std::move(item));
+    ++num_non_source_items_;
+  }
+}
+
+SchedulerQueue::Item SchedulerQueue::ReadyQueue::Pop() {
+  // OpenNode() runs first, lower ids first.
+  if (num_open_items_ > 0) {
+    --num_open_items_;
+    return open_items_.PopLowestId();
+  }
+  // Then non-sources, higher ids first.
+  if (num_non_source_items_ > 0) {
+    --num_non_source_items_;
+    return non_source_items_.PopHighestId();
+  }
+  // Then sources, in Item::operator< order.
+  CHECK(!source_items_.empty());
+  Item item = source_items_.top();
+  source_items_.pop();
+  return item;
+}
+
+void SchedulerQueue::ReadyQueue::Clear() {
+  open_items_.Clear();
+  non_source_items_.Clear();
+  source_items_ = std::priority_queue<Item>();
+  num_open_items_ = 0;
+  num_non_source_items_ = 0;
+}
+
 void SchedulerQueue::Reset() {
   absl::MutexLock lock(&mutex_);
   num_pending_tasks_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
+  busy_time_.store(0, std::memory_order_relaxed);
 }
 
 void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
@@ -137,7 +241,7 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
   {
     absl::MutexLock lock(&mutex_);
     was_idle = IsIdle();
-    queue_.push(item);
+    queue_.Push(std::move(item));
     ++num_tasks_to_add_;
     VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
 
@@ -195,10 +299,10 @@ void SchedulerQueue::RunNextTask() {
     CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
                               "This should not happen.";
 
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
+    const Item item = queue_.Pop();
+    node = item.Node();
+    calculator_context = item.Context();
+    is_open_node = item.IsOpenNode();
 
     CHECK(!node->Closed())
         << "Scheduled a node that was closed. This should not happen.";
@@ -210,6 +314,7 @@ void SchedulerQueue::RunNextTask() {
   // an executor creating standard pthread will not, by default), so we
   // do it here to ensure all executors are covered.
   AUTORELEASEPOOL {
+    PacketArena::Scope packet_arena_scope(shared_->packet_arena);
     if (is_open_node) {
       DCHECK(!calculator_context);
       OpenCalculatorNode(node);
@@ -247,7 +352,7 @@ void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
     // TODO: Should we pass tool::StatusStop() in this case?
     const absl::Status result =
         node->CloseNode(absl::OkStatus(), /*graph_run_ended=*/false);
-    shared_->timer.EndNode(start_time);
+    EndNode(start_time);
     if (!result.ok()) {
       VLOG(3) << node->DebugName()
               << " had an error while closing due to StatusStop()!";
@@ -258,7 +363,7 @@ void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
     // due to the lock on running_nodes.
     int64 start_time = shared_->timer.StartNode();
     const absl::Status result = node->ProcessNode(cc);
-    shared_->timer.EndNode(start_time);
+    EndNode(start_time);
 
     if (!result.ok()) {
       if (result == tool::StatusStop()) {
@@ -275,17 +380,30 @@ void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
         shared_->error_callback(result);
       }
     }
+    if (shared_->node_processed_callback) {
+      shared_->node_processed_callback(node->Id());
+    }
   }
 
   VLOG(4) << "Done running " << node->DebugName();
   node->EndScheduling();
 }
 
+void SchedulerQueue::EndNode(int64 start_time) {
+  busy_time_.fetch_add(shared_->timer.EndNode(start_time),
+                       std::memory_order_relaxed);
+}
+
+int SchedulerQueue::NumQueuedNodes() {
+  absl::MutexLock lock(&mutex_);
+  return queue_.size();
+}
+
 void SchedulerQueue::OpenCalculatorNode(CalculatorNode* node) {
   VLOG(3) << "Opening " << node->DebugName();
   int64 start_time = shared_->timer.StartNode();
   const absl::Status result = node->OpenNode();
-  shared_->timer.EndNode(start_time);
+  EndNode(start_time);
   if (!result.ok()) {
     VLOG(3) << node->DebugName() << " had an error!";
     shared_->error_callback(result);
@@ -302,9 +420,7 @@ void SchedulerQueue::CleanupAfterRun() {
     CHECK_EQ(num_pending_tasks_, 0);
     CHECK_EQ(num_tasks_to_add_, queue_.size());
     num_tasks_to_add_ = 0;
-    while (!queue_.empty()) {
-      queue_.pop();
-    }
+    queue_.Clear();
   }
   if (!was_idle && idle_callback_) {
     // Became idle.
@@ -20,8 +20,10 @@
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/executor.h"
@@ -49,12 +51,21 @@ class SchedulerQueue : public TaskQueue {
     // A null CalculatorContext indicates the task should run OpenNode().
     Item(CalculatorNode* node);
 
+    // For testing and benchmarking: creates an item that has the given
+    // ordering attributes but no node or calculator context.
+    static Item ForTesting(int id, bool is_source, int layer,
+                           int64 source_process_order, bool is_open_node);
+
     CalculatorNode* Node() const { return node_; }
 
     CalculatorContext* Context() const { return cc_; }
 
     bool IsOpenNode() const { return is_open_node_; }
 
+    bool IsSource() const { return is_source_; }
+
+    int Id() const { return id_; }
+
     // This comparison is meant to be used with a std::priority_queue. Since
     // the priority queue returns higher priority items first, this function
     // means "this is lower priority than that", i.e. "this runs after that".
@@ -67,15 +78,74 @@ class SchedulerQueue : public TaskQueue {
     bool operator<(const Item& that) const;
 
    private:
+    Item() = default;
+
     int64 source_process_order_ = 0;
-    CalculatorNode* node_;
-    CalculatorContext* cc_;
+    CalculatorNode* node_ = nullptr;
+    CalculatorContext* cc_ = nullptr;
     int id_ = 0;
     int layer_ = 0;
     bool is_source_ = false;
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
 
+  // The ready items of a SchedulerQueue, returned in the order defined by
+  // Item::operator< (highest priority first), like a
+  // std::priority_queue<Item>.
+  //
+  // Instead of a single binary heap, items are kept in buckets: OpenNode()
+  // items and non-source items are bucketed by node id, with a bitmap of the
+  // non-empty buckets, so Push() is O(1) and Pop() scans one bit per node.
+  // Only source items, which are ordered by layer and SourceProcessOrder and
+  // are usually few, go through a heap. Items with equal priority (the same
+  // non-source node with max_in_flight > 1) are returned in FIFO order.
+  //
+  // ReadyQueue is not thread-safe; SchedulerQueue guards it with mutex_.
+  class ReadyQueue {
+   public:
+    void Push(Item&& item);
+
+    // Removes and returns the highest-priority item.
+    // REQUIRES: !empty().
+    Item Pop();
+
+    bool empty() const { return size() == 0; }
+    size_t size() const {
+      return num_open_items_ + num_non_source_items_ + source_items_.size();
+    }
+    void Clear();
+
+   private:
+    // A FIFO of items per node id, plus a bitmap of the non-empty ids.
+    class IdBuckets {
+     public:
+      void Push(Item&& item);
+      // REQUIRES: at least one bucket is non-empty.
+      Item PopLowestId();
+      Item PopHighestId();
+      void Clear();
+
+     private:
+      // The items of one node id. Popped items stay in place until the
+      // bucket empties, so popping is O(1).
+      struct Bucket {
+        absl::InlinedVector<Item, 1> items;
+        size_t head = 0;
+      };
+
+      Item PopFromBucket(int id);
+
+      std::vector<Bucket> buckets_;
+      std::vector<uint64> non_empty_;
+    };
+
+    IdBuckets open_items_;
+    IdBuckets non_source_items_;
+    std::priority_queue<Item> source_items_;
+    size_t num_open_items_ = 0;
+    size_t num_non_source_items_ = 0;
+  };
+
   explicit SchedulerQueue(SchedulerShared* shared) : shared_(shared) {}
 
   // Sets the executor that will run the nodes. Must be called before the
@@ -132,6 +202,13 @@ class SchedulerQueue : public TaskQueue {
 
   void CleanupAfterRun() ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // Returns the time spent running calculator methods in this run, in
+  // microseconds.
+  int64 BusyTime() const { return busy_time_.load(std::memory_order_relaxed); }
+
+  // Returns the number of nodes waiting to run.
+  int NumQueuedNodes() ABSL_LOCKS_EXCLUDED(mutex_);
+
  private:
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
   // by EndScheduling.
@@ -145,6 +222,9 @@ class SchedulerQueue : public TaskQueue {
   // Checks whether the queue has no queued nodes or pending tasks.
   bool IsIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Records the end of a calculator method started at |start_time|.
+  void EndNode(int64 start_time);
+
   Executor* executor_ = nullptr;
 
   IdleCallback idle_callback_;
@@ -163,10 +243,13 @@ class SchedulerQueue : public TaskQueue {
   int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
 
   // Queue of nodes that need to be run.
-  std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
+  ReadyQueue queue_ ABSL_GUARDED_BY(mutex_);
 
   SchedulerShared* const shared_;
 
+  // Time spent running calculator methods, in microseconds.
+  std::atomic<int64> busy_time_{0};
+
   absl::Mutex mutex_;
 };
 
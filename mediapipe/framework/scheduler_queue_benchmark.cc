@@ -0,0 +1,105 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures scheduling throughput (nodes/sec) of the SchedulerQueue ready
+// structure against the std::priority_queue<Item> it replaced. Each
+// iteration makes every node of a graph ready in a shuffled order and then
+// drains the queue, as happens when a packet fans out through a wide graph.
+// BM_ReadyQueueSameNode instead queues many invocations of one node, as a
+// node with a large max_in_flight does.
+//
+// bazel run -c opt //mediapipe/framework:scheduler_queue_benchmark
+
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/scheduler_queue.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+using Item = SchedulerQueue::Item;
+
+// One item per node; every 16th node is a source.
+std::vector<Item> MakeReadyItems(int num_nodes) {
+  std::vector<Item> items;
+  items.reserve(num_nodes);
+  for (int id = 0; id < num_nodes; ++id) {
+    const bool is_source = id % 16 == 0;
+    items.push_back(Item::ForTesting(id, is_source, /*layer=*/0,
+                                     /*source_process_order=*/id,
+                                     /*is_open_node=*/false));
+  }
+  std::shuffle(items.begin(), items.end(), std::mt19937(42));
+  return items;
+}
+
+void BM_PriorityQueue(benchmark::State& state) {
+  const std::vector<Item> items = MakeReadyItems(state.range(0));
+  std::priority_queue<Item> queue;
+  for (auto _ : state) {
+    for (const Item& item : items) {
+      queue.push(item);
+    }
+    while (!queue.empty()) {
+      benchmark::DoNotOptimize(queue.top().Id());
+      queue.pop();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * items.size());
+}
+
+void BM_ReadyQueue(benchmark::State& state) {
+  const std::vector<Item> items = MakeReadyItems(state.range(0));
+  SchedulerQueue::ReadyQueue queue;
+  for (auto _ : state) {
+    for (const Item& item : items) {
+      queue.Push(Item(item));
+    }
+    while (!queue.empty()) {
+      benchmark::DoNotOptimize(queue.Pop().Id());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * items.size());
+}
+
+void BM_ReadyQueueSameNode(benchmark::State& state) {
+  const Item item = Item::ForTesting(/*id=*/3, /*is_source=*/false,
+                                     /*layer=*/0, /*source_process_order=*/0,
+                                     /*is_open_node=*/false);
+  SchedulerQueue::ReadyQueue queue;
+  for (auto _ : state) {
+    for (int i = 0; i < state.range(0); ++i) {
+      queue.Push(Item(item));
+    }
+    while (!queue.empty()) {
+      benchmark::DoNotOptimize(queue.Pop().Id());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Argument is the number of nodes in the graph.
+BENCHMARK(BM_PriorityQueue)->Arg(16)->Arg(128)->Arg(512)->Arg(2048);
+BENCHMARK(BM_ReadyQueue)->Arg(16)->Arg(128)->Arg(512)->Arg(2048);
+// Argument is the number of queued invocations.
+BENCHMARK(BM_ReadyQueueSameNode)->Arg(16)->Arg(128)->Arg(512)->Arg(2048);
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
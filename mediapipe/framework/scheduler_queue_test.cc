@@ -0,0 +1,118 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/scheduler_queue.h"
+
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+using Item = SchedulerQueue::Item;
+using ReadyQueue = SchedulerQueue::ReadyQueue;
+
+Item NonSource(int id) { return Item::ForTesting(id, false, 0, 0, false); }
+
+Item Source(int id, int layer, int64 order) {
+  return Item::ForTesting(id, true, layer, order, false);
+}
+
+Item Open(int id, bool is_source) {
+  return Item::ForTesting(id, is_source, 0, 0, true);
+}
+
+std::vector<int> PopAllIds(ReadyQueue* queue) {
+  std::vector<int> ids;
+  while (!queue->empty()) {
+    ids.push_back(queue->Pop().Id());
+  }
+  return ids;
+}
+
+TEST(ReadyQueueTest, OrdersByItemPriority) {
+  ReadyQueue queue;
+  queue.Push(Source(0, 1, 5));
+  queue.Push(NonSource(3));
+  queue.Push(Source(1, 0, 7));
+  queue.Push(Open(6, false));
+  queue.Push(NonSource(130));
+  queue.Push(Source(2, 0, 3));
+  queue.Push(Open(4, true));
+  queue.Push(NonSource(64));
+  EXPECT_EQ(8, queue.size());
+  // Open items by ascending id, then non-sources by descending id, then
+  // sources by layer and SourceProcessOrder.
+  EXPECT_EQ(std::vector<int>({4, 6, 130, 64, 3, 2, 1, 0}), PopAllIds(&queue));
+}
+
+TEST(ReadyQueueTest, SameNodeIsFifo) {
+  ReadyQueue queue;
+  Item first = NonSource(7);
+  Item second = NonSource(7);
+  queue.Push(std::move(first));
+  queue.Push(NonSource(2));
+  queue.Push(std::move(second));
+  EXPECT_EQ(std::vector<int>({7, 7, 2}), PopAllIds(&queue));
+}
+
+TEST(ReadyQueueTest, Clear) {
+  ReadyQueue queue;
+  queue.Push(NonSource(1));
+  queue.Push(Source(2, 0, 0));
+  queue.Push(Open(3, false));
+  queue.Clear();
+  EXPECT_TRUE(queue.empty());
+  queue.Push(NonSource(0));
+  EXPECT_EQ(std::vector<int>({0}), PopAllIds(&queue));
+}
+
+// Interleaves pushes and pops of random items and checks that the ReadyQueue
+// agrees with a std::priority_queue ordered by Item::operator<.
+TEST(ReadyQueueTest, MatchesPriorityQueue) {
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<int> id_dist(0, 299);
+  std::uniform_int_distribution<int> kind_dist(0, 9);
+  std::uniform_int_distribution<int> small_dist(0, 3);
+  ReadyQueue queue;
+  std::priority_queue<Item> reference;
+  for (int step = 0; step < 20000; ++step) {
+    if (reference.empty() || kind_dist(rng) < 6) {
+      const int kind = kind_dist(rng);
+      const int id = id_dist(rng);
+      Item item = kind == 0   ? Open(id, small_dist(rng) == 0)
+                  : kind < 3  ? Source(id, small_dist(rng), small_dist(rng))
+                              : NonSource(id);
+      reference.push(item);
+      queue.Push(std::move(item));
+    } else {
+      const Item expected = reference.top();
+      reference.pop();
+      const Item actual = queue.Pop();
+      // Items that compare equal may come out in either order, so compare
+      // priorities rather than identities.
+      EXPECT_FALSE(expected < actual);
+      EXPECT_FALSE(actual < expected);
+    }
+    ASSERT_EQ(reference.size(), queue.size());
+  }
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
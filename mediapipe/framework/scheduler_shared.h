@@ -25,6 +25,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -60,21 +61,37 @@ class SchedulerTimer {
 
   // Called when starting the scheduler.
   void StartRun() {
+    end_time_ = 0;
     start_time_ = absl::ToUnixMicros(clock_->TimeNow());
     total_node_time_ = 0;
   }
   // Called when terminating the scheduler.
   void EndRun() {
-    total_run_time_ = absl::ToUnixMicros(clock_->TimeNow()) - start_time_;
+    end_time_ = absl::ToUnixMicros(clock_->TimeNow());
+    total_run_time_ = end_time_ - start_time_;
   }
 
   // Called immediately before invoking ProcessNode or CloseNode.
   int64 StartNode() { return absl::ToUnixMicros(clock_->TimeNow()); }
-  // Called immediately after invoking ProcessNode or CloseNode.
-  void EndNode(int64 node_start_time) {
-    total_node_time_.fetch_add(
-        absl::ToUnixMicros(clock_->TimeNow()) - node_start_time,
-        std::memory_order_relaxed);
+  // Called immediately after invoking ProcessNode or CloseNode.  Returns the
+  // node time in microseconds.
+  int64 EndNode(int64 node_start_time) {
+    const int64 node_time =
+        absl::ToUnixMicros(clock_->TimeNow()) - node_start_time;
+    total_node_time_.fetch_add(node_time, std::memory_order_relaxed);
+    return node_time;
+  }
+
+  // Returns the wall time of the current run so far, or of the last run once
+  // it has ended, in microseconds. Returns 0 before the first run.
+  int64 RunTime() {
+    const int64 start_time = start_time_;
+    if (start_time == 0) {
+      return 0;
+    }
+    const int64 end_time = end_time_;
+    return (end_time != 0 ? end_time : absl::ToUnixMicros(clock_->TimeNow())) -
+           start_time;
   }
 
   SchedulerTimes GetSchedulerTimes() {
@@ -91,8 +108,10 @@ class SchedulerTimer {
   // Time spent actually running nodes, in microseconds.
   std::atomic<int64> total_node_time_;
 
-  // The start time of the graph, in microseconds.
-  int64 start_time_;
+  // The start and end times of the last run, in microseconds. The end time
+  // is 0 while the graph is running.
+  std::atomic<int64> start_time_{0};
+  std::atomic<int64> end_time_{0};
   // Total time spent running the graph, in microseconds.
   int64 total_run_time_;
 };
@@ -106,8 +125,13 @@ struct SchedulerShared {
   std::atomic<bool> stopping;
   std::atomic<bool> has_error;
   std::function<void(const absl::Status& error)> error_callback;
+  // If set, called with the node id after each Process() call of a
+  // calculator.
+  std::function<void(int node_id)> node_processed_callback;
   // Collects timing information for measuring overhead.
   internal::SchedulerTimer timer;
+  // The arena made current while calculators run, or null.
+  PacketArena* packet_arena = nullptr;
 };
 
 }  // namespace internal
@@ -0,0 +1,159 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the cost of timestamp bound propagation on a graph in which many
+// detector calculators rarely output a packet, and one calculator merges all
+// the detection streams. Most updates of the merging calculator's input
+// streams only advance timestamp bounds.
+//
+// bazel run -c opt //mediapipe/framework:sparse_streams_benchmark
+
+#include <map>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kPacketsPerIteration = 100;
+// Each detector outputs a packet for one input packet out of this many.
+constexpr int kDetectionPeriod = 64;
+
+// Outputs the input packet once every kDetectionPeriod packets, staggered by
+// the "PHASE" input side packet. The timestamp offset advances the output
+// bound for the other packets.
+class SparseDetectorCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->InputSidePackets().Tag("PHASE").Set<int>();
+    cc->SetTimestampOffset(0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) final {
+    phase_ = cc->InputSidePackets().Tag("PHASE").Get<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    if ((cc->Inputs().Index(0).Get<int>() + phase_) % kDetectionPeriod == 0) {
+      cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  int phase_ = 0;
+};
+REGISTER_CALCULATOR(SparseDetectorCalculator);
+
+// Counts the detections at each timestamp. Optionally also runs for the
+// timestamps at which there are none.
+class MergeDetectionsCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      cc->Inputs().Index(i).Set<int>();
+    }
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetTimestampOffset(0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    int count = 0;
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      count += cc->Inputs().Index(i).IsEmpty() ? 0 : 1;
+    }
+    if (count > 0) {
+      cc->Outputs().Index(0).AddPacket(
+          MakePacket<int>(count).At(cc->InputTimestamp()));
+    }
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(MergeDetectionsCalculator);
+
+// Also runs for the timestamps without detections.
+class MergeAllDetectionsCalculator : public MergeDetectionsCalculator {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    MP_RETURN_IF_ERROR(MergeDetectionsCalculator::GetContract(cc));
+    cc->SetProcessTimestampBounds(true);
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(MergeAllDetectionsCalculator);
+
+CalculatorGraphConfig MakeSparseStreamsConfig(int num_detectors,
+                                              bool process_bounds) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("frame");
+  config.set_num_threads(1);
+  CalculatorGraphConfig::Node* merge = config.add_node();
+  merge->set_calculator(process_bounds ? "MergeAllDetectionsCalculator"
+                                       : "MergeDetectionsCalculator");
+  merge->set_name("merge");
+  merge->add_output_stream("count");
+  for (int i = 0; i < num_detectors; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("SparseDetectorCalculator");
+    node->add_input_stream("frame");
+    node->add_output_stream(absl::StrCat("detections_", i));
+    node->add_input_side_packet(absl::StrCat("PHASE:phase_", i));
+    merge->add_input_stream(absl::StrCat("detections_", i));
+  }
+  return config;
+}
+
+void BM_SparseStreams(benchmark::State& state) {
+  const int num_detectors = state.range(0);
+  const bool process_bounds = state.range(1);
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.Initialize(
+      MakeSparseStreamsConfig(num_detectors, process_bounds)));
+  std::map<std::string, Packet> side_packets;
+  for (int i = 0; i < num_detectors; ++i) {
+    side_packets[absl::StrCat("phase_", i)] = MakePacket<int>(i);
+  }
+  MEDIAPIPE_CHECK_OK(graph.StartRun(side_packets));
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+          "frame", MakePacket<int>(timestamp).At(Timestamp(timestamp))));
+      ++timestamp;
+    }
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilIdle());
+  }
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  state.SetItemsProcessed(state.iterations() * kPacketsPerIteration);
+  state.counters["bound_only_per_frame"] =
+      static_cast<double>(graph.GetCounterFactory()
+                              ->GetCounter("merge-BoundOnlyInvocations")
+                              ->Get()) /
+      timestamp;
+}
+BENCHMARK(BM_SparseStreams)->Args({20, 0})->Args({20, 1})->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
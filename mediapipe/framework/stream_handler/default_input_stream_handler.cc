@@ -38,7 +38,8 @@ DefaultInputStreamHandler::DefaultInputStreamHandler(
     const MediaPipeOptions& options, bool calculator_run_in_parallel)
     : InputStreamHandler(std::move(tag_map), cc_manager, options,
                          calculator_run_in_parallel),
-      sync_set_(this, GetIds(input_stream_managers_.TagMap())) {
+      sync_set_(this, GetIds(input_stream_managers_.TagMap())),
+      is_min_bound_stream_(input_stream_managers_.NumEntries(), false) {
   if (options.HasExtension(DefaultInputStreamHandlerOptions::ext)) {
     SetBatchSize(options.GetExtension(DefaultInputStreamHandlerOptions::ext)
                      .batch_size());
@@ -51,6 +52,14 @@ void DefaultInputStreamHandler::PrepareForRun(
     std::function<void(CalculatorContext*)> schedule_callback,
     std::function<void(absl::Status)> error_callback) {
   sync_set_.PrepareForRun();
+  {
+    absl::MutexLock lock(&min_bound_mutex_);
+    min_bound_ids_valid_ = false;
+    min_bound_ids_.clear();
+    num_min_bound_streams_ = 0;
+    std::fill(is_min_bound_stream_.begin(), is_min_bound_stream_.end(),
+              false);
+  }
   InputStreamHandler::PrepareForRun(
       std::move(headers_ready_callback), std::move(notification_callback),
       std::move(schedule_callback), std::move(error_callback));
@@ -58,7 +67,41 @@ void DefaultInputStreamHandler::PrepareForRun(
 
 NodeReadiness DefaultInputStreamHandler::GetNodeReadiness(
     Timestamp* min_stream_timestamp) {
-  return sync_set_.GetReadiness(min_stream_timestamp);
+  // Bound changes during the readiness check are not coalesced, since the
+  // check may or may not observe them.
+  {
+    absl::MutexLock lock(&min_bound_mutex_);
+    min_bound_ids_valid_ = false;
+  }
+  NodeReadiness readiness =
+      sync_set_.GetReadiness(min_stream_timestamp, &scanned_min_bound_ids_);
+  // The new minimum-bound streams are published in one critical section, so
+  // a bound change is counted either against the old set, while it is
+  // invalid, or against the complete new set.
+  absl::MutexLock lock(&min_bound_mutex_);
+  for (CollectionItemId id : min_bound_ids_) {
+    is_min_bound_stream_[id.value()] = false;
+  }
+  min_bound_ids_.swap(scanned_min_bound_ids_);
+  for (CollectionItemId id : min_bound_ids_) {
+    is_min_bound_stream_[id.value()] = true;
+  }
+  num_min_bound_streams_ = min_bound_ids_.size();
+  min_bound_ids_valid_ = !min_bound_ids_.empty();
+  return readiness;
+}
+
+bool DefaultInputStreamHandler::BoundChangeMayAffectNode(CollectionItemId id) {
+  absl::MutexLock lock(&min_bound_mutex_);
+  if (!min_bound_ids_valid_) {
+    return true;
+  }
+  if (!is_min_bound_stream_[id.value()]) {
+    // Another empty stream still holds the minimum bound.
+    return false;
+  }
+  is_min_bound_stream_[id.value()] = false;
+  return --num_min_bound_streams_ == 0;
 }
 
 void DefaultInputStreamHandler::FillInputSet(Timestamp input_timestamp,
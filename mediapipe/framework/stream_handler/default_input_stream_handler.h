@@ -18,6 +18,8 @@
 #include <memory>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 // TODO: Move protos in another CL after the C++ code migration.
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/stream_handler/default_input_stream_handler.pb.h"
@@ -52,8 +54,32 @@ class DefaultInputStreamHandler : public InputStreamHandler {
   void FillInputSet(Timestamp input_timestamp,
                     InputStreamShardSet* input_set) override;
 
+  // Returns true only for the last of the empty streams with the minimum
+  // bound, as of the latest GetNodeReadiness(), to advance its bound. The
+  // readiness and the propagated bound depend only on the minimum bound, so
+  // the bound updates of the other streams are coalesced into that one.
+  bool BoundChangeMayAffectNode(CollectionItemId id) override;
+
   // The packet-set builder.
   SyncSet sync_set_;
+
+  // The empty streams with the minimum bound found by the readiness check
+  // in progress. Used only while the node is scheduling.
+  std::vector<CollectionItemId> scanned_min_bound_ids_;
+
+  // Guards the minimum-bound streams of the latest GetNodeReadiness(), which
+  // are replaced as a whole while producer threads report bound changes.
+  absl::Mutex min_bound_mutex_;
+  // The empty streams with the minimum bound found by the latest
+  // GetNodeReadiness().
+  std::vector<CollectionItemId> min_bound_ids_
+      ABSL_GUARDED_BY(min_bound_mutex_);
+  // False while GetNodeReadiness() runs, and when no stream is empty.
+  bool min_bound_ids_valid_ ABSL_GUARDED_BY(min_bound_mutex_) = false;
+  // The number of streams in min_bound_ids_ whose bound has not advanced.
+  int num_min_bound_streams_ ABSL_GUARDED_BY(min_bound_mutex_) = 0;
+  // Whether each stream is in min_bound_ids_ and its bound has not advanced.
+  std::vector<bool> is_min_bound_stream_ ABSL_GUARDED_BY(min_bound_mutex_);
 };
 
 }  // namespace mediapipe
@@ -14,11 +14,13 @@
 
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/port/threadpool.h"
 
 namespace mediapipe {
 
@@ -279,5 +281,160 @@ TEST(DefaultInputStreamHandlerTest, DoesntPropagateTimestampWhenBatching) {
   EXPECT_EQ(4, sink.size());
 }
 
+// Passes through the non-zero input packets. The timestamp offset advances
+// the output timestamp bound at the other timestamps.
+class NonZeroFilterCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetTimestampOffset(0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    if (cc->Inputs().Index(0).Get<int>() != 0) {
+      cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    }
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(NonZeroFilterCalculator);
+
+// Outputs the number of input packets at each settled timestamp.
+class CountInputPacketsCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      cc->Inputs().Index(i).Set<int>();
+    }
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetProcessTimestampBounds(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    int count = 0;
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      count += cc->Inputs().Index(i).IsEmpty() ? 0 : 1;
+    }
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(count).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(CountInputPacketsCalculator);
+
+// Verifies that a node whose input streams mostly advance only their timestamp
+// bounds still runs at every settled timestamp, and that the invocations
+// without input packets are counted.
+TEST(DefaultInputStreamHandlerTest, ProcessesSparseTimestampBounds) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input0"
+        input_stream: "input1"
+        input_stream: "input2"
+        node {
+          calculator: "NonZeroFilterCalculator"
+          input_stream: "input0"
+          output_stream: "detections0"
+        }
+        node {
+          calculator: "NonZeroFilterCalculator"
+          input_stream: "input1"
+          output_stream: "detections1"
+        }
+        node {
+          calculator: "NonZeroFilterCalculator"
+          input_stream: "input2"
+          output_stream: "detections2"
+        }
+        node {
+          name: "count"
+          calculator: "CountInputPacketsCalculator"
+          input_stream: "detections0"
+          input_stream: "detections1"
+          input_stream: "detections2"
+          output_stream: "count"
+        })pb");
+  std::vector<Packet> sink;
+  tool::AddVectorSink("count", &config, &sink);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int t = 0; t < 10; ++t) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input0", MakePacket<int>(t % 3 == 0 ? 1 : 0).At(Timestamp(t))));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input1", MakePacket<int>(t == 5 || t == 6 ? 1 : 0).At(Timestamp(t))));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input2", MakePacket<int>(0).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  // Every timestamp is processed before the input streams are closed.
+  std::vector<int> counts;
+  for (const Packet& packet : sink) {
+    counts.push_back(packet.Get<int>());
+  }
+  EXPECT_THAT(counts, testing::ElementsAre(1, 0, 0, 1, 0, 1, 2, 0, 0, 1));
+  EXPECT_EQ(5, graph.GetCounterFactory()
+                   ->GetCounter("count-BoundOnlyInvocations")
+                   ->Get());
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+// Advances the timestamp bounds of many input streams of one node from
+// several threads at once, while the node checks its readiness, and verifies
+// that no bound change is lost: the node runs at the last settled timestamp
+// before the input streams are closed. It may skip the timestamps settled
+// while it was running, since it runs at the latest one.
+TEST(DefaultInputStreamHandlerTest, ConcurrentBoundChangesAreNotLost) {
+  constexpr int kNumStreams = 8;
+  constexpr int kNumTimestamps = 500;
+  CalculatorGraphConfig config;
+  config.set_num_threads(4);
+  CalculatorGraphConfig::Node* count = config.add_node();
+  count->set_name("count");
+  count->set_calculator("CountInputPacketsCalculator");
+  count->add_output_stream("count");
+  for (int i = 0; i < kNumStreams; ++i) {
+    const std::string input = absl::StrCat("input", i);
+    const std::string detections = absl::StrCat("detections", i);
+    config.add_input_stream(input);
+    CalculatorGraphConfig::Node* filter = config.add_node();
+    filter->set_calculator("NonZeroFilterCalculator");
+    filter->add_input_stream(input);
+    filter->add_output_stream(detections);
+    count->add_input_stream(detections);
+  }
+  std::vector<Packet> sink;
+  tool::AddVectorSink("count", &config, &sink);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  {
+    // Every stream only advances its bound, from its own thread.
+    mediapipe::ThreadPool pool(kNumStreams);
+    pool.StartWorkers();
+    for (int i = 0; i < kNumStreams; ++i) {
+      pool.Schedule([&graph, i] {
+        const std::string input = absl::StrCat("input", i);
+        for (int t = 0; t < kNumTimestamps; ++t) {
+          MP_EXPECT_OK(graph.AddPacketToInputStream(
+              input, MakePacket<int>(0).At(Timestamp(t))));
+        }
+      });
+    }
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_FALSE(sink.empty());
+  EXPECT_EQ(Timestamp(kNumTimestamps - 1), sink.back().Timestamp());
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -199,6 +199,10 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
     }
   }
 
+  // Packets are erased outside of GetNodeReadiness(), which may also skip the
+  // readiness check, so every bound change is reported to the node.
+  bool BoundChangeMayAffectNode(CollectionItemId id) override { return true; }
+
   void FillInputSet(Timestamp input_timestamp,
                     InputStreamShardSet* input_set) override {
     CHECK(input_set);
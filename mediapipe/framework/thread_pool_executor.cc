@@ -14,12 +14,18 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <set>
 #include <utility>
 
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status_builder.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/work_stealing_executor.h"
 #include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
@@ -59,18 +65,48 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
   if (options.has_thread_name_prefix()) {
     thread_options.set_name_prefix(options.thread_name_prefix());
   }
+  if (options.cpu_ids_size() > 0 && options.has_numa_node()) {
+    return absl::InvalidArgumentError(
+        "Only one of cpu_ids and numa_node can be specified in "
+        "ThreadPoolExecutorOptions.");
+  }
 #if defined(__linux__)
-  switch (options.require_processor_performance()) {
-    case ThreadPoolExecutorOptions::LOW:
-      thread_options.set_cpu_set(InferLowerCoreIds());
-      break;
-    case ThreadPoolExecutorOptions::HIGH:
-      thread_options.set_cpu_set(InferHigherCoreIds());
-      break;
-    default:
-      break;
+  for (int cpu : options.cpu_ids()) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The cpu_ids field in ThreadPoolExecutorOptions contains the "
+                "invalid CPU id "
+             << cpu;
+    }
+  }
+  if (options.cpu_ids_size() > 0) {
+    thread_options.set_cpu_set(
+        std::set<int>(options.cpu_ids().begin(), options.cpu_ids().end()));
+  } else if (options.has_numa_node()) {
+    auto cpus_or_status = GetNumaNodeCoreIds(options.numa_node());
+    if (!cpus_or_status.ok()) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Cannot pin ThreadPoolExecutor to NUMA node "
+             << options.numa_node() << ": "
+             << cpus_or_status.status().message();
+    }
+    thread_options.set_cpu_set(cpus_or_status.value());
+  } else {
+    switch (options.require_processor_performance()) {
+      case ThreadPoolExecutorOptions::LOW:
+        thread_options.set_cpu_set(InferLowerCoreIds());
+        break;
+      case ThreadPoolExecutorOptions::HIGH:
+        thread_options.set_cpu_set(InferHigherCoreIds());
+        break;
+      default:
+        break;
+    }
   }
 #endif
+  if (options.use_work_stealing()) {
+    return new WorkStealingExecutor(thread_options, options.num_threads());
+  }
   return new ThreadPoolExecutor(thread_options, options.num_threads());
 }
 
@@ -0,0 +1,47 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/work_stealing_executor.h"
+
+#include <utility>
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+WorkStealingExecutor::WorkStealingExecutor(const ThreadOptions& thread_options,
+                                           int num_threads)
+    : thread_pool_(thread_options,
+                   thread_options.name_prefix().empty()
+                       ? "mediapipe"
+                       : thread_options.name_prefix(),
+                   num_threads) {
+  thread_pool_.StartWorkers();
+  VLOG(2) << "Started work-stealing thread pool with "
+          << thread_pool_.num_threads() << " threads.";
+}
+
+WorkStealingExecutor::WorkStealingExecutor(int num_threads)
+    : WorkStealingExecutor(ThreadOptions(), num_threads) {}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  VLOG(2) << "Terminating work-stealing thread pool after "
+          << thread_pool_.num_steals() << " steals.";
+}
+
+void WorkStealingExecutor::Schedule(std::function<void()> task) {
+  thread_pool_.Schedule(std::move(task));
+}
+
+}  // namespace mediapipe
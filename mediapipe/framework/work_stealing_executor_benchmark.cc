@@ -0,0 +1,105 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Compares the default ThreadPoolExecutor with the work-stealing executor on
+// a wide fan-out graph of trivial calculators, where scheduling overhead
+// dominates the calculators' own work.
+//
+// bazel run -c opt \
+//   //mediapipe/framework:work_stealing_executor_benchmark -- \
+//   --benchmark_filter=FanOut
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kPacketsPerIteration = 16;
+
+// Builds a graph in which "input" feeds "width" PassThroughCalculators, each
+// of which feeds one more PassThroughCalculator. The second layer is
+// scheduled from worker threads as the first layer completes.
+CalculatorGraphConfig MakeFanOutConfig(int width, int num_threads,
+                                       bool use_work_stealing) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  ThreadPoolExecutorOptions* options =
+      config.add_executor()->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  options->set_num_threads(num_threads);
+  options->set_use_work_stealing(use_work_stealing);
+  for (int i = 0; i < width; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream("input");
+    node->add_output_stream(absl::StrCat("fan_out_", i));
+    node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("fan_out_", i));
+    node->add_output_stream(absl::StrCat("output_", i));
+  }
+  return config;
+}
+
+void RunFanOut(benchmark::State& state, bool use_work_stealing) {
+  const int width = state.range(0);
+  const int num_threads = state.range(1);
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.Initialize(
+      MakeFanOutConfig(width, num_threads, use_work_stealing)));
+  MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(timestamp++))));
+    }
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilIdle());
+  }
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  // Items are calculator Process() invocations.
+  state.SetItemsProcessed(state.iterations() * kPacketsPerIteration * width *
+                          2);
+}
+
+void BM_FanOutThreadPool(benchmark::State& state) {
+  RunFanOut(state, /*use_work_stealing=*/false);
+}
+
+void BM_FanOutWorkStealing(benchmark::State& state) {
+  RunFanOut(state, /*use_work_stealing=*/true);
+}
+
+// Arguments are {fan-out width, number of threads}.
+BENCHMARK(BM_FanOutThreadPool)
+    ->Args({16, 4})
+    ->Args({64, 8})
+    ->Args({256, 16})
+    ->Args({256, 32})
+    ->UseRealTime();
+BENCHMARK(BM_FanOutWorkStealing)
+    ->Args({16, 4})
+    ->Args({64, 8})
+    ->Args({256, 16})
+    ->Args({256, 32})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
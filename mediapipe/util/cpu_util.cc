@@ -27,8 +27,10 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/flags/flag.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -38,6 +40,13 @@ ABSL_FLAG(std::string, system_cpu_max_freq_file,
           "/sys/devices/system/cpu/cpu$0/cpufreq/cpuinfo_max_freq",
           "The file pattern for CPU max frequencies, where $0 will be replaced "
           "with the CPU id.");
+ABSL_FLAG(std::string, system_numa_node_online_file,
+          "/sys/devices/system/node/online",
+          "The file listing the ids of the online NUMA nodes.");
+ABSL_FLAG(std::string, system_numa_node_cpulist_file,
+          "/sys/devices/system/node/node$0/cpulist",
+          "The file pattern for the CPU lists of NUMA nodes, where $0 will be "
+          "replaced with the node id.");
 
 namespace mediapipe {
 namespace {
@@ -114,6 +123,53 @@ std::set<int> InferLowerOrHigherCoreIds(bool lower) {
     return inferred_cores;
   }
 }
+
+// Reads the first line of |path|.
+absl::StatusOr<std::string> ReadFirstLine(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return absl::NotFoundError(absl::StrCat("Couldn't read ", path));
+  }
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+// Reads the first line of the cpulist file of a NUMA node, such as "0-3,8-11".
+absl::StatusOr<std::string> ReadNumaNodeCpuList(int node) {
+  const std::string pattern =
+      absl::GetFlag(FLAGS_system_numa_node_cpulist_file);
+  if (pattern.find("$0") == std::string::npos) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid NUMA node cpulist file: ", pattern));
+  }
+  return ReadFirstLine(absl::Substitute(pattern, node));
+}
+
+// Parses a sysfs id list such as "0,2-3" into the ids it contains.
+absl::StatusOr<std::set<int>> ParseIdList(absl::string_view list) {
+  std::set<int> ids;
+  for (absl::string_view range :
+       absl::StrSplit(absl::StripAsciiWhitespace(list), ',',
+                      absl::SkipEmpty())) {
+    std::pair<absl::string_view, absl::string_view> bounds =
+        absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first, last;
+    if (!absl::SimpleAtoi(bounds.first, &first)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid id list: ", list));
+    }
+    last = first;
+    if (!bounds.second.empty() && !absl::SimpleAtoi(bounds.second, &last)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid id list: ", list));
+    }
+    for (int id = first; id <= last; ++id) {
+      ids.insert(id);
+    }
+  }
+  return ids;
+}
 }  // namespace
 
 int NumCPUCores() {
@@ -136,4 +192,40 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+std::set<int> GetNumaNodeIds() {
+  auto online_or_status =
+      ReadFirstLine(absl::GetFlag(FLAGS_system_numa_node_online_file));
+  if (!online_or_status.ok()) {
+    return {};
+  }
+  auto ids_or_status = ParseIdList(online_or_status.value());
+  if (!ids_or_status.ok()) {
+    return {};
+  }
+  return ids_or_status.value();
+}
+
+int NumNumaNodes() { return GetNumaNodeIds().size(); }
+
+absl::StatusOr<std::set<int>> GetNumaNodeCoreIds(int node) {
+  if (node < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid NUMA node: ", node));
+  }
+  auto cpu_list_or_status = ReadNumaNodeCpuList(node);
+  if (!cpu_list_or_status.ok()) {
+    return cpu_list_or_status.status();
+  }
+  auto cpus_or_status = ParseIdList(cpu_list_or_status.value());
+  if (!cpus_or_status.ok()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid CPU list: ", cpu_list_or_status.value()));
+  }
+  if (cpus_or_status.value().empty()) {
+    return absl::NotFoundError(
+        absl::StrCat("NUMA node ", node, " has no CPUs"));
+  }
+  return cpus_or_status;
+}
+
 }  // namespace mediapipe.
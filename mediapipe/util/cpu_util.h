@@ -17,6 +17,8 @@
 
 #include <set>
 
+#include "mediapipe/framework/port/statusor.h"
+
 namespace mediapipe {
 // Returns the number of CPU cores. Compatible with Android.
 int NumCPUCores();
@@ -24,6 +26,14 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Returns the ids of the online NUMA nodes, or an empty set if the system does
+// not report them. The ids need not be contiguous.
+std::set<int> GetNumaNodeIds();
+// Returns the number of online NUMA nodes, or 0 if the system does not report
+// them.
+int NumNumaNodes();
+// Returns the set of CPU ids of a NUMA node.
+absl::StatusOr<std::set<int>> GetNumaNodeCoreIds(int node);
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_
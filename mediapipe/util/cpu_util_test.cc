@@ -0,0 +1,93 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/cpu_util.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+ABSL_DECLARE_FLAG(std::string, system_numa_node_online_file);
+ABSL_DECLARE_FLAG(std::string, system_numa_node_cpulist_file);
+
+namespace mediapipe {
+namespace {
+
+// Points the NUMA sysfs flags at files in the test directory.
+class NumaNodeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    saved_online_file_ = absl::GetFlag(FLAGS_system_numa_node_online_file);
+    saved_cpulist_pattern_ =
+        absl::GetFlag(FLAGS_system_numa_node_cpulist_file);
+    absl::SetFlag(&FLAGS_system_numa_node_online_file,
+                  TestPath("numa_node_online"));
+    absl::SetFlag(&FLAGS_system_numa_node_cpulist_file,
+                  TestPath("numa_node_cpulist_$0"));
+  }
+
+  void TearDown() override {
+    absl::SetFlag(&FLAGS_system_numa_node_online_file, saved_online_file_);
+    absl::SetFlag(&FLAGS_system_numa_node_cpulist_file,
+                  saved_cpulist_pattern_);
+  }
+
+  static std::string TestPath(const std::string& name) {
+    return absl::StrCat(getenv("TEST_TMPDIR"), "/", name);
+  }
+
+  std::string saved_online_file_;
+  std::string saved_cpulist_pattern_;
+};
+
+TEST_F(NumaNodeTest, ReadsNonContiguousNodeIds) {
+  std::ofstream(TestPath("numa_node_online")) << "0,2-3\n";
+  EXPECT_THAT(GetNumaNodeIds(), testing::ElementsAre(0, 2, 3));
+  EXPECT_EQ(NumNumaNodes(), 3);
+}
+
+TEST_F(NumaNodeTest, ReportsNoNodesWithoutOnlineFile) {
+  std::remove(TestPath("numa_node_online").c_str());
+  EXPECT_TRUE(GetNumaNodeIds().empty());
+  EXPECT_EQ(NumNumaNodes(), 0);
+
+  std::ofstream(TestPath("numa_node_online")) << "0-x\n";
+  EXPECT_TRUE(GetNumaNodeIds().empty());
+}
+
+TEST_F(NumaNodeTest, ReadsNodeCoreIds) {
+  std::ofstream(TestPath("numa_node_cpulist_2")) << "0-1,4\n";
+  auto cpus_or_status = GetNumaNodeCoreIds(2);
+  MP_ASSERT_OK(cpus_or_status);
+  EXPECT_THAT(cpus_or_status.value(), testing::ElementsAre(0, 1, 4));
+
+  std::ofstream(TestPath("numa_node_cpulist_3")) << "\n";
+  EXPECT_EQ(GetNumaNodeCoreIds(3).status().code(),
+            absl::StatusCode::kNotFound);
+  EXPECT_EQ(GetNumaNodeCoreIds(5).status().code(),
+            absl::StatusCode::kNotFound);
+  EXPECT_EQ(GetNumaNodeCoreIds(-1).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -13,6 +13,9 @@ typedef std::function<absl::Status(const std::string&, std::string*)>
 // Overrides the behavior of GetResourceContents.
 void SetCustomGlobalResourceProvider(ResourceProviderFn fn);
 
+// Returns whether a custom resource provider is set.
+bool HasCustomGlobalResourceProvider();
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_RESOURCE_UTIL_CUSTOM_H_
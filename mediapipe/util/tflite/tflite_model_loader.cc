@@ -14,15 +14,107 @@
 
 #include "mediapipe/util/tflite/tflite_model_loader.h"
 
+#include <sys/stat.h>
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/util/resource_util.h"
+#include "mediapipe/util/resource_util_custom.h"
 
 namespace mediapipe {
 
+namespace {
+
+// Returns a key identifying the contents of the regular file at "path", or an
+// empty string if "path" is not a regular file.
+std::string FileIdentity(const std::string& path) {
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+    return "";
+  }
+  // st_ino is not meaningful on every platform, so the path is part of the
+  // key as well. Size and modification time catch files replaced in place.
+  return absl::StrCat(path, ":", file_stat.st_dev, ":", file_stat.st_ino, ":",
+                      file_stat.st_size, ":", file_stat.st_mtime);
+}
+
+// Process-wide cache of models loaded from files. Graphs that load the same
+// model file share a single, memory-mapped FlatBufferModel. Entries are held
+// weakly: a model is unmapped as soon as the last packet referencing it is
+// destroyed.
+class ModelFileCache {
+ public:
+  static ModelFileCache& Get() {
+    static ModelFileCache* cache = new ModelFileCache();
+    return *cache;
+  }
+
+  absl::StatusOr<std::shared_ptr<tflite::FlatBufferModel>> GetOrLoad(
+      const std::string& path, const std::string& identity) {
+    absl::MutexLock lock(&mutex_);
+    auto found = models_.find(identity);
+    if (found != models_.end()) {
+      if (auto model = found->second.lock()) {
+        return model;
+      }
+    }
+    // Drop entries of models that are no longer used.
+    for (auto it = models_.begin(); it != models_.end();) {
+      if (it->second.expired()) {
+        models_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    VLOG(2) << "Memory-mapping the model from " << path;
+    std::shared_ptr<tflite::FlatBufferModel> model =
+        tflite::FlatBufferModel::VerifyAndBuildFromFile(path.c_str());
+    RET_CHECK(model) << "Failed to load model from path " << path;
+    models_[identity] = model;
+    return model;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::weak_ptr<tflite::FlatBufferModel>>
+      models_ ABSL_GUARDED_BY(mutex_);
+};
+
+absl::StatusOr<api2::Packet<TfLiteModelPtr>> LoadFromFile(
+    const std::string& path, const std::string& identity) {
+  ASSIGN_OR_RETURN(auto model, ModelFileCache::Get().GetOrLoad(path, identity));
+  tflite::FlatBufferModel* model_ptr = model.get();
+  return api2::MakePacket<TfLiteModelPtr>(
+      model_ptr, [model = std::move(model)](tflite::FlatBufferModel*) {
+        // The model is owned by the shared_ptr captured here, and deleted
+        // once no packet refers to it anymore.
+      });
+}
+
+}  // namespace
+
 absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
     const std::string& path) {
   std::string model_path = path;
 
+  // Model files are memory-mapped and shared, but only where the resource
+  // functions would find them: a custom resource provider takes precedence,
+  // and a file is looked up at its resolved path only.
+  if (!HasCustomGlobalResourceProvider()) {
+    auto resolved_path = mediapipe::PathToResourceAsFile(model_path);
+    if (resolved_path.ok()) {
+      const std::string identity = FileIdentity(*resolved_path);
+      if (!identity.empty()) {
+        return LoadFromFile(*resolved_path, identity);
+      }
+    }
+  }
+
   std::string model_blob;
   auto status_or_content =
       mediapipe::GetResourceContents(model_path, &model_blob);
@@ -30,6 +30,11 @@ class TfLiteModelLoader {
  public:
   // Returns a Packet containing a TfLiteModelPtr, pointing to a model loaded
   // from the specified file path.
+  //
+  // Models that are regular files on disk are memory-mapped and cached for
+  // the whole process: loading the same, unchanged file again returns the
+  // same model as long as a packet from an earlier load is still alive.
+  // Other resources (e.g. Android assets) are read into memory per call.
   static absl::StatusOr<api2::Packet<TfLiteModelPtr>> LoadFromPath(
       const std::string& path);
 };
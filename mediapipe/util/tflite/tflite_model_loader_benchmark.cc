@@ -0,0 +1,190 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the startup time and memory of 1 and of 50 graphs that load the
+// same model.  Each graph runs a calculator that loads the model in Open()
+// and holds it until Close(), as InferenceCalculator does.  The "Copied"
+// runs read the model file into memory for every graph, as
+// TfLiteModelLoader::LoadFromPath did before model files were memory-mapped
+// and shared.  The "Shared" runs call TfLiteModelLoader::LoadFromPath.
+//
+// An iteration starts the graphs and waits until all of them have opened.
+// The "rss_mb" counter is the growth of the resident set size while the
+// graphs are open, and the "model_mb" counter is the size of the model file.
+// Model buffers are always allocated with mmap, so that the buffers freed by
+// one iteration are not reused by the next one without growing the resident
+// set.
+//
+// bazel run -c opt //mediapipe/util/tflite:tflite_model_loader_benchmark
+
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif  // __GLIBC__
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/resource_util.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+
+namespace mediapipe {
+namespace {
+
+// The model loaded by every graph.
+constexpr char kModelPath[] =
+    "mediapipe/modules/palm_detection/palm_detection.tflite";
+
+// Loads the model like TfLiteModelLoader::LoadFromPath did before models
+// were shared: the file is read into a buffer owned by the returned model.
+absl::StatusOr<api2::Packet<TfLiteModelPtr>> LoadCopy(
+    const std::string& path) {
+  ASSIGN_OR_RETURN(std::string resolved_path, PathToResourceAsFile(path));
+  std::string model_blob;
+  MP_RETURN_IF_ERROR(GetResourceContents(resolved_path, &model_blob));
+  auto model = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(
+      model_blob.data(), model_blob.size());
+  RET_CHECK(model) << "Failed to load model from path " << path;
+  return api2::MakePacket<TfLiteModelPtr>(
+      model.release(),
+      [model_blob = std::move(model_blob)](tflite::FlatBufferModel* model) {
+        delete model;
+      });
+}
+
+// Loads the model given by the "model_path" side packet in Open(), and holds
+// it until the graph is closed.
+class HoldModelCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->InputSidePackets().Tag("MODEL_PATH").Set<std::string>();
+    cc->InputSidePackets().Tag("SHARED").Set<bool>();
+    cc->Inputs().Index(0).SetAny();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) final {
+    const std::string& path =
+        cc->InputSidePackets().Tag("MODEL_PATH").Get<std::string>();
+    if (cc->InputSidePackets().Tag("SHARED").Get<bool>()) {
+      ASSIGN_OR_RETURN(model_, TfLiteModelLoader::LoadFromPath(path));
+    } else {
+      ASSIGN_OR_RETURN(model_, LoadCopy(path));
+    }
+    RET_CHECK(model_.Get()->GetModel());
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    return absl::OkStatus();
+  }
+
+ private:
+  api2::Packet<TfLiteModelPtr> model_;
+};
+REGISTER_CALCULATOR(HoldModelCalculator);
+
+// Returns the resident set size of this process in bytes.
+int64 ResidentBytes() {
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm) {
+    return 0;
+  }
+  long size = 0;
+  long resident = 0;
+  if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+    resident = 0;
+  }
+  fclose(statm);
+  return static_cast<int64>(resident) * sysconf(_SC_PAGESIZE);
+}
+
+void RunGraphs(benchmark::State& state, bool shared) {
+  const int num_graphs = state.range(0);
+#ifdef __GLIBC__
+  // Fixes the threshold, which glibc otherwise raises as buffers are freed.
+  mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+#endif  // __GLIBC__
+  const std::string model_path = kModelPath;
+  auto resolved_path = PathToResourceAsFile(model_path);
+  CHECK(resolved_path.ok()) << resolved_path.status();
+  std::string model_blob;
+  CHECK(GetResourceContents(*resolved_path, &model_blob).ok());
+
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.add_input_side_packet("model_path");
+  config.add_input_side_packet("shared");
+  config.set_num_threads(1);
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("HoldModelCalculator");
+  node->add_input_stream("input");
+  node->add_input_side_packet("MODEL_PATH:model_path");
+  node->add_input_side_packet("SHARED:shared");
+  const std::map<std::string, Packet> side_packets = {
+      {"model_path", MakePacket<std::string>(model_path)},
+      {"shared", MakePacket<bool>(shared)}};
+
+  int64 rss_growth = 0;
+  for (auto _ : state) {
+    const int64 rss_before = ResidentBytes();
+    std::vector<std::unique_ptr<CalculatorGraph>> graphs;
+    for (int i = 0; i < num_graphs; ++i) {
+      graphs.push_back(absl::make_unique<CalculatorGraph>());
+      CHECK(graphs.back()->Initialize(config).ok());
+      CHECK(graphs.back()->StartRun(side_packets).ok());
+    }
+    for (auto& graph : graphs) {
+      CHECK(graph->WaitUntilIdle().ok());
+    }
+    state.PauseTiming();
+    rss_growth = ResidentBytes() - rss_before;
+    for (auto& graph : graphs) {
+      CHECK(graph->CloseAllInputStreams().ok());
+      CHECK(graph->WaitUntilDone().ok());
+    }
+    graphs.clear();
+    state.ResumeTiming();
+  }
+  state.counters["rss_mb"] = rss_growth / (1024.0 * 1024.0);
+  state.counters["model_mb"] = model_blob.size() / (1024.0 * 1024.0);
+}
+
+void BM_StartGraphsCopied(benchmark::State& state) {
+  RunGraphs(state, /*shared=*/false);
+}
+BENCHMARK(BM_StartGraphsCopied)
+    ->Arg(1)
+    ->Arg(50)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_StartGraphsShared(benchmark::State& state) {
+  RunGraphs(state, /*shared=*/true);
+}
+BENCHMARK(BM_StartGraphsShared)
+    ->Arg(1)
+    ->Arg(50)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,71 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+
+#include <string>
+
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/resource_util_custom.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kModelPath[] = "mediapipe/calculators/tensor/testdata/add.bin";
+
+TEST(TfLiteModelLoaderTest, SharesModelLoadedFromSameFile) {
+  auto first = TfLiteModelLoader::LoadFromPath(kModelPath);
+  MP_ASSERT_OK(first);
+  auto second = TfLiteModelLoader::LoadFromPath(kModelPath);
+  MP_ASSERT_OK(second);
+  ASSERT_NE(first->Get(), nullptr);
+  EXPECT_EQ(first->Get().get(), second->Get().get());
+}
+
+TEST(TfLiteModelLoaderTest, ReloadsModelAfterAllPacketsAreReleased) {
+  {
+    auto first = TfLiteModelLoader::LoadFromPath(kModelPath);
+    MP_ASSERT_OK(first);
+  }
+  auto second = TfLiteModelLoader::LoadFromPath(kModelPath);
+  MP_ASSERT_OK(second);
+  ASSERT_NE(second->Get(), nullptr);
+  EXPECT_NE(second->Get()->GetModel(), nullptr);
+}
+
+TEST(TfLiteModelLoaderTest, LoadsThroughCustomResourceProvider) {
+  int num_calls = 0;
+  SetCustomGlobalResourceProvider(
+      [&num_calls](const std::string& path, std::string* output) {
+        ++num_calls;
+        return file::GetContents(path, output);
+      });
+  auto model = TfLiteModelLoader::LoadFromPath(kModelPath);
+  SetCustomGlobalResourceProvider(nullptr);
+  MP_ASSERT_OK(model);
+  ASSERT_NE(model->Get(), nullptr);
+  EXPECT_NE(model->Get()->GetModel(), nullptr);
+  // The provider takes precedence over the memory-mapped file.
+  EXPECT_EQ(num_calls, 1);
+}
+
+TEST(TfLiteModelLoaderTest, FailsOnMissingFile) {
+  EXPECT_FALSE(
+      TfLiteModelLoader::LoadFromPath("mediapipe/does/not/exist.tflite").ok());
+}
+
+}  // namespace
+}  // namespace mediapipe